@@ -0,0 +1,155 @@
+#include "benchmarkMaps.hpp"
+
+#include <filesystem>
+#include <random>
+#include <stack>
+
+using namespace path_finding;
+
+namespace path_finding_benchmarks
+{
+	/// <summary>
+	/// Pick random walkable start and goal pairs which are at least half the map apart
+	/// </summary>
+	/// <param name="map"></param>
+	/// <param name="tiles"></param>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="number_of_queries"></param>
+	/// <param name="gen"></param>
+	static void add_long_queries(benchmark_map& map, const std::vector<tile_type>& tiles, const int width, const int height,
+		const int number_of_queries, std::mt19937_64& gen)
+	{
+		std::uniform_int_distribution x_dist(0, width - 1);
+		std::uniform_int_distribution y_dist(0, height - 1);
+		const auto min_distance = (width + height) / 2;
+		auto attempts = 0;
+		while (static_cast<int>(map.queries.size()) < number_of_queries && attempts++ < number_of_queries * 1000) {
+			const point_2d start(x_dist(gen), y_dist(gen));
+			const point_2d goal(x_dist(gen), y_dist(gen));
+			if (tiles[static_cast<size_t>(start.get_y()) * width + start.get_x()] == tile_type::elevated ||
+				tiles[static_cast<size_t>(goal.get_y()) * width + goal.get_x()] == tile_type::elevated ||
+				start.manhattan_distance(goal) < min_distance)
+				continue;
+			map.queries.emplace_back(start, goal);
+		}
+	}
+
+	/// <summary>
+	/// Open field with randomly scattered elevated tiles
+	/// </summary>
+	benchmark_map create_open_field(const int width, const int height, const double obstacle_density,
+		const int number_of_queries, const std::uint64_t seed)
+	{
+		std::mt19937_64 gen(seed);
+		std::bernoulli_distribution obstacle(obstacle_density);
+		std::vector tiles(static_cast<size_t>(width) * height, tile_type::walkable);
+		for (auto& tile : tiles)
+			if (obstacle(gen))
+				tile = tile_type::elevated;
+
+		benchmark_map map;
+		map.name = "open_" + std::to_string(width) + "x" + std::to_string(height) + "_" +
+			std::to_string(static_cast<int>(obstacle_density * 100)) + "%";
+		add_long_queries(map, tiles, width, height, number_of_queries, gen);
+		map.field.load_from_tiles(width, height, tiles);
+		return map;
+	}
+
+	/// <summary>
+	/// Comb of dead end pockets
+	/// </summary>
+	benchmark_map create_dead_end_comb(const int width, const int height)
+	{
+		std::vector tiles(static_cast<size_t>(width) * height, tile_type::walkable);
+
+		// Walls on every even column except the last, pockets in between, corridor on the bottom row
+		for (int x = 2; x < width - 1; x += 2)
+			for (int y = 0; y < height - 1; ++y)
+				tiles[static_cast<size_t>(y) * width + x] = tile_type::elevated;
+
+		benchmark_map map;
+		map.name = "comb_" + std::to_string(width) + "x" + std::to_string(height);
+		map.queries.emplace_back(point_2d(0, height - 1), point_2d(width - 1, 0));
+		map.queries.emplace_back(point_2d(width - 1, 0), point_2d(0, height - 1));
+		map.field.load_from_tiles(width, height, tiles);
+		return map;
+	}
+
+	/// <summary>
+	/// Perfect maze carved with an iterative recursive backtracker on the odd cells
+	/// </summary>
+	benchmark_map create_maze(const int width, const int height, const int number_of_queries, const std::uint64_t seed)
+	{
+		std::mt19937_64 gen(seed);
+		std::vector tiles(static_cast<size_t>(width) * height, tile_type::elevated);
+		const auto at = [&](const int x, const int y) -> tile_type& { return tiles[static_cast<size_t>(y) * width + x]; };
+
+		std::stack<point_2d> stack;
+		stack.emplace(1, 1);
+		at(1, 1) = tile_type::walkable;
+		const point_2d steps[] = { point_2d(0, -2), point_2d(0, 2), point_2d(-2, 0), point_2d(2, 0) };
+		while (!stack.empty()) {
+			const auto current = stack.top();
+			point_2d candidates[4];
+			auto count = 0;
+			for (const auto& step : steps) {
+				const auto next = current + step;
+				if (next.get_x() > 0 && next.get_x() < width - 1 && next.get_y() > 0 && next.get_y() < height - 1 &&
+					at(next.get_x(), next.get_y()) == tile_type::elevated)
+					candidates[count++] = next;
+			}
+			if (count == 0) {
+				stack.pop();
+				continue;
+			}
+			const auto next = candidates[std::uniform_int_distribution(0, count - 1)(gen)];
+			at((current.get_x() + next.get_x()) / 2, (current.get_y() + next.get_y()) / 2) = tile_type::walkable;
+			at(next.get_x(), next.get_y()) = tile_type::walkable;
+			stack.push(next);
+		}
+
+		benchmark_map map;
+		map.name = "maze_" + std::to_string(width) + "x" + std::to_string(height);
+		add_long_queries(map, tiles, width, height, number_of_queries, gen);
+		map.field.load_from_tiles(width, height, tiles);
+		return map;
+	}
+
+	/// <summary>
+	/// Woodland maps from the resources directory
+	/// </summary>
+	std::vector<benchmark_map> load_resource_maps()
+	{
+		std::vector<benchmark_map> maps;
+		for (int i = 1; i <= 5; ++i) {
+			const auto file = std::string(PATH_FINDING_RESOURCE_DIR) + "/tile_set_woodland_" + std::to_string(i) + ".json";
+			if (!std::filesystem::exists(file))
+				continue;
+
+			benchmark_map map;
+			map.name = "woodland_" + std::to_string(i);
+			map.field.load_from_json(file);
+			for (const auto& start : map.field.get_start_positions())
+				for (const auto& target : map.field.get_target_positions())
+					map.queries.emplace_back(start, target);
+			maps.push_back(std::move(map));
+		}
+		return maps;
+	}
+
+	/// <summary>
+	/// Default benchmark suite
+	/// </summary>
+	std::vector<benchmark_map> create_default_suite(const int scale)
+	{
+		std::vector<benchmark_map> suite;
+		suite.push_back(create_open_field(128 * scale, 128 * scale, 0.1, 20, 1));
+		suite.push_back(create_open_field(128 * scale, 128 * scale, 0.3, 20, 2));
+		suite.push_back(create_dead_end_comb(128 * scale + 1, 64 * scale));
+		suite.push_back(create_maze(128 * scale + 1, 128 * scale + 1, 20, 3));
+		for (auto& map : load_resource_maps())
+			suite.push_back(std::move(map));
+		return suite;
+	}
+}
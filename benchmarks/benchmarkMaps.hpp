@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace path_finding_benchmarks
+{
+	/// <summary>
+	/// Benchmark map with the queries to run on it
+	/// </summary>
+	struct benchmark_map {
+
+		/// <summary>
+		/// Name shown in the report
+		/// </summary>
+		std::string name;
+
+		/// <summary>
+		/// Battlefield
+		/// </summary>
+		path_finding::battle_field field;
+
+		/// <summary>
+		/// Start and goal pairs
+		/// </summary>
+		std::vector<std::pair<path_finding::point_2d, path_finding::point_2d>> queries;
+	};
+
+	/// <summary>
+	/// Open field with randomly scattered elevated tiles, queries are long distance pairs
+	/// </summary>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="obstacle_density">Fraction of elevated tiles in [0, 1)</param>
+	/// <param name="number_of_queries"></param>
+	/// <param name="seed"></param>
+	/// <returns></returns>
+	benchmark_map create_open_field(int width, int height, double obstacle_density, int number_of_queries, std::uint64_t seed);
+
+	/// <summary>
+	/// Comb of vertical dead end pockets which open onto a corridor along the bottom,
+	/// the goal is at the top right so the heuristic pulls the search into every pocket
+	/// </summary>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <returns></returns>
+	benchmark_map create_dead_end_comb(int width, int height);
+
+	/// <summary>
+	/// Perfect maze (recursive backtracker), full of corridors and dead ends
+	/// </summary>
+	/// <param name="width"></param>
+	/// <param name="height"></param>
+	/// <param name="number_of_queries"></param>
+	/// <param name="seed"></param>
+	/// <returns></returns>
+	benchmark_map create_maze(int width, int height, int number_of_queries, std::uint64_t seed);
+
+	/// <summary>
+	/// Woodland maps from the resources directory, every start paired with every target
+	/// Missing files are skipped
+	/// </summary>
+	/// <returns></returns>
+	std::vector<benchmark_map> load_resource_maps();
+
+	/// <summary>
+	/// Default benchmark suite, scale multiplies the map sizes
+	/// </summary>
+	/// <param name="scale"></param>
+	/// <returns></returns>
+	std::vector<benchmark_map> create_default_suite(int scale);
+}
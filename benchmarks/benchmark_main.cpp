@@ -0,0 +1,676 @@
+#include "benchmarkMaps.hpp"
+#include "../headers/pathFinder.hpp"
+#include "../headers/landmarkHeuristic.hpp"
+#include "../headers/compressedPathDatabase.hpp"
+#include "../headers/goalBounds.hpp"
+#include "../headers/rectangleDecomposition.hpp"
+#include "../headers/eventLog.hpp"
+#include "../headers/unitStore.hpp"
+#include "../headers/pathExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace path_finding;
+
+namespace path_finding_benchmarks
+{
+	/// <summary>
+	/// Result of running all the queries of a map through one engine
+	/// </summary>
+	struct benchmark_result {
+		double microseconds_per_query = 0;
+		double expanded_nodes_per_query = 0;
+		size_t total_path_length = 0;
+	};
+
+	/// <summary>
+	/// Engine under test: answers one query
+	/// </summary>
+	using engine = std::function<std::vector<point_2d>(point_2d start, point_2d goal)>;
+
+	/// <summary>
+	/// Run every query of the map through the engine
+	/// </summary>
+	/// <param name="map"></param>
+	/// <param name="path_finder">Pathfinder whose expansion counter is reported</param>
+	/// <param name="run"></param>
+	/// <returns></returns>
+	benchmark_result measure(const benchmark_map& map, const pathfinder& path_finder, const engine& run)
+	{
+		benchmark_result result;
+		const auto expanded_before = path_finder.get_expanded_node_count();
+		const auto begin = std::chrono::steady_clock::now();
+		for (const auto& [start, goal] : map.queries)
+			result.total_path_length += run(start, goal).size();
+		const auto end = std::chrono::steady_clock::now();
+
+		const auto queries = static_cast<double>(map.queries.empty() ? 1 : map.queries.size());
+		result.microseconds_per_query = std::chrono::duration<double, std::micro>(end - begin).count() / queries;
+		result.expanded_nodes_per_query = static_cast<double>(path_finder.get_expanded_node_count() - expanded_before) / queries;
+		return result;
+	}
+
+	/// <summary>
+	/// Print one row of the report
+	/// </summary>
+	void print_row(const std::string& map_name, const std::string& engine_name, const benchmark_result& result)
+	{
+		std::cout << std::left << std::setw(22) << map_name << std::setw(18) << engine_name << std::right
+			<< std::setw(14) << std::fixed << std::setprecision(1) << result.microseconds_per_query
+			<< std::setw(14) << result.expanded_nodes_per_query
+			<< std::setw(14) << result.total_path_length << '\n';
+	}
+
+	/// <summary>
+	/// Unidirectional find_path against find_path_bidirectional
+	/// </summary>
+	void run_bidirectional_suite(const std::vector<benchmark_map>& suite)
+	{
+		const std::unordered_set<point_2d> occupied;
+		for (const auto& map : suite) {
+			const pathfinder path_finder(map.field);
+			print_row(map.name, "a_star", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path(start, goal, occupied);
+			}));
+			print_row(map.name, "bidirectional", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path_bidirectional(start, goal, occupied);
+			}));
+		}
+	}
+
+	/// <summary>
+	/// ALT landmarks against plain manhattan A*: build time, table size, heuristic accuracy and expansion savings per map
+	/// Accuracy is the mean of h(start) / true distance over the queries which have a path
+	/// </summary>
+	void run_landmark_suite(const std::vector<benchmark_map>& suite)
+	{
+		const std::unordered_set<point_2d> occupied;
+		for (const auto& map : suite) {
+			pathfinder path_finder(map.field);
+			const auto plain = measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path(start, goal, occupied);
+			});
+			print_row(map.name, "a_star", plain);
+
+			for (const auto landmark_count : { 4, 8, 16 }) {
+				const auto build_begin = std::chrono::steady_clock::now();
+				const landmark_heuristic landmarks(map.field, landmark_count);
+				const auto build_end = std::chrono::steady_clock::now();
+
+				// Accuracy of both heuristics at the start of every query
+				double manhattan_accuracy = 0;
+				double landmark_accuracy = 0;
+				size_t solved = 0;
+				for (const auto& [start, goal] : map.queries) {
+					const auto distance = path_finder.find_path(start, goal, occupied).size();
+					if (distance == 0)
+						continue;
+					manhattan_accuracy += static_cast<double>(start.manhattan_distance(goal)) / static_cast<double>(distance);
+					landmark_accuracy += std::max(static_cast<double>(start.manhattan_distance(goal)),
+						static_cast<double>(landmarks.estimate(start, goal))) / static_cast<double>(distance);
+					solved++;
+				}
+
+				path_finder.set_landmarks(&landmarks);
+				const auto result = measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+					return path_finder.find_path(start, goal, occupied);
+				});
+				path_finder.set_landmarks(nullptr);
+
+				print_row(map.name, "alt_" + std::to_string(landmark_count), result);
+				std::cout << "    build " << std::setprecision(1)
+					<< std::chrono::duration<double, std::milli>(build_end - build_begin).count() << " ms, "
+					<< landmarks.get_memory_size() / 1024 << " KiB, accuracy manhattan "
+					<< std::setprecision(3) << (solved ? manhattan_accuracy / solved : 0) << " alt "
+					<< (solved ? landmark_accuracy / solved : 0) << ", expansions saved "
+					<< std::setprecision(1) << (plain.expanded_nodes_per_query > 0
+						? 100.0 * (1.0 - result.expanded_nodes_per_query / plain.expanded_nodes_per_query) : 0.0) << "%\n";
+			}
+		}
+	}
+
+	/// <summary>
+	/// Goal bounds: offline build time and size, then pruned A* (also on top of ALT) against A*, with and without units on the map
+	/// Only maps up to 128x128 cells, the build is quadratic in the number of cells
+	/// </summary>
+	void run_goal_bounds_suite(const std::vector<benchmark_map>& suite)
+	{
+		for (const auto& map : suite) {
+			if (static_cast<long long>(map.field.get_width()) * map.field.get_height() > 128 * 129)
+				continue;
+
+			const auto build_begin = std::chrono::steady_clock::now();
+			const auto bounds = goal_bounds::build(map.field);
+			const auto build_end = std::chrono::steady_clock::now();
+			const landmark_heuristic landmarks(map.field, 8);
+
+			// A few scattered units make some queries fall back to the unpruned search
+			std::unordered_set<point_2d> crowd;
+			std::mt19937_64 gen(7);
+			std::uniform_int_distribution<int> x(0, map.field.get_width() - 1), y(0, map.field.get_height() - 1);
+			for (int i = 0; i < map.field.get_width() * map.field.get_height() / 200; ++i) {
+				const point_2d p(x(gen), y(gen));
+				if (map.field.is_walkable(p))
+					crowd.insert(p);
+			}
+			for (const auto& [start, goal] : map.queries) {
+				crowd.erase(start);
+				crowd.erase(goal);
+			}
+
+			pathfinder path_finder(map.field);
+			const std::unordered_set<point_2d> empty;
+			const std::pair<std::string, const std::unordered_set<point_2d>*> runs[] = { { "", &empty }, { "+units", &crowd } };
+			for (const auto& run : runs) {
+				const auto& suffix = run.first;
+				const auto* occupied = run.second;
+				print_row(map.name, std::string("a_star") + suffix, measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+					return path_finder.find_path(start, goal, *occupied);
+				}));
+
+				path_finder.set_goal_bounds(&bounds);
+				print_row(map.name, std::string("bounds") + suffix, measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+					return path_finder.find_path(start, goal, *occupied);
+				}));
+
+				path_finder.set_landmarks(&landmarks);
+				print_row(map.name, std::string("bounds_alt") + suffix, measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+					return path_finder.find_path(start, goal, *occupied);
+				}));
+				path_finder.set_landmarks(nullptr);
+				path_finder.set_goal_bounds(nullptr);
+			}
+			std::cout << "    build " << std::setprecision(1)
+				<< std::chrono::duration<double, std::milli>(build_end - build_begin).count() << " ms, "
+				<< bounds.get_memory_size() / 1024 << " KiB" << '\n';
+		}
+	}
+
+	/// <summary>
+	/// Compressed path database: offline build time and size, then queries on the memory mapped file against A*
+	/// Only maps up to 128x128 cells, the build is quadratic in the number of cells
+	/// </summary>
+	void run_path_database_suite(const std::vector<benchmark_map>& suite)
+	{
+		const std::unordered_set<point_2d> occupied;
+		for (const auto& map : suite) {
+			if (static_cast<long long>(map.field.get_width()) * map.field.get_height() > 128 * 129)
+				continue;
+
+			pathfinder path_finder(map.field);
+			print_row(map.name, "a_star", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path(start, goal, occupied);
+			}));
+
+			const auto build_begin = std::chrono::steady_clock::now();
+			const auto built = compressed_path_database::build(map.field);
+			const auto build_end = std::chrono::steady_clock::now();
+			const auto filename = map.name + ".cpd";
+			built.save(filename);
+			const auto database = compressed_path_database::load(filename, map.field);
+
+			path_finder.set_path_database(&database);
+			print_row(map.name, "cpd", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path_from_database(start, goal, occupied);
+			}));
+			std::cout << "    build " << std::setprecision(1)
+				<< std::chrono::duration<double, std::milli>(build_end - build_begin).count() << " ms, "
+				<< database.get_memory_size() / 1024 << " KiB, " << database.get_run_count() << " runs" << '\n';
+			std::remove(filename.c_str());
+		}
+	}
+
+	/// <summary>
+	/// Rectangular symmetry reduction against A* on (256 * scale)^2 open fields from empty to dense, with and without units:
+	/// build time, rectangles and the share of cells left in the reduced graph
+	/// </summary>
+	void run_symmetry_reduction_suite(const int scale)
+	{
+		const std::unordered_set<point_2d> occupied;
+		std::uint64_t seed = 11;
+		for (const auto density : { 0.0, 0.01, 0.05, 0.1, 0.2, 0.3 }) {
+			const auto map = create_open_field(256 * scale, 256 * scale, density, 50, seed++);
+			pathfinder path_finder(map.field);
+			print_row(map.name, "a_star", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path(start, goal, occupied);
+			}));
+
+			const auto build_begin = std::chrono::steady_clock::now();
+			const auto rectangles = rectangle_decomposition::build(map.field);
+			const auto build_end = std::chrono::steady_clock::now();
+
+			path_finder.set_symmetry_reduction(&rectangles);
+			print_row(map.name, "rsr", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path_reduced(start, goal, occupied);
+			}));
+
+			// One unit per 200 cells, the rectangles holding one are searched cell by cell
+			std::unordered_set<point_2d> crowd;
+			std::mt19937_64 gen(seed);
+			std::uniform_int_distribution<int> x(0, map.field.get_width() - 1), y(0, map.field.get_height() - 1);
+			for (int i = 0; i < map.field.get_width() * map.field.get_height() / 200; ++i) {
+				const point_2d p(x(gen), y(gen));
+				if (map.field.is_walkable(p))
+					crowd.insert(p);
+			}
+			for (const auto& [start, goal] : map.queries) {
+				crowd.erase(start);
+				crowd.erase(goal);
+			}
+			print_row(map.name, "a_star+units", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path(start, goal, crowd);
+			}));
+			print_row(map.name, "rsr+units", measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+				return path_finder.find_path_reduced(start, goal, crowd);
+			}));
+			const auto cells = static_cast<double>(map.field.get_width()) * map.field.get_height();
+			std::cout << "    build " << std::setprecision(1)
+				<< std::chrono::duration<double, std::milli>(build_end - build_begin).count() << " ms, "
+				<< rectangles.get_memory_size() / 1024 << " KiB, " << rectangles.get_rectangle_count() << " rectangles, "
+				<< 100.0 * static_cast<double>(rectangles.get_perimeter_cell_count()) / cells << "% of the cells on perimeters" << '\n';
+		}
+	}
+
+	/// <summary>
+	/// Row major against Morton tiles on (1024 * scale)^2 maps: A*, ALT and symmetry reduction, whose tiles, landmark tables
+	/// and rectangle indexes all follow the layout, and the landmark build whose BFS walks the grid
+	/// </summary>
+	void run_layout_suite(const int scale)
+	{
+		const std::unordered_set<point_2d> occupied;
+		const auto side = 1024 * scale;
+		std::vector<benchmark_map> maps;
+		maps.push_back(create_open_field(side, side, 0.2, 20, 31));
+		maps.push_back(create_maze(side + 1, side + 1, 20, 32));
+		for (auto& map : maps) {
+			for (const auto type : { grid_layout_type::row_major, grid_layout_type::morton }) {
+				const std::string suffix = type == grid_layout_type::row_major ? "/row_major" : "/morton";
+				map.field.set_layout(type);
+				pathfinder path_finder(map.field);
+				print_row(map.name, "a_star" + suffix, measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+					return path_finder.find_path(start, goal, occupied);
+				}));
+
+				const auto build_begin = std::chrono::steady_clock::now();
+				const landmark_heuristic landmarks(map.field, 8);
+				const auto build_end = std::chrono::steady_clock::now();
+				path_finder.set_landmarks(&landmarks);
+				print_row(map.name, "alt" + suffix, measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+					return path_finder.find_path(start, goal, occupied);
+				}));
+				path_finder.set_landmarks(nullptr);
+
+				const auto rectangles = rectangle_decomposition::build(map.field);
+				path_finder.set_symmetry_reduction(&rectangles);
+				print_row(map.name, "rsr" + suffix, measure(map, path_finder, [&](const point_2d start, const point_2d goal) {
+					return path_finder.find_path_reduced(start, goal, occupied);
+				}));
+				std::cout << "    landmark build " << std::setprecision(1)
+					<< std::chrono::duration<double, std::milli>(build_end - build_begin).count() << " ms, "
+					<< map.field.get_cell_count() << " cells stored" << '\n';
+			}
+		}
+	}
+
+	/// <summary>
+	/// Record a seeded run of units heading for their nearest targets with occasional walls dropped in their way,
+	/// then replay it: the same workload on every build, only the engine is timed
+	/// </summary>
+	void run_replay_suite(const int scale)
+	{
+		const auto side = 128 * scale;
+		battle_field field;
+		field.generate_random_field(side, side, side / 8, side * side / 4, 777);
+		const pathfinder path_finder(field);
+		std::vector<unit> units;
+		std::unordered_set<point_2d> occupied;
+		for (const auto& start : field.get_start_positions()) {
+			units.emplace_back(start, path_finder);
+			occupied.insert(start);
+		}
+
+		// Units report every replan on the console, keep it out of the measurements
+		std::stringstream sink;
+		auto* const console = std::cout.rdbuf(sink.rdbuf());
+
+		event_log log;
+		log.begin(field, units, occupied);
+		std::mt19937 gen(777);
+		std::uniform_int_distribution<int> coordinate(0, side - 1);
+		for (int tick = 0; tick < side / 2; ++tick) {
+			if (tick % 16 == 8) {
+				const point_2d corner(coordinate(gen), coordinate(gen));
+				log.set_tiles(field, corner, corner + point_2d(side / 16, 0), tile_type::elevated);
+			}
+			for (size_t i = 0; i < units.size(); ++i)
+				log.move_to_nearest(units, i, field, occupied);
+			log.end_tick(field);
+			sink.str({});
+		}
+
+		replay_result best;
+		for (int run = 0; run < 3; ++run) {
+			const auto result = log.replay();
+			sink.str({});
+			if (run == 0 || result.engine_time < best.engine_time)
+				best = result;
+		}
+		std::cout.rdbuf(console);
+
+		benchmark_result row;
+		const auto ticks = static_cast<double>(std::max<size_t>(best.ticks, 1));
+		row.microseconds_per_query = std::chrono::duration<double, std::micro>(best.engine_time).count() / ticks;
+		row.expanded_nodes_per_query = static_cast<double>(best.expanded_nodes) / ticks;
+		row.total_path_length = best.moves;
+		print_row("replay_" + std::to_string(side) + "x" + std::to_string(side), best.identical() ? "replay" : "replay_mismatch", row);
+		std::cout << "    " << best.ticks << " ticks, " << units.size() << " units, " << best.replans << " replans, "
+			<< best.blocks << " blocked, " << log.get_events().size() * sizeof(event) / 1024 << " KiB of events\n";
+	}
+
+	/// <summary>
+	/// 100k * scale units on an open field, each heading for a cell a few steps away, moved by unit objects
+	/// and by the unit store: the first tick is mostly searching, the following ones only stepping
+	/// </summary>
+	void run_unit_store_suite(const int scale)
+	{
+		// Starts and targets take one cell in 20, crowds would turn the run into a search benchmark
+		const auto count = 100000 * static_cast<size_t>(scale);
+		const auto side = static_cast<int>(std::sqrt(static_cast<double>(count) * 40));
+		battle_field field;
+		field.generate_random_field(side, side, 0, side * side / 50, 4242);
+		const pathfinder path_finder(field);
+
+		// Walkable starts and targets up to 8 cells away, no cell is used twice so no unit waits for another forever
+		std::mt19937 gen(4242);
+		std::uniform_int_distribution<int> coordinate(0, side - 1), offset(-8, 8);
+		std::vector<std::pair<point_2d, point_2d>> assignments;
+		std::unordered_set<point_2d> starts, used;
+		while (assignments.size() < count) {
+			const point_2d start(coordinate(gen), coordinate(gen));
+			const auto target = start + point_2d(offset(gen), offset(gen));
+			if (!field.is_walkable(start) || !field.is_walkable(target) || used.count(start) != 0 || used.count(target) != 0)
+				continue;
+			used.insert(start);
+			used.insert(target);
+			starts.insert(start);
+			assignments.emplace_back(start, target);
+		}
+
+		// Units report every replan on the console, keep it out of the measurements
+		std::stringstream sink;
+		auto* const console = std::cout.rdbuf(sink.rdbuf());
+		const auto measure_ticks = [&](const std::function<size_t()>& tick, double& first, double& rest, int& ticks) {
+			for (ticks = 0; ticks < 64; ++ticks) {
+				const auto begin = std::chrono::steady_clock::now();
+				const auto moved = tick();
+				const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+				(ticks == 0 ? first : rest) += time;
+				sink.str({});
+				if (moved == 0)
+					break;
+			}
+			rest /= std::max(ticks - 1, 1);
+		};
+
+		tick_arena arena;
+		path_pool pool;
+		double object_first = 0, object_rest = 0, store_first = 0, store_rest = 0;
+		int object_ticks = 0, store_ticks = 0;
+		{
+			std::vector<unit> units;
+			units.reserve(count);
+			std::unordered_set<point_2d> occupied(starts);
+			for (const auto& [start, target] : assignments)
+				units.emplace_back(start, path_finder, pool.resource());
+			measure_ticks([&] {
+				size_t moved = 0;
+				for (size_t i = 0; i < units.size(); ++i)
+					moved += units[i].move(assignments[i].second, occupied, arena.resource()) == move_status::moved ? 1 : 0;
+				arena.reset();
+				return moved;
+			}, object_first, object_rest, object_ticks);
+		}
+
+		unit_store store(path_finder);
+		store.reserve(count);
+		std::unordered_set<point_2d> occupied(starts);
+		for (const auto& [start, target] : assignments)
+			store.set_target(store.add(start), target);
+		measure_ticks([&] {
+			const auto moved = store.tick(occupied, arena.resource());
+			arena.reset();
+			return moved;
+		}, store_first, store_rest, store_ticks);
+		std::cout.rdbuf(console);
+
+		const auto name = "units_" + std::to_string(count / 1000) + "k";
+		std::cout << std::left << std::setw(22) << name << std::setw(18) << "unit_objects" << std::right << std::setw(14)
+			<< std::fixed << std::setprecision(1) << object_first << " ms first tick, " << object_rest << " ms per tick after, "
+			<< object_ticks << " ticks" << '\n';
+		std::cout << std::left << std::setw(22) << name << std::setw(18) << "unit_store" << std::right << std::setw(14)
+			<< store_first << " ms first tick, " << store_rest << " ms per tick after, " << store_ticks << " ticks, "
+			<< store.get_path_memory_size() / 1024 << " KiB of paths" << '\n';
+	}
+
+	/// <summary>
+	/// 2000 * scale units spread over a 256 * scale field all heading for its center, searched and stored in full
+	/// by the unit store and shared in a path tree. The first tick searches every path; reports its time,
+	/// the nodes it expanded, the steps of all paths and what storing them takes
+	/// </summary>
+	void run_path_sharing_suite(const int scale)
+	{
+		const auto count = 2000 * static_cast<size_t>(scale);
+		const auto side = 256 * scale;
+		battle_field field;
+		field.generate_random_field(side, side, 0, side * side / 10, 4711);
+
+		// Goal: a walkable cell at the center, starts: distinct walkable cells which reach it
+		point_2d goal(side / 2, side / 2);
+		for (int i = 1; !field.is_walkable(goal); ++i)
+			goal = point_2d(side / 2 + i % 16, side / 2 + i / 16);
+		const pathfinder reachability(field);
+		std::mt19937 gen(4711);
+		std::uniform_int_distribution<int> coordinate(0, side - 1);
+		std::vector<point_2d> starts;
+		std::unordered_set<point_2d> used{ goal };
+		while (starts.size() < count) {
+			const point_2d start(coordinate(gen), coordinate(gen));
+			if (!field.is_walkable(start) || !used.insert(start).second || reachability.find_path(start, goal, {}).empty())
+				continue;
+			starts.push_back(start);
+		}
+
+		const auto name = "sharing_" + std::to_string(count / 1000) + "k";
+		for (const auto sharing : { false, true }) {
+			const pathfinder path_finder(field);
+			unit_store store(path_finder);
+			store.set_path_sharing(sharing);
+			store.reserve(count);
+			std::unordered_set<point_2d> occupied(starts.begin(), starts.end());
+			for (const auto& start : starts)
+				store.set_target(store.add(start), goal);
+
+			tick_arena arena;
+			const auto begin = std::chrono::steady_clock::now();
+			store.tick(occupied, arena.resource());
+			const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			const auto memory = sharing ? store.get_path_tree_memory_size() : store.get_path_memory_size();
+			size_t steps = 0;
+			for (unit_store::unit_id id = 0; id < store.size(); ++id)
+				steps += store.get_path_length(id);
+
+			std::cout << std::left << std::setw(22) << name << std::setw(18) << (sharing ? "path_tree" : "full_paths")
+				<< std::right << std::setw(14) << std::fixed << std::setprecision(1) << time << " ms first tick, "
+				<< path_finder.get_expanded_node_count() << " expanded, " << steps << " steps, "
+				<< (sharing ? std::to_string(store.get_path_tree_node_count()) + " nodes, " : "")
+				<< memory / 1024 << " KiB of paths" << '\n';
+		}
+	}
+
+	/// <summary>
+	/// 1000 * scale units crossing a 256 * scale field: unit objects searching inside the tick against units written as
+	/// coroutines which co_await their paths from the path executor's workers. Reports the worst and the average tick
+	/// </summary>
+	void run_async_suite(const int scale)
+	{
+		const auto count = 1000 * static_cast<size_t>(scale);
+		const auto side = 256 * scale;
+		battle_field field;
+		field.generate_random_field(side, side, 0, side * side / 5, 777);
+		const pathfinder path_finder(field);
+
+		std::mt19937 gen(777);
+		std::uniform_int_distribution<int> coordinate(0, side - 1);
+		std::vector<std::pair<point_2d, point_2d>> assignments;
+		std::unordered_set<point_2d> starts, used;
+		while (assignments.size() < count) {
+			const point_2d start(coordinate(gen), coordinate(gen));
+			const point_2d target(coordinate(gen), coordinate(gen));
+			if (!field.is_walkable(start) || !field.is_walkable(target) || used.count(start) != 0 || used.count(target) != 0 ||
+				path_finder.find_path(start, target, {}).empty())
+				continue;
+			used.insert(start);
+			used.insert(target);
+			starts.insert(start);
+			assignments.emplace_back(start, target);
+		}
+
+		// Ticks until nothing is left to do, at most max_ticks, the pause after a tick stands for the rest of the game's frame
+		constexpr int max_ticks = 4000;
+		const auto measure_ticks = [&](const std::function<bool()>& tick, const std::chrono::milliseconds pause,
+			double& worst, double& average, int& ticks) {
+			double total = 0;
+			for (ticks = 0; ticks < max_ticks; ++ticks) {
+				const auto begin = std::chrono::steady_clock::now();
+				const auto busy = tick();
+				const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+				worst = std::max(worst, time);
+				total += time;
+				if (!busy)
+					break;
+				std::this_thread::sleep_for(pause);
+			}
+			average = total / std::max(ticks, 1);
+		};
+
+		// Units report every replan on the console, keep it out of the measurements
+		std::stringstream sink;
+		auto* const console = std::cout.rdbuf(sink.rdbuf());
+		double blocking_worst = 0, blocking_average = 0, async_worst = 0, async_average = 0;
+		int blocking_ticks = 0, async_ticks = 0;
+		{
+			std::vector<unit> units;
+			units.reserve(count);
+			std::unordered_set<point_2d> occupied(starts);
+			for (const auto& [start, target] : assignments)
+				units.emplace_back(start, path_finder);
+			unsigned idle = 0;
+			measure_ticks([&] {
+				size_t moved = 0;
+				for (size_t i = 0; i < units.size(); ++i)
+					moved += units[i].move(assignments[i].second, occupied) == move_status::moved ? 1 : 0;
+				sink.str({});
+				idle = moved > 0 ? 0 : idle + 1;
+				return idle < 16;
+			}, std::chrono::milliseconds(0), blocking_worst, blocking_average, blocking_ticks);
+		}
+		std::cout.rdbuf(console);
+
+		size_t arrived = 0;
+		path_executor_metrics metrics;
+		{
+			std::vector<async_unit> units(count);
+			std::unordered_set<point_2d> occupied(starts);
+			field.enable_snapshots();
+			path_executor executor(field, occupied);
+			for (size_t i = 0; i < count; ++i) {
+				units[i].position = assignments[i].first;
+				executor.spawn(follow_path(executor, units[i], assignments[i].second));
+			}
+			measure_ticks([&] {
+				executor.tick();
+				return executor.get_running_count() > 0;
+			}, std::chrono::milliseconds(1), async_worst, async_average, async_ticks);
+			for (const auto& next : units)
+				arrived += next.status == move_status::at_target ? 1 : 0;
+			metrics = executor.get_metrics();
+		}
+
+		const auto name = "async_" + std::to_string(count / 1000) + "k";
+		std::cout << std::left << std::setw(22) << name << std::setw(18) << "blocking" << std::right << std::setw(14)
+			<< std::fixed << std::setprecision(2) << blocking_worst << " ms worst tick, " << blocking_average << " ms average, "
+			<< blocking_ticks << " ticks" << '\n';
+		std::cout << std::left << std::setw(22) << name << std::setw(18) << "coroutines" << std::right << std::setw(14)
+			<< async_worst << " ms worst tick, " << async_average << " ms average, " << async_ticks << " ticks, "
+			<< arrived << " of " << count << " arrived, " << metrics.requests << " requests, " << metrics.stale << " stale" << '\n';
+	}
+
+	/// <summary>
+	/// Seeded random field generator on a (1000 * scale)^2 grid, scale 10 gives 10^8 cells
+	/// </summary>
+	void run_generator_suite(const int scale)
+	{
+		for (const auto side : { 1000 * scale }) {
+			battle_field field;
+			const auto cells = static_cast<long long>(side) * side;
+			const auto begin = std::chrono::steady_clock::now();
+			field.generate_random_field(side, side, static_cast<int>(cells / 100), static_cast<int>(cells * 3 / 10), 12345);
+			const auto end = std::chrono::steady_clock::now();
+			std::cout << std::left << std::setw(22) << ("random_" + std::to_string(side) + "x" + std::to_string(side))
+				<< std::setw(18) << "generator" << std::right << std::setw(14) << std::fixed << std::setprecision(1)
+				<< std::chrono::duration<double, std::micro>(end - begin).count() << '\n';
+		}
+	}
+}
+
+/// <summary>
+/// Benchmark entry point
+/// Usage: path_finding_benchmarks [suite] [scale]
+/// </summary>
+int main(const int argc, char** argv)
+{
+	using namespace path_finding_benchmarks;
+
+	const std::string suite_name = argc > 1 ? argv[1] : "all";
+	const int scale = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+	const auto suite = create_default_suite(scale);
+
+	std::cout << std::left << std::setw(22) << "map" << std::setw(18) << "engine" << std::right
+		<< std::setw(14) << "us/query" << std::setw(14) << "expanded" << std::setw(14) << "path length" << '\n';
+
+	if (suite_name == "all" || suite_name == "bidirectional")
+		run_bidirectional_suite(suite);
+	if (suite_name == "all" || suite_name == "alt")
+		run_landmark_suite(suite);
+	if (suite_name == "all" || suite_name == "cpd")
+		run_path_database_suite(suite);
+	if (suite_name == "all" || suite_name == "bounds")
+		run_goal_bounds_suite(suite);
+	if (suite_name == "all" || suite_name == "rsr")
+		run_symmetry_reduction_suite(scale);
+	if (suite_name == "all" || suite_name == "layout")
+		run_layout_suite(scale);
+	if (suite_name == "all" || suite_name == "replay")
+		run_replay_suite(scale);
+	if (suite_name == "all" || suite_name == "units")
+		run_unit_store_suite(scale);
+	if (suite_name == "all" || suite_name == "sharing")
+		run_path_sharing_suite(scale);
+	if (suite_name == "all" || suite_name == "async")
+		run_async_suite(scale);
+	if (suite_name == "all" || suite_name == "generator")
+		run_generator_suite(scale);
+
+	return 0;
+}
@@ -1,23 +1,53 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <string>
 #include "../headers/point2d.hpp"
 #include "../headers/tileType.hpp"
+#include "../headers/mapChanges.hpp"
+#include "../headers/gridLayout.hpp"
 
 namespace path_finding
 {
     /// <summary>
     /// Battlefield class to represent a grid of tiles
+    /// The grid can be edited at runtime from the tick thread, edits are published once per tick as map_changes
+    /// to the subscribers and as an immutable snapshot that other threads can read without taking a lock
     /// </summary>
     class battle_field {
     public:
 
+        /// <summary>
+        /// Callback to be notified of published changes
+        /// </summary>
+        using change_listener = std::function<void(const map_changes&)>;
+
         /// <summary>
         /// Constructor to initialize the field
         /// </summary>
         battle_field();
 
+        /// <summary>
+        /// Copy the map data (grid, positions and version), subscribers and pending changes are not copied
+        /// </summary>
+        /// <param name="other"></param>
+        battle_field(const battle_field& other);
+
+        /// <summary>
+        /// Copy the map data (grid, positions and version), subscribers and pending changes are not copied
+        /// </summary>
+        /// <param name="other"></param>
+        /// <returns></returns>
+        battle_field& operator=(const battle_field& other);
+
+        battle_field(battle_field&&) noexcept = default;
+        battle_field& operator=(battle_field&&) noexcept = default;
+        ~battle_field() = default;
+
         /// <summary>
         /// A way to create a battlefield (grid) using json file 
         /// </summary>
@@ -33,6 +63,26 @@ namespace path_finding
         /// <param name="number_of_terrains"></param>
         void generate_random_field(int width, int height, int number_of_units, int number_of_terrains);
 
+        /// <summary>
+        /// A way to randomly generate a reproducible battlefield grid, the same seed always gives the same grid
+        /// on every platform and standard library
+        /// Cells are sampled without replacement (partial Fisher-Yates) per chunk of the grid and chunks are filled in parallel
+        /// </summary>
+        /// <param name="width"></param>
+        /// <param name="height"></param>
+        /// <param name="number_of_units"></param>
+        /// <param name="number_of_terrains"></param>
+        /// <param name="seed"></param>
+        void generate_random_field(int width, int height, int number_of_units, int number_of_terrains, std::uint64_t seed);
+
+        /// <summary>
+        /// A way to create a battlefield grid from row major tiles, e.g. for programmatically built maps
+        /// </summary>
+        /// <param name="width"></param>
+        /// <param name="height"></param>
+        /// <param name="tiles"></param>
+        void load_from_tiles(int width, int height, const std::vector<tile_type>& tiles);
+
         /// <summary>
         /// Find out whether the given tile position is walkable or not
         /// </summary>
@@ -49,22 +99,193 @@ namespace path_finding
         static point_2d generate_random_point(point_2d min, point_2d max);
 
         /// <summary>
-        /// To access the battlefield grid
+        /// To access the battlefield grid (a row by row copy)
+        /// </summary>
+        /// <returns></returns>
+        std::vector<std::vector<tile_type>> get_battlefield_grid() const;
+
+        /// <summary>
+        /// Width of the grid
+        /// </summary>
+        /// <returns></returns>
+        int get_width() const { return width_; }
+
+        /// <summary>
+        /// Height of the grid
+        /// </summary>
+        /// <returns></returns>
+        int get_height() const { return height_; }
+
+        /// <summary>
+        /// Tile at the given position, the position must be inside the grid
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        tile_type get_tile(const point_2d position) const { return grid_[index_of(position)]; }
+
+        /// <summary>
+        /// Tiles of the grid in storage order: row major unless another layout was set, padding cells are elevated
+        /// </summary>
+        /// <returns></returns>
+        const std::vector<tile_type>& get_tiles() const { return grid_; }
+
+        /// <summary>
+        /// Row major copy of the tiles whatever the layout
+        /// </summary>
+        /// <returns></returns>
+        std::vector<tile_type> get_row_major_tiles() const;
+
+        /// <summary>
+        /// Write the width * height tiles in row major order, whatever the layout
+        /// </summary>
+        /// <param name="tiles"></param>
+        void copy_row_major_tiles(tile_type* tiles) const;
+
+        /// <summary>
+        /// Index of the given position in the tiles and in any per cell array sized get_cell_count,
+        /// the position must be inside the grid
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        size_t index_of(const point_2d position) const { return layout_.index_of(position); }
+
+        /// <summary>
+        /// Position of a storage index, padding cells lie outside the grid
         /// </summary>
+        /// <param name="index"></param>
         /// <returns></returns>
-        std::vector<std::vector<tile_type>> get_battlefield_grid() const { return grid_; }
+        point_2d position_of(const size_t index) const { return layout_.position_of(index); }
+
+        /// <summary>
+        /// Number of stored cells, padding included
+        /// </summary>
+        /// <returns></returns>
+        size_t get_cell_count() const { return grid_.size(); }
+
+        /// <summary>
+        /// Layout of the tiles in memory
+        /// </summary>
+        /// <returns></returns>
+        const grid_layout& get_layout() const { return layout_; }
+
+        /// <summary>
+        /// Rearrange the tiles in the given layout, kept by later loads. Per cell data indexed with index_of
+        /// (landmarks, rectangle decompositions) must be built after this call. Content hash and version do not change
+        /// </summary>
+        /// <param name="type"></param>
+        void set_layout(grid_layout_type type);
+
+        /// <summary>
+        /// Whether the given position is inside the grid
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        bool contains(const point_2d position) const {
+            return position.get_x() >= 0 && position.get_x() < width_ && position.get_y() >= 0 && position.get_y() < height_;
+        }
+
+        /// <summary>
+        /// 64 bit FNV-1a hash of the grid size and tiles, identifies the map content for precomputed data
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_content_hash() const;
+
+        /// <summary>
+        /// Change the tile at the given position, bumps the version when the tile actually changes
+        /// Start and target positions follow start and target tiles
+        /// </summary>
+        /// <param name="position"></param>
+        /// <param name="type"></param>
+        void set_tile(point_2d position, tile_type type);
+
+        /// <summary>
+        /// Change every tile in the rectangle between min and max (inclusive, clipped to the grid) with a single version bump
+        /// </summary>
+        /// <param name="min"></param>
+        /// <param name="max"></param>
+        /// <param name="type"></param>
+        void set_tiles(point_2d min, point_2d max, tile_type type);
+
+        /// <summary>
+        /// Change the listed tiles with a single version bump, later entries for the same position win
+        /// </summary>
+        /// <param name="tiles">Positions outside the grid are rejected before anything is changed</param>
+        void set_tiles(const std::vector<std::pair<point_2d, tile_type>>& tiles);
+
+        /// <summary>
+        /// Restore a captured grid, positions and version in place, reusing the existing storage
+        /// Pending changes are dropped and subscribers are not notified, as for the loaders
+        /// </summary>
+        /// <param name="width"></param>
+        /// <param name="height"></param>
+        /// <param name="tiles">width * height row major tiles</param>
+        /// <param name="start_positions"></param>
+        /// <param name="start_count"></param>
+        /// <param name="target_positions"></param>
+        /// <param name="target_count"></param>
+        /// <param name="version"></param>
+        /// <param name="seed"></param>
+        void restore(int width, int height, const tile_type* tiles, const point_2d* start_positions, size_t start_count,
+            const point_2d* target_positions, size_t target_count, std::uint64_t version, std::uint64_t seed);
+
+        /// <summary>
+        /// Seed the grid was generated from, 0 for grids loaded from a file or tiles
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_seed() const { return seed_; }
+
+        /// <summary>
+        /// Current version of the grid, bumped by every edit that changes a tile
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_version() const { return version_; }
+
+        /// <summary>
+        /// Publish the edits made since the last publish, to be called once per tick at the tick boundary
+        /// Subscribers are notified in subscription order and the snapshot is replaced when snapshots are enabled
+        /// </summary>
+        /// <returns>The published changes, valid until the next publish</returns>
+        const map_changes& publish_changes();
+
+        /// <summary>
+        /// Subscribe to the published changes, e.g. caches and indexes which update incrementally
+        /// </summary>
+        /// <param name="listener"></param>
+        /// <returns>Id to unsubscribe with</returns>
+        size_t subscribe(change_listener listener);
+
+        /// <summary>
+        /// Stop notifying the given subscriber
+        /// </summary>
+        /// <param name="subscription_id"></param>
+        void unsubscribe(size_t subscription_id);
+
+        /// <summary>
+        /// Start publishing snapshots, takes the first one right away (call it after loading the grid)
+        /// Each publish with changes then copies the grid once
+        /// </summary>
+        void enable_snapshots();
+
+        /// <summary>
+        /// Latest published snapshot, safe to call from any thread without locking
+        /// Null until snapshots are enabled
+        /// </summary>
+        /// <returns></returns>
+        std::shared_ptr<const battle_field> get_snapshot() const;
 
         /// <summary>
         /// Get the start position of the units
         /// </summary>
         /// <returns></returns>
         std::vector<point_2d>& get_start_positions() { return start_positions_; }
+        const std::vector<point_2d>& get_start_positions() const { return start_positions_; }
 
         /// <summary>
         /// Get target position of the units
         /// </summary>
         /// <returns></returns>
         std::vector<point_2d>& get_target_positions() { return target_positions_; }
+        const std::vector<point_2d>& get_target_positions() const { return target_positions_; }
 
     private:
 
@@ -74,9 +295,16 @@ namespace path_finding
         int width_, height_;
 
         /// <summary>
-        /// Battlefield grid
+        /// Battlefield grid, in the order of the layout
         /// </summary>
-        std::vector<std::vector<tile_type>> grid_;
+        std::vector<tile_type> grid_;
+        grid_layout layout_;
+
+        /// <summary>
+        /// Number of cells each parallel work item of the random generator fills,
+        /// fixed so the generated grid does not depend on the number of threads
+        /// </summary>
+        static constexpr size_t generator_chunk_size = 1 << 20;
 
         /// <summary>
         /// Unit start positions
@@ -87,5 +315,68 @@ namespace path_finding
         /// Unit target position
         /// </summary>
         std::vector<point_2d> target_positions_;
+
+        /// <summary>
+        /// Seed of the random generator the grid came from
+        /// </summary>
+        std::uint64_t seed_ = 0;
+
+        /// <summary>
+        /// Version of the grid
+        /// </summary>
+        std::uint64_t version_ = 0;
+
+        /// <summary>
+        /// Version at the last publish
+        /// </summary>
+        std::uint64_t published_version_ = 0;
+
+        /// <summary>
+        /// Cells edited since the last publish, and a flag per cell so each is listed once
+        /// </summary>
+        std::vector<point_2d> dirty_cells_;
+        std::vector<bool> dirty_flags_;
+
+        /// <summary>
+        /// Last published changes
+        /// </summary>
+        map_changes published_changes_;
+
+        /// <summary>
+        /// Subscribers with their ids
+        /// </summary>
+        std::vector<std::pair<size_t, change_listener>> listeners_;
+        size_t next_listener_id_ = 0;
+
+        /// <summary>
+        /// Latest snapshot, only accessed through std::atomic_load and std::atomic_store
+        /// </summary>
+        std::shared_ptr<const battle_field> snapshot_;
+        bool snapshots_enabled_ = false;
+
+        /// <summary>
+        /// Set one tile without bumping the version, returns whether it changed
+        /// </summary>
+        /// <param name="position"></param>
+        /// <param name="type"></param>
+        /// <returns></returns>
+        bool write_tile(point_2d position, tile_type type);
+
+        /// <summary>
+        /// Start a new version with no pending changes, used by the loaders which replace the whole grid
+        /// </summary>
+        void reset_changes();
+
+        /// <summary>
+        /// Lay the row major tiles a loader wrote into the grid out in the current layout type
+        /// </summary>
+        void arrange_tiles();
+
+        /// <summary>
+        /// Copy the tiles of row y in row major order
+        /// </summary>
+        /// <param name="y"></param>
+        /// <param name="row">width tiles</param>
+        void copy_row(int y, tile_type* row) const;
     };
 }
@@ -2,6 +2,8 @@
 
 #include "../headers/battleField.hpp"
 
+#include <string>
+
 namespace path_finding
 {
 	/// <summary>
@@ -14,5 +16,11 @@ namespace path_finding
 		/// Create battlefield based on the user input
 		/// </summary>
 		static battle_field create();
+
+		/// <summary>
+		/// Create battlefield based on the user input
+		/// </summary>
+		/// <param name="config_file">JSON file the battlefield was loaded from, empty when it was generated</param>
+		static battle_field create(std::string& config_file);
 	};
 }
@@ -3,12 +3,15 @@
 #include "../headers/point2d.hpp"
 #include "../headers/battleField.hpp"
 #include "../headers/pathFinder.hpp"
+#include "../headers/battleFieldViewport.hpp"
 #include <windows.h>
 
 namespace path_finding
 {
 	/// <summary>
 	/// Battlefield renderer that uses windows console buffer for double buffering
+	/// The screen buffer is as large as the grid but at most as large as the console window, larger battlefields are shown
+	/// through a viewport that can follow a unit, pan and zoom out to aggregated levels of detail
 	/// </summary>
 	class battle_field_renderer {
 	public:
@@ -16,7 +19,7 @@ namespace path_finding
 		/// <summary>
 		/// Constructor
 		/// </summary>
-		/// <param name="battle_field"></param>
+		/// <param name="battle_field">Read on every update, must outlive the renderer</param>
 		explicit battle_field_renderer(const battle_field& battle_field);
 
 		/// <summary>
@@ -25,6 +28,18 @@ namespace path_finding
 		/// <param name="unit_positions"></param>
 		void update(const std::unordered_set<point_2d>& unit_positions);
 
+		/// <summary>
+		/// Keep the given position, e.g. of a chosen unit, in the middle of the window
+		/// </summary>
+		/// <param name="position"></param>
+		void follow(point_2d position) { viewport_.center_on(position); }
+
+		/// <summary>
+		/// Viewport to pan and zoom with
+		/// </summary>
+		/// <returns></returns>
+		battle_field_viewport& get_viewport() { return viewport_; }
+
 	private:
 
 		/// <summary>
@@ -38,22 +53,27 @@ namespace path_finding
 		std::vector<CHAR_INFO> char_info_buffer_;
 
 		/// <summary>
-		/// Battlefield grid
+		/// Width and height for the screen buffer
 		/// </summary>
-		std::vector<std::vector<tile_type>> battlefield_grid_;
+		int screen_buffer_width_, screen_buffer_height_;
 
 		/// <summary>
-		/// Width and height for the screen buffer
+		/// Window onto the battlefield which composes the frames
 		/// </summary>
-		int screen_buffer_width_, screen_buffer_height_;
+		battle_field_viewport viewport_;
 
 		/// <summary>
-		/// Write given character with color to a specific x, y location in the char buffer
+		/// Size of the console window, the largest screen buffer that is shown without scrolling
 		/// </summary>
-		/// <param name="x"></param>
-		/// <param name="y"></param>
-		/// <param name="ch"></param>
-		/// <param name="color"></param>
-		void write_char_buffer(int x, int y, char ch, WORD color);
+		/// <param name="width"></param>
+		/// <param name="height"></param>
+		static void get_console_size(int& width, int& height);
+
+		/// <summary>
+		/// Screen buffer size for the battlefield
+		/// </summary>
+		/// <param name="battle_field"></param>
+		/// <returns></returns>
+		static COORD get_buffer_size(const battle_field& battle_field);
 	};
 }
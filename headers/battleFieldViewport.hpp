@@ -0,0 +1,188 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/mapChanges.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Colors of the composed characters, as console character attributes
+    /// </summary>
+    namespace viewport_color
+    {
+        constexpr std::uint16_t grey = 7;
+        constexpr std::uint16_t green = 2 | 8;
+        constexpr std::uint16_t red = 4 | 8;
+        constexpr std::uint16_t yellow = 2 | 4 | 8;
+        constexpr std::uint16_t dark_yellow = 2 | 4;
+    }
+
+    /// <summary>
+    /// Composes the frame of a window onto a battlefield of any size, platform independent so the renderer only copies it out.
+    /// The frame has a border and two characters per cell. At level 0 a cell is one tile; at level k it aggregates a block
+    /// of 2^k by 2^k tiles: the first character shows the units in the block (a count), else a target, else the obstacle
+    /// density, the second character always shows the obstacle density.
+    /// Obstacle counts come from a pyramid of per block counts rebuilt only when the battlefield version changes,
+    /// or updated along the changed cells when the published changes are passed to apply_changes, so composing a frame costs the cells of the window plus the units and targets, whatever the size of the map
+    /// </summary>
+    class battle_field_viewport {
+    public:
+
+        /// <summary>
+        /// One character of the frame
+        /// </summary>
+        struct cell {
+            char ch;
+            std::uint16_t color;
+        };
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="battle_field">Read on every compose, must outlive the viewport</param>
+        /// <param name="frame_width">Characters per row including the border, at least 4</param>
+        /// <param name="frame_height">Rows including the border, at least 3</param>
+        battle_field_viewport(const battle_field& battle_field, int frame_width, int frame_height);
+
+        /// <summary>
+        /// Frame size that shows the whole battlefield at level 0, limited to the given maximum
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="max_width"></param>
+        /// <param name="max_height"></param>
+        /// <param name="width"></param>
+        /// <param name="height"></param>
+        static void fit_frame(const battle_field& battle_field, int max_width, int max_height, int& width, int& height);
+
+        /// <summary>
+        /// Change the level of detail, the center of the window stays where it is
+        /// </summary>
+        /// <param name="level">0 for every tile, k for blocks of 2^k by 2^k tiles, clamped to max_level</param>
+        void set_level(int level);
+
+        /// <summary>
+        /// Level of detail
+        /// </summary>
+        /// <returns></returns>
+        int get_level() const { return level_; }
+
+        /// <summary>
+        /// Lowest level at which the whole battlefield fits into the window
+        /// </summary>
+        /// <returns></returns>
+        int get_fitting_level() const;
+
+        /// <summary>
+        /// Center the window on the position, as far as the battlefield borders allow
+        /// </summary>
+        /// <param name="position"></param>
+        void center_on(point_2d position);
+
+        /// <summary>
+        /// Move the window by the given number of cells
+        /// </summary>
+        /// <param name="cells_x"></param>
+        /// <param name="cells_y"></param>
+        void pan(int cells_x, int cells_y);
+
+        /// <summary>
+        /// Tile in the top left corner of the window
+        /// </summary>
+        /// <returns></returns>
+        point_2d get_origin() const { return origin_; }
+
+        /// <summary>
+        /// Cells in the window horizontally and vertically
+        /// </summary>
+        /// <returns></returns>
+        int get_columns() const { return columns_; }
+        int get_rows() const { return rows_; }
+
+        /// <summary>
+        /// Frame size in characters
+        /// </summary>
+        /// <returns></returns>
+        int get_frame_width() const { return columns_ * 2 + 2; }
+        int get_frame_height() const { return rows_ + 2; }
+
+        /// <summary>
+        /// Compose the frame with the units at the given positions
+        /// </summary>
+        /// <param name="unit_positions"></param>
+        /// <returns>Row major characters of the frame</returns>
+        const std::vector<cell>& compose(const std::unordered_set<point_2d>& unit_positions);
+
+        /// <summary>
+        /// Update the obstacle counts above the changed cells instead of rebuilding them on the next compose.
+        /// Subscribe it to the battlefield; changes which do not continue the counts' version are left to the rebuild
+        /// </summary>
+        /// <param name="changes"></param>
+        void apply_changes(const map_changes& changes);
+
+        /// <summary>
+        /// Highest level of detail
+        /// </summary>
+        static constexpr int max_level = 12;
+
+    private:
+
+        /// <summary>
+        /// Tiles per side of a cell
+        /// </summary>
+        /// <returns></returns>
+        int block_size() const { return 1 << level_; }
+
+        /// <summary>
+        /// Keep the window inside the battlefield, or centered when the battlefield is smaller than the window
+        /// </summary>
+        void clamp_origin();
+
+        /// <summary>
+        /// Rebuild the obstacle counts when the battlefield changed since the last build
+        /// </summary>
+        void update_pyramid();
+
+        /// <summary>
+        /// Obstacles in the block of the cell at the current level, and the tiles of the block inside the grid
+        /// </summary>
+        /// <param name="block_x"></param>
+        /// <param name="block_y"></param>
+        /// <param name="tiles"></param>
+        /// <returns></returns>
+        std::uint32_t count_obstacles(int block_x, int block_y, std::uint32_t& tiles) const;
+
+        /// <summary>
+        /// Write a character into the frame
+        /// </summary>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        /// <param name="ch"></param>
+        /// <param name="color"></param>
+        void put(int x, int y, char ch, std::uint16_t color);
+
+        const battle_field* battle_field_;
+        int columns_, rows_;
+        int level_ = 0;
+        point_2d origin_;
+
+        /// <summary>
+        /// Level k (k >= 1) at index k - 1: elevated tiles per 2^k by 2^k block, row major
+        /// </summary>
+        std::vector<std::vector<std::uint32_t>> pyramid_;
+        std::uint64_t pyramid_version_ = 0;
+        bool pyramid_built_ = false;
+
+        /// <summary>
+        /// Units and targets per cell of the window, reused by every frame
+        /// </summary>
+        std::vector<std::uint32_t> unit_counts_;
+        std::vector<std::uint8_t> target_marks_;
+
+        std::vector<cell> frame_;
+    };
+}
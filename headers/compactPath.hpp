@@ -0,0 +1,208 @@
+#pragma once
+
+#include "../headers/point2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Path stored as its start cell and one 2 bit direction code per step (up, down, left, right), four steps per byte,
+    /// a 32nd of the memory of a vector of points.
+    /// The start cell is where the path begins and is not one of its steps, like the vector paths of the pathfinder.
+    /// Steps are decoded one at a time, by index or by iterating over the positions
+    /// </summary>
+    class compact_path {
+    public:
+
+        /// <summary>
+        /// Bits per direction code, 4-connected moves only
+        /// </summary>
+        static constexpr unsigned bits_per_step = 2;
+
+        /// <summary>
+        /// Step of each direction code: up, down, left, right (same order as the pathfinder's directions)
+        /// </summary>
+        static const point_2d directions[4];
+
+        /// <summary>
+        /// Direction code of a step between two adjacent cells, -1 when they are not adjacent
+        /// </summary>
+        /// <param name="from"></param>
+        /// <param name="to"></param>
+        /// <returns></returns>
+        static int direction_of(point_2d from, point_2d to);
+
+        /// <summary>
+        /// Forward iterator over the positions of the path, decodes one step per increment
+        /// </summary>
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = point_2d;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const point_2d*;
+            using reference = const point_2d&;
+
+            const_iterator() = default;
+            const_iterator(const compact_path* path, const size_t index, const point_2d position) :
+                path_(path), index_(index), position_(position) {}
+
+            reference operator*() const { return position_; }
+            pointer operator->() const { return &position_; }
+
+            const_iterator& operator++() {
+                if (++index_ < path_->size())
+                    position_ = position_ + directions[path_->get_step(index_)];
+                return *this;
+            }
+
+            const_iterator operator++(int) { auto copy = *this; ++*this; return copy; }
+
+            bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+            bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+        private:
+            const compact_path* path_ = nullptr;
+            size_t index_ = 0;
+            point_2d position_;
+        };
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="resource">Resource the direction codes are allocated from</param>
+        explicit compact_path(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        /// <summary>
+        /// Encode a path of adjacent points starting next to the given start cell
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="points"></param>
+        /// <param name="resource"></param>
+        compact_path(point_2d start, const std::vector<point_2d>& points,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        /// <summary>
+        /// Start over with a path of the given number of steps, all codes zero, to be filled with set_step in any order
+        /// Keeps the storage when it is large enough
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="length"></param>
+        void reset(point_2d start, size_t length);
+
+        /// <summary>
+        /// Copy raw direction codes (as returned by get_codes), keeps the storage when it is large enough
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="codes"></param>
+        /// <param name="length"></param>
+        void assign(point_2d start, const std::uint8_t* codes, size_t length);
+
+        /// <summary>
+        /// Set the direction code of a step, the step must be zero (as after reset)
+        /// </summary>
+        /// <param name="index"></param>
+        /// <param name="direction"></param>
+        void set_step(const size_t index, const int direction) {
+            codes_[index / 4] |= static_cast<std::uint8_t>(direction << (index % 4 * bits_per_step));
+        }
+
+        /// <summary>
+        /// Direction code of a step
+        /// </summary>
+        /// <param name="index"></param>
+        /// <returns></returns>
+        int get_step(const size_t index) const {
+            return codes_[index / 4] >> (index % 4 * bits_per_step) & 3;
+        }
+
+        /// <summary>
+        /// Append a step
+        /// </summary>
+        /// <param name="direction"></param>
+        void push_back(int direction);
+
+        /// <summary>
+        /// Remove every step, the storage is kept
+        /// </summary>
+        void clear() { codes_.clear(); size_ = 0; }
+
+        /// <summary>
+        /// Number of steps
+        /// </summary>
+        /// <returns></returns>
+        size_t size() const { return size_; }
+
+        /// <summary>
+        /// Whether there are no steps
+        /// </summary>
+        /// <returns></returns>
+        bool empty() const { return size_ == 0; }
+
+        /// <summary>
+        /// Cell the path starts from
+        /// </summary>
+        /// <returns></returns>
+        point_2d get_start() const { return start_; }
+
+        /// <summary>
+        /// Packed direction codes, (size() + 3) / 4 bytes
+        /// </summary>
+        /// <returns></returns>
+        const std::uint8_t* get_codes() const { return codes_.data(); }
+
+        /// <summary>
+        /// Bytes allocated for the direction codes
+        /// </summary>
+        /// <returns></returns>
+        size_t get_memory_size() const { return codes_.capacity(); }
+
+        /// <summary>
+        /// Resource the direction codes are allocated from
+        /// </summary>
+        /// <returns></returns>
+        std::pmr::memory_resource* get_resource() const { return codes_.get_allocator().resource(); }
+
+        /// <summary>
+        /// Iterator on the first step's position
+        /// </summary>
+        /// <returns></returns>
+        const_iterator begin() const {
+            return const_iterator(this, 0, empty() ? start_ : start_ + directions[get_step(0)]);
+        }
+
+        /// <summary>
+        /// Iterator past the last step
+        /// </summary>
+        /// <returns></returns>
+        const_iterator end() const { return const_iterator(this, size_, point_2d()); }
+
+        /// <summary>
+        /// Decode every step into points, e.g. to compare against a vector path
+        /// </summary>
+        /// <returns></returns>
+        std::vector<point_2d> to_points() const { return std::vector<point_2d>(begin(), end()); }
+
+    private:
+
+        /// <summary>
+        /// Start cell
+        /// </summary>
+        point_2d start_;
+
+        /// <summary>
+        /// Number of steps
+        /// </summary>
+        size_t size_ = 0;
+
+        /// <summary>
+        /// Direction codes, four per byte starting at the low bits
+        /// </summary>
+        std::pmr::vector<std::uint8_t> codes_;
+    };
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/mappedFile.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Compressed path database (CPD) for maps that never change
+    /// For every source cell it stores the first move of an optimal path to every target cell.
+    /// Targets are ordered along a Z-order (Morton) curve so nearby targets share first moves,
+    /// and each source's first move row is run length encoded over that order.
+    /// A query walks the path by repeated first move lookups (one binary search per step).
+    /// Built offline in parallel, saved next to the map and memory mapped on load.
+    /// Occupancy is not part of the database, see pathfinder::find_path_from_database
+    /// </summary>
+    class compressed_path_database {
+    public:
+
+        /// <summary>
+        /// Build the database with one BFS per walkable source cell, sources are processed in parallel
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <returns></returns>
+        static compressed_path_database build(const battle_field& battle_field);
+
+        /// <summary>
+        /// Memory map a saved database, throws when the file does not belong to the given battlefield
+        /// </summary>
+        /// <param name="filename"></param>
+        /// <param name="battle_field"></param>
+        /// <returns></returns>
+        static compressed_path_database load(const std::string& filename, const battle_field& battle_field);
+
+        /// <summary>
+        /// File name of the database saved alongside the given map file
+        /// </summary>
+        /// <param name="map_filename"></param>
+        /// <returns></returns>
+        static std::string default_filename(const std::string& map_filename) { return map_filename + file_extension; }
+
+        /// <summary>
+        /// Extension of saved database files
+        /// </summary>
+        static constexpr const char* file_extension = ".cpd";
+
+        /// <summary>
+        /// Write the database in one go
+        /// </summary>
+        /// <param name="filename"></param>
+        void save(const std::string& filename) const;
+
+        compressed_path_database(compressed_path_database&&) noexcept = default;
+        compressed_path_database& operator=(compressed_path_database&&) noexcept = default;
+        compressed_path_database(const compressed_path_database&) = delete;
+        compressed_path_database& operator=(const compressed_path_database&) = delete;
+
+        /// <summary>
+        /// Index of the first move (up, down, left, right) of an optimal path, -1 when there is none
+        /// </summary>
+        /// <param name="from"></param>
+        /// <param name="to"></param>
+        /// <returns></returns>
+        int first_move(point_2d from, point_2d to) const;
+
+        /// <summary>
+        /// Optimal path from start (excluded) to goal by repeated first move lookups, empty when there is none
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <returns></returns>
+        std::vector<point_2d> extract_path(point_2d start, point_2d goal) const;
+
+        /// <summary>
+        /// Number of runs over all sources
+        /// </summary>
+        /// <returns></returns>
+        size_t get_run_count() const { return static_cast<size_t>(run_count_); }
+
+        /// <summary>
+        /// Size of the database in bytes
+        /// </summary>
+        /// <returns></returns>
+        size_t get_memory_size() const;
+
+        /// <summary>
+        /// Moves in first move order: up, down, left, right
+        /// </summary>
+        static const point_2d moves[4];
+
+    private:
+
+        compressed_path_database() = default;
+
+        /// <summary>
+        /// Width and height of the grid
+        /// </summary>
+        int width_ = 0, height_ = 0;
+
+        /// <summary>
+        /// Content hash of the battlefield the database was built for
+        /// </summary>
+        std::uint64_t map_hash_ = 0;
+
+        /// <summary>
+        /// Number of runs
+        /// </summary>
+        std::uint64_t run_count_ = 0;
+
+        /// <summary>
+        /// Views on the data, into the owned vectors after a build or into the mapped file after a load
+        /// ranks: Z-order rank of each cell (no_rank for elevated cells)
+        /// components: connected area of each cell
+        /// offsets: first run of each source cell, one extra entry at the end
+        /// runs: (first target rank << 3) | move
+        /// </summary>
+        const std::uint32_t* ranks_ = nullptr;
+        const std::uint32_t* components_ = nullptr;
+        const std::uint64_t* offsets_ = nullptr;
+        const std::uint32_t* runs_ = nullptr;
+
+        /// <summary>
+        /// Storage after a build
+        /// </summary>
+        std::vector<std::uint32_t> owned_ranks_, owned_components_, owned_runs_;
+        std::vector<std::uint64_t> owned_offsets_;
+
+        /// <summary>
+        /// Storage after a load
+        /// </summary>
+        std::unique_ptr<mapped_file> file_;
+
+        /// <summary>
+        /// Rank of cells which are not targets
+        /// </summary>
+        static constexpr std::uint32_t no_rank = 0xFFFFFFFF;
+
+        /// <summary>
+        /// Number of cells in the grid
+        /// </summary>
+        /// <returns></returns>
+        size_t cell_count() const { return static_cast<size_t>(width_) * height_; }
+    };
+}
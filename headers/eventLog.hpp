@@ -0,0 +1,229 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/moveStatus.hpp"
+#include "../headers/point2d.hpp"
+#include "../headers/simulationSnapshot.hpp"
+#include "../headers/tileType.hpp"
+#include "../headers/unit.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Kind of a logged event
+    /// </summary>
+    enum class event_type : std::uint8_t
+    {
+        tick,
+        move,
+        move_to_nearest,
+        map_edit,
+        seed
+    };
+
+    /// <summary>
+    /// One logged event, fixed size so the log is written and read as a single block
+    /// </summary>
+    struct event {
+
+        /// <summary>
+        /// Kind of the event
+        /// </summary>
+        event_type type;
+
+        /// <summary>
+        /// move_status after a move, tile_type of a map edit
+        /// </summary>
+        std::uint8_t value;
+
+        /// <summary>
+        /// 1 when the move computed a new path (replan), 0 when it followed its current path
+        /// </summary>
+        std::uint8_t replanned;
+
+        std::uint8_t reserved;
+
+        /// <summary>
+        /// Index of the moved unit
+        /// </summary>
+        std::uint32_t unit;
+
+        /// <summary>
+        /// Target of a move, min corner of a map edit, low and high halves of the generator seed of a seed event
+        /// </summary>
+        point_2d first;
+
+        /// <summary>
+        /// Position after a move, max corner of a map edit
+        /// </summary>
+        point_2d second;
+    };
+
+    /// <summary>
+    /// Outcome of replaying a log
+    /// </summary>
+    struct replay_result {
+
+        /// <summary>
+        /// Number of ticks, moves, replans and blocked moves replayed
+        /// </summary>
+        size_t ticks = 0, moves = 0, replans = 0, blocks = 0;
+
+        /// <summary>
+        /// Number of moves whose status, replan or position differ from the log, and of seeds the restored map does not match
+        /// </summary>
+        size_t mismatches = 0;
+
+        /// <summary>
+        /// Index of the first mismatching event, the event count when there is none
+        /// </summary>
+        size_t first_mismatch = 0;
+
+        /// <summary>
+        /// Nodes expanded by the searches
+        /// </summary>
+        size_t expanded_nodes = 0;
+
+        /// <summary>
+        /// Time spent in the unit moves only (searches and steps), map edits and verification are not timed
+        /// </summary>
+        std::chrono::nanoseconds engine_time{ 0 };
+
+        /// <summary>
+        /// Whether every outcome matched the log
+        /// </summary>
+        /// <returns></returns>
+        bool identical() const { return mismatches == 0; }
+    };
+
+    /// <summary>
+    /// Deterministic log of a simulation run: the initial state with the map, a seed event with the seed the map was
+    /// generated from, then per tick the unit moves with their outcome and the map edits in the order they happened.
+    /// Moves and edits are recorded by performing them through the log.
+    /// replay() feeds the same inputs through a fresh pathfinder and units, checks that every outcome is identical
+    /// and times only the engine, so a log serves both as a regression oracle and as a stable benchmark workload
+    /// </summary>
+    class event_log {
+    public:
+
+        /// <summary>
+        /// Start a new log from the current state of the simulation
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="units"></param>
+        /// <param name="occupied_positions"></param>
+        void begin(const battle_field& battle_field, const std::vector<unit>& units,
+            const std::unordered_set<point_2d>& occupied_positions);
+
+        /// <summary>
+        /// Move a unit towards the target and record it
+        /// </summary>
+        /// <param name="units"></param>
+        /// <param name="unit_index"></param>
+        /// <param name="target"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        move_status move(std::vector<unit>& units, size_t unit_index, point_2d target,
+            std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// Move a unit towards the nearest target position of the battlefield and record it
+        /// </summary>
+        /// <param name="units"></param>
+        /// <param name="unit_index"></param>
+        /// <param name="battle_field"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        move_status move_to_nearest(std::vector<unit>& units, size_t unit_index, const battle_field& battle_field,
+            std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// Edit the map and record it
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="min"></param>
+        /// <param name="max"></param>
+        /// <param name="type"></param>
+        void set_tiles(battle_field& battle_field, point_2d min, point_2d max, tile_type type);
+
+        /// <summary>
+        /// Publish the map changes of the tick and record the tick boundary
+        /// </summary>
+        /// <param name="battle_field"></param>
+        void end_tick(battle_field& battle_field);
+
+        /// <summary>
+        /// Replay driver: run the logged inputs from the initial state and compare every outcome
+        /// </summary>
+        /// <param name="scratch_resource">Upstream for the search arenas</param>
+        /// <returns></returns>
+        replay_result replay(std::pmr::memory_resource* scratch_resource = nullptr) const;
+
+        /// <summary>
+        /// Write the initial state and the events
+        /// </summary>
+        /// <param name="filename"></param>
+        void save(const std::string& filename) const;
+
+        /// <summary>
+        /// Read a saved log, throws when the file is not a valid log of this build
+        /// </summary>
+        /// <param name="filename"></param>
+        void load(const std::string& filename);
+
+        /// <summary>
+        /// Logged events
+        /// </summary>
+        /// <returns></returns>
+        const std::vector<event>& get_events() const { return events_; }
+
+        /// <summary>
+        /// State the log starts from
+        /// </summary>
+        /// <returns></returns>
+        const simulation_snapshot& get_initial_state() const { return initial_state_; }
+
+        /// <summary>
+        /// Number of completed ticks
+        /// </summary>
+        /// <returns></returns>
+        size_t get_tick_count() const { return tick_count_; }
+
+    private:
+
+        /// <summary>
+        /// State at begin()
+        /// </summary>
+        simulation_snapshot initial_state_;
+
+        /// <summary>
+        /// Events in the order they happened
+        /// </summary>
+        std::vector<event> events_;
+
+        /// <summary>
+        /// Number of tick events
+        /// </summary>
+        size_t tick_count_ = 0;
+
+        /// <summary>
+        /// Record a move with its outcome
+        /// </summary>
+        /// <param name="type"></param>
+        /// <param name="unit_index"></param>
+        /// <param name="target"></param>
+        /// <param name="replanned"></param>
+        /// <param name="status"></param>
+        /// <param name="position"></param>
+        void record_move(event_type type, size_t unit_index, point_2d target, bool replanned, move_status status, point_2d position);
+    };
+}
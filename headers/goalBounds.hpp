@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/mappedFile.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Goal bounding for maps that rarely change
+    /// For every cell and every move (up, down, left, right) it stores the bounding box of all the targets
+    /// an optimal path to which starts with that move. A search only takes a move whose box contains its goal,
+    /// which prunes most of the edges without an abstract graph and without giving up optimality.
+    /// Every target is in the box of one optimal first move, the one the BFS reaches it through.
+    /// Built offline with one BFS per cell in parallel, saved next to the map and memory mapped on load.
+    /// Occupancy is not part of the bounds, see pathfinder::set_goal_bounds
+    /// </summary>
+    class goal_bounds {
+    public:
+
+        /// <summary>
+        /// Targets of one move, empty when min is above max
+        /// </summary>
+        struct bounding_box {
+            std::int16_t min_x, min_y, max_x, max_y;
+        };
+
+        /// <summary>
+        /// Build the bounds with one BFS per walkable source cell, sources are processed in parallel
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <returns></returns>
+        static goal_bounds build(const battle_field& battle_field);
+
+        /// <summary>
+        /// Memory map saved bounds, throws when the file does not belong to the given battlefield
+        /// </summary>
+        /// <param name="filename"></param>
+        /// <param name="battle_field"></param>
+        /// <returns></returns>
+        static goal_bounds load(const std::string& filename, const battle_field& battle_field);
+
+        /// <summary>
+        /// File name of the bounds saved alongside the given map file
+        /// </summary>
+        /// <param name="map_filename"></param>
+        /// <returns></returns>
+        static std::string default_filename(const std::string& map_filename) { return map_filename + file_extension; }
+
+        /// <summary>
+        /// Extension of saved bounds files
+        /// </summary>
+        static constexpr const char* file_extension = ".gb";
+
+        /// <summary>
+        /// Write the bounds in one go
+        /// </summary>
+        /// <param name="filename"></param>
+        void save(const std::string& filename) const;
+
+        goal_bounds(goal_bounds&&) noexcept = default;
+        goal_bounds& operator=(goal_bounds&&) noexcept = default;
+        goal_bounds(const goal_bounds&) = delete;
+        goal_bounds& operator=(const goal_bounds&) = delete;
+
+        /// <summary>
+        /// Whether an optimal path from the cell to the goal may start with the move, from must be inside the grid
+        /// </summary>
+        /// <param name="from"></param>
+        /// <param name="move">Index in moves</param>
+        /// <param name="goal"></param>
+        /// <returns></returns>
+        bool may_lead_to(const point_2d from, const size_t move, const point_2d goal) const {
+            const auto& box = boxes_[(static_cast<size_t>(from.get_y()) * width_ + from.get_x()) * 4 + move];
+            return goal.get_x() >= box.min_x && goal.get_x() <= box.max_x && goal.get_y() >= box.min_y && goal.get_y() <= box.max_y;
+        }
+
+        /// <summary>
+        /// Box of the targets of a move
+        /// </summary>
+        /// <param name="from"></param>
+        /// <param name="move"></param>
+        /// <returns></returns>
+        const bounding_box& get_box(const point_2d from, const size_t move) const {
+            return boxes_[(static_cast<size_t>(from.get_y()) * width_ + from.get_x()) * 4 + move];
+        }
+
+        /// <summary>
+        /// Content hash of the battlefield the bounds were built for
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_map_hash() const { return map_hash_; }
+
+        /// <summary>
+        /// Size of the bounds in bytes
+        /// </summary>
+        /// <returns></returns>
+        size_t get_memory_size() const { return cell_count() * 4 * sizeof(bounding_box); }
+
+        /// <summary>
+        /// Moves in the order of the boxes, the same as the pathfinder directions: up, down, left, right
+        /// </summary>
+        static const point_2d moves[4];
+
+    private:
+
+        goal_bounds() = default;
+
+        /// <summary>
+        /// Width and height of the grid
+        /// </summary>
+        int width_ = 0, height_ = 0;
+
+        /// <summary>
+        /// Content hash of the battlefield the bounds were built for
+        /// </summary>
+        std::uint64_t map_hash_ = 0;
+
+        /// <summary>
+        /// Four boxes per cell in row major order, into the owned vector after a build or into the mapped file after a load
+        /// </summary>
+        const bounding_box* boxes_ = nullptr;
+
+        /// <summary>
+        /// Storage after a build
+        /// </summary>
+        std::vector<bounding_box> owned_boxes_;
+
+        /// <summary>
+        /// Storage after a load
+        /// </summary>
+        std::unique_ptr<mapped_file> file_;
+
+        /// <summary>
+        /// Number of cells in the grid
+        /// </summary>
+        /// <returns></returns>
+        size_t cell_count() const { return static_cast<size_t>(width_) * height_; }
+    };
+}
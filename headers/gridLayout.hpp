@@ -0,0 +1,177 @@
+#pragma once
+
+#include "../headers/point2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// pdep/pext encode Morton codes in one instruction each (x86-64 with BMI2, e.g. built with -mbmi2 or PATH_FINDING_BMI2)
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#include <immintrin.h>
+#define PATH_FINDING_HAS_BMI2 1
+#endif
+
+namespace path_finding
+{
+    /// <summary>
+    /// Order of the cells of a grid in memory
+    /// </summary>
+    enum class grid_layout_type {
+
+        /// <summary>
+        /// Row after row, the neighbours above and below a cell are a whole row away
+        /// </summary>
+        row_major,
+
+        /// <summary>
+        /// Square blocks row after row, Z-order inside a block: the four neighbours of a cell are mostly a few cache
+        /// lines away and a search stays within a few pages. The grid is padded to whole blocks
+        /// </summary>
+        morton
+    };
+
+    /// <summary>
+    /// Maps the cells of a width x height grid to indexes of a flat array in the order of the layout type,
+    /// shared by the tiles of a battlefield and the per cell arrays built from it
+    /// </summary>
+    class grid_layout {
+    public:
+
+        /// <summary>
+        /// Side of a Morton block is 2^block_bits cells, a block of tiles is one 4 KiB page
+        /// </summary>
+        static constexpr int block_bits = 6;
+        static constexpr int block_side = 1 << block_bits;
+
+        /// <summary>
+        /// Row major layout of an empty grid
+        /// </summary>
+        grid_layout() = default;
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="type"></param>
+        /// <param name="width"></param>
+        /// <param name="height"></param>
+        grid_layout(grid_layout_type type, int width, int height);
+
+        /// <summary>
+        /// Order of the cells
+        /// </summary>
+        /// <returns></returns>
+        grid_layout_type get_type() const { return type_; }
+
+        /// <summary>
+        /// Size of an array holding every cell, padding included
+        /// </summary>
+        /// <returns></returns>
+        size_t get_cell_count() const { return cell_count_; }
+
+        /// <summary>
+        /// Array index of the position, the position must be inside the grid
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        size_t index_of(const point_2d position) const {
+            const auto x = static_cast<std::uint32_t>(position.get_x());
+            const auto y = static_cast<std::uint32_t>(position.get_y());
+            if (type_ == grid_layout_type::row_major)
+                return static_cast<size_t>(y) * width_ + x;
+            const auto block = static_cast<size_t>(y >> block_bits) * blocks_per_row_ + (x >> block_bits);
+            return (block << (2 * block_bits)) | static_cast<size_t>(morton_encode(x & block_mask, y & block_mask));
+        }
+
+        /// <summary>
+        /// Position of an array index, padding cells lie outside the grid
+        /// </summary>
+        /// <param name="index"></param>
+        /// <returns></returns>
+        point_2d position_of(const size_t index) const {
+            if (type_ == grid_layout_type::row_major)
+                return point_2d(static_cast<int>(index % width_), static_cast<int>(index / width_));
+            const auto block = index >> (2 * block_bits);
+            std::uint32_t x, y;
+            morton_decode(index & ((size_t(1) << (2 * block_bits)) - 1), x, y);
+            return point_2d(static_cast<int>((block % blocks_per_row_) << block_bits | x),
+                static_cast<int>((block / blocks_per_row_) << block_bits | y));
+        }
+
+        /// <summary>
+        /// Z-order code: the bits of x and y interleaved, x in the even bits
+        /// </summary>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        /// <returns></returns>
+        static std::uint64_t morton_encode(const std::uint32_t x, const std::uint32_t y) {
+#ifdef PATH_FINDING_HAS_BMI2
+            return _pdep_u64(x, 0x5555555555555555ull) | _pdep_u64(y, 0xAAAAAAAAAAAAAAAAull);
+#else
+            return spread_bits(x) | (spread_bits(y) << 1);
+#endif
+        }
+
+        /// <summary>
+        /// Coordinates of a Z-order code
+        /// </summary>
+        /// <param name="code"></param>
+        /// <param name="x"></param>
+        /// <param name="y"></param>
+        static void morton_decode(const std::uint64_t code, std::uint32_t& x, std::uint32_t& y) {
+#ifdef PATH_FINDING_HAS_BMI2
+            x = static_cast<std::uint32_t>(_pext_u64(code, 0x5555555555555555ull));
+            y = static_cast<std::uint32_t>(_pext_u64(code, 0xAAAAAAAAAAAAAAAAull));
+#else
+            x = compact_bits(code);
+            y = compact_bits(code >> 1);
+#endif
+        }
+
+    private:
+
+        static constexpr std::uint32_t block_mask = block_side - 1;
+
+        /// <summary>
+        /// Spread the 32 bits of v over the even bits of the result
+        /// </summary>
+        /// <param name="v"></param>
+        /// <returns></returns>
+        static std::uint64_t spread_bits(std::uint64_t v) {
+            v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+            v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v << 2)) & 0x3333333333333333ull;
+            v = (v | (v << 1)) & 0x5555555555555555ull;
+            return v;
+        }
+
+        /// <summary>
+        /// Gather the even bits of v, inverse of spread_bits
+        /// </summary>
+        /// <param name="v"></param>
+        /// <returns></returns>
+        static std::uint32_t compact_bits(std::uint64_t v) {
+            v &= 0x5555555555555555ull;
+            v = (v | (v >> 1)) & 0x3333333333333333ull;
+            v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v >> 4)) & 0x00FF00FF00FF00FFull;
+            v = (v | (v >> 8)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+            return static_cast<std::uint32_t>(v);
+        }
+
+        grid_layout_type type_ = grid_layout_type::row_major;
+
+        /// <summary>
+        /// Row length of the row major layout
+        /// </summary>
+        size_t width_ = 0;
+
+        /// <summary>
+        /// Blocks per row of blocks of the Morton layout
+        /// </summary>
+        size_t blocks_per_row_ = 0;
+
+        size_t cell_count_ = 0;
+    };
+}
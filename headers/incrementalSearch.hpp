@@ -0,0 +1,171 @@
+#pragma once
+
+#include "../headers/compactPath.hpp"
+#include "../headers/node.hpp"
+#include "../headers/pathFinder.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// State of an incremental search
+    /// </summary>
+    enum class search_state
+    {
+        running,
+        found,
+        no_path
+    };
+
+    /// <summary>
+    /// A* search that can be advanced by a number of expansions at a time, e.g. a few hundred per unit per tick,
+    /// so a long query never blows the frame budget.
+    /// While it runs, get_path gives the best partial path: towards the expanded node closest to the goal (lowest h).
+    /// Occupancy is read at every advance: positions occupied when they are reached are put aside and offered again
+    /// once they are free, an open node that became occupied is put aside when popped.
+    /// Tile changes invalidate the search tree, the search restarts when the battlefield version changed
+    /// </summary>
+    class incremental_search {
+    public:
+
+        /// <summary>
+        /// Constructor, nothing is expanded until the first advance
+        /// </summary>
+        /// <param name="path_finder">Gives the battlefield and the landmarks</param>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="resource">Resource the search state is allocated from, it lives across ticks</param>
+        incremental_search(const pathfinder& path_finder, point_2d start, point_2d goal,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        /// <summary>
+        /// Expand up to the given number of nodes
+        /// </summary>
+        /// <param name="max_expansions"></param>
+        /// <param name="occupied_positions"></param>
+        /// <returns></returns>
+        search_state advance(size_t max_expansions, const std::unordered_set<point_2d>& occupied_positions);
+
+        /// <summary>
+        /// Drop the search tree and start again from the given position
+        /// </summary>
+        /// <param name="start"></param>
+        void restart(point_2d start);
+
+        /// <summary>
+        /// Path from the given position to the goal once found, or towards the best node so far while running.
+        /// The position must be in the search tree (the start or a cell of an earlier path), otherwise the path is empty
+        /// </summary>
+        /// <param name="position"></param>
+        /// <param name="path"></param>
+        void get_path(point_2d position, compact_path& path) const;
+
+        /// <summary>
+        /// Whether the battlefield changed since the search started
+        /// </summary>
+        /// <returns></returns>
+        bool is_stale() const;
+
+        /// <summary>
+        /// Current state
+        /// </summary>
+        /// <returns></returns>
+        search_state get_state() const { return state_; }
+
+        /// <summary>
+        /// Start of the search
+        /// </summary>
+        /// <returns></returns>
+        point_2d get_start() const { return start_; }
+
+        /// <summary>
+        /// Goal of the search
+        /// </summary>
+        /// <returns></returns>
+        point_2d get_goal() const { return goal_; }
+
+        /// <summary>
+        /// Node the partial path leads to: the expanded node with the lowest h, ties broken by the lowest g
+        /// </summary>
+        /// <returns></returns>
+        point_2d get_best_node() const { return best_node_; }
+
+        /// <summary>
+        /// Number of nodes expanded since the search (re)started
+        /// </summary>
+        /// <returns></returns>
+        size_t get_expanded_node_count() const { return expanded_; }
+
+    private:
+
+        /// <summary>
+        /// Candidate predecessor of a position that was occupied when it was reached
+        /// </summary>
+        struct deferred_node {
+            point_2d parent;
+            float g_cost;
+        };
+
+        const pathfinder* path_finder_;
+        point_2d start_, goal_;
+        std::uint64_t version_;
+        search_state state_ = search_state::running;
+        point_2d best_node_;
+        float best_h_ = 0, best_g_ = 0;
+        size_t expanded_ = 0;
+
+        /// <summary>
+        /// Search tree and frontier
+        /// </summary>
+        std::pmr::unordered_map<point_2d, float> g_score_;
+        std::pmr::unordered_map<point_2d, point_2d> came_from_;
+        std::pmr::unordered_set<point_2d> closed_;
+        std::priority_queue<node, std::pmr::vector<node>, std::greater<node>> open_set_;
+
+        /// <summary>
+        /// Positions put aside because they were occupied
+        /// </summary>
+        std::pmr::unordered_map<point_2d, deferred_node> deferred_;
+
+        /// <summary>
+        /// Buffers of get_path, kept so the per tick calls do not allocate: the branch to the end node with the index
+        /// of each of its cells, and the climb from the unit's position
+        /// </summary>
+        mutable std::pmr::vector<point_2d> branch_, climb_;
+        mutable std::pmr::unordered_map<point_2d, size_t> branch_index_;
+
+        /// <summary>
+        /// Manhattan distance to the goal, tightened by the landmarks when available
+        /// </summary>
+        landmark_heuristic::goal_bound landmark_bound_;
+
+        /// <summary>
+        /// Heuristic estimate to the goal
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        float estimate(point_2d position) const;
+
+        /// <summary>
+        /// Open a position through the given predecessor when it improves its cost
+        /// </summary>
+        /// <param name="position"></param>
+        /// <param name="parent"></param>
+        /// <param name="g_cost"></param>
+        void relax(point_2d position, point_2d parent, float g_cost);
+
+        /// <summary>
+        /// Open the deferred positions which are free again
+        /// </summary>
+        /// <param name="occupied_positions"></param>
+        void reopen_deferred(const std::unordered_set<point_2d>& occupied_positions);
+    };
+}
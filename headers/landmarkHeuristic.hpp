@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// ALT (A*, Landmarks, Triangle inequality) heuristic
+    /// Stores the BFS distance from K landmarks to every cell, by the triangle inequality
+    /// |d(L, goal) - d(L, n)| is a lower bound of d(n, goal) for every landmark L
+    /// Distances are kept as uint16 per cell per landmark, all landmarks of a cell side by side so one lookup is one cache line
+    /// Occupied positions only remove moves, so the bound stays admissible while units move around
+    /// </summary>
+    class landmark_heuristic {
+    public:
+
+        /// <summary>
+        /// Distance of cells a landmark cannot reach
+        /// </summary>
+        static constexpr std::uint16_t unreachable = 0xFFFF;
+
+        /// <summary>
+        /// Largest stored distance, longer distances saturate which keeps the bound admissible
+        /// </summary>
+        static constexpr std::uint16_t max_distance = 0xFFFE;
+
+        /// <summary>
+        /// Constructor, selects the landmarks by farthest point selection
+        /// 1. First landmark is the walkable cell farthest from the first walkable cell
+        /// 2. Every next landmark is the cell farthest from all landmarks chosen so far,
+        ///    cells that no landmark reaches yet come first so every connected area gets one
+        /// The BFS of each selection step is kept as that landmark's distance table
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="number_of_landmarks"></param>
+        landmark_heuristic(const battle_field& battle_field, size_t number_of_landmarks);
+
+        /// <summary>
+        /// Constructor with given landmarks, the distance tables are built in parallel
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="landmarks"></param>
+        landmark_heuristic(const battle_field& battle_field, std::vector<point_2d> landmarks);
+
+        /// <summary>
+        /// Rebuild every distance table in parallel, e.g. after the map changed.
+        /// Farthest point selection keeps the tables of its own searches and does not call it
+        /// </summary>
+        void rebuild();
+
+        /// <summary>
+        /// Lower bound of the distance between two cells, 0 when no landmark can tell
+        /// </summary>
+        /// <param name="from"></param>
+        /// <param name="to"></param>
+        /// <returns></returns>
+        float estimate(point_2d from, point_2d to) const;
+
+        /// <summary>
+        /// Lower bound towards a fixed goal whose distances are looked up once
+        /// </summary>
+        class goal_bound {
+        public:
+
+            /// <summary>
+            /// Lower bound of the distance from the given cell to the goal
+            /// </summary>
+            /// <param name="from"></param>
+            /// <returns></returns>
+            float operator()(point_2d from) const;
+
+        private:
+            friend class landmark_heuristic;
+
+            /// <summary>
+            /// Owner
+            /// </summary>
+            const landmark_heuristic* landmarks_ = nullptr;
+
+            /// <summary>
+            /// Distances from every landmark to the goal (a row of the tables), null when the goal is outside the grid
+            /// </summary>
+            const std::uint16_t* goal_distances_ = nullptr;
+        };
+
+        /// <summary>
+        /// Bind the heuristic to a goal, does not allocate
+        /// </summary>
+        /// <param name="goal"></param>
+        /// <returns></returns>
+        goal_bound bind(point_2d goal) const;
+
+        /// <summary>
+        /// Selected landmarks
+        /// </summary>
+        /// <returns></returns>
+        const std::vector<point_2d>& get_landmarks() const { return landmarks_; }
+
+        /// <summary>
+        /// Size of the distance tables in bytes
+        /// </summary>
+        /// <returns></returns>
+        size_t get_memory_size() const { return distances_.size() * sizeof(std::uint16_t); }
+
+    private:
+
+        /// <summary>
+        /// Battlefield the distances are measured on
+        /// </summary>
+        const battle_field* battle_field_;
+
+        /// <summary>
+        /// Landmarks
+        /// </summary>
+        std::vector<point_2d> landmarks_;
+
+        /// <summary>
+        /// Distance tables, distances_[cell * landmarks + landmark]
+        /// </summary>
+        std::vector<std::uint16_t> distances_;
+
+        /// <summary>
+        /// Breadth first search from the given cell over walkable cells (occupancy ignored)
+        /// </summary>
+        /// <param name="source"></param>
+        /// <param name="distances">One entry per cell, unreachable for cells that cannot be reached</param>
+        void breadth_first_search(point_2d source, std::vector<std::uint16_t>& distances) const;
+
+        /// <summary>
+        /// Copy one landmark's distances into the interleaved tables of stride landmarks per cell
+        /// </summary>
+        /// <param name="landmark"></param>
+        /// <param name="distances"></param>
+        /// <param name="stride"></param>
+        void store(size_t landmark, const std::vector<std::uint16_t>& distances, size_t stride);
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../headers/point2d.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Cells of the battlefield that changed between two published versions
+    /// Every changed cell is listed once, however often it was edited in between
+    /// </summary>
+    struct map_changes {
+
+        /// <summary>
+        /// Version before the changes
+        /// </summary>
+        std::uint64_t previous_version = 0;
+
+        /// <summary>
+        /// Version after the changes
+        /// </summary>
+        std::uint64_t version = 0;
+
+        /// <summary>
+        /// Changed cells
+        /// </summary>
+        std::vector<point_2d> cells;
+
+        /// <summary>
+        /// Whether anything changed
+        /// </summary>
+        /// <returns></returns>
+        bool empty() const { return cells.empty(); }
+    };
+}
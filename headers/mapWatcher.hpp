@@ -0,0 +1,147 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/point2d.hpp"
+#include "../headers/tileType.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Counters of a map watcher
+    /// </summary>
+    struct map_watcher_metrics {
+
+        /// <summary>
+        /// Files parsed, files rejected by the parser, and grids which replaced the whole battlefield because the size changed
+        /// </summary>
+        size_t reloads = 0, errors = 0, resizes = 0;
+
+        /// <summary>
+        /// Tiles written by the applied reloads
+        /// </summary>
+        size_t applied_tiles = 0;
+    };
+
+    /// <summary>
+    /// Hot reload of the JSON file a battlefield was loaded from.
+    /// A background thread watches the file (inotify on Linux, the modification time elsewhere), parses it again after
+    /// every write and diffs the tiles against the previous version of the file. Only the changed tiles are handed to
+    /// the tick thread, which applies them at the tick boundary with poll() and publishes them as any other edit, so the
+    /// subscribed caches update incrementally. A file which does not parse is skipped, the last good version stays.
+    /// Tiles the game edited itself keep their value unless the file changes them
+    /// </summary>
+    class map_watcher {
+    public:
+
+        /// <summary>
+        /// Constructor, starts watching
+        /// </summary>
+        /// <param name="battle_field">Loaded from the file, must outlive the watcher and is only touched by poll</param>
+        /// <param name="filename">JSON file to watch</param>
+        /// <param name="poll_interval">How often the watcher checks for the stop flag, and the file without inotify</param>
+        map_watcher(battle_field& battle_field, std::string filename,
+            std::chrono::milliseconds poll_interval = std::chrono::milliseconds(100));
+
+        /// <summary>
+        /// Stop the background thread, changes not polled yet are dropped
+        /// </summary>
+        ~map_watcher();
+
+        map_watcher(const map_watcher&) = delete;
+        map_watcher& operator=(const map_watcher&) = delete;
+
+        /// <summary>
+        /// Apply the changes parsed since the last poll to the battlefield, to be called on the tick thread before
+        /// publishing the tick's changes. A file of another size replaces the whole grid, as the loaders do
+        /// </summary>
+        /// <returns>Whether the battlefield changed</returns>
+        bool poll();
+
+        /// <summary>
+        /// Whether the file is watched with inotify rather than by checking its modification time
+        /// </summary>
+        /// <returns></returns>
+        bool is_event_driven() const { return inotify_descriptor_ >= 0; }
+
+        /// <summary>
+        /// Message of the last file which did not parse, empty once a later version parsed
+        /// </summary>
+        /// <returns></returns>
+        std::string get_last_error() const;
+
+        /// <summary>
+        /// Reloads and applied tiles so far
+        /// </summary>
+        /// <returns></returns>
+        map_watcher_metrics get_metrics() const;
+
+    private:
+
+        /// <summary>
+        /// Background loop: wait for a write, let the writer finish, then reload
+        /// </summary>
+        void watch();
+
+        /// <summary>
+        /// Wait for writes with inotify
+        /// </summary>
+        void watch_events();
+
+        /// <summary>
+        /// Wait for writes by comparing the modification time and size of the file
+        /// </summary>
+        void watch_timestamps();
+
+        /// <summary>
+        /// Parse the file and queue its differences to the previous version
+        /// </summary>
+        void reload();
+
+        battle_field* battle_field_;
+        std::string filename_;
+        std::chrono::milliseconds poll_interval_;
+
+        /// <summary>
+        /// Tiles of the last version of the file that parsed, owned by the background thread
+        /// </summary>
+        int baseline_width_, baseline_height_;
+        std::vector<tile_type> baseline_;
+
+        /// <summary>
+        /// Changes waiting for poll, guarded by the mutex: either tiles to change, or a whole grid of a new size
+        /// (with later changes already applied to it)
+        /// </summary>
+        mutable std::mutex mutex_;
+        std::vector<std::pair<point_2d, tile_type>> pending_tiles_;
+        bool pending_resize_ = false;
+        int pending_width_ = 0, pending_height_ = 0;
+        std::vector<tile_type> pending_grid_;
+        std::string last_error_;
+        map_watcher_metrics metrics_;
+
+        /// <summary>
+        /// inotify instance watching the directory of the file, -1 when the modification time is checked instead,
+        /// set up by the constructor so no write after it is missed
+        /// </summary>
+        int inotify_descriptor_ = -1;
+
+        /// <summary>
+        /// Modification time and size of the file at the last check, without inotify
+        /// </summary>
+        std::filesystem::file_time_type last_write_time_;
+        std::uintmax_t last_size_ = 0;
+
+        std::atomic<bool> stopping_{ false };
+        std::thread thread_;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Read only memory mapped file, the content is paged in by the OS on first access
+    /// </summary>
+    class mapped_file {
+    public:
+
+        /// <summary>
+        /// Map the whole file, throws when the file cannot be opened or mapped
+        /// </summary>
+        /// <param name="filename"></param>
+        explicit mapped_file(const std::string& filename);
+
+        ~mapped_file();
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        /// <summary>
+        /// Start of the mapped content
+        /// </summary>
+        /// <returns></returns>
+        const unsigned char* data() const { return data_; }
+
+        /// <summary>
+        /// Size of the mapped content in bytes
+        /// </summary>
+        /// <returns></returns>
+        size_t size() const { return size_; }
+
+    private:
+
+        /// <summary>
+        /// Mapped content
+        /// </summary>
+        const unsigned char* data_;
+
+        /// <summary>
+        /// Size of the content
+        /// </summary>
+        size_t size_;
+
+        /// <summary>
+        /// OS handles (file and mapping on Windows, descriptor on POSIX)
+        /// </summary>
+        void* file_handle_;
+        void* mapping_handle_;
+    };
+}
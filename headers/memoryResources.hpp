@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Memory resource that forwards every request to an upstream resource and counts them,
+    /// so the allocation behaviour of the pathfinder and units can be verified
+    /// Counters are atomic, the resource is as thread safe as its upstream
+    /// </summary>
+    class counting_resource : public std::pmr::memory_resource {
+    public:
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="upstream"></param>
+        explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        /// <summary>
+        /// Number of allocations forwarded to the upstream resource
+        /// </summary>
+        /// <returns></returns>
+        size_t get_allocation_count() const { return allocation_count_.load(std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Number of deallocations forwarded to the upstream resource
+        /// </summary>
+        /// <returns></returns>
+        size_t get_deallocation_count() const { return deallocation_count_.load(std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Total number of bytes ever allocated
+        /// </summary>
+        /// <returns></returns>
+        size_t get_bytes_allocated() const { return bytes_allocated_.load(std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Number of bytes currently allocated and not yet released
+        /// </summary>
+        /// <returns></returns>
+        size_t get_bytes_in_use() const { return bytes_in_use_.load(std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Reset all the counters to zero (bytes in use is kept as it reflects live memory)
+        /// </summary>
+        void reset_counters();
+
+    private:
+
+        /// <summary>
+        /// Upstream resource
+        /// </summary>
+        std::pmr::memory_resource* upstream_;
+
+        /// <summary>
+        /// Counters
+        /// </summary>
+        std::atomic<size_t> allocation_count_, deallocation_count_, bytes_allocated_, bytes_in_use_;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    /// <summary>
+    /// Monotonic arena for transient data that lives for one tick of the game loop
+    /// Everything allocated from it is released in one shot by reset()
+    /// Not thread safe, use one arena per thread
+    /// </summary>
+    class tick_arena {
+    public:
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="initial_size"></param>
+        /// <param name="upstream"></param>
+        explicit tick_arena(size_t initial_size = 64 * 1024,
+            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        tick_arena(const tick_arena&) = delete;
+        tick_arena& operator=(const tick_arena&) = delete;
+
+        /// <summary>
+        /// Resource to allocate the transient data from
+        /// </summary>
+        /// <returns></returns>
+        std::pmr::memory_resource* resource() { return &arena_; }
+
+        /// <summary>
+        /// Release everything allocated during the tick
+        /// </summary>
+        void reset() { arena_.release(); }
+
+        /// <summary>
+        /// Allocation counters of the memory requested from the upstream
+        /// </summary>
+        /// <returns></returns>
+        const counting_resource& get_counter() const { return counter_; }
+
+    private:
+
+        /// <summary>
+        /// Counts the blocks requested by the arena
+        /// </summary>
+        counting_resource counter_;
+
+        /// <summary>
+        /// Arena
+        /// </summary>
+        std::pmr::monotonic_buffer_resource arena_;
+    };
+
+    /// <summary>
+    /// Thread safe pool for long lived allocations such as unit paths
+    /// Paths of similar size are recycled instead of going back to the global allocator
+    /// </summary>
+    class path_pool {
+    public:
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="upstream"></param>
+        explicit path_pool(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+        path_pool(const path_pool&) = delete;
+        path_pool& operator=(const path_pool&) = delete;
+
+        /// <summary>
+        /// Resource to allocate the paths from
+        /// </summary>
+        /// <returns></returns>
+        std::pmr::memory_resource* resource() { return &pool_; }
+
+        /// <summary>
+        /// Allocation counters of the memory requested from the upstream
+        /// </summary>
+        /// <returns></returns>
+        const counting_resource& get_counter() const { return counter_; }
+
+    private:
+
+        /// <summary>
+        /// Counts the chunks requested by the pool
+        /// </summary>
+        counting_resource counter_;
+
+        /// <summary>
+        /// Pool
+        /// </summary>
+        std::pmr::synchronized_pool_resource pool_;
+    };
+}
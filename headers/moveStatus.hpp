@@ -10,6 +10,13 @@ namespace path_finding
         at_target,
         no_path,
         blocked,
-        moved
+        moved,
+        searching,
+
+        // Conflict resolution of the unit_store
+        yielding,       // waits for the unit in its way or backs off, without searching
+        swapped,        // exchanged cells with a unit coming the opposite way, or rotated with a wait-for cycle
+        detoured,       // gave way in a wait-for cycle or to a unit that does not move, replans around it
+        oscillating     // moved back and forth between two cells, backs off before replanning
     };
 }
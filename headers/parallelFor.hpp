@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Run body(i) for every i in [0, count) on a set of worker threads
+    /// Work items are handed out one at a time, so uneven items are balanced between the threads
+    /// The first exception thrown by body is rethrown on the calling thread once all threads are done
+    /// </summary>
+    /// <param name="count"></param>
+    /// <param name="body"></param>
+    /// <param name="number_of_threads">0 uses std::thread::hardware_concurrency</param>
+    void parallel_for(size_t count, const std::function<void(size_t)>& body, unsigned number_of_threads = 0);
+}
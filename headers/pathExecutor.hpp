@@ -0,0 +1,320 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/moveStatus.hpp"
+#include "../headers/point2d.hpp"
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Coroutine of a unit's logic, owned by a path_executor once spawned.
+    /// It does not run before it is spawned and is resumed by the executor's tick only
+    /// </summary>
+    class unit_task {
+    public:
+
+        struct promise_type {
+            unit_task get_return_object() { return unit_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { exception = std::current_exception(); }
+
+            /// <summary>
+            /// Exception the logic ended with, rethrown by the executor's tick
+            /// </summary>
+            std::exception_ptr exception;
+        };
+
+        unit_task(unit_task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+        unit_task& operator=(unit_task&& other) noexcept {
+            if (this != &other) {
+                if (handle_)
+                    handle_.destroy();
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+        unit_task(const unit_task&) = delete;
+        unit_task& operator=(const unit_task&) = delete;
+
+        ~unit_task() {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        /// <summary>
+        /// Whether the logic ran to its end
+        /// </summary>
+        /// <returns></returns>
+        bool done() const { return !handle_ || handle_.done(); }
+
+    private:
+
+        friend class path_executor;
+
+        explicit unit_task(const std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    /// <summary>
+    /// State of a unit driven by follow_path
+    /// </summary>
+    struct async_unit {
+
+        /// <summary>
+        /// Cell of the unit
+        /// </summary>
+        point_2d position;
+
+        /// <summary>
+        /// Last outcome: searching while it has no path yet, moved, blocked, no_path or at_target
+        /// </summary>
+        move_status status = move_status::searching;
+
+        /// <summary>
+        /// Path being followed (start excluded), the next step, and the map version it was searched on
+        /// </summary>
+        std::vector<point_2d> path;
+        size_t path_index = 0;
+        std::uint64_t path_version = 0;
+    };
+
+    /// <summary>
+    /// Counters of a path executor
+    /// </summary>
+    struct path_executor_metrics {
+
+        /// <summary>
+        /// Requests submitted, fulfilled by the workers, and results dropped because the map changed in the meantime
+        /// </summary>
+        size_t requests = 0, fulfilled = 0, stale = 0;
+
+        /// <summary>
+        /// Coroutines resumed by the ticks
+        /// </summary>
+        size_t resumed = 0;
+    };
+
+    /// <summary>
+    /// Game loop executor for unit logic written as coroutines: a unit co_awaits a path instead of blocking the tick on a search.
+    /// Requests are searched by a pool of worker threads on the published snapshot of the battlefield (battle_field::get_snapshot),
+    /// the requesting coroutine is resumed by the first tick after the result arrived. A result searched on another map version
+    /// than the latest published one is stale and handed over as nullopt, the unit asks again.
+    /// Coroutines, the battlefield and the occupied positions belong to the tick thread, only the workers run elsewhere
+    /// </summary>
+    class path_executor {
+
+        /// <summary>
+        /// A request shared between its awaitable and the worker searching it
+        /// </summary>
+        struct request_state {
+            point_2d start, goal;
+            std::shared_ptr<const std::unordered_set<point_2d>> occupied_positions;
+            std::shared_ptr<const battle_field> snapshot;
+            std::uint64_t version = 0;
+            std::vector<point_2d> path;
+
+            /// <summary>
+            /// Set by the worker, and the coroutine to resume once it is, both guarded by the executor's mutex
+            /// </summary>
+            bool done = false;
+            std::coroutine_handle<> waiter;
+        };
+
+    public:
+
+        /// <summary>
+        /// Awaitable result of a path request. The search starts when the request is made, not when it is awaited,
+        /// so a unit can keep following its old path and await or poll the new one later.
+        /// co_await resumes with the path (empty when there is none), or nullopt when the map changed since the request
+        /// </summary>
+        class path_request {
+        public:
+
+            /// <summary>
+            /// Whether the result arrived, co_await does not suspend then
+            /// </summary>
+            /// <returns></returns>
+            bool ready() const;
+
+            bool await_ready() const { return ready(); }
+            bool await_suspend(std::coroutine_handle<> handle);
+            std::optional<std::vector<point_2d>> await_resume();
+
+        private:
+
+            friend class path_executor;
+
+            path_request(path_executor& executor, std::shared_ptr<request_state> state) :
+                executor_(&executor), state_(std::move(state)) {}
+
+            path_executor* executor_;
+            std::shared_ptr<request_state> state_;
+        };
+
+        /// <summary>
+        /// Awaitable which resumes the coroutine on the next tick
+        /// </summary>
+        struct tick_awaiter {
+            path_executor* executor;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(const std::coroutine_handle<> handle) const { executor->next_tick_.push_back(handle); }
+            void await_resume() const noexcept {}
+        };
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="battle_field">Snapshots must be enabled, the searches only read its published snapshots</param>
+        /// <param name="occupied_positions">Cells of the units, copied once per tick for the requests of that tick</param>
+        /// <param name="number_of_threads">0 uses std::thread::hardware_concurrency</param>
+        path_executor(const battle_field& battle_field, std::unordered_set<point_2d>& occupied_positions,
+            unsigned number_of_threads = 0);
+
+        /// <summary>
+        /// Stop the workers, dropping the queued requests, and destroy the coroutines
+        /// </summary>
+        ~path_executor();
+
+        path_executor(const path_executor&) = delete;
+        path_executor& operator=(const path_executor&) = delete;
+
+        /// <summary>
+        /// Take over a coroutine, it first runs on the next tick
+        /// </summary>
+        /// <param name="task"></param>
+        void spawn(unit_task task);
+
+        /// <summary>
+        /// Ask the workers for a path from start to goal around the occupied positions as of the first request of this tick
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <returns></returns>
+        path_request request_path(point_2d start, point_2d goal);
+
+        /// <summary>
+        /// co_await to give up the rest of this tick
+        /// </summary>
+        /// <returns></returns>
+        tick_awaiter next_tick() { return tick_awaiter{ this }; }
+
+        /// <summary>
+        /// One tick of the game loop: resume the coroutines waiting for this tick and those whose paths arrived,
+        /// then drop the finished ones. Rethrows the first exception a coroutine ended with
+        /// </summary>
+        /// <returns>Number of coroutines resumed</returns>
+        size_t tick();
+
+        /// <summary>
+        /// Coroutines which have not finished
+        /// </summary>
+        /// <returns></returns>
+        size_t get_running_count() const { return tasks_.size(); }
+
+        /// <summary>
+        /// Requests not fulfilled yet
+        /// </summary>
+        /// <returns></returns>
+        size_t get_pending_count() const;
+
+        /// <summary>
+        /// Version of the latest published snapshot, results searched on another one are stale
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_map_version() const { return battle_field_->get_snapshot()->get_version(); }
+
+        /// <summary>
+        /// Live battlefield, read on the tick thread only
+        /// </summary>
+        /// <returns></returns>
+        const battle_field& get_battle_field() const { return *battle_field_; }
+
+        /// <summary>
+        /// Cells of the units
+        /// </summary>
+        /// <returns></returns>
+        std::unordered_set<point_2d>& get_occupied_positions() { return *occupied_positions_; }
+
+        /// <summary>
+        /// Number of ticks so far
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_tick() const { return tick_; }
+
+        /// <summary>
+        /// Requests, results and resumes
+        /// </summary>
+        /// <returns></returns>
+        const path_executor_metrics& get_metrics() const { return metrics_; }
+
+    private:
+
+        /// <summary>
+        /// Worker loop: search queued requests on their snapshot and hand the waiting coroutines to the tick
+        /// </summary>
+        void work();
+
+        const battle_field* battle_field_;
+        std::unordered_set<point_2d>* occupied_positions_;
+
+        /// <summary>
+        /// Copy of the occupied positions shared by the requests of one tick, and the tick it was taken on
+        /// </summary>
+        std::shared_ptr<const std::unordered_set<point_2d>> occupied_snapshot_;
+        std::uint64_t occupied_snapshot_tick_ = 0;
+
+        /// <summary>
+        /// Spawned coroutines which have not finished
+        /// </summary>
+        std::vector<unit_task> tasks_;
+
+        /// <summary>
+        /// Coroutines to resume on the next tick: those which co_awaited next_tick or were just spawned
+        /// </summary>
+        std::vector<std::coroutine_handle<>> next_tick_;
+
+        /// <summary>
+        /// Requests waiting for a worker, and coroutines whose result arrived, guarded by the mutex
+        /// </summary>
+        mutable std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::deque<std::shared_ptr<request_state>> queue_;
+        std::vector<std::coroutine_handle<>> arrived_;
+        size_t in_progress_ = 0;
+        size_t fulfilled_ = 0;
+        bool stopping_ = false;
+
+        std::vector<std::thread> workers_;
+        std::uint64_t tick_ = 0;
+        path_executor_metrics metrics_;
+    };
+
+    /// <summary>
+    /// Unit logic: head for the target one step per tick.
+    /// Without a path the unit co_awaits one and idles meanwhile. When the map changes under its path it requests a new one
+    /// and keeps following the old path until the new one arrives. A blocked unit drops its path and asks again next tick,
+    /// a unit without any path waits retry_ticks before asking again. Ends at the target
+    /// </summary>
+    /// <param name="executor"></param>
+    /// <param name="unit">Must outlive the coroutine, its position must be in the occupied positions</param>
+    /// <param name="target"></param>
+    /// <param name="retry_ticks"></param>
+    /// <returns></returns>
+    unit_task follow_path(path_executor& executor, async_unit& unit, point_2d target, unsigned retry_ticks = 8);
+}
@@ -2,8 +2,19 @@
 
 #include "../headers/point2d.hpp"
 #include "../headers/battleField.hpp"
+#include "../headers/memoryResources.hpp"
+#include "../headers/landmarkHeuristic.hpp"
+#include "../headers/compressedPathDatabase.hpp"
+#include "../headers/goalBounds.hpp"
+#include "../headers/compactPath.hpp"
+#include "../headers/pathTree.hpp"
+#include "../headers/rectangleDecomposition.hpp"
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <vector>
+#include <memory_resource>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -22,6 +33,19 @@ namespace path_finding
 	    /// <param name="battle_field"></param>
 	    explicit pathfinder(const battle_field& battle_field);
 
+        /// <summary>
+        /// Copy the battlefield and the optional accelerators, the copy starts with its own zeroed counters
+        /// </summary>
+        /// <param name="other"></param>
+        pathfinder(const pathfinder& other);
+
+        /// <summary>
+        /// Copy the battlefield and the optional accelerators, the counters are reset
+        /// </summary>
+        /// <param name="other"></param>
+        /// <returns></returns>
+        pathfinder& operator=(const pathfinder& other);
+
         /// <summary>
         /// Finds the shortest path from start to goal
         /// Occupies position is used to avoid sharing the same spot between two units
@@ -33,6 +57,221 @@ namespace path_finding
         std::vector<point_2d> find_path(point_2d start, point_2d goal,
             const std::unordered_set<point_2d>& occupied_positions) const;
 
+        /// <summary>
+        /// Finds the shortest path from start to goal and allocates it from the given path resource
+        /// Search containers live in a per search monotonic arena which is released in one shot on return,
+        /// its blocks come from scratch resource when given (e.g. a per tick arena), otherwise from the pathfinder's counter
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="path_resource"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        std::pmr::vector<point_2d> find_path(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* path_resource,
+            std::pmr::memory_resource* scratch_resource = nullptr) const;
+
+        /// <summary>
+        /// Finds the shortest path from start to goal as a compact path (2 bits per step) allocated from the given path resource
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="path_resource"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        compact_path find_compact_path(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* path_resource = std::pmr::get_default_resource(),
+            std::pmr::memory_resource* scratch_resource = nullptr) const;
+
+        /// <summary>
+        /// Finds the shortest path from start to goal by searching from both ends at once (front to end heuristics)
+        /// Result is equally optimal as find_path, long queries expand two small balls instead of a big one
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <returns></returns>
+        std::vector<point_2d> find_path_bidirectional(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions) const;
+
+        /// <summary>
+        /// Bidirectional search that allocates the path from the given path resource
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="path_resource"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        std::pmr::vector<point_2d> find_path_bidirectional(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* path_resource,
+            std::pmr::memory_resource* scratch_resource = nullptr) const;
+
+        /// <summary>
+        /// Finds the shortest path from start to the nearest of the given targets with a single search
+        /// Reached target is set to the index of the target the path leads to, or targets.size() if none is reachable
+        /// Start being one of the targets gives an empty path with that target's index
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="reached_target"></param>
+        /// <returns></returns>
+        std::vector<point_2d> find_path_to_nearest(point_2d start, const std::vector<point_2d>& targets,
+            const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target) const;
+
+        /// <summary>
+        /// Nearest target search that allocates the path from the given path resource
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="reached_target"></param>
+        /// <param name="path_resource"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        std::pmr::vector<point_2d> find_path_to_nearest(point_2d start, const std::vector<point_2d>& targets,
+            const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target,
+            std::pmr::memory_resource* path_resource,
+            std::pmr::memory_resource* scratch_resource = nullptr) const;
+
+        /// <summary>
+        /// Nearest target search that gives a compact path allocated from the given path resource
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="reached_target"></param>
+        /// <param name="path_resource"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        compact_path find_compact_path_to_nearest(point_2d start, const std::vector<point_2d>& targets,
+            const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target,
+            std::pmr::memory_resource* path_resource = std::pmr::get_default_resource(),
+            std::pmr::memory_resource* scratch_resource = nullptr) const;
+
+        /// <summary>
+        /// Finds the shortest path from start to the goal of the tree as a node of the tree.
+        /// The search stops as soon as a shared node reached on the way is known to be on a path as short as any left to explore,
+        /// and splices onto its suffix. Occupied positions are avoided up to the splice and for splice_lookahead steps after it,
+        /// further along the units on a shared path are expected to move on, like those on the path of a unit after its search.
+        /// The new part of the path is added to the tree, shared where it is statically optimal: when the search met no
+        /// occupied position, and from the last cell on whose distance equals its manhattan distance
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="tree"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns>Node of the start with a reference for the caller to release, no_node when the goal cannot be reached</returns>
+        path_tree::node_id find_path_in_tree(point_2d start, const std::unordered_set<point_2d>& occupied_positions,
+            path_tree& tree, std::pmr::memory_resource* scratch_resource = nullptr) const;
+
+        /// <summary>
+        /// Steps after a shared node which find_path_in_tree requires to be free of occupied positions to splice onto it
+        /// </summary>
+        static constexpr size_t splice_lookahead = 16;
+
+        /// <summary>
+        /// Up to this many targets the nearest target search uses the min over targets heuristic,
+        /// beyond that evaluating it costs more than it saves and the search falls back to Dijkstra
+        /// </summary>
+        static constexpr size_t max_heuristic_targets = 32;
+
+        /// <summary>
+        /// Total number of nodes expanded by all the searches of this pathfinder
+        /// </summary>
+        /// <returns></returns>
+        size_t get_expanded_node_count() const { return expanded_node_count_.load(std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Use the landmark (ALT) bound on top of the manhattan distance in find_path and find_path_bidirectional
+        /// Null switches back to manhattan only, the landmarks must be built on the same battlefield and outlive the pathfinder
+        /// </summary>
+        /// <param name="landmarks"></param>
+        void set_landmarks(const landmark_heuristic* landmarks) { landmarks_ = landmarks; }
+
+        /// <summary>
+        /// Landmarks in use, null when there are none
+        /// </summary>
+        /// <returns></returns>
+        const landmark_heuristic* get_landmarks() const { return landmarks_; }
+
+        /// <summary>
+        /// Use a compressed path database in find_path_from_database
+        /// The database must be built for the same battlefield and outlive the pathfinder
+        /// </summary>
+        /// <param name="path_database"></param>
+        void set_path_database(const compressed_path_database* path_database) { path_database_ = path_database; }
+
+        /// <summary>
+        /// Prune the moves of find_path and find_path_to_nearest (up to max_heuristic_targets targets) with goal bounds, null switches pruning off.
+        /// The bounds must outlive the pathfinder. Bounds built for other content than the battlefield has now are not taken
+        /// (get_goal_bounds stays null), taken ones are ignored once the battlefield version moved on from the one at this call. Bounds know nothing of occupancy: a search in which an occupied position
+        /// took the place of an allowed move is run again without pruning, so paths stay optimal
+        /// </summary>
+        /// <param name="bounds"></param>
+        void set_goal_bounds(const goal_bounds* bounds);
+
+        /// <summary>
+        /// Goal bounds in use, null when there are none
+        /// </summary>
+        /// <returns></returns>
+        const goal_bounds* get_goal_bounds() const { return goal_bounds_; }
+
+        /// <summary>
+        /// Path database mode: the path is read from the compressed path database without searching
+        /// Falls back to find_path when there is no database or the stored path runs into an occupied position
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <returns></returns>
+        std::vector<point_2d> find_path_from_database(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions) const;
+
+        /// <summary>
+        /// Use a rectangle decomposition in find_path_reduced, null switches it off.
+        /// The decomposition must be built for the same battlefield and outlive the pathfinder, it is ignored once the
+        /// battlefield version moved on from the one at this call
+        /// </summary>
+        /// <param name="rectangles"></param>
+        void set_symmetry_reduction(const rectangle_decomposition* rectangles);
+
+        /// <summary>
+        /// Rectangle decomposition in use, null when there is none
+        /// </summary>
+        /// <returns></returns>
+        const rectangle_decomposition* get_symmetry_reduction() const { return rectangles_; }
+
+        /// <summary>
+        /// Symmetry reduction mode: A* on the perimeter cells of the empty rectangles, jumping across their interiors,
+        /// rectangles with an occupied position inside are searched cell by cell. Paths are as short as find_path's.
+        /// Falls back to find_path when there is no current decomposition or start or goal is not walkable
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <returns></returns>
+        std::vector<point_2d> find_path_reduced(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions) const;
+
+        /// <summary>
+        /// Battlefield the paths are searched on
+        /// </summary>
+        /// <returns></returns>
+        const battle_field& get_battle_field() const { return *battle_field_; }
+
+        /// <summary>
+        /// Allocation counters of the search arenas which are not given a scratch resource
+        /// </summary>
+        /// <returns></returns>
+        const counting_resource& get_search_counter() const { return search_counter_; }
+
     private:
 
         /// <summary>
@@ -45,6 +284,252 @@ namespace path_finding
         /// </summary>
         std::vector<point_2d> directions_;
 
+        /// <summary>
+        /// Optional landmark heuristic
+        /// </summary>
+        const landmark_heuristic* landmarks_ = nullptr;
+
+        /// <summary>
+        /// Optional compressed path database
+        /// </summary>
+        const compressed_path_database* path_database_ = nullptr;
+
+        /// <summary>
+        /// Optional goal bounds and the battlefield version they were set for
+        /// </summary>
+        const goal_bounds* goal_bounds_ = nullptr;
+        std::uint64_t goal_bounds_version_ = 0;
+
+        /// <summary>
+        /// Optional rectangle decomposition and the battlefield version it was set for
+        /// </summary>
+        const rectangle_decomposition* rectangles_ = nullptr;
+        std::uint64_t rectangles_version_ = 0;
+
+        /// <summary>
+        /// Default upstream of the per search arenas
+        /// </summary>
+        mutable counting_resource search_counter_;
+
+        /// <summary>
+        /// Number of nodes expanded so far, added once per search
+        /// </summary>
+        mutable std::atomic<size_t> expanded_node_count_;
+
+        /// <summary>
+        /// Size of the stack buffer each search arena starts with, small searches never reach the upstream.
+        /// Kept at a page so searches on worker threads and coroutine pools do not need large stacks
+        /// </summary>
+        static constexpr size_t search_buffer_size = 4 * 1024;
+
+        /// <summary>
+        /// G score, predecessor and closed state of the cells a search reached, indexed with battle_field::index_of.
+        /// The records are kept in pages of consecutive cells, so neighbouring cells share cache lines and pages in the
+        /// layout of the battlefield (a page is a square of cells in the Morton layout). Pages are allocated from the search
+        /// arena on first touch and dropped with it, a search only pays for the part of the map it reached
+        /// </summary>
+        class search_table {
+        public:
+            /// <summary>
+            /// Empty table for the cells of the battlefield
+            /// </summary>
+            /// <param name="battle_field"></param>
+            /// <param name="resource">Arena of the search, the pages are never deallocated one by one</param>
+            search_table(const battle_field& battle_field, std::pmr::memory_resource* resource);
+
+            /// <summary>
+            /// Cost from the start, infinity for cells not reached yet
+            /// </summary>
+            /// <param name="cell"></param>
+            /// <returns></returns>
+            float get_g_score(const size_t cell) const {
+                const auto* page = pages_[cell >> page_bits_];
+                return page != nullptr ? page[cell & page_mask_].g_score : std::numeric_limits<float>::infinity();
+            }
+
+            /// <summary>
+            /// Record a better cost and the cell it was reached from
+            /// </summary>
+            /// <param name="cell"></param>
+            /// <param name="g_score"></param>
+            /// <param name="parent"></param>
+            void set(const size_t cell, const float g_score, const size_t parent) {
+                auto& record = touch(cell);
+                record.g_score = g_score;
+                record.parent = static_cast<std::uint32_t>(parent);
+            }
+
+            /// <summary>
+            /// Predecessor of a reached cell other than the start
+            /// </summary>
+            /// <param name="cell"></param>
+            /// <returns></returns>
+            size_t get_parent(const size_t cell) const { return pages_[cell >> page_bits_][cell & page_mask_].parent; }
+
+            /// <summary>
+            /// Whether the cell was expanded
+            /// </summary>
+            /// <param name="cell"></param>
+            /// <returns></returns>
+            bool is_closed(const size_t cell) const {
+                const auto* page = pages_[cell >> page_bits_];
+                return page != nullptr && page[cell & page_mask_].closed;
+            }
+
+            /// <summary>
+            /// Mark the cell expanded
+            /// </summary>
+            /// <param name="cell"></param>
+            /// <returns>False when it was expanded before</returns>
+            bool close(const size_t cell) {
+                auto& record = touch(cell);
+                if (record.closed)
+                    return false;
+                record.closed = true;
+                return true;
+            }
+
+            /// <summary>
+            /// Cells per page at most, 16x16 cells in the Morton layout
+            /// </summary>
+            static constexpr unsigned max_page_bits = 8;
+
+        private:
+            struct record {
+                float g_score;
+                std::uint32_t parent;
+                bool closed;
+            };
+
+            /// <summary>
+            /// Record of the cell, allocating its page when the search reaches it first
+            /// </summary>
+            /// <param name="cell"></param>
+            /// <returns></returns>
+            record& touch(const size_t cell) {
+                auto*& page = pages_[cell >> page_bits_];
+                if (page == nullptr)
+                    page = allocate_page();
+                return page[cell & page_mask_];
+            }
+
+            /// <summary>
+            /// Page of unreached records
+            /// </summary>
+            /// <returns></returns>
+            record* allocate_page();
+
+            std::pmr::polymorphic_allocator<record> allocator_;
+            unsigned page_bits_ = 0;
+            size_t page_mask_ = 0;
+            std::pmr::vector<record*> pages_;
+        };
+
+        /// <summary>
+        /// A* search shared by both find_path overloads, writes the path into the given container
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <param name="path"></param>
+        template <typename Path>
+        void search(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource, Path& path) const;
+
+        /// <summary>
+        /// A* search which only takes the moves the goal bounds allow, all moves when bounds is null
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="bounds"></param>
+        /// <param name="scratch_resource"></param>
+        /// <param name="path"></param>
+        /// <returns>False, with the path untouched, when an occupied position replaced an allowed move,
+        /// then the path may not be optimal</returns>
+        template <typename Path>
+        bool search_with_bounds(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions, const goal_bounds* bounds,
+            std::pmr::memory_resource* scratch_resource, Path& path) const;
+
+        /// <summary>
+        /// Single search towards the nearest target shared by both find_path_to_nearest overloads
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="reached_target"></param>
+        /// <param name="scratch_resource"></param>
+        /// <param name="path"></param>
+        template <typename Path>
+        void search_nearest(point_2d start, const std::vector<point_2d>& targets,
+            const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target,
+            std::pmr::memory_resource* scratch_resource, Path& path) const;
+
+        /// <summary>
+        /// A* towards the nearest target, optionally pruned by goal bounds
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="bounds"></param>
+        /// <param name="reached_target"></param>
+        /// <param name="scratch_resource"></param>
+        /// <param name="path"></param>
+        /// <returns>False, with the path untouched, when an occupied position replaced an allowed move</returns>
+        template <typename Path>
+        bool search_nearest_with_bounds(point_2d start, const std::vector<point_2d>& targets,
+            const std::unordered_set<point_2d>& occupied_positions, const goal_bounds* bounds, size_t& reached_target,
+            std::pmr::memory_resource* scratch_resource, Path& path) const;
+
+        /// <summary>
+        /// Goal bounds a search from the start may use, null when there are none or they are out of date
+        /// </summary>
+        /// <param name="start"></param>
+        /// <returns></returns>
+        const goal_bounds* get_current_goal_bounds(point_2d start) const;
+
+        /// <summary>
+        /// Bidirectional A* search shared by both find_path_bidirectional overloads
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <param name="path"></param>
+        template <typename Path>
+        void search_bidirectional(point_2d start, point_2d goal,
+            const std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource, Path& path) const;
+
+        /// <summary>
+        /// A* over the perimeter cells of the empty rectangles and every cell of the crowded ones
+        /// </summary>
+        /// <param name="start">Walkable</param>
+        /// <param name="goal">Walkable</param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="rectangles"></param>
+        /// <param name="path"></param>
+        void search_reduced(point_2d start, point_2d goal, const std::unordered_set<point_2d>& occupied_positions,
+            const rectangle_decomposition& rectangles, std::vector<point_2d>& path) const;
+
+        /// <summary>
+        /// Successors of a cell in the reduced graph: in each direction the next cell when the move leaves the rectangle
+        /// or runs along its side, otherwise the cell on the opposite side (or the goal if it is on the way).
+        /// Every free neighbour in a crowded rectangle
+        /// </summary>
+        /// <param name="current"></param>
+        /// <param name="goal"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="rectangles"></param>
+        /// <param name="crowded">Rectangles with an occupied position inside</param>
+        /// <param name="neighbors"></param>
+        void get_reduced_neighbors(const point_2d& current, const point_2d& goal,
+            const std::unordered_set<point_2d>& occupied_positions, const rectangle_decomposition& rectangles,
+            const std::pmr::unordered_set<std::uint32_t>& crowded, std::pmr::vector<point_2d>& neighbors) const;
+
         /// <summary>
         /// Estimates the cost from one point to another using manhattan distance
         /// because the unit can only go up, down, left or right
@@ -60,18 +545,37 @@ namespace path_finding
         /// <param name="current"></param>
         /// <param name="occupied_positions"></param>
         /// <param name="goal"></param>
-        /// <returns></returns>
-        std::vector<point_2d> get_neighbors(const point_2d& current,
+        /// <param name="bounds">Goal bounds to skip the moves which do not lead to the goal, null for all moves</param>
+        /// <param name="neighbors"></param>
+        /// <returns>Whether an occupied position was skipped</returns>
+        bool get_neighbors(const point_2d& current,
             const std::unordered_set<point_2d>& occupied_positions,
-            const point_2d& goal) const;
+            const point_2d& goal, const goal_bounds* bounds, std::pmr::vector<point_2d>& neighbors) const;
 
         /// <summary>
-        /// Reconstruct the path from the given map of visited nodes and their predecessors 
+        /// Calculates the valid neighboring positions from the current point when any of the targets may be entered
         /// </summary>
-        /// <param name="came_from"></param>
         /// <param name="current"></param>
-        /// <returns></returns>
-        static std::vector<point_2d> reconstruct_path(
-            std::unordered_map<point_2d, point_2d>& came_from, point_2d current);
+        /// <param name="occupied_positions"></param>
+        /// <param name="targets"></param>
+        /// <param name="bounds">Goal bounds to skip the moves which lead to none of the targets, null for all moves</param>
+        /// <param name="neighbors"></param>
+        /// <returns>Whether an occupied position was skipped</returns>
+        bool get_neighbors(const point_2d& current,
+            const std::unordered_set<point_2d>& occupied_positions,
+            const std::pmr::unordered_map<point_2d, size_t>& targets, const goal_bounds* bounds,
+            std::pmr::vector<point_2d>& neighbors) const;
+
+        /// <summary>
+        /// Reconstruct the path from the predecessors in the search table into the steps before end index
+        /// of an already sized path
+        /// </summary>
+        /// <param name="table"></param>
+        /// <param name="start"></param>
+        /// <param name="current"></param>
+        /// <param name="end_index"></param>
+        /// <param name="path"></param>
+        template <typename Path>
+        void reconstruct_path(const search_table& table, point_2d start, point_2d current, size_t end_index, Path& path) const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../headers/pathFinder.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Totals of one path service session
+    /// </summary>
+    struct path_service_stats {
+
+        /// <summary>
+        /// Queries answered, and those answered with an error
+        /// </summary>
+        size_t requests = 0, errors = 0;
+
+        /// <summary>
+        /// Latency from reading a query until its response is ready to be written, total and worst
+        /// </summary>
+        std::chrono::microseconds total_latency{ 0 }, max_latency{ 0 };
+
+        /// <summary>
+        /// Duration of the session
+        /// </summary>
+        std::chrono::microseconds elapsed{ 0 };
+    };
+
+    /// <summary>
+    /// Answers newline delimited JSON path queries against one loaded map, one JSON response per line:
+    ///   query:    {"id": 7, "start": [x, y], "goal": [x, y], "occupied": [[x, y], ...], "engine": "a_star"}
+    ///   response: {"id": 7, "latency_us": t, "length": n, "path": [[x, y], ...]} or {"error": "...", "id": 7, "latency_us": t}
+    /// id, occupied and engine (a_star, bidirectional, database) are optional, id is echoed back as given.
+    /// Queries are pipelined: they are read while earlier ones are still being answered by the worker threads of the service,
+    /// which every session shares. Each session has one writer, so a slow client only holds back its own responses.
+    /// Responses are written in arrival order, or as soon as they are ready when unordered (then match them by id).
+    /// At most max_in_flight queries per session are read ahead or waiting to be written, after that reading waits,
+    /// which pushes back on the client
+    /// </summary>
+    class path_service {
+    public:
+
+        /// <summary>
+        /// Constructor, starts the workers
+        /// </summary>
+        /// <param name="path_finder">Shared by the workers, configure landmarks or a path database on it beforehand</param>
+        /// <param name="number_of_threads">0 uses std::thread::hardware_concurrency</param>
+        /// <param name="max_in_flight"></param>
+        /// <param name="ordered">Whether responses keep the arrival order</param>
+        explicit path_service(const pathfinder& path_finder, unsigned number_of_threads = 0, size_t max_in_flight = 256,
+            bool ordered = true);
+
+        /// <summary>
+        /// Destructor, the workers finish the queued queries and are joined
+        /// </summary>
+        ~path_service();
+
+        path_service(const path_service&) = delete;
+        path_service& operator=(const path_service&) = delete;
+
+        /// <summary>
+        /// Serve the queries of the input until it ends, the output is flushed after every written batch of responses.
+        /// Sessions may run at the same time on several threads
+        /// </summary>
+        /// <param name="input"></param>
+        /// <param name="output"></param>
+        /// <returns></returns>
+        path_service_stats run(std::istream& input, std::ostream& output) const;
+
+        /// <summary>
+        /// Answer a single query line
+        /// </summary>
+        /// <param name="query"></param>
+        /// <param name="failed">Set when the response is an error</param>
+        /// <returns>Response without the latency and the line break</returns>
+        std::string answer(const std::string& query, bool& failed) const;
+
+    private:
+
+        /// <summary>
+        /// State of one run: responses waiting to be written and the session totals
+        /// </summary>
+        struct session;
+
+        /// <summary>
+        /// Query waiting for a worker
+        /// </summary>
+        struct task {
+            session* owner;
+            size_t sequence;
+            std::string line;
+            std::chrono::steady_clock::time_point received;
+        };
+
+        /// <summary>
+        /// Worker loop: answer queued queries until the service stops
+        /// </summary>
+        void work() const;
+
+        /// <summary>
+        /// Writer loop of a session: take the responses that are ready, then write and flush them outside the lock
+        /// </summary>
+        /// <param name="state"></param>
+        /// <param name="output"></param>
+        void write(session& state, std::ostream& output) const;
+
+        const pathfinder* path_finder_;
+        unsigned number_of_threads_;
+        size_t max_in_flight_;
+        bool ordered_;
+
+        /// <summary>
+        /// Queries of every session, in arrival order
+        /// </summary>
+        mutable std::mutex mutex_;
+        mutable std::condition_variable work_ready_;
+        mutable std::deque<task> work_;
+        bool stopping_ = false;
+
+        std::vector<std::thread> workers_;
+    };
+}
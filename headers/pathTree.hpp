@@ -0,0 +1,163 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Shared suffixes of the paths of many units heading for the same goal.
+    /// Paths are chains of reference counted nodes, one cell each, linked to the next cell towards the goal, so all of them
+    /// form a tree rooted at the goal and a path is the node of its start cell. A node is referenced by its children and
+    /// by whoever holds the path; it goes, and releases its parent, when the last reference does.
+    /// Nodes of statically optimal paths are shared: indexed by their cell, with their distance being the length of an
+    /// optimal path on the battlefield without units, so a search reaching one of them can splice onto its suffix and stop
+    /// (see pathfinder::find_path_in_tree). Other nodes are private to the path they belong to.
+    /// An edit of the battlefield unshares every node, paths already handed out keep their nodes until they are released.
+    /// Not thread safe
+    /// </summary>
+    class path_tree {
+    public:
+
+        /// <summary>
+        /// Index of a node, stays valid while the node is referenced
+        /// </summary>
+        using node_id = std::uint32_t;
+
+        /// <summary>
+        /// Id of no node, e.g. when there is no path
+        /// </summary>
+        static constexpr node_id no_node = ~node_id(0);
+
+        /// <summary>
+        /// One cell of a path
+        /// </summary>
+        struct node {
+
+            /// <summary>
+            /// Cell of the node
+            /// </summary>
+            point_2d position;
+
+            /// <summary>
+            /// Next node towards the goal, no_node for the root
+            /// </summary>
+            node_id parent;
+
+            /// <summary>
+            /// Steps to the goal along the parents
+            /// </summary>
+            std::uint32_t distance;
+
+            /// <summary>
+            /// Children and holders
+            /// </summary>
+            std::uint32_t references;
+        };
+
+        /// <summary>
+        /// Constructor, the tree starts with the root only
+        /// </summary>
+        /// <param name="battle_field">Its version decides whether the shared nodes are still optimal, must outlive the tree</param>
+        /// <param name="goal"></param>
+        /// <param name="resource">Resource the nodes and the index are allocated from</param>
+        path_tree(const battle_field& battle_field, point_2d goal,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        /// <summary>
+        /// Goal every path leads to
+        /// </summary>
+        /// <returns></returns>
+        point_2d get_goal() const { return nodes_[root].position; }
+
+        /// <summary>
+        /// Node of the goal, never released
+        /// </summary>
+        static constexpr node_id root = 0;
+
+        /// <summary>
+        /// Node data
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        const node& get(const node_id id) const { return nodes_[id]; }
+
+        /// <summary>
+        /// Shared node of the cell, no_node when there is none
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        node_id find(point_2d position) const;
+
+        /// <summary>
+        /// Unshare every node when the battlefield changed since the nodes were shared
+        /// </summary>
+        void synchronize();
+
+        /// <summary>
+        /// Add a node in front of a parent. The new node has no reference: acquire the node of the path's start
+        /// once its chain is complete
+        /// </summary>
+        /// <param name="position">A neighbour of the parent's cell</param>
+        /// <param name="parent"></param>
+        /// <param name="shared">Whether the path through the parent is statically optimal and the cell has no shared node yet</param>
+        /// <returns></returns>
+        node_id add(point_2d position, node_id parent, bool shared);
+
+        /// <summary>
+        /// Hold a path
+        /// </summary>
+        /// <param name="id"></param>
+        void acquire(node_id id) { nodes_[id].references++; }
+
+        /// <summary>
+        /// Let go of a path, the nodes nobody references any more are freed towards the root
+        /// </summary>
+        /// <param name="id"></param>
+        void release(node_id id);
+
+        /// <summary>
+        /// Nodes in use, including the root
+        /// </summary>
+        /// <returns></returns>
+        size_t get_node_count() const { return nodes_.size() - free_nodes_.size(); }
+
+        /// <summary>
+        /// Nodes a search can splice onto, including the root
+        /// </summary>
+        /// <returns></returns>
+        size_t get_shared_node_count() const { return index_.size(); }
+
+        /// <summary>
+        /// Bytes of node storage
+        /// </summary>
+        /// <returns></returns>
+        size_t get_memory_size() const { return nodes_.capacity() * sizeof(node); }
+
+    private:
+
+        const battle_field* battle_field_;
+
+        /// <summary>
+        /// Battlefield version the shared nodes are optimal on
+        /// </summary>
+        std::uint64_t version_;
+
+        /// <summary>
+        /// Node storage, freed nodes are reused
+        /// </summary>
+        std::pmr::vector<node> nodes_;
+        std::pmr::vector<node_id> free_nodes_;
+
+        /// <summary>
+        /// Shared node of each cell
+        /// </summary>
+        std::pmr::unordered_map<point_2d, node_id> index_;
+    };
+}
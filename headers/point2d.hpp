@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstdint>
 
 namespace path_finding
 {
@@ -82,8 +83,10 @@ template <>
 struct std::hash<path_finding::point_2d> {
 	std::size_t operator()(const path_finding::point_2d& point) const noexcept
 	{
-		// Combine the hash values of x and y coordinates
-		return hash<int>()(point.get_x()) ^ (hash<int>()(point.get_y()) << 1);
+		// Both coordinates in one 64 bit key, x ^ (y << 1) only has a few thousand distinct values on large maps
+		const auto key = static_cast<std::uint64_t>(static_cast<std::uint32_t>(point.get_x())) << 32
+			| static_cast<std::uint32_t>(point.get_y());
+		return hash<std::uint64_t>()(key);
 	}
 };
 
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <future>
+#include <string>
+#include <thread>
+
+namespace path_finding
+{
+    /// <summary>
+    /// How load_or_build got its artifact
+    /// </summary>
+    enum class cache_lookup
+    {
+        hit,        // loaded from the cache
+        miss,       // no entry for the map, built and stored
+        corrupt     // entry failed its checksum or did not load, built and stored again
+    };
+
+    /// <summary>
+    /// Content addressed cache of precomputed search data (compressed path databases, goal bounds).
+    /// Entries are named after the battlefield content hash and the artifact's file extension, so an edited map
+    /// simply misses and a map loaded from another file hits. Next to every entry a small checksum file records
+    /// the cache version, content hash, size and a 64 bit checksum of the entry; it is written last, so a crash
+    /// half way through a store leaves an entry that fails verification instead of one that loads garbage.
+    /// Verified entries are memory mapped by the artifact's own load, which checks its own version and map hash.
+    /// An Artifact needs static build(field), static load(filename, field), save(filename) and a file_extension
+    /// </summary>
+    class precompute_cache {
+    public:
+
+        /// <summary>
+        /// Cache in the given directory, created when it does not exist. Without a directory nothing is kept:
+        /// every lookup misses and the built artifacts are not stored
+        /// </summary>
+        /// <param name="directory"></param>
+        explicit precompute_cache(std::string directory);
+
+        /// <summary>
+        /// Directory of the entries
+        /// </summary>
+        /// <returns></returns>
+        const std::string& get_directory() const { return directory_; }
+
+        /// <summary>
+        /// Entry of an artifact for the battlefield: directory/content hash in hex + extension
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="extension"></param>
+        /// <returns></returns>
+        std::string get_filename(const battle_field& battle_field, const std::string& extension) const;
+
+        /// <summary>
+        /// Load the artifact of the battlefield from the cache, or build and store it when there is no valid entry.
+        /// An entry which cannot be written is not an error, the artifact is just built again next time
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="lookup">Set to how the artifact was obtained, may be null</param>
+        /// <returns></returns>
+        template <typename Artifact>
+        Artifact load_or_build(const battle_field& battle_field, cache_lookup* lookup = nullptr) const {
+            const auto filename = get_filename(battle_field, Artifact::file_extension);
+            const auto content_hash = battle_field.get_content_hash();
+            auto result = find(filename, content_hash);
+            if (result == cache_lookup::hit) {
+                try {
+                    auto artifact = Artifact::load(filename, battle_field);
+                    set_lookup(lookup, result);
+                    return artifact;
+                }
+                catch (const std::exception&) {
+                    result = cache_lookup::corrupt;
+                }
+            }
+            set_lookup(lookup, result);
+            return build_and_store<Artifact>(battle_field, filename, content_hash);
+        }
+
+        /// <summary>
+        /// Like load_or_build, but a rebuild runs on a background thread.
+        /// A hit returns a ready future. On a miss the build runs detached on a copy of the battlefield, so the battlefield
+        /// may change or go away meanwhile and dropping the future does not wait for the build, which is abandoned at exit.
+        /// A store cut short leaves an entry that fails verification
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="lookup">Set to how the artifact is obtained before returning, may be null</param>
+        /// <returns></returns>
+        template <typename Artifact>
+        std::future<Artifact> load_or_build_async(const battle_field& battle_field, cache_lookup* lookup = nullptr) const {
+            const auto filename = get_filename(battle_field, Artifact::file_extension);
+            const auto content_hash = battle_field.get_content_hash();
+            auto result = find(filename, content_hash);
+            if (result == cache_lookup::hit) {
+                try {
+                    std::promise<Artifact> loaded;
+                    loaded.set_value(Artifact::load(filename, battle_field));
+                    set_lookup(lookup, result);
+                    return loaded.get_future();
+                }
+                catch (const std::exception&) {
+                    result = cache_lookup::corrupt;
+                }
+            }
+            set_lookup(lookup, result);
+            std::promise<Artifact> built;
+            auto future = built.get_future();
+            std::thread([cache = *this, field = battle_field, filename, content_hash, built = std::move(built)]() mutable {
+                try {
+                    built.set_value(cache.build_and_store<Artifact>(field, filename, content_hash));
+                }
+                catch (...) {
+                    built.set_exception(std::current_exception());
+                }
+            }).detach();
+            return future;
+        }
+
+        /// <summary>
+        /// Checksum of the entries, eight bytes at a time
+        /// </summary>
+        /// <param name="data"></param>
+        /// <param name="size"></param>
+        /// <returns></returns>
+        static std::uint64_t checksum(const unsigned char* data, size_t size);
+
+    private:
+
+        /// <summary>
+        /// Whether the entry exists and matches its checksum file
+        /// </summary>
+        /// <param name="filename"></param>
+        /// <param name="content_hash"></param>
+        /// <returns>Hit when the entry verified, miss when there is none, corrupt otherwise</returns>
+        cache_lookup find(const std::string& filename, std::uint64_t content_hash) const;
+
+        /// <summary>
+        /// Drop the checksum file of an entry before the entry is replaced
+        /// </summary>
+        /// <param name="filename"></param>
+        void invalidate(const std::string& filename) const;
+
+        /// <summary>
+        /// Move a freshly written entry into place and write its checksum file
+        /// </summary>
+        /// <param name="temporary_filename"></param>
+        /// <param name="filename"></param>
+        /// <param name="content_hash"></param>
+        void commit(const std::string& temporary_filename, const std::string& filename, std::uint64_t content_hash) const;
+
+        /// <summary>
+        /// Unique name to write an entry under before it is moved into place
+        /// </summary>
+        /// <param name="filename"></param>
+        /// <returns></returns>
+        static std::string get_temporary_filename(const std::string& filename);
+
+        /// <summary>
+        /// Build the artifact and store it, failures to store are ignored
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="filename"></param>
+        /// <param name="content_hash"></param>
+        /// <returns></returns>
+        template <typename Artifact>
+        Artifact build_and_store(const battle_field& battle_field, const std::string& filename, std::uint64_t content_hash) const {
+            auto artifact = Artifact::build(battle_field);
+            if (directory_.empty())
+                return artifact;
+            const auto temporary_filename = get_temporary_filename(filename);
+            try {
+                invalidate(filename);
+                artifact.save(temporary_filename);
+                commit(temporary_filename, filename, content_hash);
+            }
+            catch (const std::exception&) {
+                std::remove(temporary_filename.c_str());
+            }
+            return artifact;
+        }
+
+        /// <summary>
+        /// Report the lookup when asked for
+        /// </summary>
+        /// <param name="lookup"></param>
+        /// <param name="result"></param>
+        static void set_lookup(cache_lookup* lookup, const cache_lookup result) {
+            if (lookup != nullptr)
+                *lookup = result;
+        }
+
+        std::string directory_;
+    };
+}
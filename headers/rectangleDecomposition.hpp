@@ -0,0 +1,102 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/point2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Rectangular symmetry reduction for mostly open maps
+    /// The walkable cells are split into empty rectangles, the largest free squares first, each grown by whole free rows
+    /// and columns. Inside an empty rectangle every monotone path between two cells is equally short, so a search
+    /// only needs the perimeter cells: it steps along the sides and jumps straight across the interior to the opposite side
+    /// (see pathfinder::find_path_reduced). On a 4-connected grid with unit costs the paths stay optimal.
+    /// Built offline in a few passes over the grid, occupancy is not part of the rectangles
+    /// </summary>
+    class rectangle_decomposition {
+    public:
+
+        /// <summary>
+        /// Empty rectangle, bounds included
+        /// </summary>
+        struct rectangle {
+            std::int16_t min_x, min_y, max_x, max_y;
+        };
+
+        /// <summary>
+        /// Index of no rectangle, for the cells which are not walkable
+        /// </summary>
+        static constexpr std::uint32_t no_rectangle = ~std::uint32_t(0);
+
+        /// <summary>
+        /// Split the walkable cells of the battlefield into rectangles
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <returns></returns>
+        static rectangle_decomposition build(const battle_field& battle_field);
+
+        /// <summary>
+        /// Rectangle of the cell, no_rectangle outside the grid or on a cell which is not walkable
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        std::uint32_t get_rectangle_index(const point_2d position) const {
+            const auto x = position.get_x();
+            const auto y = position.get_y();
+            if (x < 0 || x >= width_ || y < 0 || y >= height_)
+                return no_rectangle;
+            return cell_rectangles_[layout_.index_of(position)];
+        }
+
+        /// <summary>
+        /// Rectangle data
+        /// </summary>
+        /// <param name="index"></param>
+        /// <returns></returns>
+        const rectangle& get_rectangle(const std::uint32_t index) const { return rectangles_[index]; }
+
+        /// <summary>
+        /// Number of rectangles
+        /// </summary>
+        /// <returns></returns>
+        size_t get_rectangle_count() const { return rectangles_.size(); }
+
+        /// <summary>
+        /// Cells on the sides of the rectangles, the only ones a reduced search expands besides start and goal
+        /// </summary>
+        /// <returns></returns>
+        size_t get_perimeter_cell_count() const { return perimeter_cell_count_; }
+
+        /// <summary>
+        /// Size of the decomposition in bytes
+        /// </summary>
+        /// <returns></returns>
+        size_t get_memory_size() const {
+            return cell_rectangles_.size() * sizeof(std::uint32_t) + rectangles_.size() * sizeof(rectangle);
+        }
+
+    private:
+
+        /// <summary>
+        /// Width and height of the grid
+        /// </summary>
+        int width_ = 0, height_ = 0;
+
+        /// <summary>
+        /// Rectangle index of every cell, in the layout of the battlefield
+        /// </summary>
+        grid_layout layout_;
+        std::vector<std::uint32_t> cell_rectangles_;
+
+        /// <summary>
+        /// Rectangles in the order they were grown
+        /// </summary>
+        std::vector<rectangle> rectangles_;
+
+        size_t perimeter_cell_count_ = 0;
+    };
+}
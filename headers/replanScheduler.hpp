@@ -0,0 +1,175 @@
+#pragma once
+
+#include "../headers/compactPath.hpp"
+#include "../headers/pathFinder.hpp"
+#include "../headers/point2d.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Counters of a replan scheduler
+    /// </summary>
+    struct replan_metrics {
+
+        /// <summary>
+        /// Requests waiting to be served
+        /// </summary>
+        size_t queue_depth = 0;
+
+        /// <summary>
+        /// Requests served by the last service call and in total
+        /// </summary>
+        size_t served_last_tick = 0, served_total = 0;
+
+        /// <summary>
+        /// Time spent in the last service call
+        /// </summary>
+        std::chrono::microseconds last_service_time{ 0 };
+
+        /// <summary>
+        /// Ticks between submit and service, average and worst over all served requests
+        /// </summary>
+        double average_wait_ticks = 0;
+        size_t max_wait_ticks = 0;
+
+        /// <summary>
+        /// Wall time between submit and service, average and worst over all served requests
+        /// </summary>
+        std::chrono::microseconds average_wait_time{ 0 };
+        std::chrono::microseconds max_wait_time{ 0 };
+    };
+
+    /// <summary>
+    /// Central queue for path requests, so a burst of blocked units does not replan in a single tick.
+    /// Requests are served once per tick by service() within a microsecond budget, in priority order:
+    /// the closer the goal the sooner, and every tick of waiting is worth aging_per_tick cells of distance
+    /// so far requests are never starved. A search that started is not interrupted, the budget can be overshot by one search.
+    /// Results are handed back asynchronously: the requester polls take_result with its ticket on later ticks.
+    /// Not thread safe, meant to be used from the tick thread
+    /// </summary>
+    class replan_scheduler {
+    public:
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="path_finder"></param>
+        /// <param name="budget">Time per service call, at least one request is served per call</param>
+        /// <param name="aging_per_tick">Distance a request gains in priority for every tick it waits</param>
+        /// <param name="resource">Resource the queued requests and the results are allocated from</param>
+        replan_scheduler(const pathfinder& path_finder, std::chrono::microseconds budget, int aging_per_tick = 8,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        replan_scheduler(const replan_scheduler&) = delete;
+        replan_scheduler& operator=(const replan_scheduler&) = delete;
+
+        /// <summary>
+        /// Queue a request for a path from start to goal
+        /// </summary>
+        /// <param name="start"></param>
+        /// <param name="goal"></param>
+        /// <returns>Ticket to take the result with, never 0</returns>
+        std::uint64_t submit(point_2d start, point_2d goal);
+
+        /// <summary>
+        /// Serve queued requests in priority order until the budget is spent, then start the next tick
+        /// </summary>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource">Upstream for the search arenas, e.g. a tick_arena</param>
+        void service(const std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// Move the result of a served request into the given path, an empty path means there is none
+        /// </summary>
+        /// <param name="ticket"></param>
+        /// <param name="path"></param>
+        /// <returns>False while the request is still queued (or the ticket is unknown)</returns>
+        bool take_result(std::uint64_t ticket, compact_path& path);
+
+        /// <summary>
+        /// Drop a queued request or an untaken result
+        /// </summary>
+        /// <param name="ticket"></param>
+        void cancel(std::uint64_t ticket);
+
+        /// <summary>
+        /// Whether the request of the ticket is still waiting to be served
+        /// </summary>
+        /// <param name="ticket"></param>
+        /// <returns></returns>
+        bool is_pending(std::uint64_t ticket) const { return pending_.find(ticket) != pending_.end(); }
+
+        /// <summary>
+        /// Change the time per service call
+        /// </summary>
+        /// <param name="budget"></param>
+        void set_budget(const std::chrono::microseconds budget) { budget_ = budget; }
+
+        /// <summary>
+        /// Queue depth and wait times
+        /// </summary>
+        /// <returns></returns>
+        const replan_metrics& get_metrics() const { return metrics_; }
+
+        /// <summary>
+        /// Number of service calls so far
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_tick() const { return tick_; }
+
+    private:
+
+        /// <summary>
+        /// Queued request, the key orders the queue: submit tick * aging + distance, lowest first
+        /// </summary>
+        struct request {
+            std::int64_t key;
+            std::uint64_t ticket;
+            point_2d start, goal;
+            std::uint64_t submit_tick;
+            std::chrono::steady_clock::time_point submit_time;
+
+            bool operator>(const request& other) const {
+                return key != other.key ? key > other.key : ticket > other.ticket;
+            }
+        };
+
+        const pathfinder* path_finder_;
+        std::chrono::microseconds budget_;
+        int aging_per_tick_;
+        std::pmr::memory_resource* resource_;
+        std::uint64_t tick_ = 0;
+        std::uint64_t next_ticket_ = 1;
+
+        /// <summary>
+        /// Requests by priority, cancelled ones are skipped when popped
+        /// </summary>
+        std::priority_queue<request, std::pmr::vector<request>, std::greater<request>> queue_;
+
+        /// <summary>
+        /// Tickets still queued
+        /// </summary>
+        std::pmr::unordered_set<std::uint64_t> pending_;
+
+        /// <summary>
+        /// Served requests not taken yet
+        /// </summary>
+        std::pmr::unordered_map<std::uint64_t, compact_path> results_;
+
+        /// <summary>
+        /// Sums behind the averages
+        /// </summary>
+        std::uint64_t total_wait_ticks_ = 0;
+        std::chrono::microseconds total_wait_time_{ 0 };
+
+        replan_metrics metrics_;
+    };
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/memoryResources.hpp"
+#include "../headers/unitStore.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Where the units of a scenario head for
+    /// </summary>
+    enum class scenario_goal
+    {
+        nearest,    // every unit heads for the nearest target, like the demo
+        assigned    // unit i heads for target i, one search per unit instead of a search over all targets
+    };
+
+    /// <summary>
+    /// One entry of the manifest: a number of seeded simulations on one map
+    /// </summary>
+    struct scenario {
+
+        /// <summary>
+        /// Name in the report, and the map the simulations run on
+        /// </summary>
+        std::string name, map;
+
+        /// <summary>
+        /// Units per simulation, placed on random walkable cells with as many random targets.
+        /// 0 uses the start and target positions of the map
+        /// </summary>
+        size_t units = 0;
+
+        /// <summary>
+        /// Seed of the first simulation, simulation i uses seed + i
+        /// </summary>
+        std::uint64_t seed = 1;
+
+        /// <summary>
+        /// Number of simulations
+        /// </summary>
+        size_t runs = 1;
+
+        /// <summary>
+        /// Simulations stop after this many ticks at the latest
+        /// </summary>
+        size_t max_ticks = 1000;
+
+        /// <summary>
+        /// Where the units head for
+        /// </summary>
+        scenario_goal goal = scenario_goal::nearest;
+    };
+
+    /// <summary>
+    /// Outcome of one simulation
+    /// </summary>
+    struct simulation_result {
+
+        /// <summary>
+        /// Units, units at a target at the end, and ticks until every unit arrived, nobody could move or max_ticks
+        /// </summary>
+        size_t units = 0, arrived = 0, ticks = 0;
+        conflict_metrics conflicts;
+        std::chrono::microseconds elapsed{ 0 };
+    };
+
+    /// <summary>
+    /// Totals of all the simulations of a scenario
+    /// </summary>
+    struct scenario_summary {
+
+        /// <summary>
+        /// Scenario name and number of simulations
+        /// </summary>
+        std::string name;
+        size_t runs = 0;
+
+        /// <summary>
+        /// Sums over the runs, the ticks of the longest run, and the runs in which every unit arrived
+        /// </summary>
+        size_t units = 0, arrived = 0, ticks = 0, max_ticks = 0, completed_runs = 0;
+        conflict_metrics conflicts;
+
+        /// <summary>
+        /// Simulation time summed over the runs (CPU time, the runs overlap)
+        /// </summary>
+        std::chrono::microseconds elapsed{ 0 };
+    };
+
+    /// <summary>
+    /// Results of a scenario runner run
+    /// </summary>
+    struct scenario_report {
+
+        /// <summary>
+        /// Summaries in manifest order
+        /// </summary>
+        std::vector<scenario_summary> scenarios;
+
+        /// <summary>
+        /// Simulations run, unit moves simulated (units * ticks summed) and threads used
+        /// </summary>
+        size_t simulations = 0, unit_ticks = 0;
+        unsigned threads = 0;
+
+        /// <summary>
+        /// Wall time of the whole run
+        /// </summary>
+        std::chrono::microseconds wall_time{ 0 };
+
+        /// <summary>
+        /// Simulations per second of wall time
+        /// </summary>
+        /// <returns></returns>
+        double get_throughput() const;
+
+        /// <summary>
+        /// Report as a JSON document
+        /// </summary>
+        /// <returns></returns>
+        std::string to_json() const;
+    };
+
+    /// <summary>
+    /// Runs many independent simulations (balance testing) sharded over worker threads with parallel_for.
+    /// Maps are loaded once and shared read only: every simulation has its own pathfinder, unit store, occupied positions
+    /// and search arena on top of the shared battle_field. The maps must not change while run is running.
+    /// Simulations are seeded, their results do not depend on the number of threads
+    /// </summary>
+    class scenario_runner {
+    public:
+
+        /// <summary>
+        /// Load a manifest:
+        ///   {"maps": {"woodland": {"file": "tile_set_woodland_1.json"},
+        ///             "open": {"width": 256, "height": 256, "units": 64, "terrains": 4000, "seed": 7}},
+        ///    "scenarios": [{"name": "crowd", "map": "woodland", "units": 40, "seed": 1, "runs": 100,
+        ///                   "max_ticks": 500, "goal": "nearest"}]}
+        /// Map files are relative to the manifest, maps without a file are generated with generate_random_field.
+        /// Throws when the manifest is malformed or names an unknown map
+        /// </summary>
+        /// <param name="manifest_filename"></param>
+        /// <returns></returns>
+        static scenario_runner load(const std::string& manifest_filename);
+
+        /// <summary>
+        /// Add a map under a name, replaces a map of the same name
+        /// </summary>
+        /// <param name="name"></param>
+        /// <param name="field"></param>
+        void add_map(const std::string& name, battle_field field);
+
+        /// <summary>
+        /// Add a scenario, its map must have been added
+        /// </summary>
+        /// <param name="scenario"></param>
+        void add_scenario(const scenario& scenario);
+
+        /// <summary>
+        /// Run every simulation of every scenario
+        /// </summary>
+        /// <param name="number_of_threads">0 uses std::thread::hardware_concurrency</param>
+        /// <returns></returns>
+        scenario_report run(unsigned number_of_threads = 0) const;
+
+        /// <summary>
+        /// Run one simulation of the scenario on the map
+        /// </summary>
+        /// <param name="field"></param>
+        /// <param name="scenario"></param>
+        /// <param name="seed"></param>
+        /// <param name="arena">Per thread arena for the searches, reset after every tick, null for a local one</param>
+        /// <returns></returns>
+        static simulation_result simulate(const battle_field& field, const scenario& scenario, std::uint64_t seed,
+            tick_arena* arena = nullptr);
+
+        /// <summary>
+        /// Scenarios in the order they were added
+        /// </summary>
+        /// <returns></returns>
+        const std::vector<scenario>& get_scenarios() const { return scenarios_; }
+
+    private:
+
+        /// <summary>
+        /// Shared read only maps by name
+        /// </summary>
+        std::map<std::string, battle_field> maps_;
+
+        std::vector<scenario> scenarios_;
+    };
+}
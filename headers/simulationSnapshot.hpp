@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../headers/battleField.hpp"
+#include "../headers/point2d.hpp"
+#include "../headers/unit.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Binary image of one tick of the simulation: battlefield cells and positions, the seed the battlefield was generated from,
+    /// every unit's position and path, and occupancy. The simulation itself draws no random numbers once the map exists.
+    /// capture() writes the image into a buffer that is reused between captures, so the tick thread only pays for the copies.
+    /// save() then writes the buffer with a single write, from any thread, while the simulation carries on.
+    /// Records are stored as raw bytes, files are only meant to be restored by a build with the same layout
+    /// </summary>
+    class simulation_snapshot {
+    public:
+
+        /// <summary>
+        /// Copy the state of the simulation into the snapshot
+        /// </summary>
+        /// <param name="tick"></param>
+        /// <param name="battle_field"></param>
+        /// <param name="units"></param>
+        /// <param name="occupied_positions"></param>
+        void capture(std::uint64_t tick, const battle_field& battle_field, const std::vector<unit>& units,
+            const std::unordered_set<point_2d>& occupied_positions);
+
+        /// <summary>
+        /// Put the simulation back in the captured state
+        /// The units must already exist (same count as captured), their paths reuse their storage when it is large enough
+        /// </summary>
+        /// <param name="battle_field"></param>
+        /// <param name="units"></param>
+        /// <param name="occupied_positions"></param>
+        void restore(battle_field& battle_field, std::vector<unit>& units, std::unordered_set<point_2d>& occupied_positions) const;
+
+        /// <summary>
+        /// Write the snapshot with one buffered write
+        /// </summary>
+        /// <param name="filename"></param>
+        void save(const std::string& filename) const;
+
+        /// <summary>
+        /// Write the snapshot to a binary stream, e.g. as part of a larger file
+        /// </summary>
+        /// <param name="stream"></param>
+        void save(std::ostream& stream) const;
+
+        /// <summary>
+        /// Read a saved snapshot, throws when the file is not a valid snapshot of this build
+        /// </summary>
+        /// <param name="filename"></param>
+        void load(const std::string& filename);
+
+        /// <summary>
+        /// Read a snapshot of the given size in bytes from a binary stream
+        /// </summary>
+        /// <param name="stream"></param>
+        /// <param name="size"></param>
+        void load(std::istream& stream, size_t size);
+
+        /// <summary>
+        /// Whether anything has been captured or loaded
+        /// </summary>
+        /// <returns></returns>
+        bool empty() const { return size_ == 0; }
+
+        /// <summary>
+        /// Tick the snapshot was captured at
+        /// </summary>
+        /// <returns></returns>
+        std::uint64_t get_tick() const;
+
+        /// <summary>
+        /// Number of units in the snapshot
+        /// </summary>
+        /// <returns></returns>
+        size_t get_unit_count() const;
+
+        /// <summary>
+        /// Size of the binary image in bytes
+        /// </summary>
+        /// <returns></returns>
+        size_t get_size() const { return size_; }
+
+    private:
+
+        /// <summary>
+        /// Binary image, laid out as in the file, in words so every section is aligned
+        /// </summary>
+        std::vector<std::uint64_t> buffer_;
+
+        /// <summary>
+        /// Size of the image in bytes, the buffer is rounded up to whole words
+        /// </summary>
+        size_t size_ = 0;
+    };
+}
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstdint>
+
 namespace path_finding
 {
     /// <summary>
     /// Tile type enumerator to identify each tiles in the grid (battlefield)
+    /// Stored in one byte so large grids stay compact
     /// </summary>
-    enum class tile_type
+    enum class tile_type : std::int8_t
     {
          walkable = -1, 
 		 start = 0, 
@@ -3,6 +3,12 @@
 #include "../headers/moveStatus.hpp"
 #include "../headers/point2d.hpp"
 #include "../headers/pathFinder.hpp"
+#include "../headers/compactPath.hpp"
+#include "../headers/incrementalSearch.hpp"
+#include "../headers/replanScheduler.hpp"
+
+#include <memory>
+#include <memory_resource>
 
 namespace path_finding
 {
@@ -17,7 +23,9 @@ namespace path_finding
         /// </summary>
         /// <param name="position"></param>
         /// <param name="path_finder"></param>
-        unit(point_2d position, const pathfinder& path_finder);
+        /// <param name="path_resource">Resource the unit's path codes are allocated from, e.g. a shared path_pool</param>
+        unit(point_2d position, const pathfinder& path_finder,
+            std::pmr::memory_resource* path_resource = std::pmr::get_default_resource());
 
         /// <summary>
         /// To move the unit to a new target position
@@ -25,8 +33,41 @@ namespace path_finding
         /// </summary>
         /// <param name="target"></param>
         /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource">Upstream for the search arena when a path is computed, e.g. a tick_arena</param>
+        /// <returns></returns>
+        move_status move(point_2d target, std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// To move the unit towards the nearest of the given targets, found with a single search
+        /// The nearest target is chosen whenever a path is (re)computed
+        /// </summary>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
         /// <returns></returns>
-        move_status move(point_2d target, std::unordered_set<point_2d>& occupied_positions);
+        move_status move_to_nearest(const std::vector<point_2d>& targets, std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// To move the unit to a target with a time sliced search, at most expansion budget nodes are expanded per call
+        /// While the search is running the unit follows the best partial path, the search resumes on the next call
+        /// </summary>
+        /// <param name="target"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="expansion_budget"></param>
+        /// <returns>searching when the search is running and there is no step to take yet</returns>
+        move_status move_incremental(point_2d target, std::unordered_set<point_2d>& occupied_positions, size_t expansion_budget);
+
+        /// <summary>
+        /// To move the unit to a target with paths requested from a shared scheduler instead of searching right away
+        /// The unit waits (searching) until the scheduler served its request, the scheduler is serviced once per tick by its owner
+        /// </summary>
+        /// <param name="target"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scheduler"></param>
+        /// <returns>searching while the request is queued</returns>
+        move_status move_scheduled(point_2d target, std::unordered_set<point_2d>& occupied_positions, replan_scheduler& scheduler);
 
         /// <summary>
         /// Get current position of the unit on the battlefield grid
@@ -34,8 +75,38 @@ namespace path_finding
         /// <returns></returns>
         point_2d get_position() const;
 
+        /// <summary>
+        /// Current path, including the steps already taken
+        /// </summary>
+        /// <returns></returns>
+        const compact_path& get_path() const { return path_; }
+
+        /// <summary>
+        /// Index of the next step in the path
+        /// </summary>
+        /// <returns></returns>
+        size_t get_path_index() const { return path_index_; }
+
+        /// <summary>
+        /// Put the unit back in a captured state, the path reuses the unit's storage when it is large enough
+        /// A running incremental search and a queued path request are dropped
+        /// </summary>
+        /// <param name="position"></param>
+        /// <param name="path_start"></param>
+        /// <param name="path_codes">Packed direction codes as given by compact_path::get_codes</param>
+        /// <param name="path_length"></param>
+        /// <param name="path_index"></param>
+        void restore(point_2d position, point_2d path_start, const std::uint8_t* path_codes, size_t path_length, size_t path_index);
+
     private:
 
+        /// <summary>
+        /// Take the next step along the current path
+        /// </summary>
+        /// <param name="occupied_positions"></param>
+        /// <returns></returns>
+        move_status step(std::unordered_set<point_2d>& occupied_positions);
+
         /// <summary>
         /// Position of the unit
         /// </summary>
@@ -52,8 +123,19 @@ namespace path_finding
         const pathfinder* path_finder_;
 
         /// <summary>
-        /// Unit's path
+        /// Unit's path, the next step is decoded from its direction code at the path index
+        /// </summary>
+        compact_path path_;
+
+        /// <summary>
+        /// Running time sliced search of move_incremental, null when the path is complete
+        /// </summary>
+        std::unique_ptr<incremental_search> search_;
+
+        /// <summary>
+        /// Ticket of the queued path request of move_scheduled and its target, 0 when there is none
         /// </summary>
-        std::vector<point_2d> path_;
+        std::uint64_t replan_ticket_ = 0;
+        point_2d replan_target_;
     };
 }
\ No newline at end of file
@@ -0,0 +1,565 @@
+#pragma once
+
+#include "../headers/moveStatus.hpp"
+#include "../headers/point2d.hpp"
+#include "../headers/pathFinder.hpp"
+#include "../headers/compactPath.hpp"
+#include "../headers/pathTree.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace path_finding
+{
+    class unit_handle;
+
+    /// <summary>
+    /// Settings of the unit store's conflict resolution
+    /// </summary>
+    struct conflict_resolution {
+
+        /// <summary>
+        /// Off: a blocked unit drops its path and searches again on its next move, like unit::move
+        /// </summary>
+        bool enabled = true;
+
+        /// <summary>
+        /// Ticks a unit waits behind a unit that is moving before it detours
+        /// </summary>
+        unsigned max_yield_ticks = 4;
+
+        /// <summary>
+        /// Cap of the exponential back off after failed searches and oscillations, 1, 2, 4, ... ticks without searching
+        /// </summary>
+        unsigned max_backoff_ticks = 32;
+
+        /// <summary>
+        /// Steps back to the previous cell in a row that count as oscillation
+        /// </summary>
+        unsigned oscillation_limit = 3;
+
+        /// <summary>
+        /// Longest wait-for chain followed when looking for a cycle
+        /// </summary>
+        unsigned max_cycle_length = 64;
+    };
+
+    /// <summary>
+    /// Counters of the unit store's searches and conflict resolutions
+    /// </summary>
+    struct conflict_metrics {
+
+        /// <summary>
+        /// Paths searched
+        /// </summary>
+        size_t searches = 0;
+
+        /// <summary>
+        /// Moves spent waiting for another unit or backing off
+        /// </summary>
+        size_t yields = 0;
+
+        /// <summary>
+        /// Head on pairs and wait-for cycles that exchanged cells all at once
+        /// </summary>
+        size_t swaps = 0;
+
+        /// <summary>
+        /// Paths dropped to search around a blocking unit, and wait-for cycles resolved by a rotation or a detour
+        /// </summary>
+        size_t detours = 0, cycles = 0;
+
+        /// <summary>
+        /// Back and forth movements detected
+        /// </summary>
+        size_t oscillations = 0;
+    };
+
+    /// <summary>
+    /// Structure of arrays store for large numbers of units (100k and more).
+    /// Positions, targets, path cursors and statuses live in contiguous arrays indexed by unit id,
+    /// the direction codes of all paths share one pooled buffer: every unit owns a slot of a power of two size,
+    /// freed slots are reused by the next path of the same size class so the buffer stops growing after warm up.
+    /// A tick streams over the arrays in id order with the same rules as unit::move and unit::move_to_nearest,
+    /// but without the console output.
+    /// Unlike unit objects the store knows which unit blocks which, so it resolves conflicts instead of searching again on every tick:
+    /// units coming head on swap cells, a unit behind a moving unit yields for a few ticks, a wait-for cycle rotates
+    /// when every member can step into the next one's cell, otherwise the unit with the highest id (lowest priority) detours,
+    /// and failed searches, detours and oscillations back off exponentially.
+    /// With path sharing, units heading for the same single target keep their paths in one path tree per target:
+    /// a search stops where it meets the path of another unit and the common suffix is stored once.
+    /// Not thread safe
+    /// </summary>
+    class unit_store {
+    public:
+
+        /// <summary>
+        /// Index of a unit in the arrays, units are never removed so ids stay valid
+        /// </summary>
+        using unit_id = std::uint32_t;
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="path_finder">Its battlefield must keep its size while the store is used</param>
+        /// <param name="resource">Resource the arrays and the path buffer are allocated from</param>
+        explicit unit_store(const pathfinder& path_finder, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        /// <summary>
+        /// Change the conflict resolution settings
+        /// </summary>
+        /// <param name="resolution"></param>
+        void set_conflict_resolution(const conflict_resolution& resolution) { resolution_ = resolution; }
+
+        /// <summary>
+        /// Conflict resolution settings
+        /// </summary>
+        /// <returns></returns>
+        const conflict_resolution& get_conflict_resolution() const { return resolution_; }
+
+        /// <summary>
+        /// Searches and conflict resolutions so far
+        /// </summary>
+        /// <returns></returns>
+        const conflict_metrics& get_conflict_metrics() const { return metrics_; }
+
+        /// <summary>
+        /// Share the paths of units heading for the same target (move, and move_to_nearest with a single target)
+        /// in a path tree per target, instead of searching and storing every path in full. Applies to the next searches
+        /// </summary>
+        /// <param name="enabled"></param>
+        void set_path_sharing(const bool enabled) { path_sharing_ = enabled; }
+
+        /// <summary>
+        /// Whether paths are shared
+        /// </summary>
+        /// <returns></returns>
+        bool get_path_sharing() const { return path_sharing_; }
+
+        unit_store(const unit_store&) = delete;
+        unit_store& operator=(const unit_store&) = delete;
+
+        /// <summary>
+        /// Add a unit, its target is its position until set_target
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        unit_id add(point_2d position);
+
+        /// <summary>
+        /// Reserve the arrays for the given number of units
+        /// </summary>
+        /// <param name="count"></param>
+        void reserve(size_t count);
+
+        /// <summary>
+        /// Number of units
+        /// </summary>
+        /// <returns></returns>
+        size_t size() const { return positions_.size(); }
+
+        /// <summary>
+        /// Target of the unit for tick, a new target drops the current path and any back off
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="target"></param>
+        void set_target(unit_id id, point_2d target);
+
+        /// <summary>
+        /// Move every unit one step towards its own target
+        /// </summary>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource">Upstream for the search arenas and the temporary paths, e.g. a tick_arena</param>
+        /// <returns>Number of units that changed cells (moved, swapped or oscillating)</returns>
+        size_t tick(std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// Move every unit one step towards the nearest of the given targets
+        /// </summary>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns>Number of units that changed cells (moved, swapped or oscillating)</returns>
+        size_t tick_to_nearest(const std::vector<point_2d>& targets, std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// Move one unit towards the target, same rules as unit::move plus the conflict resolution
+        /// A swap moves both units, the other unit's next move is then used up by it
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="target"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        move_status move(unit_id id, point_2d target, std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// Move one unit towards the nearest of the targets, same rules as unit::move_to_nearest plus the conflict resolution
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        move_status move_to_nearest(unit_id id, const std::vector<point_2d>& targets, std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource = nullptr);
+
+        /// <summary>
+        /// Handle to a unit
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        unit_handle operator[](unit_id id);
+
+        /// <summary>
+        /// Positions of all the units by id
+        /// </summary>
+        /// <returns></returns>
+        const std::pmr::vector<point_2d>& get_positions() const { return positions_; }
+
+        /// <summary>
+        /// Position of the unit
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        point_2d get_position(const unit_id id) const { return positions_[id]; }
+
+        /// <summary>
+        /// Target of the unit for tick
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        point_2d get_target(const unit_id id) const { return targets_[id]; }
+
+        /// <summary>
+        /// Status of the unit's last move, searching before the first one
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        move_status get_status(const unit_id id) const { return statuses_[id]; }
+
+        /// <summary>
+        /// Index of the next step in the unit's path
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        size_t get_path_index(const unit_id id) const { return path_indices_[id]; }
+
+        /// <summary>
+        /// Number of steps of the unit's path, 0 when it has to be computed on the next move
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        size_t get_path_length(const unit_id id) const { return path_lengths_[id]; }
+
+        /// <summary>
+        /// Direction code of a step of the unit's path
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="index"></param>
+        /// <returns></returns>
+        int get_step(const unit_id id, const size_t index) const {
+            if (path_nodes_[id] != path_tree::no_node)
+                return get_tree_step(id, index);
+            return path_codes_[path_offsets_[id] + index / 4] >> (index % 4 * compact_path::bits_per_step) & 3;
+        }
+
+        /// <summary>
+        /// Decode the unit's path, including the steps already taken
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="resource"></param>
+        /// <returns></returns>
+        compact_path get_path(unit_id id, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+        /// <summary>
+        /// Bytes of the shared path buffer
+        /// </summary>
+        /// <returns></returns>
+        size_t get_path_memory_size() const { return path_codes_.capacity(); }
+
+        /// <summary>
+        /// Nodes of the shared paths, over all targets
+        /// </summary>
+        /// <returns></returns>
+        size_t get_path_tree_node_count() const;
+
+        /// <summary>
+        /// Bytes of the shared paths
+        /// </summary>
+        /// <returns></returns>
+        size_t get_path_tree_memory_size() const;
+
+    private:
+
+        /// <summary>
+        /// Id of no unit, e.g. when a unit waits for nobody
+        /// </summary>
+        static constexpr unit_id no_unit = ~unit_id(0);
+
+        /// <summary>
+        /// Slot class of units without a slot
+        /// </summary>
+        static constexpr std::uint8_t no_slot = 0xff;
+
+        /// <summary>
+        /// Bytes of the smallest slot, 16 steps
+        /// </summary>
+        static constexpr size_t min_slot_size = 4;
+
+        /// <summary>
+        /// Tree index of units without a shared path
+        /// </summary>
+        static constexpr std::uint32_t no_tree = ~std::uint32_t(0);
+
+        /// <summary>
+        /// Copy the path into the unit's slot, swapping the slot for a larger one when needed
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="path"></param>
+        void store_path(unit_id id, const compact_path& path);
+
+        /// <summary>
+        /// Search the unit's path in the tree of the target and hold it
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="target"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns>False when the target cannot be reached</returns>
+        bool search_tree_path(unit_id id, point_2d target, const std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource);
+
+        /// <summary>
+        /// Let go of the unit's shared path, if it has one
+        /// </summary>
+        /// <param name="id"></param>
+        void release_tree_path(unit_id id);
+
+        /// <summary>
+        /// Direction code of a step of the unit's shared path
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="index"></param>
+        /// <returns></returns>
+        int get_tree_step(unit_id id, size_t index) const;
+
+        /// <summary>
+        /// Move the path cursor past the step just taken
+        /// </summary>
+        /// <param name="id"></param>
+        void advance(unit_id id);
+
+        /// <summary>
+        /// Take the next step along the unit's path, the path is dropped when the next position is occupied
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="occupied_positions"></param>
+        /// <returns></returns>
+        move_status step(unit_id id, std::unordered_set<point_2d>& occupied_positions);
+
+        /// <summary>
+        /// Resolve the unit's next cell being taken by the blocker: swap, yield or detour
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="blocker"></param>
+        /// <returns></returns>
+        move_status resolve_conflict(unit_id id, unit_id blocker);
+
+        /// <summary>
+        /// Back off after a failed search or an oscillation, twice as long as the previous time
+        /// </summary>
+        /// <param name="id"></param>
+        void back_off(unit_id id);
+
+        /// <summary>
+        /// Drop the path so the unit searches around what is in its way on its next move
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        move_status detour(unit_id id);
+
+        /// <summary>
+        /// Follow a battlefield that was loaded again with another size: the occupants are laid out for the new grid,
+        /// units outside it are left out, and every unit searches again
+        /// </summary>
+        void fit_battle_field();
+
+        /// <summary>
+        /// Unit standing on the cell
+        /// </summary>
+        /// <param name="position"></param>
+        /// <returns></returns>
+        unit_id& occupant(const point_2d position) {
+            return occupants_[static_cast<size_t>(position.get_y()) * static_cast<size_t>(occupants_width_)
+                + static_cast<size_t>(position.get_x())];
+        }
+
+        /// <summary>
+        /// Cell the unit steps into next, its position when the path is complete
+        /// </summary>
+        /// <param name="id"></param>
+        /// <returns></returns>
+        point_2d get_next_position(unit_id id) const;
+
+        /// <summary>
+        /// Reference to pathfinder
+        /// </summary>
+        const pathfinder* path_finder_;
+
+        /// <summary>
+        /// Per unit arrays, all indexed by unit id: path cursor and length count steps, the offset is the slot in the path buffer
+        /// </summary>
+        std::pmr::vector<point_2d> positions_;
+        std::pmr::vector<point_2d> targets_;
+        std::pmr::vector<std::uint32_t> path_indices_;
+        std::pmr::vector<std::uint32_t> path_lengths_;
+        std::pmr::vector<std::uint32_t> path_offsets_;
+        std::pmr::vector<std::uint8_t> path_slot_classes_;
+        std::pmr::vector<move_status> statuses_;
+
+        /// <summary>
+        /// Conflict state by unit id: the unit it waits for, ticks waited behind it, ticks left to back off,
+        /// failures in a row (the back off exponent), cell before the last step, steps back to it in a row,
+        /// and whether a swap used up the next move
+        /// </summary>
+        std::pmr::vector<unit_id> waiting_for_;
+        std::pmr::vector<std::uint16_t> waited_ticks_;
+        std::pmr::vector<std::uint16_t> backoff_ticks_;
+        std::pmr::vector<std::uint8_t> failures_;
+        std::pmr::vector<point_2d> previous_positions_;
+        std::pmr::vector<std::uint8_t> reversals_;
+        std::pmr::vector<std::uint8_t> swapped_;
+
+        /// <summary>
+        /// Unit standing on each cell of the battlefield, row by row, no_unit where there is none, and the grid size it was laid out for
+        /// </summary>
+        std::pmr::vector<unit_id> occupants_;
+        int occupants_width_ = 0;
+        int occupants_height_ = 0;
+
+        /// <summary>
+        /// Members of the wait-for chain being resolved, kept to reuse its storage
+        /// </summary>
+        std::pmr::vector<unit_id> cycle_;
+
+        conflict_resolution resolution_;
+        conflict_metrics metrics_;
+
+        /// <summary>
+        /// Direction codes of every path, a slot of min_slot_size << class bytes per unit
+        /// </summary>
+        std::pmr::vector<std::uint8_t> path_codes_;
+
+        /// <summary>
+        /// Offsets of the free slots by class
+        /// </summary>
+        std::pmr::vector<std::pmr::vector<std::uint32_t>> free_slots_;
+
+        /// <summary>
+        /// Shared paths by unit id: the tree, the node of the path's start (held) and the node of the unit's cell.
+        /// The slot of a unit is not read while it has a shared path
+        /// </summary>
+        std::pmr::vector<std::uint32_t> path_trees_;
+        std::pmr::vector<path_tree::node_id> path_nodes_;
+        std::pmr::vector<path_tree::node_id> path_cursors_;
+
+        /// <summary>
+        /// A path tree per target, and the tree of each target
+        /// </summary>
+        std::pmr::deque<path_tree> trees_;
+        std::pmr::unordered_map<point_2d, std::uint32_t> tree_ids_;
+        bool path_sharing_ = false;
+    };
+
+    /// <summary>
+    /// Thin handle to a unit of a unit_store: the store and an id, cheap to copy,
+    /// valid as long as the store. Offers the unit interface on top of the arrays
+    /// </summary>
+    class unit_handle {
+    public:
+
+        /// <summary>
+        /// Constructor
+        /// </summary>
+        /// <param name="store"></param>
+        /// <param name="id"></param>
+        unit_handle(unit_store& store, const unit_store::unit_id id) : store_(&store), id_(id) {}
+
+        /// <summary>
+        /// To move the unit to a new target position
+        /// </summary>
+        /// <param name="target"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        move_status move(const point_2d target, std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource = nullptr) const {
+            return store_->move(id_, target, occupied_positions, scratch_resource);
+        }
+
+        /// <summary>
+        /// To move the unit towards the nearest of the given targets
+        /// </summary>
+        /// <param name="targets"></param>
+        /// <param name="occupied_positions"></param>
+        /// <param name="scratch_resource"></param>
+        /// <returns></returns>
+        move_status move_to_nearest(const std::vector<point_2d>& targets, std::unordered_set<point_2d>& occupied_positions,
+            std::pmr::memory_resource* scratch_resource = nullptr) const {
+            return store_->move_to_nearest(id_, targets, occupied_positions, scratch_resource);
+        }
+
+        /// <summary>
+        /// Id of the unit in the store
+        /// </summary>
+        /// <returns></returns>
+        unit_store::unit_id get_id() const { return id_; }
+
+        /// <summary>
+        /// Get current position of the unit on the battlefield grid
+        /// </summary>
+        /// <returns></returns>
+        point_2d get_position() const { return store_->get_position(id_); }
+
+        /// <summary>
+        /// Status of the last move
+        /// </summary>
+        /// <returns></returns>
+        move_status get_status() const { return store_->get_status(id_); }
+
+        /// <summary>
+        /// Index of the next step in the path
+        /// </summary>
+        /// <returns></returns>
+        size_t get_path_index() const { return store_->get_path_index(id_); }
+
+        /// <summary>
+        /// Current path, including the steps already taken
+        /// </summary>
+        /// <returns></returns>
+        compact_path get_path() const { return store_->get_path(id_); }
+
+    private:
+
+        /// <summary>
+        /// Store the unit lives in and its index there
+        /// </summary>
+        unit_store* store_;
+        unit_store::unit_id id_;
+    };
+
+    /// <summary>
+    /// Handle to a unit
+    /// </summary>
+    /// <param name="id"></param>
+    /// <returns></returns>
+    inline unit_handle unit_store::operator[](const unit_id id) { return unit_handle(*this, id); }
+}
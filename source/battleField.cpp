@@ -1,10 +1,11 @@
 #include "../headers/battleField.hpp"
+#include "../headers/parallelFor.hpp"
 
 #include <random>
 #include <windows.h>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
-#include <unordered_set>
 #include <nlohmann/json.hpp>
 
 /// <summary>
@@ -20,7 +21,39 @@ namespace path_finding
     battle_field::battle_field() :
         width_(0), height_(0) {
         // Default the entire grid is walkable
-        grid_.resize(height_, std::vector(width_, tile_type::walkable));
+        grid_.resize(static_cast<size_t>(width_) * height_, tile_type::walkable);
+    }
+
+    /// <summary>
+    /// Copy constructor, copies only the map data
+    /// </summary>
+    /// <param name="other"></param>
+    battle_field::battle_field(const battle_field& other) :
+        width_(other.width_), height_(other.height_), grid_(other.grid_), layout_(other.layout_),
+        start_positions_(other.start_positions_), target_positions_(other.target_positions_), seed_(other.seed_),
+        version_(other.version_), published_version_(other.version_) {
+    }
+
+    /// <summary>
+    /// Copy assignment, copies only the map data
+    /// </summary>
+    /// <param name="other"></param>
+    /// <returns></returns>
+    battle_field& battle_field::operator=(const battle_field& other) {
+        if (this != &other) {
+            width_ = other.width_;
+            height_ = other.height_;
+            grid_ = other.grid_;
+            layout_ = other.layout_;
+            start_positions_ = other.start_positions_;
+            target_positions_ = other.target_positions_;
+            seed_ = other.seed_;
+            version_ = other.version_;
+            published_version_ = other.version_;
+            dirty_cells_.clear();
+            dirty_flags_.clear();
+        }
+        return *this;
     }
 
     /// <summary>
@@ -100,17 +133,18 @@ namespace path_finding
         // Calculate the grid size
         width_ = canvas_width_int / tile_width_int;
         height_ = canvas_height_int / tile_height_int; 
+        seed_ = 0;
 
         // Resize the grid (height x width)
-        grid_.resize(height_);
-        for (auto& row : grid_) {
-            row.resize(width_, tile_type::walkable);
-        }
+        grid_.assign(static_cast<size_t>(width_) * height_, tile_type::walkable);
+        start_positions_.clear();
+        target_positions_.clear();
+        reset_changes();
 
         // Load battlefield data into the grid
         const auto& layer_data = map_data["layers"][0]["data"];
         if (layer_data.is_array()) {
-            for (size_t i = 0; i < layer_data.size(); ++i) {
+            for (size_t i = 0; i < std::min(layer_data.size(), grid_.size()); ++i) {
                 int x = static_cast<int>(i) % width_;
                 int y = static_cast<int>(i) / width_;
                 int type = layer_data[i];
@@ -135,9 +169,142 @@ namespace path_finding
                 if (tile_type == tile_type::target)
                     target_positions_.emplace_back(x, y);
 
-                grid_[y][x] = tile_type;
+                grid_[i] = tile_type;
+            }
+        }
+        arrange_tiles();
+    }
+
+    /// <summary>
+    /// Mix a seed with a stream index (splitmix64) so every chunk of the grid gets an independent random engine
+    /// </summary>
+    /// <param name="seed"></param>
+    /// <param name="stream"></param>
+    /// <returns></returns>
+    static std::uint64_t mix_seed(const std::uint64_t seed, const std::uint64_t stream)
+    {
+        auto z = seed + (stream + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /// <summary>
+    /// Full 64 x 64 bit product, split in its high and low words (no 128 bit integer type needed)
+    /// </summary>
+    /// <param name="a"></param>
+    /// <param name="b"></param>
+    /// <param name="high"></param>
+    /// <returns>The low word</returns>
+    static std::uint64_t multiply_wide(const std::uint64_t a, const std::uint64_t b, std::uint64_t& high)
+    {
+        const std::uint64_t a_low = a & 0xFFFFFFFFull, a_high = a >> 32;
+        const std::uint64_t b_low = b & 0xFFFFFFFFull, b_high = b >> 32;
+        const auto low_low = a_low * b_low;
+        const auto high_low = a_high * b_low;
+        const auto low_high = a_low * b_high;
+        const auto middle = (low_low >> 32) + (high_low & 0xFFFFFFFFull) + (low_high & 0xFFFFFFFFull);
+        high = a_high * b_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+        return (middle << 32) | (low_low & 0xFFFFFFFFull);
+    }
+
+    /// <summary>
+    /// Unbiased integer in [0, range) straight from the engine output (Lemire's multiply and reject)
+    /// Unlike std::uniform_int_distribution the result is the same with every standard library
+    /// </summary>
+    /// <param name="range"></param>
+    /// <param name="gen"></param>
+    /// <returns></returns>
+    static std::uint64_t bounded(const std::uint64_t range, std::mt19937_64& gen)
+    {
+        std::uint64_t high;
+        auto low = multiply_wide(gen(), range, high);
+        if (low < range) {
+            const auto threshold = (0 - range) % range;
+            while (low < threshold)
+                low = multiply_wide(gen(), range, high);
+        }
+        return high;
+    }
+
+    /// <summary>
+    /// Number of set bits
+    /// </summary>
+    /// <param name="bits"></param>
+    /// <returns></returns>
+    static size_t count_bits(std::uint64_t bits)
+    {
+        bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+        bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+        bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        return static_cast<size_t>((bits * 0x0101010101010101ull) >> 56);
+    }
+
+    /// <summary>
+    /// Binomial draw of trials with success probability numerator / denominator, straight from the engine output
+    /// 64 trials at a time: every trial compares its own random bits with the binary expansion of the probability
+    /// (taken by long division, so it is exact) and stops as soon as the comparison is decided for all of them
+    /// Unlike std::binomial_distribution the result is the same with every standard library
+    /// </summary>
+    /// <param name="trials"></param>
+    /// <param name="numerator">Not more than denominator</param>
+    /// <param name="denominator">Below 2^63</param>
+    /// <param name="gen"></param>
+    /// <returns></returns>
+    static size_t binomial(size_t trials, const std::uint64_t numerator, const std::uint64_t denominator, std::mt19937_64& gen)
+    {
+        size_t successes = 0;
+        while (trials > 0 && numerator > 0) {
+            const auto block = std::min<size_t>(trials, 64);
+            std::uint64_t below = 0;
+            auto undecided = block == 64 ? ~0ull : (1ull << block) - 1;
+            auto remainder = numerator;
+            while (undecided != 0) {
+                remainder *= 2;
+                const auto bit = remainder >= denominator;
+                if (bit)
+                    remainder -= denominator;
+                const auto random = gen();
+                if (bit) {
+                    below |= undecided & ~random;
+                    undecided &= random;
+                }
+                else
+                    undecided &= ~random;
+                // The rest of the expansion is zero, the undecided trials can only tie or end above
+                if (remainder == 0)
+                    break;
             }
+            successes += count_bits(below);
+            trials -= block;
+        }
+        return successes;
+    }
+
+    /// <summary>
+    /// Distribute count picks over buckets of the given sizes, as if the picks were drawn without replacement from all buckets together
+    /// Each bucket gets a binomial share of what is left, clamped so the remaining buckets can always take the rest
+    /// </summary>
+    /// <param name="sizes"></param>
+    /// <param name="count"></param>
+    /// <param name="gen"></param>
+    /// <returns></returns>
+    static std::vector<size_t> split_count(const std::vector<size_t>& sizes, size_t count, std::mt19937_64& gen)
+    {
+        std::vector<size_t> counts(sizes.size(), 0);
+        size_t remaining_cells = 0;
+        for (const auto size : sizes)
+            remaining_cells += size;
+
+        for (size_t i = 0; i < sizes.size() && count > 0; ++i) {
+            const auto remaining_after = remaining_cells - sizes[i];
+            const auto low = count > remaining_after ? count - remaining_after : 0;
+            const auto high = std::min(sizes[i], count);
+            counts[i] = std::clamp(binomial(sizes[i], count, remaining_cells, gen), low, high);
+            count -= counts[i];
+            remaining_cells = remaining_after;
         }
+        return counts;
     }
 
     /// <summary>
@@ -148,6 +315,28 @@ namespace path_finding
     /// <param name="number_of_units"></param>
     /// <param name="number_of_terrains"></param>
     void battle_field::generate_random_field(int width, int height, int number_of_units, int number_of_terrains)
+    {
+        std::random_device rd;
+        const auto seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+        generate_random_field(width, height, number_of_units, number_of_terrains, seed);
+    }
+
+    /// <summary>
+    /// Reproducible random battlefield grid (there will be only one target for all the units)
+    /// 1. Target is drawn uniformly from the whole grid
+    /// 2. Grid is cut into fixed size chunks and the terrain and unit counts are split between them
+    /// 3. Each chunk draws its cells without replacement with its own engine, in parallel:
+    ///    sparse chunks by rejection against the grid itself (used as the bitmap), dense ones with a partial Fisher-Yates
+    /// 4. Terrains are drawn first, units only from the remaining walkable cells
+    /// Every draw is derived from the raw mt19937_64 output (no std distributions), so the grid does not depend on the standard library
+    /// </summary>
+    /// <param name="width"></param>
+    /// <param name="height"></param>
+    /// <param name="number_of_units"></param>
+    /// <param name="number_of_terrains"></param>
+    /// <param name="seed"></param>
+    void battle_field::generate_random_field(int width, int height, int number_of_units, int number_of_terrains,
+        const std::uint64_t seed)
     {
         // Check for the valid width and height for the battlefield grid
         if (width <= 0 || height <= 0)
@@ -157,9 +346,9 @@ namespace path_finding
             throw std::runtime_error(ss.str());
         }
 
-        auto grid_size = width * height;
+        const auto grid_size = static_cast<size_t>(width) * height;
         // Check for number of units
-        if (number_of_units >= grid_size)
+        if (number_of_units < 0 || static_cast<size_t>(number_of_units) >= grid_size)
         {
             std::stringstream ss;
             ss << "Entered number of units are more than battlefield size";
@@ -167,73 +356,139 @@ namespace path_finding
         }
 
         // Check for number of terrains
-        if (number_of_terrains >= grid_size)
+        if (number_of_terrains < 0 || static_cast<size_t>(number_of_terrains) >= grid_size)
         {
             std::stringstream ss;
             ss << "Entered number of terrains are more than battlefield size";
             throw std::runtime_error(ss.str());
         }
 
+        // Units, terrains and the target must all fit
+        if (static_cast<size_t>(number_of_units) + number_of_terrains >= grid_size)
+        {
+            std::stringstream ss;
+            ss << "Entered number of units and terrains are more than battlefield size";
+            throw std::runtime_error(ss.str());
+        }
+
         // Set member variables
         width_ = width;
         height_ = height;
+        start_positions_.clear();
+        target_positions_.clear();
+        reset_changes();
+
+        seed_ = seed;
 
         // Create a walkable grid
-        grid_.resize(height);
-        for (auto& row : grid_) {
-            row.resize(width, tile_type::walkable);
+        grid_.assign(grid_size, tile_type::walkable);
+
+        // Add target (only one target supported)
+        std::mt19937_64 gen(seed);
+        const auto target_index = static_cast<size_t>(bounded(grid_size, gen));
+        grid_[target_index] = tile_type::target;
+        target_positions_.emplace_back(static_cast<int>(target_index % width), static_cast<int>(target_index / width));
+
+        // Split the terrains and then the units between the chunks
+        const auto chunk_count = (grid_size + generator_chunk_size - 1) / generator_chunk_size;
+        std::vector<size_t> free_cells(chunk_count);
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            const auto begin = chunk * generator_chunk_size;
+            const auto end = std::min(grid_size, begin + generator_chunk_size);
+            free_cells[chunk] = end - begin - (target_index >= begin && target_index < end ? 1 : 0);
         }
+        const auto chunk_terrains = split_count(free_cells, number_of_terrains, gen);
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk)
+            free_cells[chunk] -= chunk_terrains[chunk];
+        const auto chunk_units = split_count(free_cells, number_of_units, gen);
+
+        // Fill the chunks in parallel, every chunk only writes its own cells
+        std::vector<std::vector<point_2d>> chunk_unit_positions(chunk_count);
+        parallel_for(chunk_count, [&](const size_t chunk) {
+            const auto begin = chunk * generator_chunk_size;
+            const auto end = std::min(grid_size, begin + generator_chunk_size);
+            std::mt19937_64 chunk_gen(mix_seed(seed, chunk));
+            auto& unit_positions = chunk_unit_positions[chunk];
+            unit_positions.reserve(chunk_units[chunk]);
+
+            const auto place = [&](const size_t index, const bool is_terrain) {
+                if (is_terrain) {
+                    grid_[index] = tile_type::elevated;
+                    return;
+                }
+                grid_[index] = tile_type::start;
+                unit_positions.emplace_back(static_cast<int>(index % width), static_cast<int>(index / width));
+            };
+
+            const auto picks = chunk_terrains[chunk] + chunk_units[chunk];
+            if (picks * 4 <= end - begin) {
+                // Sparse chunk: rejection sampling, the grid tells which cells are still free
+                for (size_t k = 0; k < picks; ++k) {
+                    auto index = begin + static_cast<size_t>(bounded(end - begin, chunk_gen));
+                    while (grid_[index] != tile_type::walkable)
+                        index = begin + static_cast<size_t>(bounded(end - begin, chunk_gen));
+                    place(index, k < chunk_terrains[chunk]);
+                }
+                return;
+            }
 
-        auto min_point = point_2d(0, 0);
-        auto max_point = point_2d(width - 1, height - 1);
+            // Dense chunk: partial Fisher-Yates over the free cells
+            std::vector<std::uint32_t> cells;
+            cells.reserve(end - begin);
+            for (auto index = begin; index < end; ++index)
+                if (index != target_index)
+                    cells.push_back(static_cast<std::uint32_t>(index - begin));
+            for (size_t k = 0; k < picks; ++k) {
+                const auto j = k + static_cast<size_t>(bounded(cells.size() - k, chunk_gen));
+                std::swap(cells[k], cells[j]);
+                place(begin + cells[k], k < chunk_terrains[chunk]);
+            }
+        });
 
-        // Add target (only one target supported)
-        const auto target = generate_random_point(min_point, max_point);
-        grid_[target.get_y()][target.get_x()] = tile_type::target;
-        target_positions_.push_back(target);
-
-        // Add number of terrains
-        auto terrain_positions = std::unordered_set<point_2d>();
-        auto number_of_terrain_counter = 0;
-        while (number_of_terrain_counter < number_of_terrains)
+        // Unit start positions in chunk order
+        start_positions_.reserve(number_of_units);
+        for (const auto& unit_positions : chunk_unit_positions)
+            start_positions_.insert(start_positions_.end(), unit_positions.begin(), unit_positions.end());
+        arrange_tiles();
+    }
+
+    /// <summary>
+    /// Create a battlefield grid from row major tiles, start and target positions are collected from the tiles
+    /// </summary>
+    /// <param name="width"></param>
+    /// <param name="height"></param>
+    /// <param name="tiles"></param>
+    void battle_field::load_from_tiles(const int width, const int height, const std::vector<tile_type>& tiles)
+    {
+        // Check for the valid width and height for the battlefield grid
+        if (width <= 0 || height <= 0 || tiles.size() != static_cast<size_t>(width) * height)
         {
-            // Randomly generated new point on the grid 
-            const auto new_point = generate_random_point(min_point, max_point);
-
-            // Add a new position as terrains position when
-            // 1. A tile is not a terrain
-            // 3. Not a target
-            if (terrain_positions.find(new_point) == terrain_positions.end() &&
-                new_point != target)
-            {
-                terrain_positions.emplace(new_point);
-                grid_[new_point.get_y()][new_point.get_x()] = tile_type::elevated;
-                number_of_terrain_counter++;
-            }
+            std::stringstream ss;
+            ss << "Invalid battlefield grid size: (" << width << ", " << height << ") for " << tiles.size() << " tiles";
+            throw std::runtime_error(ss.str());
         }
 
-        // Add number of units
-        auto number_of_unit_counter = 0;
-        auto unit_positions = std::unordered_set<point_2d>();
-        while (number_of_unit_counter < number_of_units)
-        {
-            // Randomly generated new point on the grid 
-            const auto new_point = generate_random_point(min_point, max_point);
-
-            // Add a new position as unit position when
-			// 1. Not a terrain
-			// 2. Not a target
-            // 3. Not occupied by unit
-            if (unit_positions.find(new_point) == unit_positions.end() &&
-                terrain_positions.find(new_point) != terrain_positions.end() &&
-                new_point != target)
-            {
-                unit_positions.emplace(new_point);
-                grid_[new_point.get_y()][new_point.get_x()] = tile_type::start;
-                start_positions_.push_back(new_point);
-                number_of_unit_counter++;
+        // Set member variables
+        width_ = width;
+        height_ = height;
+        start_positions_.clear();
+        target_positions_.clear();
+        reset_changes();
+
+        seed_ = 0;
+
+        // Copy the tiles and collect the start and target positions
+        grid_ = tiles;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const auto tile = grid_[static_cast<size_t>(y) * width + x];
+                if (tile == tile_type::start)
+                    start_positions_.emplace_back(x, y);
+                if (tile == tile_type::target)
+                    target_positions_.emplace_back(x, y);
             }
         }
+        arrange_tiles();
     }
 
     /// <summary>
@@ -253,20 +508,339 @@ namespace path_finding
         }
 
         // Allow walkable, start, and target positions
-        const auto tile_type = grid_[y][x];
+        const auto tile_type = grid_[layout_.index_of(position)];
         return tile_type == tile_type::start ||
             tile_type == tile_type::target ||
             tile_type == tile_type::walkable;
     }
 
+    /// <summary>
+    /// Set one tile and keep the start/target positions and the dirty list up to date
+    /// </summary>
+    /// <param name="position"></param>
+    /// <param name="type"></param>
+    /// <returns></returns>
+    bool battle_field::write_tile(const point_2d position, const tile_type type)
+    {
+        auto& tile = grid_[index_of(position)];
+        if (tile == type)
+            return false;
+
+        // Keep the position lists in line with the tiles
+        const auto remove_position = [&](std::vector<point_2d>& positions) {
+            positions.erase(std::remove(positions.begin(), positions.end(), position), positions.end());
+        };
+        if (tile == tile_type::start)
+            remove_position(start_positions_);
+        if (tile == tile_type::target)
+            remove_position(target_positions_);
+        if (type == tile_type::start)
+            start_positions_.push_back(position);
+        if (type == tile_type::target)
+            target_positions_.push_back(position);
+        tile = type;
+
+        // List each cell only once until the next publish
+        if (dirty_flags_.size() != grid_.size())
+            dirty_flags_.assign(grid_.size(), false);
+        if (!dirty_flags_[index_of(position)]) {
+            dirty_flags_[index_of(position)] = true;
+            dirty_cells_.push_back(position);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Grid is replaced as a whole by a loader: new version and nothing pending
+    /// </summary>
+    void battle_field::reset_changes()
+    {
+        version_++;
+        published_version_ = version_;
+        dirty_cells_.clear();
+        dirty_flags_.clear();
+    }
+
+    /// <summary>
+    /// Copy the captured data over the current grid and positions
+    /// </summary>
+    /// <param name="width"></param>
+    /// <param name="height"></param>
+    /// <param name="tiles"></param>
+    /// <param name="start_positions"></param>
+    /// <param name="start_count"></param>
+    /// <param name="target_positions"></param>
+    /// <param name="target_count"></param>
+    /// <param name="version"></param>
+    /// <param name="seed"></param>
+    void battle_field::restore(const int width, const int height, const tile_type* tiles, const point_2d* start_positions,
+        const size_t start_count, const point_2d* target_positions, const size_t target_count, const std::uint64_t version,
+        const std::uint64_t seed)
+    {
+        if (width <= 0 || height <= 0)
+        {
+            std::stringstream ss;
+            ss << "Invalid battlefield grid size: (" << width << ", " << height << ")";
+            throw std::runtime_error(ss.str());
+        }
+
+        width_ = width;
+        height_ = height;
+        grid_.assign(tiles, tiles + static_cast<size_t>(width) * height);
+        arrange_tiles();
+        start_positions_.assign(start_positions, start_positions + start_count);
+        target_positions_.assign(target_positions, target_positions + target_count);
+        reset_changes();
+        seed_ = seed;
+        version_ = version;
+        published_version_ = version;
+    }
+
+    /// <summary>
+    /// Change a single tile
+    /// </summary>
+    /// <param name="position"></param>
+    /// <param name="type"></param>
+    void battle_field::set_tile(const point_2d position, const tile_type type)
+    {
+        if (!contains(position))
+        {
+            std::stringstream ss;
+            ss << "Tile position outside of the battlefield: (" << position.get_x() << ", " << position.get_y() << ")";
+            throw std::runtime_error(ss.str());
+        }
+
+        if (write_tile(position, type))
+            version_++;
+    }
+
+    /// <summary>
+    /// Change a rectangle of tiles with one version bump
+    /// </summary>
+    /// <param name="min"></param>
+    /// <param name="max"></param>
+    /// <param name="type"></param>
+    void battle_field::set_tiles(const point_2d min, const point_2d max, const tile_type type)
+    {
+        // Clip the rectangle to the grid
+        const auto min_x = std::max(0, std::min(min.get_x(), max.get_x()));
+        const auto min_y = std::max(0, std::min(min.get_y(), max.get_y()));
+        const auto max_x = std::min(width_ - 1, std::max(min.get_x(), max.get_x()));
+        const auto max_y = std::min(height_ - 1, std::max(min.get_y(), max.get_y()));
+
+        auto changed = false;
+        for (auto y = min_y; y <= max_y; ++y)
+            for (auto x = min_x; x <= max_x; ++x)
+                changed = write_tile(point_2d(x, y), type) || changed;
+        if (changed)
+            version_++;
+    }
+
+    /// <summary>
+    /// Check every position first so a bad list leaves the grid as it was, then change the tiles with one version bump
+    /// </summary>
+    /// <param name="tiles"></param>
+    void battle_field::set_tiles(const std::vector<std::pair<point_2d, tile_type>>& tiles)
+    {
+        for (const auto& [position, type] : tiles) {
+            if (!contains(position))
+            {
+                std::stringstream ss;
+                ss << "Tile position outside of the battlefield: (" << position.get_x() << ", " << position.get_y() << ")";
+                throw std::runtime_error(ss.str());
+            }
+        }
+
+        auto changed = false;
+        for (const auto& [position, type] : tiles)
+            changed = write_tile(position, type) || changed;
+        if (changed)
+            version_++;
+    }
+
+    /// <summary>
+    /// Publish the pending edits to the subscribers and the snapshot
+    /// </summary>
+    /// <returns></returns>
+    const map_changes& battle_field::publish_changes()
+    {
+        published_changes_.previous_version = published_version_;
+        published_changes_.version = version_;
+        published_changes_.cells.swap(dirty_cells_);
+        dirty_cells_.clear();
+        for (const auto& cell : published_changes_.cells)
+            dirty_flags_[index_of(cell)] = false;
+        published_version_ = version_;
+
+        if (!published_changes_.empty()) {
+            // Readers keep whichever snapshot they loaded, the new one is swapped in atomically
+            if (snapshots_enabled_)
+                std::atomic_store(&snapshot_, std::shared_ptr<const battle_field>(std::make_shared<battle_field>(*this)));
+
+            for (const auto& [id, listener] : listeners_)
+                listener(published_changes_);
+        }
+        return published_changes_;
+    }
+
+    /// <summary>
+    /// Add a subscriber
+    /// </summary>
+    /// <param name="listener"></param>
+    /// <returns></returns>
+    size_t battle_field::subscribe(change_listener listener)
+    {
+        listeners_.emplace_back(next_listener_id_, std::move(listener));
+        return next_listener_id_++;
+    }
+
+    /// <summary>
+    /// Remove a subscriber
+    /// </summary>
+    /// <param name="subscription_id"></param>
+    void battle_field::unsubscribe(const size_t subscription_id)
+    {
+        listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+            [&](const auto& listener) { return listener.first == subscription_id; }), listeners_.end());
+    }
+
+    /// <summary>
+    /// Start publishing snapshots
+    /// </summary>
+    void battle_field::enable_snapshots()
+    {
+        snapshots_enabled_ = true;
+        std::atomic_store(&snapshot_, std::shared_ptr<const battle_field>(std::make_shared<battle_field>(*this)));
+    }
+
+    /// <summary>
+    /// Latest published snapshot
+    /// </summary>
+    /// <returns></returns>
+    std::shared_ptr<const battle_field> battle_field::get_snapshot() const
+    {
+        return std::atomic_load(&snapshot_);
+    }
+
+    /// <summary>
+    /// Generate random 2D point within min and max (inclusive), the engine is created once per thread
+    /// </summary>
+    /// <param name="min"></param>
+    /// <param name="max"></param>
+    /// <returns></returns>
     point_2d battle_field::generate_random_point(point_2d min, point_2d max)
     {
-        std::random_device rd;              
-        std::mt19937 gen(rd());
+        thread_local std::mt19937 gen(std::random_device{}());
 
         // Randomly generate x and y components 
         std::uniform_int_distribution x_dist(min.get_x(), max.get_x());
         std::uniform_int_distribution y_dist(min.get_y(), max.get_y());
         return point_2d(x_dist(gen), y_dist(gen));
     }
+
+    /// <summary>
+    /// FNV-1a over the grid size followed by the tiles
+    /// </summary>
+    /// <returns></returns>
+    std::uint64_t battle_field::get_content_hash() const
+    {
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        const auto mix = [&](const unsigned char byte) {
+            hash ^= byte;
+            hash *= 0x100000001B3ull;
+        };
+        for (const auto value : { width_, height_ })
+            for (int shift = 0; shift < 32; shift += 8)
+                mix(static_cast<unsigned char>(static_cast<unsigned>(value) >> shift));
+        // Row major whatever the layout, the hash names the map content
+        for (int y = 0; y < height_; ++y)
+            for (int x = 0; x < width_; ++x)
+                mix(static_cast<unsigned char>(grid_[layout_.index_of(point_2d(x, y))]));
+        return hash;
+    }
+
+    /// <summary>
+    /// Copy the grid row by row
+    /// </summary>
+    /// <returns></returns>
+    std::vector<std::vector<tile_type>> battle_field::get_battlefield_grid() const
+    {
+        std::vector<std::vector<tile_type>> rows(height_, std::vector<tile_type>(width_));
+        for (int y = 0; y < height_; ++y)
+            copy_row(y, rows[y].data());
+        return rows;
+    }
+
+    /// <summary>
+    /// Row major copy of the tiles
+    /// </summary>
+    /// <returns></returns>
+    std::vector<tile_type> battle_field::get_row_major_tiles() const
+    {
+        std::vector<tile_type> tiles(static_cast<size_t>(width_) * height_);
+        copy_row_major_tiles(tiles.data());
+        return tiles;
+    }
+
+    /// <summary>
+    /// One copy for the row major layout, row by row otherwise
+    /// </summary>
+    /// <param name="tiles"></param>
+    void battle_field::copy_row_major_tiles(tile_type* tiles) const
+    {
+        if (layout_.get_type() == grid_layout_type::row_major) {
+            std::copy(grid_.begin(), grid_.end(), tiles);
+            return;
+        }
+        for (int y = 0; y < height_; ++y)
+            copy_row(y, tiles + static_cast<size_t>(y) * width_);
+    }
+
+    /// <summary>
+    /// Rearrange the tiles, from row major back to the layout type
+    /// </summary>
+    /// <param name="type"></param>
+    void battle_field::set_layout(const grid_layout_type type)
+    {
+        if (type == layout_.get_type())
+            return;
+        grid_ = get_row_major_tiles();
+        layout_ = grid_layout(type, width_, height_);
+        arrange_tiles();
+        // Pending changes keep their flags at the new indexes
+        dirty_flags_.assign(dirty_cells_.empty() ? 0 : grid_.size(), false);
+        for (const auto& cell : dirty_cells_)
+            dirty_flags_[index_of(cell)] = true;
+    }
+
+    /// <summary>
+    /// Row major grids are used as they are, others are copied cell by cell into a grid padded with elevated tiles
+    /// </summary>
+    void battle_field::arrange_tiles()
+    {
+        layout_ = grid_layout(layout_.get_type(), width_, height_);
+        if (layout_.get_type() == grid_layout_type::row_major)
+            return;
+
+        std::vector<tile_type> arranged(layout_.get_cell_count(), tile_type::elevated);
+        for (int y = 0; y < height_; ++y)
+            for (int x = 0; x < width_; ++x)
+                arranged[layout_.index_of(point_2d(x, y))] = grid_[static_cast<size_t>(y) * width_ + x];
+        grid_.swap(arranged);
+    }
+
+    /// <summary>
+    /// Copy one row of tiles in row major order
+    /// </summary>
+    /// <param name="y"></param>
+    /// <param name="row"></param>
+    void battle_field::copy_row(const int y, tile_type* row) const
+    {
+        if (layout_.get_type() == grid_layout_type::row_major) {
+            std::copy_n(grid_.begin() + static_cast<std::ptrdiff_t>(y) * width_, width_, row);
+            return;
+        }
+        for (int x = 0; x < width_; ++x)
+            row[x] = grid_[layout_.index_of(point_2d(x, y))];
+    }
 } 
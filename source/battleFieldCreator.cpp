@@ -10,6 +10,18 @@ namespace path_finding
 	/// </summary>
 	battle_field battle_field_creator::create()
 	{
+		std::string config_file;
+		return create(config_file);
+	}
+
+	/// <summary>
+	/// Create battlefield based on the user input, and tell where it was loaded from
+	/// </summary>
+	/// <param name="config_file"></param>
+	battle_field battle_field_creator::create(std::string& config_file)
+	{
+		config_file.clear();
+
 		// Ask for grid generator selection
 		auto grid_generator_selection = 0;
 		std::cout << "[1] Load default JSON file " << "\n";
@@ -28,10 +40,11 @@ namespace path_finding
 		case 1:
 			{
 				// Load battlefield configuration from a JSON file
-				std::string config_file = "../resources/tile_set_woodland_1.json";
-				if (!std::filesystem::exists(config_file))
-					throw std::runtime_error("Resource file not found: " + config_file);
-				battle_field.load_from_json(config_file);
+				const std::string default_file = "../resources/tile_set_woodland_1.json";
+				if (!std::filesystem::exists(default_file))
+					throw std::runtime_error("Resource file not found: " + default_file);
+				battle_field.load_from_json(default_file);
+				config_file = default_file;
 				break;
 			}
 		case 2:
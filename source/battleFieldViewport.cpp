@@ -0,0 +1,341 @@
+#include "../headers/battleFieldViewport.hpp"
+
+#include <algorithm>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Round down to a multiple of the block size, also for negative values
+    /// </summary>
+    /// <param name="value"></param>
+    /// <param name="block"></param>
+    /// <returns></returns>
+    static int align_down(const int value, const int block)
+    {
+        return (value >= 0 ? value / block : (value - block + 1) / block) * block;
+    }
+
+    /// <summary>
+    /// Glyph for the share of obstacles in a block
+    /// </summary>
+    /// <param name="obstacles"></param>
+    /// <param name="tiles"></param>
+    /// <returns></returns>
+    static char density_glyph(const std::uint32_t obstacles, const std::uint32_t tiles)
+    {
+        if (obstacles == 0 || tiles == 0)
+            return ' ';
+        if (obstacles * 4 < tiles)
+            return '.';
+        if (obstacles * 2 < tiles)
+            return ':';
+        if (obstacles * 4 < tiles * 3)
+            return '*';
+        return '#';
+    }
+
+    /// <summary>
+    /// Constructor, the window starts in the top left corner at level 0
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="frame_width"></param>
+    /// <param name="frame_height"></param>
+    battle_field_viewport::battle_field_viewport(const battle_field& battle_field, const int frame_width, const int frame_height) :
+        battle_field_(&battle_field),
+        columns_(std::max(1, (frame_width - 2) / 2)), rows_(std::max(1, frame_height - 2))
+    {
+        frame_.resize(static_cast<size_t>(get_frame_width()) * get_frame_height());
+        clamp_origin();
+    }
+
+    /// <summary>
+    /// Two characters per tile plus the border, as the full grid renderer always did, within the maximum.
+    /// The width is even, a whole number of cells
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="max_width"></param>
+    /// <param name="max_height"></param>
+    /// <param name="width"></param>
+    /// <param name="height"></param>
+    void battle_field_viewport::fit_frame(const battle_field& battle_field, const int max_width, const int max_height,
+        int& width, int& height)
+    {
+        width = std::max(4, std::min(max_width, battle_field.get_width() * 2 + 2) / 2 * 2);
+        height = std::max(3, std::min(max_height, battle_field.get_height() + 2));
+    }
+
+    /// <summary>
+    /// Keep the center, then realign the window to the new blocks
+    /// </summary>
+    /// <param name="level"></param>
+    void battle_field_viewport::set_level(const int level)
+    {
+        const point_2d center(origin_.get_x() + columns_ * block_size() / 2, origin_.get_y() + rows_ * block_size() / 2);
+        level_ = std::clamp(level, 0, max_level);
+        center_on(center);
+    }
+
+    /// <summary>
+    /// Smallest block size whose window spans the grid
+    /// </summary>
+    /// <returns></returns>
+    int battle_field_viewport::get_fitting_level() const
+    {
+        int level = 0;
+        while (level < max_level &&
+            (static_cast<long long>(columns_) << level < battle_field_->get_width() ||
+             static_cast<long long>(rows_) << level < battle_field_->get_height()))
+            level++;
+        return level;
+    }
+
+    /// <summary>
+    /// Put the position in the middle of the window
+    /// </summary>
+    /// <param name="position"></param>
+    void battle_field_viewport::center_on(const point_2d position)
+    {
+        origin_ = point_2d(position.get_x() - columns_ * block_size() / 2, position.get_y() - rows_ * block_size() / 2);
+        clamp_origin();
+    }
+
+    /// <summary>
+    /// Move the window by whole cells
+    /// </summary>
+    /// <param name="cells_x"></param>
+    /// <param name="cells_y"></param>
+    void battle_field_viewport::pan(const int cells_x, const int cells_y)
+    {
+        origin_ = point_2d(origin_.get_x() + cells_x * block_size(), origin_.get_y() + cells_y * block_size());
+        clamp_origin();
+    }
+
+    /// <summary>
+    /// Per axis: a grid smaller than the window is centered, a larger one keeps the window inside it.
+    /// The origin stays on a block boundary so the pyramid answers every cell
+    /// </summary>
+    void battle_field_viewport::clamp_origin()
+    {
+        const auto block = block_size();
+        const auto clamp_axis = [block](const int origin, const int cells, const int size) {
+            const auto span = cells * block;
+            if (span >= size)
+                return align_down(-(span - size) / 2, block);
+            const auto last = align_down(size - span + block - 1, block);
+            return align_down(std::clamp(origin, 0, last), block);
+        };
+        origin_ = point_2d(clamp_axis(origin_.get_x(), columns_, battle_field_->get_width()),
+            clamp_axis(origin_.get_y(), rows_, battle_field_->get_height()));
+    }
+
+    /// <summary>
+    /// Level 1 counts the elevated tiles of 2x2 blocks, every further level sums 2x2 blocks of the one below
+    /// </summary>
+    void battle_field_viewport::update_pyramid()
+    {
+        if (pyramid_built_ && pyramid_version_ == battle_field_->get_version())
+            return;
+
+        const auto width = battle_field_->get_width();
+        const auto height = battle_field_->get_height();
+        pyramid_.assign(max_level, {});
+
+        auto below_width = width, below_height = height;
+        for (int level = 1; level <= max_level; ++level) {
+            const auto level_width = (below_width + 1) / 2;
+            const auto level_height = (below_height + 1) / 2;
+            auto& counts = pyramid_[level - 1];
+            counts.assign(static_cast<size_t>(level_width) * level_height, 0);
+            for (int y = 0; y < below_height; ++y) {
+                for (int x = 0; x < below_width; ++x) {
+                    const auto index = static_cast<size_t>(y) * below_width + x;
+                    const auto below = level == 1
+                        ? (battle_field_->get_tile(point_2d(x, y)) == tile_type::elevated ? 1u : 0u)
+                        : pyramid_[level - 2][index];
+                    counts[static_cast<size_t>(y / 2) * level_width + x / 2] += below;
+                }
+            }
+            below_width = level_width;
+            below_height = level_height;
+        }
+
+        pyramid_version_ = battle_field_->get_version();
+        pyramid_built_ = true;
+    }
+
+    /// <summary>
+    /// Per changed cell, recount the block containing it on every level from the four blocks below it
+    /// </summary>
+    /// <param name="changes"></param>
+    void battle_field_viewport::apply_changes(const map_changes& changes)
+    {
+        // Not built, already current, or changes were missed (a reload, an unpublished edit): compose rebuilds
+        if (!pyramid_built_ || pyramid_version_ == changes.version || pyramid_version_ != changes.previous_version)
+            return;
+
+        const auto width = battle_field_->get_width();
+        const auto height = battle_field_->get_height();
+        for (const auto& changed : changes.cells) {
+            auto x = changed.get_x(), y = changed.get_y();
+            auto below_width = width, below_height = height;
+            for (int level = 1; level <= max_level; ++level) {
+                const auto level_width = (below_width + 1) / 2;
+                x /= 2;
+                y /= 2;
+                std::uint32_t count = 0;
+                for (auto below_y = y * 2; below_y < std::min(y * 2 + 2, below_height); ++below_y) {
+                    for (auto below_x = x * 2; below_x < std::min(x * 2 + 2, below_width); ++below_x) {
+                        const auto index = static_cast<size_t>(below_y) * below_width + below_x;
+                        count += level == 1
+                            ? (battle_field_->get_tile(point_2d(below_x, below_y)) == tile_type::elevated ? 1u : 0u)
+                            : pyramid_[level - 2][index];
+                    }
+                }
+                pyramid_[level - 1][static_cast<size_t>(y) * level_width + x] = count;
+                below_width = level_width;
+                below_height = (below_height + 1) / 2;
+            }
+        }
+        pyramid_version_ = changes.version;
+    }
+
+    /// <summary>
+    /// Pyramid lookup, the block area is clipped to the grid
+    /// </summary>
+    /// <param name="block_x"></param>
+    /// <param name="block_y"></param>
+    /// <param name="tiles"></param>
+    /// <returns></returns>
+    std::uint32_t battle_field_viewport::count_obstacles(const int block_x, const int block_y, std::uint32_t& tiles) const
+    {
+        const auto block = block_size();
+        const auto width = battle_field_->get_width();
+        const auto height = battle_field_->get_height();
+        tiles = static_cast<std::uint32_t>(std::min(block, width - block_x * block)) *
+            static_cast<std::uint32_t>(std::min(block, height - block_y * block));
+        const auto level_width = (width + block - 1) / block;
+        return pyramid_[level_ - 1][static_cast<size_t>(block_y) * level_width + block_x];
+    }
+
+    /// <summary>
+    /// Border, then one pass over the cells of the window, units and targets are binned into the cells first
+    /// </summary>
+    /// <param name="unit_positions"></param>
+    /// <returns></returns>
+    const std::vector<battle_field_viewport::cell>& battle_field_viewport::compose(const std::unordered_set<point_2d>& unit_positions)
+    {
+        const auto frame_width = get_frame_width();
+        const auto frame_height = get_frame_height();
+        std::fill(frame_.begin(), frame_.end(), cell{ ' ', viewport_color::grey });
+
+        // Border
+        for (int x = 1; x < frame_width - 1; ++x) {
+            put(x, 0, '-', viewport_color::grey);
+            put(x, frame_height - 1, '-', viewport_color::grey);
+        }
+        for (int y = 1; y < frame_height - 1; ++y) {
+            put(0, y, '|', viewport_color::grey);
+            put(frame_width - 1, y, '|', viewport_color::grey);
+        }
+        put(0, 0, '+', viewport_color::grey);
+        put(frame_width - 1, 0, '+', viewport_color::grey);
+        put(0, frame_height - 1, '+', viewport_color::grey);
+        put(frame_width - 1, frame_height - 1, '+', viewport_color::grey);
+
+        // Units and targets per cell
+        const auto block = block_size();
+        const auto cells = static_cast<size_t>(columns_) * rows_;
+        unit_counts_.assign(cells, 0);
+        target_marks_.assign(cells, 0);
+        const auto cell_of = [&](const point_2d position, size_t& index) {
+            const auto dx = position.get_x() - origin_.get_x();
+            const auto dy = position.get_y() - origin_.get_y();
+            if (dx < 0 || dy < 0 || dx >= columns_ * block || dy >= rows_ * block)
+                return false;
+            index = static_cast<size_t>(dy / block) * columns_ + dx / block;
+            return true;
+        };
+        size_t index = 0;
+        for (const auto& position : unit_positions)
+            if (cell_of(position, index))
+                unit_counts_[index]++;
+        for (const auto& position : battle_field_->get_target_positions())
+            if (cell_of(position, index))
+                target_marks_[index] = 1;
+
+        if (level_ > 0)
+            update_pyramid();
+
+        const auto width = battle_field_->get_width();
+        const auto height = battle_field_->get_height();
+        for (int row = 0; row < rows_; ++row) {
+            const auto y = origin_.get_y() + row * block;
+            if (y < 0 || y >= height)
+                continue;
+            for (int column = 0; column < columns_; ++column) {
+                const auto x = origin_.get_x() + column * block;
+                if (x < 0 || x >= width)
+                    continue;
+                const auto cell_index = static_cast<size_t>(row) * columns_ + column;
+                const auto screen_x = column * 2 + 1;
+                const auto units = unit_counts_[cell_index];
+
+                if (level_ == 0) {
+                    char ch = ' ';
+                    std::uint16_t color = viewport_color::grey;
+                    if (units > 0) {
+                        ch = 'U';
+                        color = viewport_color::yellow;
+                    }
+                    else {
+                        switch (battle_field_->get_tile(point_2d(x, y))) {
+                        case tile_type::start:
+                            color = viewport_color::dark_yellow;
+                            break;
+                        case tile_type::target:
+                            ch = 'X';
+                            color = viewport_color::red;
+                            break;
+                        case tile_type::elevated:
+                            ch = '*';
+                            color = viewport_color::green;
+                            break;
+                        default:
+                            break;
+                        }
+                    }
+                    put(screen_x, row + 1, ch, color);
+                    put(screen_x + 1, row + 1, ' ', color);
+                    continue;
+                }
+
+                // Aggregated block: units, else target, else obstacles first, obstacles second
+                std::uint32_t tiles = 0;
+                const auto obstacles = count_obstacles(x / block, y / block, tiles);
+                const auto glyph = density_glyph(obstacles, tiles);
+                if (units > 0)
+                    put(screen_x, row + 1, units < 10 ? static_cast<char>('0' + units) : '+', viewport_color::yellow);
+                else if (target_marks_[cell_index] != 0)
+                    put(screen_x, row + 1, 'X', viewport_color::red);
+                else
+                    put(screen_x, row + 1, glyph, viewport_color::green);
+                put(screen_x + 1, row + 1, glyph, viewport_color::green);
+            }
+        }
+        return frame_;
+    }
+
+    /// <summary>
+    /// Write a character, positions outside the frame are ignored
+    /// </summary>
+    /// <param name="x"></param>
+    /// <param name="y"></param>
+    /// <param name="ch"></param>
+    /// <param name="color"></param>
+    void battle_field_viewport::put(const int x, const int y, const char ch, const std::uint16_t color)
+    {
+        if (x < 0 || y < 0 || x >= get_frame_width() || y >= get_frame_height())
+            return;
+        frame_[static_cast<size_t>(y) * get_frame_width() + x] = cell{ ch, color };
+    }
+}
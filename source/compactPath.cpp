@@ -0,0 +1,90 @@
+#include "../headers/compactPath.hpp"
+
+#include <stdexcept>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Steps in code order
+    /// </summary>
+    const point_2d compact_path::directions[4] = { point_2d(0, -1), point_2d(0, 1), point_2d(-1, 0), point_2d(1, 0) };
+
+    /// <summary>
+    /// Find the code whose step leads from one cell to the other
+    /// </summary>
+    /// <param name="from"></param>
+    /// <param name="to"></param>
+    /// <returns></returns>
+    int compact_path::direction_of(const point_2d from, const point_2d to)
+    {
+        for (int direction = 0; direction < 4; ++direction)
+            if (from + directions[direction] == to)
+                return direction;
+        return -1;
+    }
+
+    /// <summary>
+    /// Constructor to initialize an empty path
+    /// </summary>
+    /// <param name="resource"></param>
+    compact_path::compact_path(std::pmr::memory_resource* resource) :
+        codes_(resource)
+    {
+    }
+
+    /// <summary>
+    /// Constructor to encode the steps between consecutive points
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="points"></param>
+    /// <param name="resource"></param>
+    compact_path::compact_path(const point_2d start, const std::vector<point_2d>& points, std::pmr::memory_resource* resource) :
+        codes_(resource)
+    {
+        reset(start, points.size());
+        auto previous = start;
+        for (size_t i = 0; i < points.size(); ++i) {
+            const auto direction = direction_of(previous, points[i]);
+            if (direction < 0)
+                throw std::invalid_argument("Path points must be adjacent");
+            set_step(i, direction);
+            previous = points[i];
+        }
+    }
+
+    /// <summary>
+    /// Zero the codes for the new length
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="length"></param>
+    void compact_path::reset(const point_2d start, const size_t length)
+    {
+        start_ = start;
+        size_ = length;
+        codes_.assign((length + 3) / 4, 0);
+    }
+
+    /// <summary>
+    /// Copy the packed codes
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="codes"></param>
+    /// <param name="length"></param>
+    void compact_path::assign(const point_2d start, const std::uint8_t* codes, const size_t length)
+    {
+        start_ = start;
+        size_ = length;
+        codes_.assign(codes, codes + (length + 3) / 4);
+    }
+
+    /// <summary>
+    /// Start a new byte every four steps
+    /// </summary>
+    /// <param name="direction"></param>
+    void compact_path::push_back(const int direction)
+    {
+        if (size_ % 4 == 0)
+            codes_.push_back(0);
+        set_step(size_++, direction);
+    }
+}
@@ -0,0 +1,316 @@
+#include "../headers/compressedPathDatabase.hpp"
+#include "../headers/parallelFor.hpp"
+#include "../headers/gridLayout.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Moves in first move order
+    /// </summary>
+    const point_2d compressed_path_database::moves[4] = { point_2d(0, -1), point_2d(0, 1), point_2d(-1, 0), point_2d(1, 0) };
+
+    /// <summary>
+    /// File header, followed by ranks, components, offsets and runs
+    /// </summary>
+    struct cpd_file_header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::int32_t width;
+        std::int32_t height;
+        std::uint64_t map_hash;
+        std::uint64_t run_count;
+    };
+
+    /// <summary>
+    /// File identification
+    /// </summary>
+    static constexpr char cpd_magic[8] = { 'P', 'F', 'C', 'P', 'D', 0, 0, 0 };
+    static constexpr std::uint32_t cpd_version = 1;
+
+    /// <summary>
+    /// Markers in the per source first move scratch array
+    /// </summary>
+    static constexpr std::uint8_t unvisited = 0xFF;
+    static constexpr std::uint8_t source_cell = 0xFE;
+
+    /// <summary>
+    /// Build the database
+    /// 1. Rank the walkable cells along the Z-order curve
+    /// 2. Label connected areas so unreachable queries are answered without a lookup
+    /// 3. Per source: BFS which carries the first move to every cell, then run length encode the moves in rank order,
+    ///    unreachable targets are wildcards and extend the current run
+    /// 4. Concatenate the rows and compute the offsets
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <returns></returns>
+    compressed_path_database compressed_path_database::build(const battle_field& battle_field)
+    {
+        compressed_path_database database;
+        database.width_ = battle_field.get_width();
+        database.height_ = battle_field.get_height();
+        database.map_hash_ = battle_field.get_content_hash();
+
+        const auto width = database.width_;
+        const auto cells = database.cell_count();
+        const auto position_of = [&](const size_t cell) {
+            return point_2d(static_cast<int>(cell % width), static_cast<int>(cell / width));
+        };
+
+        // Z-order ranks of the walkable cells
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> keys;
+        for (size_t cell = 0; cell < cells; ++cell) {
+            const auto position = position_of(cell);
+            if (battle_field.is_walkable(position))
+                keys.emplace_back(grid_layout::morton_encode(position.get_x(), position.get_y()), static_cast<std::uint32_t>(cell));
+        }
+        if (keys.size() >= (std::uint64_t(1) << 29))
+            throw std::runtime_error("Battlefield has too many walkable cells for a path database");
+        std::sort(keys.begin(), keys.end());
+        std::vector<std::uint32_t> order(keys.size());
+        database.owned_ranks_.assign(cells, no_rank);
+        for (size_t rank = 0; rank < keys.size(); ++rank) {
+            order[rank] = keys[rank].second;
+            database.owned_ranks_[keys[rank].second] = static_cast<std::uint32_t>(rank);
+        }
+
+        // Connected areas by flood fill
+        database.owned_components_.assign(cells, no_rank);
+        std::vector<std::uint32_t> queue;
+        std::uint32_t component = 0;
+        for (const auto seed : order) {
+            if (database.owned_components_[seed] != no_rank)
+                continue;
+            queue.assign(1, seed);
+            database.owned_components_[seed] = component;
+            for (size_t head = 0; head < queue.size(); ++head) {
+                for (const auto& move : moves) {
+                    const auto neighbor = position_of(queue[head]) + move;
+                    if (!battle_field.is_walkable(neighbor))
+                        continue;
+                    const auto neighbor_cell = static_cast<size_t>(neighbor.get_y()) * width + neighbor.get_x();
+                    if (database.owned_components_[neighbor_cell] != no_rank)
+                        continue;
+                    database.owned_components_[neighbor_cell] = component;
+                    queue.push_back(static_cast<std::uint32_t>(neighbor_cell));
+                }
+            }
+            component++;
+        }
+
+        // Ranks on a grid padded with an elevated border, so the BFS below steps by index without bounds checks
+        const auto padded_width = static_cast<std::ptrdiff_t>(width) + 2;
+        std::vector<std::uint32_t> padded_ranks(static_cast<size_t>(padded_width) * (database.height_ + 2), no_rank);
+        for (size_t cell = 0; cell < cells; ++cell)
+            padded_ranks[(cell / width + 1) * padded_width + cell % width + 1] = database.owned_ranks_[cell];
+        const std::ptrdiff_t steps[4] = { -padded_width, padded_width, -1, 1 };
+
+        // First move rows, blocks of sources in parallel
+        constexpr size_t sources_per_block = 64;
+        const auto block_count = (cells + sources_per_block - 1) / sources_per_block;
+        std::vector<std::vector<std::uint32_t>> block_runs(block_count);
+        std::vector<std::uint64_t> run_counts(cells, 0);
+        parallel_for(block_count, [&](const size_t block) {
+            // First move per target rank, so the encoding below reads it sequentially
+            std::vector<std::uint8_t> first(order.size(), unvisited);
+            std::vector<std::ptrdiff_t> bfs_queue;
+            bfs_queue.reserve(order.size());
+            auto& runs = block_runs[block];
+
+            const auto block_end = std::min(cells, (block + 1) * sources_per_block);
+            for (auto source = block * sources_per_block; source < block_end; ++source) {
+                if (database.owned_ranks_[source] == no_rank)
+                    continue;
+
+                // BFS, every cell inherits the first move of its parent
+                const auto padded_source = static_cast<std::ptrdiff_t>((source / width + 1) * padded_width + source % width + 1);
+                bfs_queue.assign(1, padded_source);
+                first[padded_ranks[padded_source]] = source_cell;
+                for (size_t head = 0; head < bfs_queue.size(); ++head) {
+                    const auto cell = bfs_queue[head];
+                    const auto inherited = first[padded_ranks[cell]];
+                    for (std::uint8_t move = 0; move < 4; ++move) {
+                        const auto neighbor = cell + steps[move];
+                        const auto neighbor_rank = padded_ranks[neighbor];
+                        if (neighbor_rank == no_rank || first[neighbor_rank] != unvisited)
+                            continue;
+                        first[neighbor_rank] = inherited == source_cell ? move : inherited;
+                        bfs_queue.push_back(neighbor);
+                    }
+                }
+
+                // Run length encode in rank order
+                const auto runs_before = runs.size();
+                std::uint8_t current = unvisited;
+                for (size_t rank = 0; rank < first.size(); ++rank) {
+                    const auto move = first[rank];
+                    if (move == unvisited || move == source_cell || move == current)
+                        continue;
+                    runs.push_back(static_cast<std::uint32_t>((runs.size() == runs_before ? 0 : rank) << 3) | move);
+                    current = move;
+                }
+                run_counts[source] = runs.size() - runs_before;
+
+                // Reset only what this BFS touched
+                for (const auto cell : bfs_queue)
+                    first[padded_ranks[cell]] = unvisited;
+            }
+        });
+
+        // Offsets and concatenated runs
+        database.owned_offsets_.assign(cells + 1, 0);
+        for (size_t cell = 0; cell < cells; ++cell)
+            database.owned_offsets_[cell + 1] = database.owned_offsets_[cell] + run_counts[cell];
+        database.owned_runs_.reserve(database.owned_offsets_.back());
+        for (const auto& runs : block_runs)
+            database.owned_runs_.insert(database.owned_runs_.end(), runs.begin(), runs.end());
+
+        database.run_count_ = database.owned_runs_.size();
+        database.ranks_ = database.owned_ranks_.data();
+        database.components_ = database.owned_components_.data();
+        database.offsets_ = database.owned_offsets_.data();
+        database.runs_ = database.owned_runs_.data();
+        return database;
+    }
+
+    /// <summary>
+    /// Write header and arrays
+    /// </summary>
+    /// <param name="filename"></param>
+    void compressed_path_database::save(const std::string& filename) const
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + filename);
+
+        cpd_file_header header{};
+        std::memcpy(header.magic, cpd_magic, sizeof(cpd_magic));
+        header.version = cpd_version;
+        header.width = width_;
+        header.height = height_;
+        header.map_hash = map_hash_;
+        header.run_count = run_count_;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(ranks_), static_cast<std::streamsize>(cell_count() * sizeof(std::uint32_t)));
+        file.write(reinterpret_cast<const char*>(components_), static_cast<std::streamsize>(cell_count() * sizeof(std::uint32_t)));
+        file.write(reinterpret_cast<const char*>(offsets_), static_cast<std::streamsize>((cell_count() + 1) * sizeof(std::uint64_t)));
+        file.write(reinterpret_cast<const char*>(runs_), static_cast<std::streamsize>(run_count_ * sizeof(std::uint32_t)));
+        if (!file)
+            throw std::runtime_error("Failed to write file: " + filename);
+    }
+
+    /// <summary>
+    /// Map the file and point the views into it
+    /// </summary>
+    /// <param name="filename"></param>
+    /// <param name="battle_field"></param>
+    /// <returns></returns>
+    compressed_path_database compressed_path_database::load(const std::string& filename, const battle_field& battle_field)
+    {
+        compressed_path_database database;
+        database.file_ = std::make_unique<mapped_file>(filename);
+        const auto* data = database.file_->data();
+        const auto size = database.file_->size();
+
+        cpd_file_header header{};
+        if (size < sizeof(header))
+            throw std::runtime_error("Invalid path database: " + filename);
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, cpd_magic, sizeof(cpd_magic)) != 0 || header.version != cpd_version)
+            throw std::runtime_error("Invalid path database: " + filename);
+        if (header.width != battle_field.get_width() || header.height != battle_field.get_height() ||
+            header.map_hash != battle_field.get_content_hash())
+            throw std::runtime_error("Path database does not match the battlefield: " + filename);
+
+        database.width_ = header.width;
+        database.height_ = header.height;
+        database.map_hash_ = header.map_hash;
+        database.run_count_ = header.run_count;
+
+        const auto cells = database.cell_count();
+        const auto expected_size = sizeof(header) + cells * 2 * sizeof(std::uint32_t) +
+            (cells + 1) * sizeof(std::uint64_t) + header.run_count * sizeof(std::uint32_t);
+        if (size != expected_size)
+        {
+            std::stringstream ss;
+            ss << "Invalid path database size: " << size << " instead of " << expected_size;
+            throw std::runtime_error(ss.str());
+        }
+
+        auto offset = sizeof(header);
+        database.ranks_ = reinterpret_cast<const std::uint32_t*>(data + offset);
+        offset += cells * sizeof(std::uint32_t);
+        database.components_ = reinterpret_cast<const std::uint32_t*>(data + offset);
+        offset += cells * sizeof(std::uint32_t);
+        database.offsets_ = reinterpret_cast<const std::uint64_t*>(data + offset);
+        offset += (cells + 1) * sizeof(std::uint64_t);
+        database.runs_ = reinterpret_cast<const std::uint32_t*>(data + offset);
+        return database;
+    }
+
+    /// <summary>
+    /// Binary search the run covering the target's rank in the source's row
+    /// </summary>
+    /// <param name="from"></param>
+    /// <param name="to"></param>
+    /// <returns></returns>
+    int compressed_path_database::first_move(const point_2d from, const point_2d to) const
+    {
+        const auto inside = [&](const point_2d p) {
+            return p.get_x() >= 0 && p.get_x() < width_ && p.get_y() >= 0 && p.get_y() < height_;
+        };
+        if (!inside(from) || !inside(to) || from == to)
+            return -1;
+
+        const auto from_cell = static_cast<size_t>(from.get_y()) * width_ + from.get_x();
+        const auto to_cell = static_cast<size_t>(to.get_y()) * width_ + to.get_x();
+        const auto rank = ranks_[to_cell];
+        if (rank == no_rank || ranks_[from_cell] == no_rank || components_[from_cell] != components_[to_cell])
+            return -1;
+
+        const auto* begin = runs_ + offsets_[from_cell];
+        const auto* end = runs_ + offsets_[from_cell + 1];
+        if (begin == end)
+            return -1;
+        const auto* run = std::upper_bound(begin, end, rank,
+            [](const std::uint32_t value, const std::uint32_t element) { return value < (element >> 3); });
+        return static_cast<int>(*(run - 1) & 7);
+    }
+
+    /// <summary>
+    /// Follow the first moves until the goal is reached
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <returns></returns>
+    std::vector<point_2d> compressed_path_database::extract_path(const point_2d start, const point_2d goal) const
+    {
+        std::vector<point_2d> path;
+        auto current = start;
+        while (current != goal) {
+            const auto move = first_move(current, goal);
+            if (move < 0)
+                return {};
+            current = current + moves[move];
+            path.push_back(current);
+        }
+        return path;
+    }
+
+    /// <summary>
+    /// Size of all the arrays
+    /// </summary>
+    /// <returns></returns>
+    size_t compressed_path_database::get_memory_size() const
+    {
+        return cell_count() * 2 * sizeof(std::uint32_t) + (cell_count() + 1) * sizeof(std::uint64_t) +
+            static_cast<size_t>(run_count_) * sizeof(std::uint32_t);
+    }
+}
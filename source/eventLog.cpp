@@ -0,0 +1,312 @@
+#include "../headers/eventLog.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace path_finding
+{
+    static_assert(std::is_trivially_copyable_v<event> && sizeof(event) == 24, "events are written as raw bytes");
+
+    /// <summary>
+    /// File header, followed by the initial state and the events
+    /// </summary>
+    struct event_log_header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t event_size;
+        std::uint64_t snapshot_size;
+        std::uint64_t event_count;
+    };
+
+    /// <summary>
+    /// File identification
+    /// </summary>
+    static constexpr char event_log_magic[8] = { 'P', 'F', 'E', 'V', 'T', 0, 0, 0 };
+    static constexpr std::uint32_t event_log_version = 2;
+
+    /// <summary>
+    /// Whether a move of the unit computes a new path, the unit searches whenever it has no path
+    /// unless a plain move is already at its target
+    /// </summary>
+    /// <param name="u"></param>
+    /// <param name="type"></param>
+    /// <param name="target"></param>
+    /// <returns></returns>
+    static bool will_replan(const unit& u, const event_type type, const point_2d target)
+    {
+        return u.get_path().empty() && !(type == event_type::move && u.get_position() == target);
+    }
+
+    /// <summary>
+    /// Event carrying a generator seed
+    /// </summary>
+    /// <param name="seed"></param>
+    /// <returns></returns>
+    static event make_seed_event(const std::uint64_t seed)
+    {
+        const point_2d halves(static_cast<int>(static_cast<std::uint32_t>(seed)), static_cast<int>(static_cast<std::uint32_t>(seed >> 32)));
+        return { event_type::seed, 0, 0, 0, 0, halves, point_2d() };
+    }
+
+    /// <summary>
+    /// Seed of a seed event
+    /// </summary>
+    /// <param name="e"></param>
+    /// <returns></returns>
+    static std::uint64_t seed_of(const event& e)
+    {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(e.first.get_x())) |
+            static_cast<std::uint64_t>(static_cast<std::uint32_t>(e.first.get_y())) << 32;
+    }
+
+    /// <summary>
+    /// Capture the initial state, drop the previous events and log the seed of the map
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="units"></param>
+    /// <param name="occupied_positions"></param>
+    void event_log::begin(const battle_field& battle_field, const std::vector<unit>& units,
+        const std::unordered_set<point_2d>& occupied_positions)
+    {
+        initial_state_.capture(0, battle_field, units, occupied_positions);
+        events_.clear();
+        events_.push_back(make_seed_event(battle_field.get_seed()));
+        tick_count_ = 0;
+    }
+
+    /// <summary>
+    /// Perform the move, then record it
+    /// </summary>
+    /// <param name="units"></param>
+    /// <param name="unit_index"></param>
+    /// <param name="target"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    move_status event_log::move(std::vector<unit>& units, const size_t unit_index, const point_2d target,
+        std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource)
+    {
+        auto& u = units.at(unit_index);
+        const auto replanned = will_replan(u, event_type::move, target);
+        const auto status = u.move(target, occupied_positions, scratch_resource);
+        record_move(event_type::move, unit_index, target, replanned, status, u.get_position());
+        return status;
+    }
+
+    /// <summary>
+    /// Perform the move, then record it
+    /// </summary>
+    /// <param name="units"></param>
+    /// <param name="unit_index"></param>
+    /// <param name="battle_field"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    move_status event_log::move_to_nearest(std::vector<unit>& units, const size_t unit_index, const battle_field& battle_field,
+        std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource)
+    {
+        auto& u = units.at(unit_index);
+        const auto replanned = will_replan(u, event_type::move_to_nearest, point_2d());
+        const auto status = u.move_to_nearest(battle_field.get_target_positions(), occupied_positions, scratch_resource);
+        record_move(event_type::move_to_nearest, unit_index, point_2d(), replanned, status, u.get_position());
+        return status;
+    }
+
+    /// <summary>
+    /// Perform the edit, then record it
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="min"></param>
+    /// <param name="max"></param>
+    /// <param name="type"></param>
+    void event_log::set_tiles(battle_field& battle_field, const point_2d min, const point_2d max, const tile_type type)
+    {
+        battle_field.set_tiles(min, max, type);
+        events_.push_back({ event_type::map_edit, static_cast<std::uint8_t>(type), 0, 0, 0, min, max });
+    }
+
+    /// <summary>
+    /// Publish, then record the boundary
+    /// </summary>
+    /// <param name="battle_field"></param>
+    void event_log::end_tick(battle_field& battle_field)
+    {
+        battle_field.publish_changes();
+        events_.push_back({ event_type::tick, 0, 0, 0, 0, point_2d(), point_2d() });
+        tick_count_++;
+    }
+
+    /// <summary>
+    /// Append a move event
+    /// </summary>
+    /// <param name="type"></param>
+    /// <param name="unit_index"></param>
+    /// <param name="target"></param>
+    /// <param name="replanned"></param>
+    /// <param name="status"></param>
+    /// <param name="position"></param>
+    void event_log::record_move(const event_type type, const size_t unit_index, const point_2d target, const bool replanned,
+        const move_status status, const point_2d position)
+    {
+        events_.push_back({ type, static_cast<std::uint8_t>(status), static_cast<std::uint8_t>(replanned), 0,
+            static_cast<std::uint32_t>(unit_index), target, position });
+    }
+
+    /// <summary>
+    /// Restore the initial state into a fresh simulation, then run the events in order.
+    /// Consecutive moves are timed as one batch, their outcomes are compared after the clock stopped
+    /// </summary>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    replay_result event_log::replay(std::pmr::memory_resource* scratch_resource) const
+    {
+        replay_result result;
+        result.first_mismatch = events_.size();
+        if (initial_state_.empty())
+            return result;
+
+        battle_field field;
+        const pathfinder path_finder(field);
+        std::vector<unit> units;
+        units.reserve(initial_state_.get_unit_count());
+        for (size_t i = 0; i < initial_state_.get_unit_count(); ++i)
+            units.emplace_back(point_2d(), path_finder);
+        std::unordered_set<point_2d> occupied_positions;
+        initial_state_.restore(field, units, occupied_positions);
+
+        struct outcome {
+            move_status status;
+            bool replanned;
+            point_2d position;
+        };
+        std::vector<outcome> outcomes;
+        const auto expanded_before = path_finder.get_expanded_node_count();
+
+        for (size_t i = 0; i < events_.size();) {
+            const auto& e = events_[i];
+            if (e.type == event_type::tick) {
+                field.publish_changes();
+                result.ticks++;
+                ++i;
+                continue;
+            }
+            if (e.type == event_type::seed) {
+                if (field.get_seed() != seed_of(e) && result.mismatches++ == 0)
+                    result.first_mismatch = i;
+                ++i;
+                continue;
+            }
+            if (e.type == event_type::map_edit) {
+                field.set_tiles(e.first, e.second, static_cast<tile_type>(e.value));
+                ++i;
+                continue;
+            }
+
+            // Batch of consecutive moves
+            auto end = i;
+            while (end < events_.size() && (events_[end].type == event_type::move || events_[end].type == event_type::move_to_nearest)) {
+                if (events_[end].unit >= units.size())
+                    throw std::runtime_error("Invalid event log: unit index out of range");
+                ++end;
+            }
+
+            outcomes.clear();
+            const auto begin = std::chrono::steady_clock::now();
+            for (auto j = i; j < end; ++j) {
+                const auto& move = events_[j];
+                auto& u = units[move.unit];
+                const auto replanned = will_replan(u, move.type, move.first);
+                const auto status = move.type == event_type::move
+                    ? u.move(move.first, occupied_positions, scratch_resource)
+                    : u.move_to_nearest(field.get_target_positions(), occupied_positions, scratch_resource);
+                outcomes.push_back({ status, replanned, u.get_position() });
+            }
+            result.engine_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+
+            for (auto j = i; j < end; ++j) {
+                const auto& move = events_[j];
+                const auto& actual = outcomes[j - i];
+                result.moves++;
+                result.replans += actual.replanned ? 1 : 0;
+                result.blocks += actual.status == move_status::blocked ? 1 : 0;
+                if (static_cast<std::uint8_t>(actual.status) != move.value || actual.replanned != (move.replanned != 0) ||
+                    actual.position != move.second) {
+                    if (result.mismatches++ == 0)
+                        result.first_mismatch = j;
+                }
+            }
+            i = end;
+        }
+
+        result.expanded_nodes = path_finder.get_expanded_node_count() - expanded_before;
+        return result;
+    }
+
+    /// <summary>
+    /// Header, initial state and events
+    /// </summary>
+    /// <param name="filename"></param>
+    void event_log::save(const std::string& filename) const
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + filename);
+
+        event_log_header header{};
+        std::memcpy(header.magic, event_log_magic, sizeof(event_log_magic));
+        header.version = event_log_version;
+        header.event_size = sizeof(event);
+        header.snapshot_size = initial_state_.get_size();
+        header.event_count = events_.size();
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        initial_state_.save(file);
+        file.write(reinterpret_cast<const char*>(events_.data()), static_cast<std::streamsize>(events_.size() * sizeof(event)));
+        if (!file)
+            throw std::runtime_error("Failed to write file: " + filename);
+    }
+
+    /// <summary>
+    /// Read and check the header, then the initial state and the events
+    /// </summary>
+    /// <param name="filename"></param>
+    void event_log::load(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + filename);
+        const auto size = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+
+        event_log_header header{};
+        if (size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, event_log_magic, sizeof(event_log_magic)) != 0 ||
+            header.version != event_log_version || header.event_size != sizeof(event) ||
+            header.snapshot_size > size || header.event_count > size / sizeof(event))
+            throw std::runtime_error("Invalid event log: " + filename);
+
+        const auto expected_size = sizeof(header) + header.snapshot_size + header.event_count * sizeof(event);
+        if (size != expected_size)
+        {
+            std::stringstream ss;
+            ss << "Invalid event log size: " << size << " instead of " << expected_size;
+            throw std::runtime_error(ss.str());
+        }
+
+        simulation_snapshot initial_state;
+        if (header.snapshot_size > 0)
+            initial_state.load(file, static_cast<size_t>(header.snapshot_size));
+        std::vector<event> events(static_cast<size_t>(header.event_count));
+        if (!file.read(reinterpret_cast<char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(event))))
+            throw std::runtime_error("Failed to read file: " + filename);
+
+        initial_state_ = std::move(initial_state);
+        events_ = std::move(events);
+        tick_count_ = 0;
+        for (const auto& e : events_)
+            tick_count_ += e.type == event_type::tick ? 1 : 0;
+    }
+}
@@ -0,0 +1,187 @@
+#include "../headers/goalBounds.hpp"
+#include "../headers/parallelFor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Moves in box order
+    /// </summary>
+    const point_2d goal_bounds::moves[4] = { point_2d(0, -1), point_2d(0, 1), point_2d(-1, 0), point_2d(1, 0) };
+
+    /// <summary>
+    /// File header, followed by the boxes
+    /// </summary>
+    struct gb_file_header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::int32_t width;
+        std::int32_t height;
+        std::uint64_t map_hash;
+    };
+
+    /// <summary>
+    /// File identification
+    /// </summary>
+    static constexpr char gb_magic[8] = { 'P', 'F', 'G', 'B', 0, 0, 0, 0 };
+    static constexpr std::uint32_t gb_version = 1;
+
+    /// <summary>
+    /// Markers in the per source first move scratch array
+    /// </summary>
+    static constexpr std::uint8_t unvisited = 0xFF;
+    static constexpr std::uint8_t source_cell = 0xFE;
+
+    /// <summary>
+    /// Build the bounds
+    /// Per source: BFS which carries the first move to every cell, then every reached cell grows the box of its first move.
+    /// One optimal first move per target is enough, the search can follow them all the way to the goal,
+    /// and the boxes stay much tighter than with every optimal first move on open ground
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <returns></returns>
+    goal_bounds goal_bounds::build(const battle_field& battle_field)
+    {
+        if (battle_field.get_width() > std::numeric_limits<std::int16_t>::max() ||
+            battle_field.get_height() > std::numeric_limits<std::int16_t>::max())
+            throw std::runtime_error("Battlefield is too large for goal bounds");
+
+        goal_bounds bounds;
+        bounds.width_ = battle_field.get_width();
+        bounds.height_ = battle_field.get_height();
+        bounds.map_hash_ = battle_field.get_content_hash();
+
+        const auto width = bounds.width_;
+        const auto cells = bounds.cell_count();
+        constexpr bounding_box empty_box = { std::numeric_limits<std::int16_t>::max(), std::numeric_limits<std::int16_t>::max(),
+            std::numeric_limits<std::int16_t>::min(), std::numeric_limits<std::int16_t>::min() };
+        bounds.owned_boxes_.assign(cells * 4, empty_box);
+
+        // Walkable cells on a grid padded with an elevated border, so the BFS below steps by index without bounds checks
+        const auto padded_width = static_cast<std::ptrdiff_t>(width) + 2;
+        const auto padded_cells = static_cast<size_t>(padded_width) * (bounds.height_ + 2);
+        std::vector<std::uint8_t> walkable(padded_cells, 0);
+        for (size_t cell = 0; cell < cells; ++cell)
+            walkable[(cell / width + 1) * padded_width + cell % width + 1] =
+                battle_field.is_walkable(point_2d(static_cast<int>(cell % width), static_cast<int>(cell / width))) ? 1 : 0;
+        const std::ptrdiff_t steps[4] = { -padded_width, padded_width, -1, 1 };
+
+        // Blocks of sources in parallel, every source writes only its own four boxes
+        constexpr size_t sources_per_block = 64;
+        const auto block_count = (cells + sources_per_block - 1) / sources_per_block;
+        parallel_for(block_count, [&](const size_t block) {
+            std::vector<std::uint8_t> first(padded_cells, unvisited);
+            std::vector<std::ptrdiff_t> bfs_queue;
+            bfs_queue.reserve(cells);
+
+            const auto block_end = std::min(cells, (block + 1) * sources_per_block);
+            for (auto source = block * sources_per_block; source < block_end; ++source) {
+                const auto padded_source = static_cast<std::ptrdiff_t>((source / width + 1) * padded_width + source % width + 1);
+                if (walkable[padded_source] == 0)
+                    continue;
+
+                // BFS, every cell inherits the first move of its parent
+                bfs_queue.assign(1, padded_source);
+                first[padded_source] = source_cell;
+                for (size_t head = 0; head < bfs_queue.size(); ++head) {
+                    const auto cell = bfs_queue[head];
+                    const auto inherited = first[cell];
+                    for (std::uint8_t move = 0; move < 4; ++move) {
+                        const auto neighbor = cell + steps[move];
+                        if (walkable[neighbor] == 0 || first[neighbor] != unvisited)
+                            continue;
+                        first[neighbor] = inherited == source_cell ? move : inherited;
+                        bfs_queue.push_back(neighbor);
+                    }
+                }
+
+                // Grow the boxes, then reset only what this BFS touched
+                auto* boxes = bounds.owned_boxes_.data() + source * 4;
+                for (size_t index = 1; index < bfs_queue.size(); ++index) {
+                    const auto cell = bfs_queue[index];
+                    const auto x = static_cast<std::int16_t>(cell % padded_width - 1);
+                    const auto y = static_cast<std::int16_t>(cell / padded_width - 1);
+                    auto& box = boxes[first[cell]];
+                    box.min_x = std::min(box.min_x, x);
+                    box.min_y = std::min(box.min_y, y);
+                    box.max_x = std::max(box.max_x, x);
+                    box.max_y = std::max(box.max_y, y);
+                }
+                for (const auto cell : bfs_queue)
+                    first[cell] = unvisited;
+            }
+        });
+
+        bounds.boxes_ = bounds.owned_boxes_.data();
+        return bounds;
+    }
+
+    /// <summary>
+    /// Write header and boxes
+    /// </summary>
+    /// <param name="filename"></param>
+    void goal_bounds::save(const std::string& filename) const
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + filename);
+
+        gb_file_header header{};
+        std::memcpy(header.magic, gb_magic, sizeof(gb_magic));
+        header.version = gb_version;
+        header.width = width_;
+        header.height = height_;
+        header.map_hash = map_hash_;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(boxes_), static_cast<std::streamsize>(get_memory_size()));
+        if (!file)
+            throw std::runtime_error("Failed to write file: " + filename);
+    }
+
+    /// <summary>
+    /// Map the file and point the boxes into it
+    /// </summary>
+    /// <param name="filename"></param>
+    /// <param name="battle_field"></param>
+    /// <returns></returns>
+    goal_bounds goal_bounds::load(const std::string& filename, const battle_field& battle_field)
+    {
+        goal_bounds bounds;
+        bounds.file_ = std::make_unique<mapped_file>(filename);
+        const auto* data = bounds.file_->data();
+        const auto size = bounds.file_->size();
+
+        gb_file_header header{};
+        if (size < sizeof(header))
+            throw std::runtime_error("Invalid goal bounds: " + filename);
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, gb_magic, sizeof(gb_magic)) != 0 || header.version != gb_version)
+            throw std::runtime_error("Invalid goal bounds: " + filename);
+        if (header.width != battle_field.get_width() || header.height != battle_field.get_height() ||
+            header.map_hash != battle_field.get_content_hash())
+            throw std::runtime_error("Goal bounds do not match the battlefield: " + filename);
+
+        bounds.width_ = header.width;
+        bounds.height_ = header.height;
+        bounds.map_hash_ = header.map_hash;
+
+        const auto expected_size = sizeof(header) + bounds.get_memory_size();
+        if (size != expected_size)
+        {
+            std::stringstream ss;
+            ss << "Invalid goal bounds size: " << size << " instead of " << expected_size;
+            throw std::runtime_error(ss.str());
+        }
+
+        bounds.boxes_ = reinterpret_cast<const bounding_box*>(data + sizeof(header));
+        return bounds;
+    }
+}
@@ -0,0 +1,22 @@
+#include "../headers/gridLayout.hpp"
+
+namespace path_finding
+{
+    /// <summary>
+    /// Row major grids take width * height cells, Morton grids are rounded up to whole blocks in both directions
+    /// </summary>
+    /// <param name="type"></param>
+    /// <param name="width"></param>
+    /// <param name="height"></param>
+    grid_layout::grid_layout(const grid_layout_type type, const int width, const int height) :
+        type_(type), width_(static_cast<size_t>(width))
+    {
+        if (type_ == grid_layout_type::row_major) {
+            cell_count_ = static_cast<size_t>(width) * height;
+            return;
+        }
+        blocks_per_row_ = (static_cast<size_t>(width) + block_side - 1) >> block_bits;
+        const auto block_rows = (static_cast<size_t>(height) + block_side - 1) >> block_bits;
+        cell_count_ = (blocks_per_row_ * block_rows) << (2 * block_bits);
+    }
+}
@@ -0,0 +1,227 @@
+#include "../headers/incrementalSearch.hpp"
+
+#include <algorithm>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Constructor to initialize the containers and open the start
+    /// </summary>
+    /// <param name="path_finder"></param>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="resource"></param>
+    incremental_search::incremental_search(const pathfinder& path_finder, const point_2d start, const point_2d goal,
+        std::pmr::memory_resource* resource) :
+        path_finder_(&path_finder), start_(start), goal_(goal), version_(0),
+        g_score_(resource), came_from_(resource), closed_(resource),
+        open_set_{ std::greater<node>(), std::pmr::vector<node>(resource) }, deferred_(resource),
+        branch_(resource), climb_(resource), branch_index_(resource),
+        landmark_bound_(path_finder.get_landmarks() != nullptr ? path_finder.get_landmarks()->bind(goal) : landmark_heuristic::goal_bound())
+    {
+        restart(start);
+    }
+
+    /// <summary>
+    /// Clear everything and open the new start
+    /// </summary>
+    /// <param name="start"></param>
+    void incremental_search::restart(const point_2d start)
+    {
+        start_ = start;
+        version_ = path_finder_->get_battle_field().get_version();
+        g_score_.clear();
+        came_from_.clear();
+        closed_.clear();
+        deferred_.clear();
+        while (!open_set_.empty())
+            open_set_.pop();
+        expanded_ = 0;
+
+        best_node_ = start;
+        best_h_ = estimate(start);
+        best_g_ = 0;
+        g_score_[start] = 0;
+        open_set_.emplace(start, 0.0f, best_h_);
+        state_ = start == goal_ ? search_state::found : search_state::running;
+    }
+
+    /// <summary>
+    /// Whether the tiles changed under the search tree
+    /// </summary>
+    /// <returns></returns>
+    bool incremental_search::is_stale() const
+    {
+        return path_finder_->get_battle_field().get_version() != version_;
+    }
+
+    /// <summary>
+    /// Same estimate as the pathfinder's A*
+    /// </summary>
+    /// <param name="position"></param>
+    /// <returns></returns>
+    float incremental_search::estimate(const point_2d position) const
+    {
+        return std::max(static_cast<float>(position.manhattan_distance(goal_)), landmark_bound_(position));
+    }
+
+    /// <summary>
+    /// Record the cheaper predecessor and push the position
+    /// </summary>
+    /// <param name="position"></param>
+    /// <param name="parent"></param>
+    /// <param name="g_cost"></param>
+    void incremental_search::relax(const point_2d position, const point_2d parent, const float g_cost)
+    {
+        const auto known = g_score_.find(position);
+        if (known != g_score_.end() && known->second <= g_cost)
+            return;
+
+        came_from_[position] = parent;
+        g_score_[position] = g_cost;
+        open_set_.emplace(position, g_cost, estimate(position));
+    }
+
+    /// <summary>
+    /// Push back the deferred positions nobody stands on any more
+    /// </summary>
+    /// <param name="occupied_positions"></param>
+    void incremental_search::reopen_deferred(const std::unordered_set<point_2d>& occupied_positions)
+    {
+        for (auto it = deferred_.begin(); it != deferred_.end();) {
+            if (occupied_positions.find(it->first) != occupied_positions.end()) {
+                ++it;
+                continue;
+            }
+            if (closed_.find(it->first) == closed_.end())
+                relax(it->first, it->second.parent, it->second.g_cost);
+            it = deferred_.erase(it);
+        }
+    }
+
+    /// <summary>
+    /// A* with lazy deletion, stops after the budget, at the goal or when the open set runs dry
+    /// </summary>
+    /// <param name="max_expansions"></param>
+    /// <param name="occupied_positions"></param>
+    /// <returns></returns>
+    search_state incremental_search::advance(const size_t max_expansions, const std::unordered_set<point_2d>& occupied_positions)
+    {
+        if (is_stale())
+            restart(start_);
+        if (state_ != search_state::running)
+            return state_;
+
+        reopen_deferred(occupied_positions);
+        const auto& field = path_finder_->get_battle_field();
+        const auto is_occupied = [&](const point_2d& position) {
+            return position != goal_ && position != start_ && occupied_positions.find(position) != occupied_positions.end();
+        };
+
+        for (size_t expansions = 0; expansions < max_expansions;) {
+            if (open_set_.empty()) {
+                state_ = search_state::no_path;
+                return state_;
+            }
+
+            const node current_node = open_set_.top();
+            open_set_.pop();
+            const auto position = current_node.position;
+
+            // Superseded by a cheaper entry, already expanded or put aside
+            const auto known = g_score_.find(position);
+            if (known == g_score_.end() || known->second < current_node.g_cost || closed_.find(position) != closed_.end())
+                continue;
+
+            if (position == goal_) {
+                state_ = search_state::found;
+                return state_;
+            }
+
+            // Occupied since it was opened, wait until it is free
+            if (is_occupied(position)) {
+                deferred_[position] = { came_from_[position], current_node.g_cost };
+                g_score_.erase(known);
+                continue;
+            }
+
+            closed_.insert(position);
+            expanded_++;
+            expansions++;
+            if (current_node.h_cost < best_h_ || (current_node.h_cost == best_h_ && current_node.g_cost < best_g_)) {
+                best_node_ = position;
+                best_h_ = current_node.h_cost;
+                best_g_ = current_node.g_cost;
+            }
+
+            for (const auto& direction : compact_path::directions) {
+                const auto neighbor = position + direction;
+                if (!field.is_walkable(neighbor) || closed_.find(neighbor) != closed_.end())
+                    continue;
+
+                const auto g_cost = current_node.g_cost + 1;
+                if (is_occupied(neighbor)) {
+                    const auto deferred = deferred_.find(neighbor);
+                    if (deferred == deferred_.end() || g_cost < deferred->second.g_cost)
+                        deferred_[neighbor] = { position, g_cost };
+                    continue;
+                }
+                relax(neighbor, position, g_cost);
+            }
+        }
+
+        return state_;
+    }
+
+    /// <summary>
+    /// Climb the tree from the position until the branch towards the end node, then follow that branch down.
+    /// The branch cells are indexed so each step of the climb is one lookup
+    /// </summary>
+    /// <param name="position"></param>
+    /// <param name="path"></param>
+    void incremental_search::get_path(const point_2d position, compact_path& path) const
+    {
+        path.clear();
+        if (state_ == search_state::no_path)
+            return;
+
+        // Branch from the root to the end node, stored end first
+        const auto end = state_ == search_state::found ? goal_ : best_node_;
+        branch_.clear();
+        branch_index_.clear();
+        branch_.push_back(end);
+        for (auto it = came_from_.find(end); it != came_from_.end(); it = came_from_.find(it->second))
+            branch_.push_back(it->second);
+        if (branch_.back() != start_)
+            return;
+        for (size_t i = 0; i < branch_.size(); ++i)
+            branch_index_.emplace(branch_[i], i);
+
+        // Climb from the position until a cell of the branch
+        climb_.clear();
+        auto current = position;
+        auto joint = branch_index_.find(current);
+        while (joint == branch_index_.end()) {
+            const auto parent = came_from_.find(current);
+            if (parent == came_from_.end())
+                return;
+            current = parent->second;
+            climb_.push_back(current);
+            joint = branch_index_.find(current);
+        }
+
+        // Climb, then the branch from the joint down to the end node
+        const auto descent = joint->second;
+        path.reset(position, climb_.size() + descent);
+        auto previous = position;
+        size_t index = 0;
+        for (const auto& cell : climb_) {
+            path.set_step(index++, compact_path::direction_of(previous, cell));
+            previous = cell;
+        }
+        for (auto i = descent; i > 0; --i) {
+            path.set_step(index++, compact_path::direction_of(previous, branch_[i - 1]));
+            previous = branch_[i - 1];
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#include "../headers/landmarkHeuristic.hpp"
+#include "../headers/parallelFor.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Constructor with farthest point landmark selection
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="number_of_landmarks"></param>
+    landmark_heuristic::landmark_heuristic(const battle_field& battle_field, const size_t number_of_landmarks) :
+        battle_field_(&battle_field)
+    {
+        // Per cell data in the layout of the battlefield, padding cells are not walkable
+        const auto cell_count = battle_field.get_cell_count();
+
+        // Seed of the selection: the first walkable cell
+        size_t seed = cell_count;
+        for (size_t cell = 0; cell < cell_count && seed == cell_count; ++cell)
+            if (battle_field.is_walkable(battle_field.position_of(cell)))
+                seed = cell;
+        if (seed == cell_count || number_of_landmarks == 0)
+            return;
+
+        // Distance of every cell to the nearest landmark chosen so far, starts from the seed
+        std::vector<std::uint16_t> distances;
+        breadth_first_search(battle_field.position_of(seed), distances);
+        auto nearest = distances;
+
+        // Each landmark's search is stored as soon as it ran, the tables are compacted when fewer landmarks were found
+        distances_.assign(cell_count * number_of_landmarks, unreachable);
+        while (landmarks_.size() < number_of_landmarks) {
+
+            // Farthest walkable cell, unreached ones win over any finite distance
+            size_t farthest = cell_count;
+            for (size_t cell = 0; cell < cell_count; ++cell) {
+                if (!battle_field.is_walkable(battle_field.position_of(cell)))
+                    continue;
+                if (farthest == cell_count || nearest[cell] > nearest[farthest])
+                    farthest = cell;
+            }
+            if (farthest == cell_count || (nearest[farthest] == 0 && !landmarks_.empty()))
+                break;
+
+            const auto landmark = battle_field.position_of(farthest);
+            breadth_first_search(landmark, distances);
+            store(landmarks_.size(), distances, number_of_landmarks);
+            landmarks_.push_back(landmark);
+            for (size_t cell = 0; cell < cell_count; ++cell)
+                nearest[cell] = std::min(nearest[cell], distances[cell]);
+        }
+
+        const auto count = landmarks_.size();
+        if (count < number_of_landmarks) {
+            for (size_t cell = 1; cell < cell_count; ++cell)
+                std::copy_n(distances_.begin() + cell * number_of_landmarks, count, distances_.begin() + cell * count);
+            distances_.resize(cell_count * count);
+            distances_.shrink_to_fit();
+        }
+    }
+
+    /// <summary>
+    /// Constructor with given landmarks
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="landmarks"></param>
+    landmark_heuristic::landmark_heuristic(const battle_field& battle_field, std::vector<point_2d> landmarks) :
+        battle_field_(&battle_field), landmarks_(std::move(landmarks))
+    {
+        rebuild();
+    }
+
+    /// <summary>
+    /// One BFS per landmark, in parallel
+    /// </summary>
+    void landmark_heuristic::rebuild()
+    {
+        const auto cell_count = battle_field_->get_cell_count();
+        distances_.assign(cell_count * landmarks_.size(), unreachable);
+        parallel_for(landmarks_.size(), [&](const size_t landmark) {
+            std::vector<std::uint16_t> distances;
+            breadth_first_search(landmarks_[landmark], distances);
+            store(landmark, distances, landmarks_.size());
+        });
+    }
+
+    /// <summary>
+    /// Lower bound between two cells
+    /// </summary>
+    /// <param name="from"></param>
+    /// <param name="to"></param>
+    /// <returns></returns>
+    float landmark_heuristic::estimate(const point_2d from, const point_2d to) const
+    {
+        return bind(to)(from);
+    }
+
+    /// <summary>
+    /// Look up the goal distances once
+    /// </summary>
+    /// <param name="goal"></param>
+    /// <returns></returns>
+    landmark_heuristic::goal_bound landmark_heuristic::bind(const point_2d goal) const
+    {
+        goal_bound bound;
+        bound.landmarks_ = this;
+        if (battle_field_->contains(goal) && !landmarks_.empty())
+            bound.goal_distances_ = distances_.data() + battle_field_->index_of(goal) * landmarks_.size();
+        return bound;
+    }
+
+    /// <summary>
+    /// Maximum over the landmarks which reach both cells of |d(L, goal) - d(L, from)|
+    /// </summary>
+    /// <param name="from"></param>
+    /// <returns></returns>
+    float landmark_heuristic::goal_bound::operator()(const point_2d from) const
+    {
+        if (goal_distances_ == nullptr || !landmarks_->battle_field_->contains(from))
+            return 0;
+
+        const auto count = landmarks_->landmarks_.size();
+        const auto* cell_distances = landmarks_->distances_.data() + landmarks_->battle_field_->index_of(from) * count;
+        int bound = 0;
+        for (size_t landmark = 0; landmark < count; ++landmark) {
+            if (cell_distances[landmark] == unreachable || goal_distances_[landmark] == unreachable)
+                continue;
+            bound = std::max(bound, std::abs(static_cast<int>(goal_distances_[landmark]) - cell_distances[landmark]));
+        }
+        return static_cast<float>(bound);
+    }
+
+    /// <summary>
+    /// Breadth first search over walkable cells
+    /// </summary>
+    /// <param name="source"></param>
+    /// <param name="distances"></param>
+    void landmark_heuristic::breadth_first_search(const point_2d source, std::vector<std::uint16_t>& distances) const
+    {
+        const auto cell_count = battle_field_->get_cell_count();
+        distances.assign(cell_count, unreachable);
+        if (!battle_field_->is_walkable(source))
+            return;
+
+        // Cells in visiting order, doubles as the queue
+        std::vector<std::uint32_t> queue;
+        queue.reserve(cell_count);
+        queue.push_back(static_cast<std::uint32_t>(battle_field_->index_of(source)));
+        distances[queue.front()] = 0;
+
+        const point_2d directions[] = { point_2d(0, -1), point_2d(0, 1), point_2d(-1, 0), point_2d(1, 0) };
+        for (size_t head = 0; head < queue.size(); ++head) {
+            const auto cell = queue[head];
+            const auto position = battle_field_->position_of(cell);
+            const auto next_distance = static_cast<std::uint16_t>(std::min<int>(distances[cell] + 1, max_distance));
+            for (const auto& direction : directions) {
+                const auto neighbor = position + direction;
+                if (!battle_field_->is_walkable(neighbor))
+                    continue;
+                const auto neighbor_cell = battle_field_->index_of(neighbor);
+                if (distances[neighbor_cell] != unreachable)
+                    continue;
+                distances[neighbor_cell] = next_distance;
+                queue.push_back(static_cast<std::uint32_t>(neighbor_cell));
+            }
+        }
+    }
+
+    /// <summary>
+    /// Interleave one landmark's distances into the tables
+    /// </summary>
+    /// <param name="landmark"></param>
+    /// <param name="distances"></param>
+    /// <param name="stride"></param>
+    void landmark_heuristic::store(const size_t landmark, const std::vector<std::uint16_t>& distances, const size_t stride)
+    {
+        for (size_t cell = 0; cell < distances.size(); ++cell)
+            distances_[cell * stride + landmark] = distances[cell];
+    }
+}
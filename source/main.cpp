@@ -1,19 +1,30 @@
 #include <filesystem>
 
-#include "../headers/unit.hpp"
+#include "../headers/unitStore.hpp"
 #include "../headers/point2d.hpp"
 #include "../headers/pathFinder.hpp"
 #include "../headers/battleField.hpp"
 #include "../headers/battleFieldCreator.hpp"
 #include "../headers/battleFieldRenderer.hpp"
+#include "../headers/memoryResources.hpp"
+#include "../headers/goalBounds.hpp"
+#include "../headers/precomputeCache.hpp"
+#include "../headers/mapWatcher.hpp"
 
+#include <future>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <thread>
 
 // Add path_finding namespace used for this project
 using namespace path_finding;
 
+/// <summary>
+/// Goal bounds take one search per cell, the demo only builds them for map files up to this many cells
+/// </summary>
+constexpr size_t max_goal_bounds_cells = 128 * 128;
+
 /// <summary>
 /// Main entry point of an application
 /// </summary>
@@ -22,7 +33,8 @@ int main() {
 	try {
 
 		// Create a battlefield based on user input
-		auto battle_field = battle_field_creator::create();
+		std::string config_file;
+		auto battle_field = battle_field_creator::create(config_file);
 
 		// Get unit start positions and target positions from battlefield
 		const auto& start_positions = battle_field.get_start_positions();
@@ -37,43 +49,106 @@ int main() {
 		// Initialize pathfinder 
 		pathfinder path_finder(battle_field);
 
-		// Create units dynamically based on JSON start positions
-		std::vector<unit> units;
+		// Goal bounds of a map file come from the cache keyed by the map content (PATH_FINDING_CACHE_DIR, none when empty),
+		// a map seen for the first time builds them in the background. Random maps and large maps search without them
+		const precompute_cache cache(PATH_FINDING_CACHE_DIR);
+		const auto build_bounds = [&] {
+			const auto cells = static_cast<size_t>(battle_field.get_width()) * static_cast<size_t>(battle_field.get_height());
+			return !config_file.empty() && cells <= max_goal_bounds_cells
+				? cache.load_or_build_async<goal_bounds>(battle_field) : std::future<goal_bounds>();
+		};
+		auto pending_bounds = build_bounds();
+		std::optional<goal_bounds> bounds;
+
+		// Long lived unit paths come from a shared pool, transient search data from a per tick arena
+		path_pool unit_path_pool;
+		tick_arena search_arena;
+
+		// Create units dynamically based on JSON start positions, stored as arrays with their paths in one shared buffer
+		unit_store units(path_finder, unit_path_pool.resource());
 		std::unordered_set<point_2d> occupied_positions;
 
+		// Units heading for the same target share the common ends of their paths
+		units.set_path_sharing(true);
+		units.reserve(start_positions.size());
 		for (const auto& startPos : start_positions) {
-			units.emplace_back(startPos, path_finder);
+			units.add(startPos);
 			occupied_positions.insert(startPos);
 		}
 
-		// Use only one target for all the units 
-		const auto target = target_positions[0];
+		// Every unit heads for its nearest target
 		battle_field_renderer battle_field_renderer(battle_field);
 
+		// A map loaded from a file is reloaded when the file is saved, the renderer's obstacle counts follow the edits
+		std::optional<map_watcher> watcher;
+		if (!config_file.empty())
+			watcher.emplace(battle_field, config_file);
+		battle_field.subscribe([&battle_field_renderer](const map_changes& changes) {
+			battle_field_renderer.get_viewport().apply_changes(changes);
+		});
+
 		// Update the display to display the setup 
 		battle_field_renderer.update(occupied_positions);
 
-		// Game loop for unit movement
+		// Game loop for unit movement, waiting and backing off units retry within the longest back off
+		unsigned ticksWithoutMovement = 0;
 		while (true) {
 
-			// Mark movement flag to be no movement 
-			bool movementHappened = false;
+			// Searches prune with the bounds as soon as they are available, bounds of a map that was edited meanwhile are rebuilt
+			if (!bounds && pending_bounds.valid() && pending_bounds.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				bounds.emplace(pending_bounds.get());
+				path_finder.set_goal_bounds(&*bounds);
+				if (path_finder.get_goal_bounds() == nullptr) {
+					bounds.reset();
+					pending_bounds = build_bounds();
+				}
+			}
+
+			// Edits of the map file land at the tick boundary, only the changed tiles, the bounds are built again for the new map
+			// (a build still running finishes for the old map, is rejected and starts again above)
+			if (watcher && watcher->poll()) {
+				battle_field.publish_changes();
+				if (bounds || !pending_bounds.valid()) {
+					path_finder.set_goal_bounds(nullptr);
+					bounds.reset();
+					pending_bounds = build_bounds();
+				}
+			}
+
+			// Move every unit one step, the movement flag is set if any unit has moved
+			const bool movementHappened = units.tick_to_nearest(target_positions, occupied_positions, search_arena.resource()) > 0;
+			ticksWithoutMovement = movementHappened ? 0 : ticksWithoutMovement + 1;
 
-			// Update movement flag if any unit has moved
-			for (auto& unit : units)
-				if (unit.move(target, occupied_positions) == move_status::moved)
-					movementHappened = true;
+			// Drop everything the searches of this tick allocated
+			search_arena.reset();
 
-			// Update the display 
+			// Update the display, the window follows the first unit on maps larger than the console
+			battle_field_renderer.follow(units.get_position(0));
 			battle_field_renderer.update(occupied_positions);
 
-			if (!movementHappened) {
-				std::cout << "All units reached their targets!" << '\n';
+			// Done when every unit arrived, or nobody moved for longer than any unit backs off
+			size_t arrived = 0;
+			for (unit_store::unit_id id = 0; id < units.size(); ++id)
+				arrived += units.get_status(id) == move_status::at_target ? 1 : 0;
+
+			if (arrived == units.size() || ticksWithoutMovement > units.get_conflict_resolution().max_backoff_ticks) {
+				if (arrived == units.size())
+					std::cout << "All units reached their targets!" << '\n';
+				else
+					std::cout << arrived << " of " << units.size() << " units reached their targets, the others are stuck." << '\n';
+
+				const auto& metrics = units.get_conflict_metrics();
+				std::cout << "Searches: " << metrics.searches << ", swaps: " << metrics.swaps << ", detours: " << metrics.detours
+					<< " (" << metrics.cycles << " wait-for cycles), yields: " << metrics.yields
+					<< ", oscillations: " << metrics.oscillations << '\n';
+				std::cout << "Search arena allocations: " << search_arena.get_counter().get_allocation_count()
+					<< ", path pool allocations: " << unit_path_pool.get_counter().get_allocation_count() << '\n';
 				break;
 			}
 
 			// Slow down for effect
-			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+			if (movementHappened)
+				std::this_thread::sleep_for(std::chrono::milliseconds(300));
 		}
 
 	}
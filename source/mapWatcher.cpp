@@ -0,0 +1,251 @@
+#include "../headers/mapWatcher.hpp"
+
+#include <exception>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace path_finding
+{
+    /// <summary>
+    /// Quiet time after the last write event before the file is parsed, so a writer has finished
+    /// </summary>
+    static constexpr std::chrono::milliseconds settle_time(20);
+
+    /// <summary>
+    /// Take the tiles of the loaded battlefield as the baseline, set up the watch and start the background thread
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="filename"></param>
+    /// <param name="poll_interval"></param>
+    map_watcher::map_watcher(battle_field& battle_field, std::string filename, const std::chrono::milliseconds poll_interval) :
+        battle_field_(&battle_field), filename_(std::move(filename)), poll_interval_(poll_interval),
+        baseline_width_(battle_field.get_width()), baseline_height_(battle_field.get_height()),
+        baseline_(battle_field.get_row_major_tiles())
+    {
+#ifdef __linux__
+        // Watch the directory rather than the file, editors replace the file by renaming a new one over it
+        inotify_descriptor_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_descriptor_ >= 0) {
+            auto directory = std::filesystem::path(filename_).parent_path();
+            if (directory.empty())
+                directory = ".";
+            if (inotify_add_watch(inotify_descriptor_, directory.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+                close(inotify_descriptor_);
+                inotify_descriptor_ = -1;
+            }
+        }
+#endif
+        if (inotify_descriptor_ < 0) {
+            std::error_code error;
+            last_write_time_ = std::filesystem::last_write_time(filename_, error);
+            last_size_ = std::filesystem::file_size(filename_, error);
+        }
+
+        thread_ = std::thread([this] { watch(); });
+    }
+
+    /// <summary>
+    /// Stop and join the background thread, it sees the flag within one poll interval
+    /// </summary>
+    map_watcher::~map_watcher()
+    {
+        stopping_ = true;
+        thread_.join();
+#ifdef __linux__
+        if (inotify_descriptor_ >= 0)
+            close(inotify_descriptor_);
+#endif
+    }
+
+    /// <summary>
+    /// Take the pending changes under the lock, then edit the battlefield without it
+    /// </summary>
+    /// <returns></returns>
+    bool map_watcher::poll()
+    {
+        std::vector<std::pair<point_2d, tile_type>> tiles;
+        std::vector<tile_type> grid;
+        bool resize;
+        int width, height;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tiles.swap(pending_tiles_);
+            grid.swap(pending_grid_);
+            resize = pending_resize_;
+            width = pending_width_;
+            height = pending_height_;
+            pending_resize_ = false;
+        }
+
+        size_t changed = 0;
+        if (resize) {
+            battle_field_->load_from_tiles(width, height, grid);
+            changed = grid.size();
+        }
+        else if (!tiles.empty()) {
+            const auto version = battle_field_->get_version();
+            battle_field_->set_tiles(tiles);
+            changed = battle_field_->get_version() != version ? tiles.size() : 0;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        metrics_.resizes += resize ? 1 : 0;
+        metrics_.applied_tiles += changed;
+        return changed > 0;
+    }
+
+    /// <summary>
+    /// Message of the last rejected file
+    /// </summary>
+    /// <returns></returns>
+    std::string map_watcher::get_last_error() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_error_;
+    }
+
+    /// <summary>
+    /// Copy of the counters
+    /// </summary>
+    /// <returns></returns>
+    map_watcher_metrics map_watcher::get_metrics() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return metrics_;
+    }
+
+    /// <summary>
+    /// Events when the constructor could set them up, the modification time otherwise
+    /// </summary>
+    void map_watcher::watch()
+    {
+        if (inotify_descriptor_ >= 0)
+            watch_events();
+        else
+            watch_timestamps();
+    }
+
+    /// <summary>
+    /// Block on the descriptor for at most a poll interval, a write to the file is followed by reads until the
+    /// directory was quiet for the settle time
+    /// </summary>
+    void map_watcher::watch_events()
+    {
+#ifdef __linux__
+        const auto name = std::filesystem::path(filename_).filename().string();
+
+        // Whether any event of the buffer names the file, the buffer is drained
+        alignas(inotify_event) char buffer[4096];
+        const auto read_events = [&]() {
+            auto written = false;
+            ssize_t length;
+            while ((length = read(inotify_descriptor_, buffer, sizeof(buffer))) > 0) {
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    if (event->len > 0 && name == event->name)
+                        written = true;
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                }
+            }
+            return written;
+        };
+
+        pollfd descriptor{ inotify_descriptor_, POLLIN, 0 };
+        while (!stopping_) {
+            if (::poll(&descriptor, 1, static_cast<int>(poll_interval_.count())) <= 0 || !read_events())
+                continue;
+            while (!stopping_ && ::poll(&descriptor, 1, static_cast<int>(settle_time.count())) > 0)
+                read_events();
+            if (!stopping_)
+                reload();
+        }
+#endif
+    }
+
+    /// <summary>
+    /// Check the file once per poll interval, a change is parsed once it stayed the same for the settle time,
+    /// otherwise the next check sees it again
+    /// </summary>
+    void map_watcher::watch_timestamps()
+    {
+        while (!stopping_) {
+            std::this_thread::sleep_for(poll_interval_);
+
+            std::error_code error;
+            const auto write_time = std::filesystem::last_write_time(filename_, error);
+            const auto size = std::filesystem::file_size(filename_, error);
+            if (error || (write_time == last_write_time_ && size == last_size_))
+                continue;
+            last_write_time_ = write_time;
+            last_size_ = size;
+
+            std::this_thread::sleep_for(settle_time);
+            if (std::filesystem::last_write_time(filename_, error) == write_time && !error)
+                reload();
+        }
+    }
+
+    /// <summary>
+    /// Parse into a private battlefield, diff against the baseline and merge the result into the pending changes
+    /// </summary>
+    void map_watcher::reload()
+    {
+        battle_field parsed;
+        try {
+            parsed.load_from_json(filename_);
+        }
+        catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            metrics_.errors++;
+            last_error_ = e.what();
+            return;
+        }
+
+        const auto width = parsed.get_width();
+        const auto height = parsed.get_height();
+        const auto& tiles = parsed.get_tiles();
+
+        // Changed tiles, unless the size changed and the whole grid goes
+        std::vector<std::pair<point_2d, tile_type>> changes;
+        const auto resize = width != baseline_width_ || height != baseline_height_;
+        if (!resize) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    const auto index = static_cast<size_t>(y) * width + x;
+                    if (tiles[index] != baseline_[index])
+                        changes.emplace_back(point_2d(x, y), tiles[index]);
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            metrics_.reloads++;
+            last_error_.clear();
+            if (resize) {
+                pending_resize_ = true;
+                pending_width_ = width;
+                pending_height_ = height;
+                pending_grid_ = tiles;
+                pending_tiles_.clear();
+            }
+            else if (pending_resize_) {
+                // A grid not polled yet takes the changes directly
+                for (const auto& [position, type] : changes)
+                    pending_grid_[static_cast<size_t>(position.get_y()) * width + position.get_x()] = type;
+            }
+            else {
+                pending_tiles_.insert(pending_tiles_.end(), changes.begin(), changes.end());
+            }
+        }
+
+        baseline_width_ = width;
+        baseline_height_ = height;
+        baseline_ = tiles;
+    }
+}
@@ -0,0 +1,104 @@
+#include "../headers/mappedFile.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace path_finding
+{
+#ifdef _WIN32
+    /// <summary>
+    /// Map the file with CreateFileMapping / MapViewOfFile
+    /// </summary>
+    /// <param name="filename"></param>
+    mapped_file::mapped_file(const std::string& filename) :
+        data_(nullptr), size_(0), file_handle_(nullptr), mapping_handle_(nullptr)
+    {
+        const auto file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Failed to open file: " + filename);
+        file_handle_ = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to read file size: " + filename);
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ == 0)
+            return;
+
+        mapping_handle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle_ == nullptr) {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map file: " + filename);
+        }
+        data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr) {
+            CloseHandle(mapping_handle_);
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map file: " + filename);
+        }
+    }
+
+    /// <summary>
+    /// Unmap and close
+    /// </summary>
+    mapped_file::~mapped_file()
+    {
+        if (data_ != nullptr)
+            UnmapViewOfFile(data_);
+        if (mapping_handle_ != nullptr)
+            CloseHandle(mapping_handle_);
+        if (file_handle_ != nullptr)
+            CloseHandle(file_handle_);
+    }
+#else
+    /// <summary>
+    /// Map the file with mmap
+    /// </summary>
+    /// <param name="filename"></param>
+    mapped_file::mapped_file(const std::string& filename) :
+        data_(nullptr), size_(0), file_handle_(nullptr), mapping_handle_(nullptr)
+    {
+        const auto descriptor = open(filename.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            throw std::runtime_error("Failed to open file: " + filename);
+
+        struct stat status {};
+        if (fstat(descriptor, &status) != 0) {
+            close(descriptor);
+            throw std::runtime_error("Failed to read file size: " + filename);
+        }
+        size_ = static_cast<size_t>(status.st_size);
+        if (size_ > 0) {
+            auto* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping == MAP_FAILED) {
+                close(descriptor);
+                throw std::runtime_error("Failed to map file: " + filename);
+            }
+            data_ = static_cast<const unsigned char*>(mapping);
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        close(descriptor);
+    }
+
+    /// <summary>
+    /// Unmap
+    /// </summary>
+    mapped_file::~mapped_file()
+    {
+        if (data_ != nullptr)
+            munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+}
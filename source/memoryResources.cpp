@@ -0,0 +1,80 @@
+#include "../headers/memoryResources.hpp"
+
+namespace path_finding
+{
+    /// <summary>
+    /// Constructor to initialize the upstream and counters
+    /// </summary>
+    /// <param name="upstream"></param>
+    counting_resource::counting_resource(std::pmr::memory_resource* upstream) :
+        upstream_(upstream), allocation_count_(0), deallocation_count_(0), bytes_allocated_(0), bytes_in_use_(0)
+    {
+    }
+
+    /// <summary>
+    /// Reset the counters
+    /// </summary>
+    void counting_resource::reset_counters()
+    {
+        allocation_count_.store(0, std::memory_order_relaxed);
+        deallocation_count_.store(0, std::memory_order_relaxed);
+        bytes_allocated_.store(0, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Forward the allocation to the upstream and count it
+    /// </summary>
+    /// <param name="bytes"></param>
+    /// <param name="alignment"></param>
+    /// <returns></returns>
+    void* counting_resource::do_allocate(const size_t bytes, const size_t alignment)
+    {
+        void* p = upstream_->allocate(bytes, alignment);
+        allocation_count_.fetch_add(1, std::memory_order_relaxed);
+        bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+        bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed);
+        return p;
+    }
+
+    /// <summary>
+    /// Forward the deallocation to the upstream and count it
+    /// </summary>
+    /// <param name="p"></param>
+    /// <param name="bytes"></param>
+    /// <param name="alignment"></param>
+    void counting_resource::do_deallocate(void* p, const size_t bytes, const size_t alignment)
+    {
+        upstream_->deallocate(p, bytes, alignment);
+        deallocation_count_.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Two counting resources are only interchangeable when they are the same object
+    /// </summary>
+    /// <param name="other"></param>
+    /// <returns></returns>
+    bool counting_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    /// <summary>
+    /// Constructor to initialize the arena on top of a counting upstream
+    /// </summary>
+    /// <param name="initial_size"></param>
+    /// <param name="upstream"></param>
+    tick_arena::tick_arena(const size_t initial_size, std::pmr::memory_resource* upstream) :
+        counter_(upstream), arena_(initial_size, &counter_)
+    {
+    }
+
+    /// <summary>
+    /// Constructor to initialize the pool on top of a counting upstream
+    /// </summary>
+    /// <param name="upstream"></param>
+    path_pool::path_pool(std::pmr::memory_resource* upstream) :
+        counter_(upstream), pool_(&counter_)
+    {
+    }
+}
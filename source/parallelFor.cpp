@@ -0,0 +1,54 @@
+#include "../headers/parallelFor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Run body for every index on worker threads, the calling thread works as well
+    /// </summary>
+    /// <param name="count"></param>
+    /// <param name="body"></param>
+    /// <param name="number_of_threads"></param>
+    void parallel_for(const size_t count, const std::function<void(size_t)>& body, unsigned number_of_threads)
+    {
+        if (number_of_threads == 0)
+            number_of_threads = std::max(1u, std::thread::hardware_concurrency());
+        number_of_threads = static_cast<unsigned>(std::min<size_t>(number_of_threads, count));
+
+        std::atomic<size_t> next_index(0);
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        const auto worker = [&]() {
+            for (auto i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1)) {
+                try {
+                    body(i);
+                }
+                catch (...) {
+                    // Keep the first error and stop handing out work
+                    std::lock_guard lock(error_mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    next_index.store(count);
+                }
+            }
+        };
+
+        // Extra threads, the calling thread is the last worker
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < number_of_threads; ++t)
+            threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads)
+            thread.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,272 @@
+#include "../headers/pathExecutor.hpp"
+#include "../headers/pathFinder.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Whether the worker handed over the path
+    /// </summary>
+    /// <returns></returns>
+    bool path_executor::path_request::ready() const
+    {
+        std::lock_guard<std::mutex> lock(executor_->mutex_);
+        return state_->done;
+    }
+
+    /// <summary>
+    /// Park the coroutine until the worker is done, or carry on when it already is
+    /// </summary>
+    /// <param name="handle"></param>
+    /// <returns></returns>
+    bool path_executor::path_request::await_suspend(const std::coroutine_handle<> handle)
+    {
+        std::lock_guard<std::mutex> lock(executor_->mutex_);
+        if (state_->done)
+            return false;
+        state_->waiter = handle;
+        return true;
+    }
+
+    /// <summary>
+    /// Hand over the path unless a newer map was published since it was requested
+    /// </summary>
+    /// <returns></returns>
+    std::optional<std::vector<point_2d>> path_executor::path_request::await_resume()
+    {
+        if (state_->version != executor_->get_map_version()) {
+            executor_->metrics_.stale++;
+            return std::nullopt;
+        }
+        return std::move(state_->path);
+    }
+
+    /// <summary>
+    /// Start the workers, the battlefield must publish snapshots
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="number_of_threads"></param>
+    path_executor::path_executor(const battle_field& battle_field, std::unordered_set<point_2d>& occupied_positions,
+        unsigned number_of_threads) :
+        battle_field_(&battle_field), occupied_positions_(&occupied_positions)
+    {
+        if (!battle_field.get_snapshot())
+            throw std::runtime_error("path_executor needs a battlefield with snapshots enabled");
+        if (number_of_threads == 0)
+            number_of_threads = std::max(1u, std::thread::hardware_concurrency());
+        workers_.reserve(number_of_threads);
+        for (unsigned i = 0; i < number_of_threads; ++i)
+            workers_.emplace_back([this] { work(); });
+    }
+
+    /// <summary>
+    /// Join the workers before the coroutines go, a worker never touches a destroyed coroutine
+    /// </summary>
+    path_executor::~path_executor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+        tasks_.clear();
+    }
+
+    /// <summary>
+    /// Own the coroutine and run it on the next tick
+    /// </summary>
+    /// <param name="task"></param>
+    void path_executor::spawn(unit_task task)
+    {
+        if (task.done())
+            return;
+        next_tick_.push_back(task.handle_);
+        tasks_.push_back(std::move(task));
+    }
+
+    /// <summary>
+    /// Queue the request on the latest published battlefield snapshot, taking a new occupancy snapshot
+    /// on the first request of a tick
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <returns></returns>
+    path_executor::path_request path_executor::request_path(const point_2d start, const point_2d goal)
+    {
+        if (!occupied_snapshot_ || occupied_snapshot_tick_ != tick_) {
+            occupied_snapshot_ = std::make_shared<const std::unordered_set<point_2d>>(*occupied_positions_);
+            occupied_snapshot_tick_ = tick_;
+        }
+
+        auto state = std::make_shared<request_state>();
+        state->start = start;
+        state->goal = goal;
+        state->occupied_positions = occupied_snapshot_;
+        state->snapshot = battle_field_->get_snapshot();
+        state->version = state->snapshot->get_version();
+        metrics_.requests++;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(state);
+        }
+        work_available_.notify_one();
+        return path_request(*this, std::move(state));
+    }
+
+    /// <summary>
+    /// Resume whatever is ready, in the order: next tick waiters and spawns, then arrived paths
+    /// </summary>
+    /// <returns></returns>
+    size_t path_executor::tick()
+    {
+        tick_++;
+        std::vector<std::coroutine_handle<>> ready;
+        ready.swap(next_tick_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready.insert(ready.end(), arrived_.begin(), arrived_.end());
+            arrived_.clear();
+            metrics_.fulfilled = fulfilled_;
+        }
+
+        for (const auto handle : ready)
+            handle.resume();
+        metrics_.resumed += ready.size();
+
+        // Drop the finished coroutines, the first failure is passed on
+        std::exception_ptr failure;
+        for (const auto& task : tasks_)
+            if (!failure && task.done() && task.handle_.promise().exception)
+                failure = task.handle_.promise().exception;
+        tasks_.erase(std::remove_if(tasks_.begin(), tasks_.end(), [](const unit_task& task) { return task.done(); }),
+            tasks_.end());
+        if (failure)
+            std::rethrow_exception(failure);
+        return ready.size();
+    }
+
+    /// <summary>
+    /// Queued and running requests
+    /// </summary>
+    /// <returns></returns>
+    size_t path_executor::get_pending_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size() + in_progress_;
+    }
+
+    /// <summary>
+    /// Take requests one at a time, search them without the lock, then publish the path and the waiting coroutine
+    /// </summary>
+    void path_executor::work()
+    {
+        while (true) {
+            std::shared_ptr<request_state> state;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_available_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (stopping_)
+                    return;
+                state = std::move(queue_.front());
+                queue_.pop_front();
+                in_progress_++;
+            }
+
+            const pathfinder path_finder(*state->snapshot);
+            auto path = path_finder.find_path(state->start, state->goal, *state->occupied_positions);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            state->path = std::move(path);
+            state->done = true;
+            in_progress_--;
+            fulfilled_++;
+            if (state->waiter) {
+                arrived_.push_back(state->waiter);
+                state->waiter = {};
+            }
+        }
+    }
+
+    /// <summary>
+    /// Request, follow, replan on map edits and blocks, until the unit stands on the target
+    /// </summary>
+    /// <param name="executor"></param>
+    /// <param name="unit"></param>
+    /// <param name="target"></param>
+    /// <param name="retry_ticks"></param>
+    /// <returns></returns>
+    unit_task follow_path(path_executor& executor, async_unit& unit, const point_2d target, const unsigned retry_ticks)
+    {
+        auto& occupied = executor.get_occupied_positions();
+        std::optional<path_executor::path_request> replan;
+        point_2d replan_start;
+        while (unit.position != target) {
+
+            // Nothing to follow: idle until a path arrives
+            if (unit.path_index >= unit.path.size()) {
+                unit.status = move_status::searching;
+                replan.reset();
+                auto path = co_await executor.request_path(unit.position, target);
+                if (!path)
+                    continue;
+                if (path->empty()) {
+                    unit.status = move_status::no_path;
+                    for (unsigned i = 0; i < retry_ticks; ++i)
+                        co_await executor.next_tick();
+                    continue;
+                }
+                unit.path = std::move(*path);
+                unit.path_index = 0;
+                unit.path_version = executor.get_map_version();
+            }
+
+            // The map changed under the path: keep following the old one until the new one is there.
+            // The new path starts where the unit was, it is joined where it passes the unit or requested again
+            if (!replan && unit.path_version != executor.get_map_version()) {
+                replan_start = unit.position;
+                replan.emplace(executor.request_path(unit.position, target));
+            }
+            if (replan && replan->ready()) {
+                auto path = co_await *replan;
+                replan.reset();
+                if (path) {
+                    // Index of the step after the unit's cell, past the end when the path does not pass the unit
+                    size_t index = 0;
+                    if (unit.position != replan_start) {
+                        const auto here = std::find(path->begin(), path->end(), unit.position);
+                        index = here != path->end() ? static_cast<size_t>(here - path->begin()) + 1 : path->size() + 1;
+                    }
+                    if (index <= path->size()) {
+                        unit.path = std::move(*path);
+                        unit.path_index = index;
+                        unit.path_version = executor.get_map_version();
+                        if (unit.path_index >= unit.path.size())
+                            continue;
+                    }
+                }
+            }
+
+            // One step, a blocked unit asks for a path around the obstacle on the next tick
+            const auto next = unit.path[unit.path_index];
+            if (!executor.get_battle_field().is_walkable(next) || occupied.find(next) != occupied.end()) {
+                unit.status = move_status::blocked;
+                unit.path.clear();
+                unit.path_index = 0;
+                co_await executor.next_tick();
+                continue;
+            }
+            occupied.erase(unit.position);
+            unit.position = next;
+            occupied.insert(next);
+            unit.path_index++;
+            unit.status = move_status::moved;
+            co_await executor.next_tick();
+        }
+        unit.status = move_status::at_target;
+    }
+}
@@ -1,16 +1,59 @@
 #include "../headers/node.hpp"
 #include "../headers/pathFinder.hpp"
 #include <queue>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <memory>
 #include <unordered_map>
 
 namespace path_finding {
 
+    /// <summary>
+    /// Size a vector path for the given number of steps
+    /// </summary>
+    /// <param name="path"></param>
+    /// <param name="start"></param>
+    /// <param name="length"></param>
+    static void prepare_path(std::vector<point_2d>& path, point_2d, const size_t length) { path.resize(length); }
+    static void prepare_path(std::pmr::vector<point_2d>& path, point_2d, const size_t length) { path.resize(length); }
+
+    /// <summary>
+    /// Size a compact path for the given number of steps
+    /// </summary>
+    /// <param name="path"></param>
+    /// <param name="start"></param>
+    /// <param name="length"></param>
+    static void prepare_path(compact_path& path, const point_2d start, const size_t length) { path.reset(start, length); }
+
+    /// <summary>
+    /// Store the step from one cell to the next at the given index of a vector path
+    /// </summary>
+    /// <param name="path"></param>
+    /// <param name="index"></param>
+    /// <param name="from"></param>
+    /// <param name="to"></param>
+    static void write_step(std::vector<point_2d>& path, const size_t index, point_2d, const point_2d to) { path[index] = to; }
+    static void write_step(std::pmr::vector<point_2d>& path, const size_t index, point_2d, const point_2d to) { path[index] = to; }
+
+    /// <summary>
+    /// Store the step from one cell to the next at the given index of a compact path
+    /// </summary>
+    /// <param name="path"></param>
+    /// <param name="index"></param>
+    /// <param name="from"></param>
+    /// <param name="to"></param>
+    static void write_step(compact_path& path, const size_t index, const point_2d from, const point_2d to) {
+        path.set_step(index, compact_path::direction_of(from, to));
+    }
+
     /// <summary>
     /// Constructor to initialize battlefield reference and predefine directions to calculate neighboring nodes
     /// </summary>
     /// <param name="battle_field"></param>
     pathfinder::pathfinder(const battle_field& battle_field) :
-	battle_field_(&battle_field)
+	battle_field_(&battle_field), expanded_node_count_(0)
     {
         // Predefine directions into the vector
         directions_.clear();
@@ -20,6 +63,39 @@ namespace path_finding {
         directions_.emplace_back(1, 0);     // Right
     }
 
+    /// <summary>
+    /// Copy constructor, the counters are not shared: atomics and the counting resource cannot be copied
+    /// </summary>
+    /// <param name="other"></param>
+    pathfinder::pathfinder(const pathfinder& other) :
+        battle_field_(other.battle_field_), directions_(other.directions_), landmarks_(other.landmarks_),
+        path_database_(other.path_database_), goal_bounds_(other.goal_bounds_), goal_bounds_version_(other.goal_bounds_version_),
+        rectangles_(other.rectangles_), rectangles_version_(other.rectangles_version_), expanded_node_count_(0)
+    {
+    }
+
+    /// <summary>
+    /// Copy assignment, takes the settings of the other pathfinder and resets the counters
+    /// </summary>
+    /// <param name="other"></param>
+    /// <returns></returns>
+    pathfinder& pathfinder::operator=(const pathfinder& other)
+    {
+        if (this == &other)
+            return *this;
+        battle_field_ = other.battle_field_;
+        directions_ = other.directions_;
+        landmarks_ = other.landmarks_;
+        path_database_ = other.path_database_;
+        goal_bounds_ = other.goal_bounds_;
+        goal_bounds_version_ = other.goal_bounds_version_;
+        rectangles_ = other.rectangles_;
+        rectangles_version_ = other.rectangles_version_;
+        search_counter_.reset_counters();
+        expanded_node_count_.store(0, std::memory_order_relaxed);
+        return *this;
+    }
+
     /// <summary>
     /// To find the shortest path from start to goal while avoiding occupied positions by other units 
     /// </summary>
@@ -30,58 +106,184 @@ namespace path_finding {
     std::vector<point_2d> pathfinder::find_path(point_2d start, point_2d goal,
         const std::unordered_set<point_2d>& occupied_positions) const
     {
-        // To keep track of visited nodes
-        std::unordered_set<point_2d> visited;
+        std::vector<point_2d> path;
+        search(start, goal, occupied_positions, nullptr, path);
+        return path;
+    }
+
+    /// <summary>
+    /// To find the shortest path from start to goal, the path is allocated from the given path resource
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="path_resource"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    std::pmr::vector<point_2d> pathfinder::find_path(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* path_resource,
+        std::pmr::memory_resource* scratch_resource) const
+    {
+        std::pmr::vector<point_2d> path(path_resource);
+        search(start, goal, occupied_positions, scratch_resource, path);
+        return path;
+    }
+
+    /// <summary>
+    /// To find the shortest path from start to goal as a compact path allocated from the given path resource
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="path_resource"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    compact_path pathfinder::find_compact_path(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* path_resource,
+        std::pmr::memory_resource* scratch_resource) const
+    {
+        compact_path path(path_resource);
+        search(start, goal, occupied_positions, scratch_resource, path);
+        return path;
+    }
 
-        // To keep track of the cost from start to each node
-        std::unordered_map<point_2d, float> g_score;
+    /// <summary>
+    /// Use goal bounds in find_path
+    /// </summary>
+    /// <param name="bounds"></param>
+    void pathfinder::set_goal_bounds(const goal_bounds* bounds)
+    {
+        // Bounds finished in the background may belong to the map before an edit
+        goal_bounds_ = bounds != nullptr && bounds->get_map_hash() == battle_field_->get_content_hash() ? bounds : nullptr;
+        goal_bounds_version_ = battle_field_->get_version();
+    }
 
-        // To keep track of the predecessors
-        std::unordered_map<point_2d, point_2d> came_from;
+    /// <summary>
+    /// Pruned search while the goal bounds are current, again without pruning when occupancy got in its way
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <param name="path"></param>
+    template <typename Path>
+    void pathfinder::search(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* scratch_resource, Path& path) const
+    {
+        const auto* bounds = get_current_goal_bounds(start);
+        if (bounds == nullptr || !search_with_bounds(start, goal, occupied_positions, bounds, scratch_resource, path))
+            search_with_bounds(start, goal, occupied_positions, nullptr, scratch_resource, path);
+    }
+
+    /// <summary>
+    /// Goal bounds while they belong to the current battlefield version and the start has boxes
+    /// </summary>
+    /// <param name="start"></param>
+    /// <returns></returns>
+    const goal_bounds* pathfinder::get_current_goal_bounds(point_2d start) const
+    {
+        return goal_bounds_ != nullptr && goal_bounds_version_ == battle_field_->get_version() &&
+            battle_field_->is_walkable(start) ? goal_bounds_ : nullptr;
+    }
+
+    /// <summary>
+    /// A* search, every container, the pages of the search table included, lives in a monotonic arena that is dropped
+    /// at once when the search returns.
+    /// Without occupancy in the way the pruned search finds a path as short as the static optimum, which is optimal
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="bounds"></param>
+    /// <param name="scratch_resource"></param>
+    /// <param name="path"></param>
+    /// <returns></returns>
+    template <typename Path>
+    bool pathfinder::search_with_bounds(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions, const goal_bounds* bounds,
+        std::pmr::memory_resource* scratch_resource, Path& path) const
+    {
+        // A start outside the grid has no cell in the search table, and no path
+        if (!battle_field_->contains(start))
+            return true;
+
+        // Per search arena, starts on the stack and grows from the scratch resource
+        std::array<std::byte, search_buffer_size> buffer;
+        std::pmr::monotonic_buffer_resource search_arena(buffer.data(), buffer.size(),
+            scratch_resource != nullptr ? scratch_resource : &search_counter_);
+
+        // Visited nodes, the cost from start to each node and the predecessors, in the layout of the battlefield
+        search_table table(*battle_field_, &search_arena);
 
         // Priority queue 
-        std::priority_queue<node, std::vector<node>, std::greater<node>> open_set;
+        std::priority_queue<node, std::pmr::vector<node>, std::greater<node>> open_set{
+            std::greater<node>(), std::pmr::vector<node>(&search_arena) };
+
+        // Neighbours of the current node, reused for every expansion
+        std::pmr::vector<point_2d> neighbours(&search_arena);
+        neighbours.reserve(directions_.size());
+
+        // Manhattan distance, tightened by the landmarks when available
+        const auto landmark_bound = landmarks_ != nullptr ? landmarks_->bind(goal) : landmark_heuristic::goal_bound();
+        const auto estimate = [&](const point_2d& position) {
+            return std::max(heuristic(position, goal), landmark_bound(position));
+        };
 
         // Set initial cost from start to itself as 0
-        g_score[start] = 0;
+        const auto start_cell = battle_field_->index_of(start);
+        table.set(start_cell, 0, start_cell);
 
         // Add the start node to the open set with g = 0, and h = estimated distance to goal
-        open_set.emplace(start, 0, heuristic(start, goal));
+        open_set.emplace(start, 0, estimate(start));
 
         // Loop: continue until there are no more nodes to explore
+        size_t expanded = 0;
         while (!open_set.empty()) {
 
             // Get the node with the lowest total cost (f = g + h)
             node current_node = open_set.top();
             open_set.pop();
 
-            // Reconstruct the path by walking back through came_from map if the goal is reached
+            // Reconstruct the path by walking back through the predecessors if the goal is reached
+            const auto current_cell = battle_field_->index_of(current_node.position);
             if (current_node.position == goal) {
-                return reconstruct_path(came_from, goal);
+                expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+                const auto length = static_cast<size_t>(table.get_g_score(current_cell));
+                prepare_path(path, start, length);
+                reconstruct_path(table, start, goal, length, path);
+                return true;
             }
 
             // Avoid going back to already visited nodes
-            visited.insert(current_node.position);
+            table.close(current_cell);
+            expanded++;
 
             // Check all valid neighboring nodes of the current node
-            const auto neighbours = get_neighbors(current_node.position, occupied_positions, goal);
+            if (get_neighbors(current_node.position, occupied_positions, goal, bounds, neighbours) && bounds != nullptr) {
+                // A unit took the place of an allowed move, the pruned moves may hold the optimal path around it
+                expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+                return false;
+            }
             for (const auto& neighbor : neighbours) {
 
                 // Continue if the neighbour is already visited
-                if (visited.find(neighbor) != visited.end()) continue;
+                const auto neighbor_cell = battle_field_->index_of(neighbor);
+                if (table.is_closed(neighbor_cell)) continue;
 
                 // Tentative g-score is the cost from start to neighbor through current
                 // Each move has cost of 1
-                const float tentative_g_score = g_score[current_node.position] + 1;
+                const float tentative_g_score = table.get_g_score(current_cell) + 1;
 
-                // If neighbor not yet in g_score, or a better path is found
-                if (!g_score.count(neighbor) || tentative_g_score < g_score[neighbor]) {
+                // If neighbor not reached yet, or a better path is found
+                if (tentative_g_score < table.get_g_score(neighbor_cell)) {
                     // Record this path as the best so far
-                    came_from[neighbor] = current_node.position;
-                    g_score[neighbor] = tentative_g_score;
+                    table.set(neighbor_cell, tentative_g_score, current_cell);
 
                     // Calculate heuristic cost from neighbor to goal
-                    float h = heuristic(neighbor, goal);
+                    float h = estimate(neighbor);
 
                     // Add neighbor to open set with updated scores
                     open_set.emplace(neighbor, tentative_g_score, h);
@@ -89,7 +291,638 @@ namespace path_finding {
             }
         }
 
-        return {}; // No path found
+        // No path found, path stays empty
+        expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// <summary>
+    /// Read the path from the compressed path database, search only when occupancy gets in the way
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <returns></returns>
+    std::vector<point_2d> pathfinder::find_path_from_database(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions) const
+    {
+        // The database only knows paths between walkable cells
+        if (path_database_ == nullptr || !battle_field_->is_walkable(start))
+            return find_path(start, goal, occupied_positions);
+
+        auto path = path_database_->extract_path(start, goal);
+        for (const auto& position : path)
+            if (position != goal && occupied_positions.find(position) != occupied_positions.end())
+                return find_path(start, goal, occupied_positions);
+        return path;
+    }
+
+    /// <summary>
+    /// Use a rectangle decomposition in find_path_reduced
+    /// </summary>
+    /// <param name="rectangles"></param>
+    void pathfinder::set_symmetry_reduction(const rectangle_decomposition* rectangles)
+    {
+        rectangles_ = rectangles;
+        rectangles_version_ = battle_field_->get_version();
+    }
+
+    /// <summary>
+    /// Search the reduced graph while the decomposition is current
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <returns></returns>
+    std::vector<point_2d> pathfinder::find_path_reduced(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions) const
+    {
+        if (rectangles_ == nullptr || rectangles_version_ != battle_field_->get_version() ||
+            !battle_field_->is_walkable(start) || !battle_field_->is_walkable(goal))
+            return find_path(start, goal, occupied_positions);
+
+        std::vector<point_2d> path;
+        search_reduced(start, goal, occupied_positions, *rectangles_, path);
+        return path;
+    }
+
+    /// <summary>
+    /// A* where a jump costs the cells it crosses, the manhattan estimate stays consistent.
+    /// The path between two jump points is a straight line inside an empty rectangle, it is filled in cell by cell
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="rectangles"></param>
+    /// <param name="path"></param>
+    void pathfinder::search_reduced(point_2d start, point_2d goal, const std::unordered_set<point_2d>& occupied_positions,
+        const rectangle_decomposition& rectangles, std::vector<point_2d>& path) const
+    {
+        // A start outside the grid has no cell in the search table, and no path
+        if (!battle_field_->contains(start))
+            return;
+
+        // Write the cells of a straight line after from up to to, backwards from the step before end index
+        const auto write_line = [&path](const point_2d from, const point_2d to, size_t end_index) {
+            const auto dx = to.get_x() - from.get_x();
+            const auto dy = to.get_y() - from.get_y();
+            const point_2d back(dx < 0 ? 1 : dx > 0 ? -1 : 0, dy < 0 ? 1 : dy > 0 ? -1 : 0);
+            for (auto position = to; position != from; position = position + back)
+                path[--end_index] = position;
+            return end_index;
+        };
+
+        // Per search arena, starts on the stack and grows from the pathfinder's counter
+        std::array<std::byte, search_buffer_size> buffer;
+        std::pmr::monotonic_buffer_resource search_arena(buffer.data(), buffer.size(), &search_counter_);
+
+        // Rectangles with a unit inside are searched cell by cell
+        std::pmr::unordered_set<std::uint32_t> crowded(&search_arena);
+        for (const auto& position : occupied_positions) {
+            const auto index = rectangles.get_rectangle_index(position);
+            if (index != rectangle_decomposition::no_rectangle)
+                crowded.insert(index);
+        }
+
+        // Within one empty rectangle any monotone path is free, across then down
+        const auto start_rectangle = rectangles.get_rectangle_index(start);
+        if (start_rectangle == rectangles.get_rectangle_index(goal) && crowded.count(start_rectangle) == 0) {
+            const point_2d corner(goal.get_x(), start.get_y());
+            const auto length = static_cast<size_t>(start.manhattan_distance(goal));
+            path.resize(length);
+            write_line(start, corner, write_line(corner, goal, length));
+            return;
+        }
+
+        search_table table(*battle_field_, &search_arena);
+        std::pmr::vector<point_2d> neighbours(&search_arena);
+        neighbours.reserve(directions_.size());
+
+        // Equal estimates go deepest first: a jump lands on many cells of the same estimate, the one closest to the goal
+        // leads on without expanding the others
+        const auto later = [](const node& a, const node& b) {
+            return a.f_cost() > b.f_cost() || (a.f_cost() == b.f_cost() && a.g_cost < b.g_cost);
+        };
+        std::priority_queue<node, std::pmr::vector<node>, decltype(later)> open_set{
+            later, std::pmr::vector<node>(&search_arena) };
+
+        const auto start_cell = battle_field_->index_of(start);
+        table.set(start_cell, 0, start_cell);
+        open_set.emplace(start, 0, heuristic(start, goal));
+
+        size_t expanded = 0;
+        while (!open_set.empty()) {
+            const node current_node = open_set.top();
+            open_set.pop();
+
+            // Walk back over the jump points and fill in the lines between them
+            const auto current_cell = battle_field_->index_of(current_node.position);
+            if (current_node.position == goal) {
+                expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+                auto end_index = static_cast<size_t>(table.get_g_score(current_cell));
+                path.resize(end_index);
+                for (auto position = goal; position != start;) {
+                    const auto previous = battle_field_->position_of(table.get_parent(battle_field_->index_of(position)));
+                    end_index = write_line(previous, position, end_index);
+                    position = previous;
+                }
+                return;
+            }
+
+            if (!table.close(current_cell))
+                continue;
+            expanded++;
+
+            get_reduced_neighbors(current_node.position, goal, occupied_positions, rectangles, crowded, neighbours);
+            for (const auto& neighbor : neighbours) {
+                const auto neighbor_cell = battle_field_->index_of(neighbor);
+                if (table.is_closed(neighbor_cell))
+                    continue;
+
+                // A jump costs one per cell crossed
+                const float tentative_g_score = table.get_g_score(current_cell) +
+                    static_cast<float>(current_node.position.manhattan_distance(neighbor));
+                if (tentative_g_score < table.get_g_score(neighbor_cell)) {
+                    table.set(neighbor_cell, tentative_g_score, current_cell);
+                    open_set.emplace(neighbor, tentative_g_score, heuristic(neighbor, goal));
+                }
+            }
+        }
+
+        // No path found, path stays empty
+        expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// A* towards the goal of the tree where every shared node reached offers a complete path: its cost so far plus its distance.
+    /// The best such offer is taken once no open node has a lower estimate, which with the consistent manhattan estimate
+    /// means no path through the open nodes is shorter. Reaching the goal is the offer of the root.
+    /// A node whose next splice_lookahead steps run into a unit makes no offer
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="tree"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    path_tree::node_id pathfinder::find_path_in_tree(point_2d start, const std::unordered_set<point_2d>& occupied_positions,
+        path_tree& tree, std::pmr::memory_resource* scratch_resource) const
+    {
+        tree.synchronize();
+        const auto goal = tree.get_goal();
+
+        // A start outside the grid has no cell in the search table, and no path
+        if (!battle_field_->contains(start))
+            return path_tree::no_node;
+
+        // Per search arena, starts on the stack and grows from the scratch resource
+        std::array<std::byte, search_buffer_size> buffer;
+        std::pmr::monotonic_buffer_resource search_arena(buffer.data(), buffer.size(),
+            scratch_resource != nullptr ? scratch_resource : &search_counter_);
+
+        search_table table(*battle_field_, &search_arena);
+        std::priority_queue<node, std::pmr::vector<node>, std::greater<node>> open_set{
+            std::greater<node>(), std::pmr::vector<node>(&search_arena) };
+        std::pmr::vector<point_2d> neighbours(&search_arena);
+        neighbours.reserve(directions_.size());
+
+        // Whether the first steps after a node are free of occupied positions (the goal may be occupied)
+        const auto is_suffix_clear = [&](path_tree::node_id id) {
+            for (size_t step = 0; step < splice_lookahead; ++step) {
+                id = tree.get(id).parent;
+                if (id == path_tree::no_node || id == path_tree::root)
+                    return true;
+                if (occupied_positions.find(tree.get(id).position) != occupied_positions.end())
+                    return false;
+            }
+            return true;
+        };
+
+        // Best offer so far. Statically optimal as long as the search ran as it would have without units
+        auto splice = path_tree::no_node;
+        auto splice_cost = std::numeric_limits<float>::infinity();
+        point_2d splice_position;
+        auto statically_optimal = true;
+        const auto offer = [&](const point_2d position, const float g) {
+            const auto id = tree.find(position);
+            if (id == path_tree::no_node || g + static_cast<float>(tree.get(id).distance) >= splice_cost)
+                return;
+            if (!is_suffix_clear(id)) {
+                statically_optimal = false;
+                return;
+            }
+            splice = id;
+            splice_cost = g + static_cast<float>(tree.get(id).distance);
+            splice_position = position;
+        };
+
+        const auto start_cell = battle_field_->index_of(start);
+        table.set(start_cell, 0, start_cell);
+        open_set.emplace(start, 0, heuristic(start, goal));
+        offer(start, 0);
+
+        size_t expanded = 0;
+        while (!open_set.empty() && open_set.top().f_cost() < splice_cost) {
+            const node current_node = open_set.top();
+            open_set.pop();
+            const auto current_cell = battle_field_->index_of(current_node.position);
+            if (!table.close(current_cell))
+                continue;
+            expanded++;
+
+            if (get_neighbors(current_node.position, occupied_positions, goal, nullptr, neighbours))
+                statically_optimal = false;
+            for (const auto& neighbor : neighbours) {
+                const auto neighbor_cell = battle_field_->index_of(neighbor);
+                if (table.is_closed(neighbor_cell)) continue;
+
+                const float tentative_g_score = table.get_g_score(current_cell) + 1;
+                if (tentative_g_score < table.get_g_score(neighbor_cell)) {
+                    table.set(neighbor_cell, tentative_g_score, current_cell);
+                    open_set.emplace(neighbor, tentative_g_score, heuristic(neighbor, goal));
+                    offer(neighbor, tentative_g_score);
+                }
+            }
+        }
+        expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+        if (splice == path_tree::no_node)
+            return path_tree::no_node;
+
+        // Chain the cells before the splice in front of it, from the splice back to the start. A cell is shared when the
+        // path is statically optimal from there: the search met no unit, or the rest is as long as the manhattan distance
+        // (the path from the splice on is optimal already, the last steps of an optimal path are optimal as well)
+        std::pmr::vector<point_2d> prefix(&search_arena);
+        for (auto position = splice_position; position != start;) {
+            position = battle_field_->position_of(table.get_parent(battle_field_->index_of(position)));
+            prefix.push_back(position);
+        }
+        auto shared_count = statically_optimal ? prefix.size() : 0;
+        for (size_t i = 0; i < prefix.size(); ++i)
+            if (heuristic(prefix[i], goal) == static_cast<float>(tree.get(splice).distance + i + 1))
+                shared_count = std::max(shared_count, i + 1);
+        auto head = splice;
+        for (size_t i = 0; i < prefix.size(); ++i)
+            head = tree.add(prefix[i], head, i < shared_count && tree.find(prefix[i]) == path_tree::no_node);
+        tree.acquire(head);
+        return head;
+    }
+
+    /// <summary>
+    /// To find the shortest path from start to the nearest of the targets
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="reached_target"></param>
+    /// <returns></returns>
+    std::vector<point_2d> pathfinder::find_path_to_nearest(point_2d start, const std::vector<point_2d>& targets,
+        const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target) const
+    {
+        std::vector<point_2d> path;
+        search_nearest(start, targets, occupied_positions, reached_target, nullptr, path);
+        return path;
+    }
+
+    /// <summary>
+    /// To find the shortest path from start to the nearest of the targets, the path is allocated from the given path resource
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="reached_target"></param>
+    /// <param name="path_resource"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    std::pmr::vector<point_2d> pathfinder::find_path_to_nearest(point_2d start, const std::vector<point_2d>& targets,
+        const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target,
+        std::pmr::memory_resource* path_resource,
+        std::pmr::memory_resource* scratch_resource) const
+    {
+        std::pmr::vector<point_2d> path(path_resource);
+        search_nearest(start, targets, occupied_positions, reached_target, scratch_resource, path);
+        return path;
+    }
+
+    /// <summary>
+    /// To find the shortest path from start to the nearest of the targets as a compact path allocated from the given path resource
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="reached_target"></param>
+    /// <param name="path_resource"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    compact_path pathfinder::find_compact_path_to_nearest(point_2d start, const std::vector<point_2d>& targets,
+        const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target,
+        std::pmr::memory_resource* path_resource,
+        std::pmr::memory_resource* scratch_resource) const
+    {
+        compact_path path(path_resource);
+        search_nearest(start, targets, occupied_positions, reached_target, scratch_resource, path);
+        return path;
+    }
+
+    /// <summary>
+    /// Search towards the nearest target, pruned by the goal bounds for a few targets, again without pruning when
+    /// occupancy got in its way.
+    /// Heuristic is the manhattan distance to the closest target (admissible and consistent as a minimum of such),
+    /// with many targets it is replaced by zero, i.e. plain Dijkstra
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="reached_target"></param>
+    /// <param name="scratch_resource"></param>
+    /// <param name="path"></param>
+    template <typename Path>
+    void pathfinder::search_nearest(point_2d start, const std::vector<point_2d>& targets,
+        const std::unordered_set<point_2d>& occupied_positions, size_t& reached_target,
+        std::pmr::memory_resource* scratch_resource, Path& path) const
+    {
+        const auto* bounds = targets.size() <= max_heuristic_targets ? get_current_goal_bounds(start) : nullptr;
+        if (bounds == nullptr ||
+            !search_nearest_with_bounds(start, targets, occupied_positions, bounds, reached_target, scratch_resource, path))
+            search_nearest_with_bounds(start, targets, occupied_positions, nullptr, reached_target, scratch_resource, path);
+    }
+
+    /// <summary>
+    /// A* towards a set of targets, the first target popped from the open set is the nearest one
+    /// With bounds a move is only taken when its box holds one of the targets, every target keeps an optimal path
+    /// so the nearest one is still found first
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="bounds"></param>
+    /// <param name="reached_target"></param>
+    /// <param name="scratch_resource"></param>
+    /// <param name="path"></param>
+    /// <returns></returns>
+    template <typename Path>
+    bool pathfinder::search_nearest_with_bounds(point_2d start, const std::vector<point_2d>& targets,
+        const std::unordered_set<point_2d>& occupied_positions, const goal_bounds* bounds, size_t& reached_target,
+        std::pmr::memory_resource* scratch_resource, Path& path) const
+    {
+        path.clear();
+        reached_target = targets.size();
+
+        // A start outside the grid has no cell in the search table, and no path
+        if (!battle_field_->contains(start))
+            return true;
+
+        // Per search arena, starts on the stack and grows from the scratch resource
+        std::array<std::byte, search_buffer_size> buffer;
+        std::pmr::monotonic_buffer_resource search_arena(buffer.data(), buffer.size(),
+            scratch_resource != nullptr ? scratch_resource : &search_counter_);
+
+        // Target lookup, the first index wins for duplicated targets
+        std::pmr::unordered_map<point_2d, size_t> target_indices(&search_arena);
+        for (size_t i = 0; i < targets.size(); ++i)
+            target_indices.emplace(targets[i], i);
+        if (target_indices.empty())
+            return true;
+
+        // Already standing on a target
+        const auto start_target = target_indices.find(start);
+        if (start_target != target_indices.end()) {
+            reached_target = start_target->second;
+            return true;
+        }
+
+        const auto use_heuristic = targets.size() <= max_heuristic_targets;
+        const auto nearest_heuristic = [&](const point_2d& position) {
+            if (!use_heuristic)
+                return 0.0f;
+            auto h = std::numeric_limits<float>::infinity();
+            for (const auto& target : targets)
+                h = std::min(h, heuristic(position, target));
+            return h;
+        };
+
+        search_table table(*battle_field_, &search_arena);
+        std::priority_queue<node, std::pmr::vector<node>, std::greater<node>> open_set{
+            std::greater<node>(), std::pmr::vector<node>(&search_arena) };
+        std::pmr::vector<point_2d> neighbours(&search_arena);
+        neighbours.reserve(directions_.size());
+
+        const auto start_cell = battle_field_->index_of(start);
+        table.set(start_cell, 0, start_cell);
+        open_set.emplace(start, 0, nearest_heuristic(start));
+
+        size_t expanded = 0;
+        while (!open_set.empty()) {
+            node current_node = open_set.top();
+            open_set.pop();
+
+            // Skip entries which have already been expanded through a cheaper path
+            const auto current_cell = battle_field_->index_of(current_node.position);
+            if (!table.close(current_cell)) continue;
+
+            // First target to be expanded is the nearest one
+            const auto target = target_indices.find(current_node.position);
+            if (target != target_indices.end()) {
+                reached_target = target->second;
+                const auto length = static_cast<size_t>(table.get_g_score(current_cell));
+                prepare_path(path, start, length);
+                reconstruct_path(table, start, current_node.position, length, path);
+                break;
+            }
+            expanded++;
+
+            const float current_g = table.get_g_score(current_cell);
+            if (get_neighbors(current_node.position, occupied_positions, target_indices, bounds, neighbours) && bounds != nullptr) {
+                // A unit took the place of an allowed move, the pruned moves may hold the optimal path around it
+                expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+                return false;
+            }
+            for (const auto& neighbor : neighbours) {
+                const auto neighbor_cell = battle_field_->index_of(neighbor);
+                if (table.is_closed(neighbor_cell)) continue;
+
+                const float tentative_g_score = current_g + 1;
+                if (tentative_g_score < table.get_g_score(neighbor_cell)) {
+                    table.set(neighbor_cell, tentative_g_score, current_cell);
+                    open_set.emplace(neighbor, tentative_g_score, nearest_heuristic(neighbor));
+                }
+            }
+        }
+
+        expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// <summary>
+    /// To find the shortest path from start to goal with a bidirectional search
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <returns></returns>
+    std::vector<point_2d> pathfinder::find_path_bidirectional(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions) const
+    {
+        std::vector<point_2d> path;
+        search_bidirectional(start, goal, occupied_positions, nullptr, path);
+        return path;
+    }
+
+    /// <summary>
+    /// To find the shortest path from start to goal with a bidirectional search, the path is allocated from the given path resource
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="path_resource"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    std::pmr::vector<point_2d> pathfinder::find_path_bidirectional(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* path_resource,
+        std::pmr::memory_resource* scratch_resource) const
+    {
+        std::pmr::vector<point_2d> path(path_resource);
+        search_bidirectional(start, goal, occupied_positions, scratch_resource, path);
+        return path;
+    }
+
+    /// <summary>
+    /// Bidirectional A*, a forward search from start towards goal and a backward search from goal towards start
+    /// 1. Each side uses the manhattan distance to the opposite end as heuristic (front to end)
+    /// 2. The side with the smaller open set is expanded next
+    /// 3. Whenever a side reaches a node labelled by the other side, the best meeting cost (mu) is updated
+    /// 4. Search stops as soon as the lowest f of either side is not below mu, no cheaper path can exist then
+    /// 5. The path is stitched from the forward predecessors up to the meeting node and the backward successors after it
+    /// Moves are symmetric, so the backward search reuses get_neighbors with start as the occupancy exception
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <param name="path"></param>
+    template <typename Path>
+    void pathfinder::search_bidirectional(point_2d start, point_2d goal,
+        const std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* scratch_resource, Path& path) const
+    {
+        path.clear();
+
+        // Same answers as find_path for trivial queries, both roots need a cell in the search tables
+        if (start == goal || !battle_field_->contains(start) || !battle_field_->is_walkable(goal))
+            return;
+
+        // Per search arena, starts on the stack and grows from the scratch resource
+        std::array<std::byte, search_buffer_size> buffer;
+        std::pmr::monotonic_buffer_resource search_arena(buffer.data(), buffer.size(),
+            scratch_resource != nullptr ? scratch_resource : &search_counter_);
+
+        // State of one search direction, each side has a search table of its own
+        struct frontier {
+            point_2d root, target;
+            landmark_heuristic::goal_bound landmark_bound;
+            const battle_field* field;
+            search_table* table;
+            std::priority_queue<node, std::pmr::vector<node>, std::greater<node>> open_set;
+
+            frontier(const point_2d from, const point_2d to, const landmark_heuristic* landmarks, const battle_field* battle_field,
+                search_table& search_table, std::pmr::memory_resource* resource) :
+                root(from), target(to),
+                landmark_bound(landmarks != nullptr ? landmarks->bind(to) : landmark_heuristic::goal_bound()), field(battle_field),
+                table(&search_table), open_set{ std::greater<node>(), std::pmr::vector<node>(resource) } {
+            }
+
+            // Manhattan distance to the opposite end, tightened by the landmarks when available
+            float estimate(const point_2d& position) const {
+                return std::max(heuristic(position, target), landmark_bound(position));
+            }
+
+            // Drop entries which have been superseded by a cheaper one or are already closed
+            void skip_stale() {
+                while (!open_set.empty() && table->is_closed(field->index_of(open_set.top().position)))
+                    open_set.pop();
+            }
+        };
+
+        search_table forward_table(*battle_field_, &search_arena);
+        search_table backward_table(*battle_field_, &search_arena);
+        frontier forward(start, goal, landmarks_, battle_field_, forward_table, &search_arena);
+        frontier backward(goal, start, landmarks_, battle_field_, backward_table, &search_arena);
+        for (auto* side : { &forward, &backward }) {
+            const auto root_cell = battle_field_->index_of(side->root);
+            side->table->set(root_cell, 0, root_cell);
+            side->open_set.emplace(side->root, 0, side->estimate(side->root));
+        }
+
+        // Neighbours of the current node, reused for every expansion
+        std::pmr::vector<point_2d> neighbours(&search_arena);
+        neighbours.reserve(directions_.size());
+
+        // Best known path cost through a meeting node
+        auto best_cost = std::numeric_limits<float>::infinity();
+        auto meeting = start;
+        auto met = false;
+
+        size_t expanded = 0;
+        while (true) {
+            forward.skip_stale();
+            backward.skip_stale();
+            if (forward.open_set.empty() || backward.open_set.empty())
+                break;
+
+            // Neither side can improve on the best meeting any more
+            if (forward.open_set.top().f_cost() >= best_cost || backward.open_set.top().f_cost() >= best_cost)
+                break;
+
+            // Expand the side with the smaller frontier
+            const auto forward_turn = forward.open_set.size() <= backward.open_set.size();
+            auto& side = forward_turn ? forward : backward;
+            auto& other = forward_turn ? backward : forward;
+
+            const node current_node = side.open_set.top();
+            side.open_set.pop();
+            const auto current_cell = battle_field_->index_of(current_node.position);
+            side.table->close(current_cell);
+            expanded++;
+
+            const float current_g = side.table->get_g_score(current_cell);
+            get_neighbors(current_node.position, occupied_positions, side.target, nullptr, neighbours);
+            for (const auto& neighbor : neighbours) {
+
+                // Continue if the neighbour is already closed by this side
+                const auto neighbor_cell = battle_field_->index_of(neighbor);
+                if (side.table->is_closed(neighbor_cell)) continue;
+
+                const float tentative_g_score = current_g + 1;
+                if (side.table->get_g_score(neighbor_cell) <= tentative_g_score) continue;
+
+                side.table->set(neighbor_cell, tentative_g_score, current_cell);
+                side.open_set.emplace(neighbor, tentative_g_score, side.estimate(neighbor));
+
+                // Frontiers touch, check whether this is a cheaper connection
+                const auto other_g = other.table->get_g_score(neighbor_cell);
+                if (tentative_g_score + other_g < best_cost) {
+                    best_cost = tentative_g_score + other_g;
+                    meeting = neighbor;
+                    met = true;
+                }
+            }
+        }
+
+        expanded_node_count_.fetch_add(expanded, std::memory_order_relaxed);
+        if (!met)
+            return;
+
+        // Forward half: start (excluded) up to the meeting node
+        const auto meeting_cell = battle_field_->index_of(meeting);
+        auto index = static_cast<size_t>(forward.table->get_g_score(meeting_cell));
+        prepare_path(path, start, static_cast<size_t>(best_cost));
+        reconstruct_path(*forward.table, start, meeting, index, path);
+
+        // Backward half: successors of the meeting node down to the goal
+        for (auto position = meeting; position != goal;) {
+            const auto next = battle_field_->position_of(backward.table->get_parent(battle_field_->index_of(position)));
+            write_step(path, index++, position, next);
+            position = next;
+        }
     }
 
     /// <summary>
@@ -105,49 +938,175 @@ namespace path_finding {
 
     /// <summary>
     /// Get all the valid neighbours from the current position.
-    /// Neighbour must be walkable and not occupied or target
+    /// Neighbour must be walkable and not occupied or target, and its move must lead to the goal when there are bounds
     /// </summary>
     /// <param name="current"></param>
     /// <param name="occupied_positions"></param>
     /// <param name="goal"></param>
+    /// <param name="bounds"></param>
+    /// <param name="neighbors"></param>
     /// <returns></returns>
-    std::vector<point_2d> pathfinder::get_neighbors(const point_2d& current,
+    bool pathfinder::get_neighbors(const point_2d& current,
         const std::unordered_set<point_2d>& occupied_positions,
-        const point_2d& goal) const {
+        const point_2d& goal, const goal_bounds* bounds, std::pmr::vector<point_2d>& neighbors) const {
 
-        std::vector<point_2d> neighbors;
-        for (const auto& dir : directions_) {
-            point_2d neighbor = current + dir;
+        neighbors.clear();
+        bool skipped_occupied = false;
+        for (size_t move = 0; move < directions_.size(); ++move) {
+            if (bounds != nullptr && !bounds->may_lead_to(current, move, goal))
+                continue;
+            point_2d neighbor = current + directions_[move];
+            if (!battle_field_->is_walkable(neighbor))
+                continue;
             const auto isOccupied = occupied_positions.find(neighbor) != occupied_positions.end();
-            if (battle_field_->is_walkable(neighbor) &&
-                (!isOccupied || neighbor == goal)) {
+            if (!isOccupied || neighbor == goal)
                 neighbors.push_back(neighbor);
-            }
+            else
+                skipped_occupied = true;
         }
-        return neighbors;
+        return skipped_occupied;
     }
 
     /// <summary>
-    /// Reconstruct the path by walking back through came_from map if the goal is reached
+    /// Get all the valid neighbours from the current position when any of the targets may be entered even if occupied,
+    /// with bounds only the moves whose box holds one of the targets
     /// </summary>
-    /// <param name="came_from"></param>
     /// <param name="current"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="targets"></param>
+    /// <param name="bounds"></param>
+    /// <param name="neighbors"></param>
     /// <returns></returns>
-    std::vector<point_2d> pathfinder::reconstruct_path(std::unordered_map<point_2d, point_2d>& came_from,
-        point_2d current)
+    bool pathfinder::get_neighbors(const point_2d& current,
+        const std::unordered_set<point_2d>& occupied_positions,
+        const std::pmr::unordered_map<point_2d, size_t>& targets, const goal_bounds* bounds,
+        std::pmr::vector<point_2d>& neighbors) const {
+
+        neighbors.clear();
+        bool skipped_occupied = false;
+        for (size_t move = 0; move < directions_.size(); ++move) {
+            if (bounds != nullptr && std::none_of(targets.begin(), targets.end(), [&](const auto& target) {
+                    return bounds->may_lead_to(current, move, target.first);
+                }))
+                continue;
+            point_2d neighbor = current + directions_[move];
+            if (!battle_field_->is_walkable(neighbor))
+                continue;
+            const auto isOccupied = occupied_positions.find(neighbor) != occupied_positions.end();
+            if (!isOccupied || targets.find(neighbor) != targets.end())
+                neighbors.push_back(neighbor);
+            else
+                skipped_occupied = true;
+        }
+        return skipped_occupied;
+    }
+
+    /// <summary>
+    /// Reconstruct the path by walking back through the predecessors in the search table
+    /// </summary>
+    /// <param name="table"></param>
+    /// <param name="start"></param>
+    /// <param name="current"></param>
+    /// <param name="end_index"></param>
+    /// <param name="path"></param>
+    template <typename Path>
+    void pathfinder::reconstruct_path(const search_table& table, const point_2d start, point_2d current, size_t end_index,
+        Path& path) const
     {
-        std::vector<point_2d> path;
+        while (current != start && end_index > 0) {
+            const auto previous = battle_field_->position_of(table.get_parent(battle_field_->index_of(current)));
+            write_step(path, --end_index, previous, current);
+            current = previous;
+        }
+    }
 
-        // Back track from the goal to the start and add the nodes into path vector
-        while (came_from.find(current) != came_from.end()) {
-            path.push_back(current);
-            current = came_from[current];
+    /// <summary>
+    /// Pages of up to 2^max_page_bits cells, smaller ones for maps with fewer cells
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="resource"></param>
+    pathfinder::search_table::search_table(const battle_field& battle_field, std::pmr::memory_resource* resource) :
+        allocator_(resource), pages_(resource)
+    {
+        const auto cell_count = battle_field.get_cell_count();
+        while (page_bits_ < max_page_bits && (size_t(1) << page_bits_) < cell_count)
+            page_bits_++;
+        page_mask_ = (size_t(1) << page_bits_) - 1;
+        pages_.assign((cell_count + page_mask_) >> page_bits_, nullptr);
+    }
+
+    /// <summary>
+    /// Unreached records have an infinite cost and are open
+    /// </summary>
+    /// <returns></returns>
+    pathfinder::search_table::record* pathfinder::search_table::allocate_page()
+    {
+        const auto page_size = page_mask_ + 1;
+        auto* page = allocator_.allocate(page_size);
+        std::uninitialized_fill_n(page, page_size, record{ std::numeric_limits<float>::infinity(), 0, false });
+        return page;
+    }
+
+    /// <summary>
+    /// Successors in the reduced graph. Stepping along a side keeps every perimeter cell reachable, so a path may leave the
+    /// rectangle anywhere, and an optimal path entering an empty rectangle can always be turned into one that runs along
+    /// the side and then straight across. The goal is reached by the jumps of the perimeter cells in its row and column.
+    /// The argument holds for each empty rectangle on its own, so crowded ones can be searched as the plain grid
+    /// </summary>
+    /// <param name="current"></param>
+    /// <param name="goal"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="rectangles"></param>
+    /// <param name="crowded"></param>
+    /// <param name="neighbors"></param>
+    void pathfinder::get_reduced_neighbors(const point_2d& current, const point_2d& goal,
+        const std::unordered_set<point_2d>& occupied_positions, const rectangle_decomposition& rectangles,
+        const std::pmr::unordered_set<std::uint32_t>& crowded, std::pmr::vector<point_2d>& neighbors) const {
+
+        // Single steps into cells which are walkable and free unless they are the goal
+        const auto step = [&](const point_2d neighbor) {
+            if (rectangles.get_rectangle_index(neighbor) != rectangle_decomposition::no_rectangle &&
+                (neighbor == goal || occupied_positions.find(neighbor) == occupied_positions.end()))
+                neighbors.push_back(neighbor);
+        };
+
+        neighbors.clear();
+        const auto index = rectangles.get_rectangle_index(current);
+        if (crowded.count(index) != 0) {
+            for (const auto& direction : directions_)
+                step(current + direction);
+            return;
         }
 
-        // Reverse the vector to correct the path from start to goal/target
-        std::reverse(path.begin(), path.end());
+        const auto& rectangle = rectangles.get_rectangle(index);
+        const auto x = current.get_x();
+        const auto y = current.get_y();
+        for (const auto& direction : directions_) {
+            const auto dx = direction.get_x();
+            const auto dy = direction.get_y();
 
-        // Return the correct path
-        return path;
+            // Cells between the current one and the side the move heads for
+            const auto to_side = dx > 0 ? rectangle.max_x - x : dx < 0 ? x - rectangle.min_x
+                : dy > 0 ? rectangle.max_y - y : y - rectangle.min_y;
+            const auto along_side = dx != 0 ? y == rectangle.min_y || y == rectangle.max_y
+                : x == rectangle.min_x || x == rectangle.max_x;
+
+            if (to_side == 0) {
+                // Out into the next rectangle
+                step(current + direction);
+            }
+            else if (along_side) {
+                neighbors.push_back(current + direction);
+            }
+            else {
+                // Across the interior, the goal is the only interior cell a jump stops at
+                const auto goal_ahead = dx != 0 ? (goal.get_x() - x) * dx : (goal.get_y() - y) * dy;
+                const auto goal_in_line = dx != 0 ? goal.get_y() == y : goal.get_x() == x;
+                if (goal_in_line && goal_ahead > 0 && goal_ahead <= to_side && rectangles.get_rectangle_index(goal) == index)
+                    neighbors.push_back(goal);
+                else
+                    neighbors.emplace_back(x + dx * to_side, y + dy * to_side);
+            }
+        }
     }
 }
@@ -0,0 +1,248 @@
+#include "../headers/pathService.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <ostream>
+#include <nlohmann/json.hpp>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Responses of one run, guarded by its own mutex so sessions do not wait on each other
+    /// </summary>
+    struct path_service::session {
+        std::mutex mutex;
+        std::condition_variable output_ready, space_ready;
+        std::map<size_t, std::string> finished;
+        size_t in_flight = 0, next_to_write = 0;
+        bool input_done = false;
+        path_service_stats stats;
+    };
+
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    /// <param name="path_finder"></param>
+    /// <param name="number_of_threads"></param>
+    /// <param name="max_in_flight"></param>
+    /// <param name="ordered"></param>
+    path_service::path_service(const pathfinder& path_finder, const unsigned number_of_threads, const size_t max_in_flight,
+        const bool ordered) :
+        path_finder_(&path_finder),
+        number_of_threads_(number_of_threads != 0 ? number_of_threads : std::max(1u, std::thread::hardware_concurrency())),
+        max_in_flight_(std::max<size_t>(1, max_in_flight)), ordered_(ordered)
+    {
+        workers_.reserve(number_of_threads_);
+        for (unsigned i = 0; i < number_of_threads_; ++i)
+            workers_.emplace_back([this] { work(); });
+    }
+
+    /// <summary>
+    /// Let the workers drain the queue, then join them
+    /// </summary>
+    path_service::~path_service()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    /// <summary>
+    /// Read a point written as [x, y]
+    /// </summary>
+    /// <param name="value"></param>
+    /// <returns></returns>
+    static point_2d to_point(const nlohmann::json& value)
+    {
+        if (!value.is_array() || value.size() != 2)
+            throw std::runtime_error("points are written as [x, y]");
+        return point_2d(value[0].get<int>(), value[1].get<int>());
+    }
+
+    /// <summary>
+    /// Parse the query and search, the response is a JSON object so fields can still be added
+    /// </summary>
+    /// <param name="path_finder"></param>
+    /// <param name="query"></param>
+    /// <param name="failed"></param>
+    /// <returns></returns>
+    static nlohmann::json respond(const pathfinder& path_finder, const std::string& query, bool& failed)
+    {
+        nlohmann::json response = nlohmann::json::object();
+        failed = false;
+        try {
+            const auto request = nlohmann::json::parse(query);
+            if (request.contains("id"))
+                response["id"] = request["id"];
+
+            const auto start = to_point(request.at("start"));
+            const auto goal = to_point(request.at("goal"));
+
+            // Clients are not trusted, the searches index the grid with both ends
+            const auto& battle_field = path_finder.get_battle_field();
+            if (!battle_field.contains(start) || !battle_field.contains(goal))
+                throw std::runtime_error("start and goal must lie inside the " + std::to_string(battle_field.get_width()) +
+                    "x" + std::to_string(battle_field.get_height()) + " grid");
+            std::unordered_set<point_2d> occupied;
+            if (request.contains("occupied"))
+                for (const auto& position : request["occupied"])
+                    occupied.insert(to_point(position));
+
+            const auto engine = request.value("engine", std::string("a_star"));
+            std::vector<point_2d> path;
+            if (engine == "a_star")
+                path = path_finder.find_path(start, goal, occupied);
+            else if (engine == "bidirectional")
+                path = path_finder.find_path_bidirectional(start, goal, occupied);
+            else if (engine == "database")
+                path = path_finder.find_path_from_database(start, goal, occupied);
+            else
+                throw std::runtime_error("unknown engine: " + engine);
+
+            auto points = nlohmann::json::array();
+            for (const auto& p : path)
+                points.push_back({ p.get_x(), p.get_y() });
+            response["length"] = path.size();
+            response["path"] = std::move(points);
+        }
+        catch (const std::exception& e) {
+            failed = true;
+            response["error"] = e.what();
+        }
+        return response;
+    }
+
+    /// <summary>
+    /// Format the response
+    /// </summary>
+    /// <param name="query"></param>
+    /// <param name="failed"></param>
+    /// <returns></returns>
+    std::string path_service::answer(const std::string& query, bool& failed) const
+    {
+        return respond(*path_finder_, query, failed).dump();
+    }
+
+    /// <summary>
+    /// Answer, add the latency, then hand the response to its session
+    /// </summary>
+    void path_service::work() const
+    {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            work_ready_.wait(lock, [&] { return !work_.empty() || stopping_; });
+            if (work_.empty())
+                return;
+            auto next = std::move(work_.front());
+            work_.pop_front();
+            lock.unlock();
+
+            bool failed = false;
+            auto response = respond(*path_finder_, next.line, failed);
+            const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - next.received);
+            response["latency_us"] = latency.count();
+            auto text = response.dump();
+
+            {
+                // Notified under the lock: once the last response is written the session may end and be destroyed
+                auto& state = *next.owner;
+                std::lock_guard session_lock(state.mutex);
+                state.stats.requests++;
+                state.stats.errors += failed ? 1 : 0;
+                state.stats.total_latency += latency;
+                state.stats.max_latency = std::max(state.stats.max_latency, latency);
+                state.finished.emplace(next.sequence, std::move(text));
+                state.output_ready.notify_one();
+            }
+            lock.lock();
+        }
+    }
+
+    /// <summary>
+    /// The only thread writing to the output of the session, the lock is not held while writing
+    /// </summary>
+    /// <param name="state"></param>
+    /// <param name="output"></param>
+    void path_service::write(session& state, std::ostream& output) const
+    {
+        const auto ready = [&] {
+            return !state.finished.empty() && (!ordered_ || state.finished.begin()->first == state.next_to_write);
+        };
+
+        std::vector<std::string> batch;
+        std::unique_lock lock(state.mutex);
+        while (true) {
+            state.output_ready.wait(lock, [&] { return ready() || (state.input_done && state.in_flight == 0); });
+            if (!ready())
+                return;
+
+            // In order mode the run of consecutive responses, otherwise every finished one
+            batch.clear();
+            for (auto it = state.finished.begin(); it != state.finished.end() && (!ordered_ || it->first == state.next_to_write);
+                it = state.finished.erase(it)) {
+                batch.push_back(std::move(it->second));
+                state.next_to_write++;
+            }
+            lock.unlock();
+
+            for (const auto& response : batch)
+                output << response << '\n';
+            output.flush();
+
+            lock.lock();
+            state.in_flight -= batch.size();
+            state.space_ready.notify_one();
+        }
+    }
+
+    /// <summary>
+    /// Reader on the calling thread, the shared workers answer and a writer thread of the session writes
+    /// </summary>
+    /// <param name="input"></param>
+    /// <param name="output"></param>
+    /// <returns></returns>
+    path_service_stats path_service::run(std::istream& input, std::ostream& output) const
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        session state;
+        std::thread writer([&] { write(state, output); });
+
+        // Read ahead up to the in flight limit
+        std::string line;
+        size_t sequence = 0;
+        while (std::getline(input, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+
+            {
+                std::unique_lock lock(state.mutex);
+                state.space_ready.wait(lock, [&] { return state.in_flight < max_in_flight_; });
+                state.in_flight++;
+            }
+            {
+                std::lock_guard lock(mutex_);
+                work_.push_back({ &state, sequence++, std::move(line), std::chrono::steady_clock::now() });
+            }
+            work_ready_.notify_one();
+        }
+
+        {
+            std::lock_guard lock(state.mutex);
+            state.input_done = true;
+            state.output_ready.notify_one();
+        }
+        writer.join();
+
+        state.stats.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+        return state.stats;
+    }
+}
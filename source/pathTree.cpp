@@ -0,0 +1,82 @@
+#include "../headers/pathTree.hpp"
+
+namespace path_finding
+{
+    /// <summary>
+    /// Root node of the goal, it holds a reference to itself so it is never freed
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="goal"></param>
+    /// <param name="resource"></param>
+    path_tree::path_tree(const battle_field& battle_field, const point_2d goal, std::pmr::memory_resource* resource) :
+        battle_field_(&battle_field), version_(battle_field.get_version()), nodes_(resource), free_nodes_(resource),
+        index_(resource)
+    {
+        nodes_.push_back(node{ goal, no_node, 0, 1 });
+        index_.emplace(goal, root);
+    }
+
+    /// <summary>
+    /// Look up the shared node
+    /// </summary>
+    /// <param name="position"></param>
+    /// <returns></returns>
+    path_tree::node_id path_tree::find(const point_2d position) const
+    {
+        const auto found = index_.find(position);
+        return found != index_.end() ? found->second : no_node;
+    }
+
+    /// <summary>
+    /// Drop the index but the root, the nodes stay for the paths which hold them
+    /// </summary>
+    void path_tree::synchronize()
+    {
+        if (version_ == battle_field_->get_version())
+            return;
+        index_.clear();
+        index_.emplace(get_goal(), root);
+        version_ = battle_field_->get_version();
+    }
+
+    /// <summary>
+    /// Take a free node or a new one, the parent gains a child
+    /// </summary>
+    /// <param name="position"></param>
+    /// <param name="parent"></param>
+    /// <param name="shared"></param>
+    /// <returns></returns>
+    path_tree::node_id path_tree::add(const point_2d position, const node_id parent, const bool shared)
+    {
+        const node added{ position, parent, nodes_[parent].distance + 1, 0 };
+        node_id id;
+        if (!free_nodes_.empty()) {
+            id = free_nodes_.back();
+            free_nodes_.pop_back();
+            nodes_[id] = added;
+        }
+        else {
+            id = static_cast<node_id>(nodes_.size());
+            nodes_.push_back(added);
+        }
+        nodes_[parent].references++;
+        if (shared)
+            index_.emplace(position, id);
+        return id;
+    }
+
+    /// <summary>
+    /// Walk towards the root while the released node was the last reference of its parent
+    /// </summary>
+    /// <param name="id"></param>
+    void path_tree::release(node_id id)
+    {
+        while (id != no_node && --nodes_[id].references == 0) {
+            const auto found = index_.find(nodes_[id].position);
+            if (found != index_.end() && found->second == id)
+                index_.erase(found);
+            free_nodes_.push_back(id);
+            id = nodes_[id].parent;
+        }
+    }
+}
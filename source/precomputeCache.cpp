@@ -0,0 +1,174 @@
+#include "../headers/precomputeCache.hpp"
+#include "../headers/mappedFile.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Checksum file written next to every entry
+    /// </summary>
+    struct cache_entry_sum {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t content_hash;
+        std::uint64_t size;
+        std::uint64_t checksum;
+    };
+
+    /// <summary>
+    /// File identification, the version changes when the layout of the cache changes
+    /// </summary>
+    static constexpr char cache_magic[8] = { 'P', 'F', 'C', 'A', 'C', 'H', 'E', 0 };
+    static constexpr std::uint32_t cache_version = 1;
+
+    /// <summary>
+    /// Extension of the checksum files
+    /// </summary>
+    static constexpr const char* sum_extension = ".sum";
+
+    /// <summary>
+    /// Create the directory, if there is one
+    /// </summary>
+    /// <param name="directory"></param>
+    precompute_cache::precompute_cache(std::string directory)
+        : directory_(std::move(directory))
+    {
+        if (!directory_.empty())
+            std::filesystem::create_directories(directory_);
+    }
+
+    /// <summary>
+    /// Name the entry after the content hash
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="extension"></param>
+    /// <returns></returns>
+    std::string precompute_cache::get_filename(const battle_field& battle_field, const std::string& extension) const
+    {
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << battle_field.get_content_hash() << extension;
+        return (std::filesystem::path(directory_) / name.str()).string();
+    }
+
+    /// <summary>
+    /// Multiply and rotate over 64 bit words, the tail is packed into a last word
+    /// </summary>
+    /// <param name="data"></param>
+    /// <param name="size"></param>
+    /// <returns></returns>
+    std::uint64_t precompute_cache::checksum(const unsigned char* data, const size_t size)
+    {
+        constexpr std::uint64_t prime = 0x9E3779B97F4A7C15ull;
+        std::uint64_t hash = 0xCBF29CE484222325ull ^ size;
+        const auto mix = [&](const std::uint64_t word) {
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 29;
+        };
+
+        size_t offset = 0;
+        for (; offset + sizeof(std::uint64_t) <= size; offset += sizeof(std::uint64_t)) {
+            std::uint64_t word;
+            std::memcpy(&word, data + offset, sizeof(word));
+            mix(word);
+        }
+        if (offset < size) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, data + offset, size - offset);
+            mix(word);
+        }
+        return hash;
+    }
+
+    /// <summary>
+    /// Read the checksum file, then map the entry and compare. Always a miss without a directory
+    /// </summary>
+    /// <param name="filename"></param>
+    /// <param name="content_hash"></param>
+    /// <returns></returns>
+    cache_lookup precompute_cache::find(const std::string& filename, const std::uint64_t content_hash) const
+    {
+        std::error_code error;
+        if (directory_.empty() || !std::filesystem::exists(filename, error))
+            return cache_lookup::miss;
+
+        std::ifstream file(filename + sum_extension, std::ios::binary);
+        cache_entry_sum sum{};
+        if (!file.is_open() || !file.read(reinterpret_cast<char*>(&sum), sizeof(sum)))
+            return cache_lookup::corrupt;
+        if (std::memcmp(sum.magic, cache_magic, sizeof(cache_magic)) != 0 || sum.version != cache_version ||
+            sum.content_hash != content_hash || std::filesystem::file_size(filename, error) != sum.size || error)
+            return cache_lookup::corrupt;
+
+        try {
+            const mapped_file entry(filename);
+            return checksum(entry.data(), entry.size()) == sum.checksum ? cache_lookup::hit : cache_lookup::corrupt;
+        }
+        catch (const std::exception&) {
+            return cache_lookup::corrupt;
+        }
+    }
+
+    /// <summary>
+    /// Remove the checksum file, the entry stays invalid until commit wrote a new one
+    /// </summary>
+    /// <param name="filename"></param>
+    void precompute_cache::invalidate(const std::string& filename) const
+    {
+        std::error_code error;
+        std::filesystem::remove(filename + sum_extension, error);
+    }
+
+    /// <summary>
+    /// Rename the entry into place, then write the checksum file the same way
+    /// </summary>
+    /// <param name="temporary_filename"></param>
+    /// <param name="filename"></param>
+    /// <param name="content_hash"></param>
+    void precompute_cache::commit(const std::string& temporary_filename, const std::string& filename,
+        const std::uint64_t content_hash) const
+    {
+        std::filesystem::rename(temporary_filename, filename);
+
+        cache_entry_sum sum{};
+        std::memcpy(sum.magic, cache_magic, sizeof(cache_magic));
+        sum.version = cache_version;
+        sum.content_hash = content_hash;
+        {
+            const mapped_file entry(filename);
+            sum.size = entry.size();
+            sum.checksum = checksum(entry.data(), entry.size());
+        }
+
+        const auto sum_filename = filename + sum_extension;
+        const auto temporary_sum_filename = get_temporary_filename(sum_filename);
+        {
+            std::ofstream file(temporary_sum_filename, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                throw std::runtime_error("Failed to open file: " + temporary_sum_filename);
+            file.write(reinterpret_cast<const char*>(&sum), sizeof(sum));
+            if (!file)
+                throw std::runtime_error("Failed to write file: " + temporary_sum_filename);
+        }
+        std::filesystem::rename(temporary_sum_filename, sum_filename);
+    }
+
+    /// <summary>
+    /// Tag the name with the writing thread, so concurrent stores of the same entry do not write into one file
+    /// </summary>
+    /// <param name="filename"></param>
+    /// <returns></returns>
+    std::string precompute_cache::get_temporary_filename(const std::string& filename)
+    {
+        return filename + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    }
+}
@@ -0,0 +1,90 @@
+#include "../headers/rectangleDecomposition.hpp"
+
+#include <algorithm>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Largest squares first, in passes: a pass computes the largest free square ending at every cell and places the ones
+    /// of at least half the largest size in row major order, skipping those an earlier placement of the pass overlaps.
+    /// A placed square grows into a rectangle by whole free rows and columns, so corridors give long thin rectangles.
+    /// Taking the anchors in row major order instead leaves strips between the rectangles, most cells end on a perimeter
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <returns></returns>
+    rectangle_decomposition rectangle_decomposition::build(const battle_field& battle_field)
+    {
+        rectangle_decomposition decomposition;
+        const auto width = battle_field.get_width();
+        const auto height = battle_field.get_height();
+        decomposition.width_ = width;
+        decomposition.height_ = height;
+        decomposition.layout_ = battle_field.get_layout();
+        decomposition.cell_rectangles_.assign(battle_field.get_cell_count(), no_rectangle);
+        auto& cells = decomposition.cell_rectangles_;
+
+        const auto is_free = [&](const int x, const int y) {
+            const point_2d position(x, y);
+            return cells[battle_field.index_of(position)] == no_rectangle && battle_field.is_walkable(position);
+        };
+        const auto is_area_free = [&](const int min_x, const int min_y, const int max_x, const int max_y) {
+            if (min_x < 0 || min_y < 0 || max_x >= width || max_y >= height)
+                return false;
+            for (auto y = min_y; y <= max_y; ++y)
+                for (auto x = min_x; x <= max_x; ++x)
+                    if (!is_free(x, y))
+                        return false;
+            return true;
+        };
+
+        // Side of the largest free square whose bottom right corner is the cell
+        std::vector<int> squares(cells.size());
+        while (true) {
+            auto largest = 0;
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    const auto index = static_cast<size_t>(y) * width + x;
+                    squares[index] = !is_free(x, y) ? 0 : x == 0 || y == 0 ? 1
+                        : 1 + std::min({ squares[index - 1], squares[index - width], squares[index - width - 1] });
+                    largest = std::max(largest, squares[index]);
+                }
+            }
+            if (largest == 0)
+                break;
+
+            const auto threshold = std::max(largest / 2, 1);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    const auto side = squares[static_cast<size_t>(y) * width + x];
+                    if (side < threshold)
+                        continue;
+                    auto min_x = x - side + 1, min_y = y - side + 1, max_x = x, max_y = y;
+                    if (!is_area_free(min_x, min_y, max_x, max_y))
+                        continue;
+
+                    // Grow by whole rows and columns while any side can move
+                    for (auto grown = true; grown;) {
+                        grown = false;
+                        if (is_area_free(max_x + 1, min_y, max_x + 1, max_y)) { max_x++; grown = true; }
+                        if (is_area_free(min_x, max_y + 1, max_x, max_y + 1)) { max_y++; grown = true; }
+                        if (is_area_free(min_x - 1, min_y, min_x - 1, max_y)) { min_x--; grown = true; }
+                        if (is_area_free(min_x, min_y - 1, max_x, min_y - 1)) { min_y--; grown = true; }
+                    }
+
+                    const auto index = static_cast<std::uint32_t>(decomposition.rectangles_.size());
+                    decomposition.rectangles_.push_back(rectangle{ static_cast<std::int16_t>(min_x), static_cast<std::int16_t>(min_y),
+                        static_cast<std::int16_t>(max_x), static_cast<std::int16_t>(max_y) });
+                    for (auto row = min_y; row <= max_y; ++row)
+                        for (auto column = min_x; column <= max_x; ++column)
+                            cells[battle_field.index_of(point_2d(column, row))] = index;
+
+                    // Rectangles two cells thin or less have no interior
+                    const auto columns = static_cast<size_t>(max_x - min_x + 1);
+                    const auto rows = static_cast<size_t>(max_y - min_y + 1);
+                    decomposition.perimeter_cell_count_ += columns <= 2 || rows <= 2 ? columns * rows : 2 * (columns + rows) - 4;
+                }
+            }
+        }
+        return decomposition;
+    }
+}
@@ -0,0 +1,107 @@
+#include "../headers/replanScheduler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Constructor to initialize the queue on the given resource
+    /// </summary>
+    /// <param name="path_finder"></param>
+    /// <param name="budget"></param>
+    /// <param name="aging_per_tick"></param>
+    /// <param name="resource"></param>
+    replan_scheduler::replan_scheduler(const pathfinder& path_finder, const std::chrono::microseconds budget,
+        const int aging_per_tick, std::pmr::memory_resource* resource) :
+        path_finder_(&path_finder), budget_(budget), aging_per_tick_(aging_per_tick), resource_(resource),
+        queue_{ std::greater<request>(), std::pmr::vector<request>(resource) }, pending_(resource), results_(resource)
+    {
+    }
+
+    /// <summary>
+    /// Every request ages at the same rate, so ordering by submit tick * aging + distance
+    /// is the same as ordering by distance - waited ticks * aging at any tick
+    /// </summary>
+    /// <param name="start"></param>
+    /// <param name="goal"></param>
+    /// <returns></returns>
+    std::uint64_t replan_scheduler::submit(const point_2d start, const point_2d goal)
+    {
+        const auto ticket = next_ticket_++;
+        const auto key = static_cast<std::int64_t>(tick_) * aging_per_tick_ + start.manhattan_distance(goal);
+        queue_.push({ key, ticket, start, goal, tick_, std::chrono::steady_clock::now() });
+        pending_.insert(ticket);
+        metrics_.queue_depth = pending_.size();
+        return ticket;
+    }
+
+    /// <summary>
+    /// Serve the best requests while there is time left, the first one always
+    /// </summary>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    void replan_scheduler::service(const std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource)
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        auto now = begin;
+        metrics_.served_last_tick = 0;
+
+        while (!queue_.empty() && (metrics_.served_last_tick == 0 || now - begin < budget_)) {
+            const auto next = queue_.top();
+            queue_.pop();
+            if (pending_.erase(next.ticket) == 0)
+                continue;
+
+            results_.insert_or_assign(next.ticket,
+                path_finder_->find_compact_path(next.start, next.goal, occupied_positions, resource_, scratch_resource));
+            now = std::chrono::steady_clock::now();
+
+            // Wait of the request, from submit until its path is ready
+            const auto wait_ticks = static_cast<size_t>(tick_ - next.submit_tick);
+            const auto wait_time = std::chrono::duration_cast<std::chrono::microseconds>(now - next.submit_time);
+            metrics_.served_last_tick++;
+            metrics_.served_total++;
+            total_wait_ticks_ += wait_ticks;
+            total_wait_time_ += wait_time;
+            metrics_.max_wait_ticks = std::max(metrics_.max_wait_ticks, wait_ticks);
+            metrics_.max_wait_time = std::max(metrics_.max_wait_time, wait_time);
+        }
+
+        if (metrics_.served_total > 0) {
+            metrics_.average_wait_ticks = static_cast<double>(total_wait_ticks_) / static_cast<double>(metrics_.served_total);
+            metrics_.average_wait_time = total_wait_time_ / static_cast<std::int64_t>(metrics_.served_total);
+        }
+        metrics_.queue_depth = pending_.size();
+        metrics_.last_service_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+        tick_++;
+    }
+
+    /// <summary>
+    /// Hand over a served path, its storage moves to the caller when both use the same resource
+    /// </summary>
+    /// <param name="ticket"></param>
+    /// <param name="path"></param>
+    /// <returns></returns>
+    bool replan_scheduler::take_result(const std::uint64_t ticket, compact_path& path)
+    {
+        const auto result = results_.find(ticket);
+        if (result == results_.end())
+            return false;
+
+        path = std::move(result->second);
+        results_.erase(result);
+        return true;
+    }
+
+    /// <summary>
+    /// Forget the ticket, a queued request is skipped when it reaches the top
+    /// </summary>
+    /// <param name="ticket"></param>
+    void replan_scheduler::cancel(const std::uint64_t ticket)
+    {
+        pending_.erase(ticket);
+        results_.erase(ticket);
+        metrics_.queue_depth = pending_.size();
+    }
+}
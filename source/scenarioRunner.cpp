@@ -0,0 +1,278 @@
+#include "../headers/scenarioRunner.hpp"
+#include "../headers/parallelFor.hpp"
+#include "../headers/pathFinder.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Simulations per second of wall time
+    /// </summary>
+    /// <returns></returns>
+    double scenario_report::get_throughput() const
+    {
+        const auto seconds = std::chrono::duration<double>(wall_time).count();
+        return seconds > 0 ? static_cast<double>(simulations) / seconds : 0.0;
+    }
+
+    /// <summary>
+    /// Totals, throughput and one entry per scenario
+    /// </summary>
+    /// <returns></returns>
+    std::string scenario_report::to_json() const
+    {
+        nlohmann::json report;
+        const auto seconds = std::chrono::duration<double>(wall_time).count();
+        report["simulations"] = simulations;
+        report["threads"] = threads;
+        report["wall_time_ms"] = std::chrono::duration<double, std::milli>(wall_time).count();
+        report["simulations_per_second"] = get_throughput();
+        report["unit_ticks_per_second"] = seconds > 0 ? static_cast<double>(unit_ticks) / seconds : 0.0;
+
+        report["scenarios"] = nlohmann::json::array();
+        for (const auto& summary : scenarios) {
+            const auto runs = static_cast<double>(std::max<size_t>(summary.runs, 1));
+            report["scenarios"].push_back({
+                { "name", summary.name },
+                { "runs", summary.runs },
+                { "completed_runs", summary.completed_runs },
+                { "units", summary.units },
+                { "arrived", summary.arrived },
+                { "arrival_rate", summary.units > 0 ? static_cast<double>(summary.arrived) / static_cast<double>(summary.units) : 0.0 },
+                { "average_ticks", static_cast<double>(summary.ticks) / runs },
+                { "max_ticks", summary.max_ticks },
+                { "searches", summary.conflicts.searches },
+                { "yields", summary.conflicts.yields },
+                { "swaps", summary.conflicts.swaps },
+                { "detours", summary.conflicts.detours },
+                { "cycles", summary.conflicts.cycles },
+                { "oscillations", summary.conflicts.oscillations },
+                { "cpu_time_ms", std::chrono::duration<double, std::milli>(summary.elapsed).count() }
+            });
+        }
+        return report.dump(2);
+    }
+
+    /// <summary>
+    /// Parse the manifest, load or generate the maps, then add the scenarios
+    /// </summary>
+    /// <param name="manifest_filename"></param>
+    /// <returns></returns>
+    scenario_runner scenario_runner::load(const std::string& manifest_filename)
+    {
+        std::ifstream file(manifest_filename);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + manifest_filename);
+
+        nlohmann::json manifest;
+        file >> manifest;
+        if (!manifest.contains("maps") || !manifest.contains("scenarios"))
+            throw std::runtime_error("Manifest needs maps and scenarios: " + manifest_filename);
+
+        scenario_runner runner;
+        const auto directory = std::filesystem::path(manifest_filename).parent_path();
+        for (const auto& [name, map] : manifest["maps"].items()) {
+            battle_field field;
+            if (map.contains("file"))
+                field.load_from_json((directory / map["file"].get<std::string>()).string());
+            else
+                field.generate_random_field(map.at("width").get<int>(), map.at("height").get<int>(), map.value("units", 0),
+                    map.value("terrains", 0), map.value("seed", std::uint64_t(1)));
+            runner.add_map(name, std::move(field));
+        }
+
+        for (const auto& entry : manifest["scenarios"]) {
+            scenario next;
+            next.map = entry.at("map").get<std::string>();
+            next.name = entry.value("name", next.map);
+            next.units = entry.value("units", size_t(0));
+            next.seed = entry.value("seed", std::uint64_t(1));
+            next.runs = entry.value("runs", size_t(1));
+            next.max_ticks = entry.value("max_ticks", size_t(1000));
+
+            const auto goal = entry.value("goal", std::string("nearest"));
+            if (goal == "assigned")
+                next.goal = scenario_goal::assigned;
+            else if (goal != "nearest")
+                throw std::runtime_error("Unknown goal in scenario " + next.name + ": " + goal);
+            runner.add_scenario(next);
+        }
+        return runner;
+    }
+
+    /// <summary>
+    /// Add a map
+    /// </summary>
+    /// <param name="name"></param>
+    /// <param name="field"></param>
+    void scenario_runner::add_map(const std::string& name, battle_field field)
+    {
+        maps_.insert_or_assign(name, std::move(field));
+    }
+
+    /// <summary>
+    /// Add a scenario on a known map
+    /// </summary>
+    /// <param name="scenario"></param>
+    void scenario_runner::add_scenario(const scenario& scenario)
+    {
+        if (maps_.find(scenario.map) == maps_.end())
+            throw std::invalid_argument("Unknown map in scenario " + scenario.name + ": " + scenario.map);
+        scenarios_.push_back(scenario);
+    }
+
+    /// <summary>
+    /// One job per simulation, handed out to the threads one at a time, aggregated in manifest order
+    /// </summary>
+    /// <param name="number_of_threads"></param>
+    /// <returns></returns>
+    scenario_report scenario_runner::run(unsigned number_of_threads) const
+    {
+        struct job {
+            size_t scenario;
+            std::uint64_t seed;
+        };
+        std::vector<job> jobs;
+        for (size_t index = 0; index < scenarios_.size(); ++index)
+            for (size_t run = 0; run < scenarios_[index].runs; ++run)
+                jobs.push_back({ index, scenarios_[index].seed + run });
+
+        if (number_of_threads == 0)
+            number_of_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        // Simulations only read the maps, everything they change is their own
+        std::vector<simulation_result> results(jobs.size());
+        const auto begin = std::chrono::steady_clock::now();
+        parallel_for(jobs.size(), [&](const size_t index) {
+            thread_local tick_arena arena;
+            const auto& next = scenarios_[jobs[index].scenario];
+            results[index] = simulate(maps_.at(next.map), next, jobs[index].seed, &arena);
+        }, number_of_threads);
+
+        scenario_report report;
+        report.wall_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+        report.threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(number_of_threads, jobs.size())));
+        report.simulations = jobs.size();
+        for (const auto& next : scenarios_) {
+            report.scenarios.emplace_back();
+            report.scenarios.back().name = next.name;
+        }
+
+        for (size_t index = 0; index < jobs.size(); ++index) {
+            const auto& result = results[index];
+            auto& summary = report.scenarios[jobs[index].scenario];
+            summary.runs++;
+            summary.units += result.units;
+            summary.arrived += result.arrived;
+            summary.ticks += result.ticks;
+            summary.max_ticks = std::max(summary.max_ticks, result.ticks);
+            summary.completed_runs += result.arrived == result.units ? 1 : 0;
+            summary.conflicts.searches += result.conflicts.searches;
+            summary.conflicts.yields += result.conflicts.yields;
+            summary.conflicts.swaps += result.conflicts.swaps;
+            summary.conflicts.detours += result.conflicts.detours;
+            summary.conflicts.cycles += result.conflicts.cycles;
+            summary.conflicts.oscillations += result.conflicts.oscillations;
+            summary.elapsed += result.elapsed;
+            report.unit_ticks += result.units * result.ticks;
+        }
+        return report;
+    }
+
+    /// <summary>
+    /// Draw distinct walkable cells
+    /// </summary>
+    /// <param name="field"></param>
+    /// <param name="count"></param>
+    /// <param name="used">Cells taken already, the drawn ones are added</param>
+    /// <param name="gen"></param>
+    /// <returns></returns>
+    static std::vector<point_2d> draw_cells(const battle_field& field, const size_t count, std::unordered_set<point_2d>& used,
+        std::mt19937_64& gen)
+    {
+        std::uniform_int_distribution<int> x(0, field.get_width() - 1), y(0, field.get_height() - 1);
+        std::vector<point_2d> cells;
+        cells.reserve(count);
+        for (size_t attempts = 0; cells.size() < count; ++attempts) {
+            if (attempts > count * 100 + 1000)
+                throw std::runtime_error("Not enough free walkable cells for the scenario's units");
+            const point_2d cell(x(gen), y(gen));
+            if (field.is_walkable(cell) && used.insert(cell).second)
+                cells.push_back(cell);
+        }
+        return cells;
+    }
+
+    /// <summary>
+    /// Place the units, then tick until every unit arrived, nobody moved for longer than any unit backs off, or max ticks
+    /// </summary>
+    /// <param name="field"></param>
+    /// <param name="scenario"></param>
+    /// <param name="seed"></param>
+    /// <param name="arena"></param>
+    /// <returns></returns>
+    simulation_result scenario_runner::simulate(const battle_field& field, const scenario& scenario, const std::uint64_t seed,
+        tick_arena* arena)
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        tick_arena local_arena;
+        if (arena == nullptr)
+            arena = &local_arena;
+
+        // Map positions, or random cells drawn from the seed
+        std::vector<point_2d> starts, targets;
+        if (scenario.units == 0) {
+            starts = field.get_start_positions();
+            targets = field.get_target_positions();
+        }
+        else {
+            std::mt19937_64 gen(seed);
+            std::unordered_set<point_2d> used;
+            starts = draw_cells(field, scenario.units, used, gen);
+            targets = draw_cells(field, scenario.units, used, gen);
+        }
+        if (targets.empty())
+            throw std::runtime_error("Scenario " + scenario.name + " has no targets");
+
+        const pathfinder path_finder(field);
+        unit_store units(path_finder);
+        std::unordered_set<point_2d> occupied;
+        units.reserve(starts.size());
+        for (const auto& start : starts) {
+            const auto id = units.add(start);
+            if (scenario.goal == scenario_goal::assigned)
+                units.set_target(id, targets[id % targets.size()]);
+            occupied.insert(start);
+        }
+
+        simulation_result result;
+        result.units = units.size();
+        unsigned ticks_without_movement = 0;
+        while (result.ticks < scenario.max_ticks) {
+            const auto moved = scenario.goal == scenario_goal::nearest
+                ? units.tick_to_nearest(targets, occupied, arena->resource())
+                : units.tick(occupied, arena->resource());
+            arena->reset();
+            result.ticks++;
+            ticks_without_movement = moved > 0 ? 0 : ticks_without_movement + 1;
+
+            result.arrived = 0;
+            for (unit_store::unit_id id = 0; id < units.size(); ++id)
+                result.arrived += units.get_status(id) == move_status::at_target ? 1 : 0;
+            if (result.arrived == result.units || ticks_without_movement > units.get_conflict_resolution().max_backoff_ticks)
+                break;
+        }
+
+        result.conflicts = units.get_conflict_metrics();
+        result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+        return result;
+    }
+}
@@ -0,0 +1,306 @@
+#include "../headers/simulationSnapshot.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace path_finding
+{
+    static_assert(std::is_trivially_copyable_v<point_2d> && sizeof(point_2d) == 8, "points are copied as raw bytes");
+
+    /// <summary>
+    /// File header, followed by the sections listed in snapshot_layout
+    /// </summary>
+    struct snapshot_header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t unit_size;
+        std::uint64_t tick;
+        std::int32_t width;
+        std::int32_t height;
+        std::uint64_t map_version;
+        std::uint64_t seed;
+        std::uint64_t start_count;
+        std::uint64_t target_count;
+        std::uint64_t unit_count;
+        std::uint64_t path_code_size;
+        std::uint64_t occupied_count;
+    };
+
+    /// <summary>
+    /// Captured unit, the direction codes of its path follow those of the previous unit in the path section
+    /// </summary>
+    struct snapshot_unit {
+        point_2d position;
+        point_2d path_start;
+        std::uint32_t path_index;
+        std::uint32_t path_length;
+    };
+
+    /// <summary>
+    /// Bytes of packed direction codes of a path
+    /// </summary>
+    /// <param name="path_length"></param>
+    /// <returns></returns>
+    static size_t code_size(const size_t path_length)
+    {
+        return (path_length + 3) / 4;
+    }
+
+    /// <summary>
+    /// File identification
+    /// </summary>
+    static constexpr char snapshot_magic[8] = { 'P', 'F', 'S', 'I', 'M', 0, 0, 0 };
+    static constexpr std::uint32_t snapshot_version = 3;
+
+    /// <summary>
+    /// Round a byte count up to whole words
+    /// </summary>
+    /// <param name="bytes"></param>
+    /// <returns></returns>
+    static size_t align_up(const size_t bytes)
+    {
+        return (bytes + sizeof(std::uint64_t) - 1) & ~(sizeof(std::uint64_t) - 1);
+    }
+
+    /// <summary>
+    /// Byte offset of every section for the counts in a header
+    /// </summary>
+    struct snapshot_layout {
+        size_t tiles, start_positions, target_positions, units, occupied, path_codes, size;
+
+        explicit snapshot_layout(const snapshot_header& header)
+        {
+            tiles = align_up(sizeof(snapshot_header));
+            start_positions = tiles + align_up(static_cast<size_t>(header.width) * header.height * sizeof(tile_type));
+            target_positions = start_positions + header.start_count * sizeof(point_2d);
+            units = target_positions + header.target_count * sizeof(point_2d);
+            occupied = units + header.unit_count * sizeof(snapshot_unit);
+            path_codes = occupied + header.occupied_count * sizeof(point_2d);
+            size = path_codes + align_up(header.path_code_size);
+        }
+    };
+
+    /// <summary>
+    /// Size the buffer once, then copy every part of the state into its section
+    /// </summary>
+    /// <param name="tick"></param>
+    /// <param name="battle_field"></param>
+    /// <param name="units"></param>
+    /// <param name="occupied_positions"></param>
+    void simulation_snapshot::capture(const std::uint64_t tick, const battle_field& battle_field, const std::vector<unit>& units,
+        const std::unordered_set<point_2d>& occupied_positions)
+    {
+        const auto& start_positions = battle_field.get_start_positions();
+        const auto& target_positions = battle_field.get_target_positions();
+
+        snapshot_header header{};
+        std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+        header.version = snapshot_version;
+        header.unit_size = sizeof(snapshot_unit);
+        header.tick = tick;
+        header.width = battle_field.get_width();
+        header.height = battle_field.get_height();
+        header.map_version = battle_field.get_version();
+        header.seed = battle_field.get_seed();
+        header.start_count = start_positions.size();
+        header.target_count = target_positions.size();
+        header.unit_count = units.size();
+        for (const auto& u : units)
+            header.path_code_size += code_size(u.get_path().size());
+        header.occupied_count = occupied_positions.size();
+
+        // Keeps its capacity, so captures of a steady simulation do not allocate
+        const snapshot_layout layout(header);
+        buffer_.resize(layout.size / sizeof(std::uint64_t));
+        size_ = layout.size;
+        auto* data = reinterpret_cast<char*>(buffer_.data());
+
+        std::memcpy(data, &header, sizeof(header));
+        battle_field.copy_row_major_tiles(reinterpret_cast<tile_type*>(data + layout.tiles));
+        std::memcpy(data + layout.start_positions, start_positions.data(), start_positions.size() * sizeof(point_2d));
+        std::memcpy(data + layout.target_positions, target_positions.data(), target_positions.size() * sizeof(point_2d));
+
+        auto* unit_records = reinterpret_cast<snapshot_unit*>(data + layout.units);
+        auto* path_codes = reinterpret_cast<std::uint8_t*>(data + layout.path_codes);
+        for (const auto& u : units) {
+            const auto& path = u.get_path();
+            *unit_records++ = { u.get_position(), path.get_start(),
+                static_cast<std::uint32_t>(u.get_path_index()), static_cast<std::uint32_t>(path.size()) };
+            if (!path.empty())
+                std::memcpy(path_codes, path.get_codes(), code_size(path.size()));
+            path_codes += code_size(path.size());
+        }
+
+        auto* occupied = reinterpret_cast<point_2d*>(data + layout.occupied);
+        for (const auto& position : occupied_positions)
+            *occupied++ = position;
+    }
+
+    /// <summary>
+    /// Copy every section back, nothing is allocated per unit beyond growing a path that is too small
+    /// </summary>
+    /// <param name="battle_field"></param>
+    /// <param name="units"></param>
+    /// <param name="occupied_positions"></param>
+    void simulation_snapshot::restore(battle_field& battle_field, std::vector<unit>& units,
+        std::unordered_set<point_2d>& occupied_positions) const
+    {
+        if (empty())
+            throw std::runtime_error("Nothing to restore, the snapshot is empty");
+
+        const auto* data = reinterpret_cast<const char*>(buffer_.data());
+        snapshot_header header{};
+        std::memcpy(&header, data, sizeof(header));
+        if (header.unit_count != units.size())
+        {
+            std::stringstream ss;
+            ss << "Snapshot has " << header.unit_count << " units, the simulation has " << units.size();
+            throw std::runtime_error(ss.str());
+        }
+
+        const snapshot_layout layout(header);
+        battle_field.restore(header.width, header.height, reinterpret_cast<const tile_type*>(data + layout.tiles),
+            reinterpret_cast<const point_2d*>(data + layout.start_positions), static_cast<size_t>(header.start_count),
+            reinterpret_cast<const point_2d*>(data + layout.target_positions), static_cast<size_t>(header.target_count),
+            header.map_version, header.seed);
+
+        const auto* unit_records = reinterpret_cast<const snapshot_unit*>(data + layout.units);
+        const auto* path_codes = reinterpret_cast<const std::uint8_t*>(data + layout.path_codes);
+        for (auto& u : units) {
+            const auto& record = *unit_records++;
+            u.restore(record.position, record.path_start, path_codes, record.path_length, record.path_index);
+            path_codes += code_size(record.path_length);
+        }
+
+        const auto* occupied = reinterpret_cast<const point_2d*>(data + layout.occupied);
+        occupied_positions.clear();
+        occupied_positions.reserve(static_cast<size_t>(header.occupied_count));
+        occupied_positions.insert(occupied, occupied + header.occupied_count);
+    }
+
+    /// <summary>
+    /// The buffer already holds the file content
+    /// </summary>
+    /// <param name="filename"></param>
+    void simulation_snapshot::save(const std::string& filename) const
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + filename);
+
+        save(file);
+        if (!file)
+            throw std::runtime_error("Failed to write file: " + filename);
+    }
+
+    /// <summary>
+    /// Write the image as is
+    /// </summary>
+    /// <param name="stream"></param>
+    void simulation_snapshot::save(std::ostream& stream) const
+    {
+        stream.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(size_));
+    }
+
+    /// <summary>
+    /// Read the whole file
+    /// </summary>
+    /// <param name="filename"></param>
+    void simulation_snapshot::load(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + filename);
+
+        const auto size = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+        load(file, size);
+    }
+
+    /// <summary>
+    /// Read the image with one read and check it against its header: every count must fit into the image before the
+    /// layout is computed from them, and the paths of the units must cover the path section exactly, so restore
+    /// never reads past the image
+    /// </summary>
+    /// <param name="stream"></param>
+    /// <param name="size"></param>
+    void simulation_snapshot::load(std::istream& stream, const size_t size)
+    {
+        snapshot_header header{};
+        if (size < sizeof(header))
+            throw std::runtime_error("Invalid simulation snapshot");
+
+        std::vector<std::uint64_t> buffer(align_up(size) / sizeof(std::uint64_t));
+        if (!stream.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size)))
+            throw std::runtime_error("Failed to read the simulation snapshot");
+
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0 || header.version != snapshot_version ||
+            header.unit_size != sizeof(snapshot_unit) || header.width <= 0 || header.height <= 0)
+            throw std::runtime_error("Invalid simulation snapshot");
+        if (static_cast<std::uint64_t>(header.width) * static_cast<std::uint64_t>(header.height) > size ||
+            header.start_count > size / sizeof(point_2d) || header.target_count > size / sizeof(point_2d) ||
+            header.unit_count > size / sizeof(snapshot_unit) || header.occupied_count > size / sizeof(point_2d) ||
+            header.path_code_size > size)
+            throw std::runtime_error("Invalid simulation snapshot counts");
+
+        const snapshot_layout layout(header);
+        if (size != layout.size)
+        {
+            std::stringstream ss;
+            ss << "Invalid simulation snapshot size: " << size << " instead of " << layout.size;
+            throw std::runtime_error(ss.str());
+        }
+
+        const auto* unit_records = reinterpret_cast<const snapshot_unit*>(reinterpret_cast<const char*>(buffer.data()) + layout.units);
+        std::uint64_t path_code_size = 0;
+        for (size_t i = 0; i < header.unit_count; ++i) {
+            const auto& record = unit_records[i];
+            if (record.path_index > record.path_length)
+            {
+                std::stringstream ss;
+                ss << "Invalid simulation snapshot: unit " << i << " is at step " << record.path_index << " of "
+                    << record.path_length;
+                throw std::runtime_error(ss.str());
+            }
+            path_code_size += code_size(record.path_length);
+        }
+        if (path_code_size != header.path_code_size)
+        {
+            std::stringstream ss;
+            ss << "Invalid simulation snapshot: the paths need " << path_code_size << " bytes of codes, the file has "
+                << header.path_code_size;
+            throw std::runtime_error(ss.str());
+        }
+
+        buffer_ = std::move(buffer);
+        size_ = size;
+    }
+
+    /// <summary>
+    /// Read from the header
+    /// </summary>
+    /// <returns></returns>
+    std::uint64_t simulation_snapshot::get_tick() const
+    {
+        snapshot_header header{};
+        if (!empty())
+            std::memcpy(&header, buffer_.data(), sizeof(header));
+        return header.tick;
+    }
+
+    /// <summary>
+    /// Read from the header
+    /// </summary>
+    /// <returns></returns>
+    size_t simulation_snapshot::get_unit_count() const
+    {
+        snapshot_header header{};
+        if (!empty())
+            std::memcpy(&header, buffer_.data(), sizeof(header));
+        return static_cast<size_t>(header.unit_count);
+    }
+}
@@ -1,5 +1,4 @@
 #include "unit.hpp"
-#include <iostream>
 
 namespace path_finding
 {
@@ -8,8 +7,9 @@ namespace path_finding
     /// </summary>
     /// <param name="position"></param>
     /// <param name="path_finder"></param>
-    unit::unit(const point_2d position, const pathfinder& path_finder)
-        : position_(position), path_index_(0), path_finder_(&path_finder) {
+    /// <param name="path_resource"></param>
+    unit::unit(const point_2d position, const pathfinder& path_finder, std::pmr::memory_resource* path_resource)
+        : position_(position), path_index_(0), path_finder_(&path_finder), path_(path_resource) {
     }
 
     /// <summary>
@@ -17,30 +17,153 @@ namespace path_finding
     /// </summary>
     /// <param name="target"></param>
     /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
     /// <returns></returns>
-    move_status unit::move(point_2d target, std::unordered_set<point_2d>& occupied_positions) {
-        if (position_ == target) {
-            std::cout << "Unit already at target." << '\n';
+    move_status unit::move(point_2d target, std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* scratch_resource) {
+        if (position_ == target)
             return move_status::at_target;
-        }
 
         // Compute path if not already set
         if (path_.empty()) {
-            path_ = path_finder_->find_path(position_, target, occupied_positions);
-            if (path_.empty()) {
-                std::cout << "No valid path to target!" << '\n';
+            path_ = path_finder_->find_compact_path(position_, target, occupied_positions,
+                path_.get_resource(), scratch_resource);
+            if (path_.empty())
                 return move_status::no_path;
-            }
             path_index_ = 0;
         }
 
+        return step(occupied_positions);
+    }
+
+    /// <summary>
+    /// Move unit to the nearest of the given targets while avoiding the occupied position by other units
+    /// </summary>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    move_status unit::move_to_nearest(const std::vector<point_2d>& targets, std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* scratch_resource) {
+
+        // Compute path to the nearest target if not already set
+        if (path_.empty()) {
+            auto reached_target = targets.size();
+            path_ = path_finder_->find_compact_path_to_nearest(position_, targets, occupied_positions, reached_target,
+                path_.get_resource(), scratch_resource);
+            if (reached_target == targets.size())
+                return move_status::no_path;
+            if (path_.empty())
+                return move_status::at_target;
+            path_index_ = 0;
+        }
+
+        return step(occupied_positions);
+    }
+
+    /// <summary>
+    /// Move unit to the given target position, searching for at most the given number of expansions per call
+    /// </summary>
+    /// <param name="target"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="expansion_budget"></param>
+    /// <returns></returns>
+    move_status unit::move_incremental(point_2d target, std::unordered_set<point_2d>& occupied_positions,
+        const size_t expansion_budget) {
+        if (position_ == target) {
+            search_.reset();
+            return move_status::at_target;
+        }
+
+        // A search for another target is of no use
+        if (search_ != nullptr && search_->get_goal() != target)
+            search_.reset();
+
+        // Follow a complete path
+        if (search_ == nullptr && path_index_ < path_.size())
+            return step(occupied_positions);
+
+        if (search_ == nullptr)
+            search_ = std::make_unique<incremental_search>(*path_finder_, position_, target, path_.get_resource());
+        if (search_->is_stale())
+            search_->restart(position_);
+
+        const auto state = search_->advance(expansion_budget, occupied_positions);
+        if (state == search_state::no_path) {
+            search_.reset();
+            path_.clear();
+            return move_status::no_path;
+        }
+
+        // Path to the goal when found, towards the best node so far otherwise
+        search_->get_path(position_, path_);
+        path_index_ = 0;
+        if (state == search_state::found)
+            search_.reset();
+        else if (path_.empty() && search_->get_best_node() != position_)
+            search_->restart(position_);
+
+        if (path_.empty())
+            return move_status::searching;
+        return step(occupied_positions);
+    }
+
+    /// <summary>
+    /// Move unit to the given target position, paths come from the scheduler
+    /// </summary>
+    /// <param name="target"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scheduler"></param>
+    /// <returns></returns>
+    move_status unit::move_scheduled(point_2d target, std::unordered_set<point_2d>& occupied_positions,
+        replan_scheduler& scheduler) {
+        if (replan_ticket_ != 0 && (position_ == target || replan_target_ != target)) {
+            scheduler.cancel(replan_ticket_);
+            replan_ticket_ = 0;
+        }
+        if (position_ == target)
+            return move_status::at_target;
+
+        // Wait for the requested path
+        if (replan_ticket_ != 0) {
+            if (!scheduler.take_result(replan_ticket_, path_))
+                return move_status::searching;
+            replan_ticket_ = 0;
+            path_index_ = 0;
+            if (path_.empty())
+                return move_status::no_path;
+        }
+
+        // Request a path instead of searching now
+        if (path_index_ >= path_.size()) {
+            path_.clear();
+            replan_ticket_ = scheduler.submit(position_, target);
+            replan_target_ = target;
+            return move_status::searching;
+        }
+
+        return step(occupied_positions);
+    }
+
+    /// <summary>
+    /// Take the next step along the path, the path is cleared when the next position is occupied
+    /// </summary>
+    /// <param name="occupied_positions"></param>
+    /// <returns></returns>
+    move_status unit::step(std::unordered_set<point_2d>& occupied_positions) {
+
         // Move one step at a time
         if (path_index_ < path_.size()) {
-            point_2d nextPosition = path_[path_index_];
+            point_2d nextPosition = position_ + compact_path::directions[path_.get_step(path_index_)];
 
             // Do not use occupied positions 
             if (occupied_positions.find(nextPosition) != occupied_positions.end()) {
-                std::cout << "Next position is occupied! Recomputing path..." << '\n';
+                path_.clear();
+                return move_status::blocked;
+            }
+
+            // The map may have changed since the path was computed
+            if (!path_finder_->get_battle_field().is_walkable(nextPosition)) {
                 path_.clear();
                 return move_status::blocked;
             }
@@ -65,4 +188,22 @@ namespace path_finding
     /// </summary>
     /// <returns></returns>
     point_2d unit::get_position() const { return position_; }
+
+    /// <summary>
+    /// Restore the position and the path
+    /// </summary>
+    /// <param name="position"></param>
+    /// <param name="path_start"></param>
+    /// <param name="path_codes"></param>
+    /// <param name="path_length"></param>
+    /// <param name="path_index"></param>
+    void unit::restore(const point_2d position, const point_2d path_start, const std::uint8_t* path_codes,
+        const size_t path_length, const size_t path_index)
+    {
+        position_ = position;
+        path_.assign(path_start, path_codes, path_length);
+        path_index_ = path_index;
+        search_.reset();
+        replan_ticket_ = 0;
+    }
 }
@@ -0,0 +1,617 @@
+#include "../headers/unitStore.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+namespace path_finding
+{
+    /// <summary>
+    /// Constructor to initialize the arrays on the given resource
+    /// </summary>
+    /// <param name="path_finder"></param>
+    /// <param name="resource"></param>
+    unit_store::unit_store(const pathfinder& path_finder, std::pmr::memory_resource* resource) :
+        path_finder_(&path_finder), positions_(resource), targets_(resource), path_indices_(resource),
+        path_lengths_(resource), path_offsets_(resource), path_slot_classes_(resource), statuses_(resource),
+        waiting_for_(resource), waited_ticks_(resource), backoff_ticks_(resource), failures_(resource),
+        previous_positions_(resource), reversals_(resource), swapped_(resource), occupants_(resource), cycle_(resource),
+        path_codes_(resource), free_slots_(resource), path_trees_(resource), path_nodes_(resource), path_cursors_(resource),
+        trees_(resource), tree_ids_(resource)
+    {
+        fit_battle_field();
+    }
+
+    /// <summary>
+    /// Lay the occupants out again when the grid size changed, the old paths may leave the grid or cross new walls
+    /// </summary>
+    void unit_store::fit_battle_field()
+    {
+        const auto& field = path_finder_->get_battle_field();
+        if (field.get_width() == occupants_width_ && field.get_height() == occupants_height_)
+            return;
+
+        occupants_width_ = field.get_width();
+        occupants_height_ = field.get_height();
+        occupants_.assign(static_cast<size_t>(occupants_width_) * static_cast<size_t>(occupants_height_), no_unit);
+        for (unit_id id = 0; id < positions_.size(); ++id) {
+            release_tree_path(id);
+            path_lengths_[id] = 0;
+            path_indices_[id] = 0;
+            waiting_for_[id] = no_unit;
+            waited_ticks_[id] = 0;
+            if (field.contains(positions_[id]))
+                occupant(positions_[id]) = id;
+        }
+    }
+
+    /// <summary>
+    /// Append the unit to every array, it has no path and no slot yet
+    /// </summary>
+    /// <param name="position"></param>
+    /// <returns></returns>
+    unit_store::unit_id unit_store::add(const point_2d position)
+    {
+        fit_battle_field();
+        const auto id = static_cast<unit_id>(positions_.size());
+        positions_.push_back(position);
+        targets_.push_back(position);
+        path_indices_.push_back(0);
+        path_lengths_.push_back(0);
+        path_offsets_.push_back(0);
+        path_slot_classes_.push_back(no_slot);
+        statuses_.push_back(move_status::searching);
+        waiting_for_.push_back(no_unit);
+        waited_ticks_.push_back(0);
+        backoff_ticks_.push_back(0);
+        failures_.push_back(0);
+        previous_positions_.push_back(position);
+        reversals_.push_back(0);
+        swapped_.push_back(0);
+        path_trees_.push_back(no_tree);
+        path_nodes_.push_back(path_tree::no_node);
+        path_cursors_.push_back(path_tree::no_node);
+        if (path_finder_->get_battle_field().contains(position))
+            occupant(position) = id;
+        return id;
+    }
+
+    /// <summary>
+    /// Reserve every array
+    /// </summary>
+    /// <param name="count"></param>
+    void unit_store::reserve(const size_t count)
+    {
+        positions_.reserve(count);
+        targets_.reserve(count);
+        path_indices_.reserve(count);
+        path_lengths_.reserve(count);
+        path_offsets_.reserve(count);
+        path_slot_classes_.reserve(count);
+        statuses_.reserve(count);
+        waiting_for_.reserve(count);
+        waited_ticks_.reserve(count);
+        backoff_ticks_.reserve(count);
+        failures_.reserve(count);
+        previous_positions_.reserve(count);
+        reversals_.reserve(count);
+        swapped_.reserve(count);
+        path_trees_.reserve(count);
+        path_nodes_.reserve(count);
+        path_cursors_.reserve(count);
+    }
+
+    /// <summary>
+    /// Set the target, the path to the previous one is of no use
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="target"></param>
+    void unit_store::set_target(const unit_id id, const point_2d target)
+    {
+        if (targets_[id] != target) {
+            path_lengths_[id] = 0;
+            path_indices_[id] = 0;
+            backoff_ticks_[id] = 0;
+            failures_[id] = 0;
+        }
+        targets_[id] = target;
+    }
+
+    /// <summary>
+    /// One pass over the arrays in id order
+    /// </summary>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    size_t unit_store::tick(std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource)
+    {
+        size_t moved = 0;
+        for (unit_id id = 0; id < positions_.size(); ++id) {
+            const auto status = move(id, targets_[id], occupied_positions, scratch_resource);
+            moved += status == move_status::moved || status == move_status::swapped || status == move_status::oscillating ? 1 : 0;
+        }
+        return moved;
+    }
+
+    /// <summary>
+    /// One pass over the arrays in id order
+    /// </summary>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    size_t unit_store::tick_to_nearest(const std::vector<point_2d>& targets, std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* scratch_resource)
+    {
+        size_t moved = 0;
+        for (unit_id id = 0; id < positions_.size(); ++id) {
+            const auto status = move_to_nearest(id, targets, occupied_positions, scratch_resource);
+            moved += status == move_status::moved || status == move_status::swapped || status == move_status::oscillating ? 1 : 0;
+        }
+        return moved;
+    }
+
+    /// <summary>
+    /// Move the unit to the given target position while avoiding the occupied position by other units
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="target"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    move_status unit_store::move(const unit_id id, const point_2d target, std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* scratch_resource)
+    {
+        fit_battle_field();
+
+        // The move was used up by a swap, or the unit backs off
+        if (swapped_[id] != 0) {
+            swapped_[id] = 0;
+            return statuses_[id] = move_status::swapped;
+        }
+        if (positions_[id] == target)
+            return statuses_[id] = move_status::at_target;
+        if (backoff_ticks_[id] > 0) {
+            backoff_ticks_[id]--;
+            metrics_.yields++;
+            return statuses_[id] = move_status::yielding;
+        }
+
+        // Compute path if not already set, the temporary path comes from the scratch resource
+        if (path_lengths_[id] == 0 && path_sharing_) {
+            metrics_.searches++;
+            if (!search_tree_path(id, target, occupied_positions, scratch_resource)) {
+                back_off(id);
+                return statuses_[id] = move_status::no_path;
+            }
+        }
+        else if (path_lengths_[id] == 0) {
+            metrics_.searches++;
+            const auto path = path_finder_->find_compact_path(positions_[id], target, occupied_positions,
+                scratch_resource != nullptr ? scratch_resource : std::pmr::get_default_resource(), scratch_resource);
+            if (path.empty()) {
+                back_off(id);
+                return statuses_[id] = move_status::no_path;
+            }
+            store_path(id, path);
+        }
+
+        return statuses_[id] = step(id, occupied_positions);
+    }
+
+    /// <summary>
+    /// Move the unit to the nearest of the given targets while avoiding the occupied position by other units
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="targets"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    move_status unit_store::move_to_nearest(const unit_id id, const std::vector<point_2d>& targets,
+        std::unordered_set<point_2d>& occupied_positions, std::pmr::memory_resource* scratch_resource)
+    {
+        fit_battle_field();
+        if (swapped_[id] != 0) {
+            swapped_[id] = 0;
+            return statuses_[id] = move_status::swapped;
+        }
+        if (backoff_ticks_[id] > 0) {
+            backoff_ticks_[id]--;
+            metrics_.yields++;
+            return statuses_[id] = move_status::yielding;
+        }
+
+        if (path_lengths_[id] == 0 && path_sharing_ && targets.size() == 1) {
+            metrics_.searches++;
+            if (!search_tree_path(id, targets.front(), occupied_positions, scratch_resource)) {
+                back_off(id);
+                return statuses_[id] = move_status::no_path;
+            }
+            if (path_lengths_[id] == 0)
+                return statuses_[id] = move_status::at_target;
+        }
+        else if (path_lengths_[id] == 0) {
+            metrics_.searches++;
+            auto reached_target = targets.size();
+            const auto path = path_finder_->find_compact_path_to_nearest(positions_[id], targets, occupied_positions, reached_target,
+                scratch_resource != nullptr ? scratch_resource : std::pmr::get_default_resource(), scratch_resource);
+            if (reached_target == targets.size()) {
+                back_off(id);
+                return statuses_[id] = move_status::no_path;
+            }
+            if (path.empty())
+                return statuses_[id] = move_status::at_target;
+            store_path(id, path);
+        }
+
+        return statuses_[id] = step(id, occupied_positions);
+    }
+
+    /// <summary>
+    /// Copy the codes into the unit's slot, a slot too small goes back to its free list for a larger one
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="path"></param>
+    void unit_store::store_path(const unit_id id, const compact_path& path)
+    {
+        release_tree_path(id);
+        const auto bytes = (path.size() + 3) / 4;
+        auto slot_class = path_slot_classes_[id];
+        if (slot_class == no_slot || (min_slot_size << slot_class) < bytes) {
+            if (slot_class != no_slot)
+                free_slots_[slot_class].push_back(path_offsets_[id]);
+
+            // Smallest class that fits
+            slot_class = 0;
+            while ((min_slot_size << slot_class) < bytes)
+                slot_class++;
+            if (free_slots_.size() <= slot_class)
+                free_slots_.resize(slot_class + 1U);
+
+            auto& free_list = free_slots_[slot_class];
+            if (!free_list.empty()) {
+                path_offsets_[id] = free_list.back();
+                free_list.pop_back();
+            }
+            else {
+                path_offsets_[id] = static_cast<std::uint32_t>(path_codes_.size());
+                path_codes_.resize(path_codes_.size() + (min_slot_size << slot_class));
+            }
+            path_slot_classes_[id] = slot_class;
+        }
+
+        std::memcpy(path_codes_.data() + path_offsets_[id], path.get_codes(), bytes);
+        path_lengths_[id] = static_cast<std::uint32_t>(path.size());
+        path_indices_[id] = 0;
+    }
+
+    /// <summary>
+    /// Take the next step along the path, the path is dropped when the next position is occupied
+    /// unless the conflict resolution finds a better way out
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="occupied_positions"></param>
+    /// <returns></returns>
+    move_status unit_store::step(const unit_id id, std::unordered_set<point_2d>& occupied_positions)
+    {
+        const auto index = path_indices_[id];
+        if (index >= path_lengths_[id])
+            return move_status::at_target;
+
+        const auto position = positions_[id];
+        const auto next_position = position + compact_path::directions[get_step(id, index)];
+
+        // The map may have changed since the path was computed
+        if (!path_finder_->get_battle_field().is_walkable(next_position)) {
+            path_lengths_[id] = 0;
+            path_indices_[id] = 0;
+            return move_status::blocked;
+        }
+
+        // Do not use occupied positions
+        if (occupied_positions.find(next_position) != occupied_positions.end()) {
+            const auto blocker = occupant(next_position);
+            if (resolution_.enabled && blocker != no_unit && blocker != id)
+                return resolve_conflict(id, blocker);
+            path_lengths_[id] = 0;
+            path_indices_[id] = 0;
+            return move_status::blocked;
+        }
+
+        occupied_positions.erase(position);
+        occupied_positions.insert(next_position);
+        occupant(position) = no_unit;
+        occupant(next_position) = id;
+        positions_[id] = next_position;
+        advance(id);
+        waiting_for_[id] = no_unit;
+        waited_ticks_[id] = 0;
+
+        // Stepping back into the cell it just left, again and again
+        if (next_position == previous_positions_[id])
+            reversals_[id]++;
+        else {
+            reversals_[id] = 0;
+            failures_[id] = 0;
+        }
+        previous_positions_[id] = position;
+        if (resolution_.enabled && reversals_[id] >= resolution_.oscillation_limit) {
+            metrics_.oscillations++;
+            reversals_[id] = 0;
+            path_lengths_[id] = 0;
+            path_indices_[id] = 0;
+            back_off(id);
+            return move_status::oscillating;
+        }
+        return move_status::moved;
+    }
+
+    /// <summary>
+    /// Head on: swap. Otherwise wait for the blocker, unless it waits for this unit through a cycle
+    /// (rotated when every member can step, else the lowest priority member detours), it does not move, or the wait takes too long
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="blocker"></param>
+    /// <returns></returns>
+    move_status unit_store::resolve_conflict(const unit_id id, const unit_id blocker)
+    {
+        const auto position = positions_[id];
+        const auto blocker_moves = path_indices_[blocker] < path_lengths_[blocker] && backoff_ticks_[blocker] == 0;
+
+        // Both want the other's cell
+        if (blocker_moves && swapped_[blocker] == 0 && get_next_position(blocker) == position) {
+            const auto next_position = positions_[blocker];
+            occupant(position) = blocker;
+            occupant(next_position) = id;
+            for (const auto& [member, from, to] : { std::tuple(id, position, next_position), std::tuple(blocker, next_position, position) }) {
+                positions_[member] = to;
+                previous_positions_[member] = from;
+                advance(member);
+                waiting_for_[member] = no_unit;
+                waited_ticks_[member] = 0;
+                reversals_[member] = 0;
+            }
+            swapped_[blocker] = 1;
+            statuses_[blocker] = move_status::swapped;
+            metrics_.swaps++;
+            return move_status::swapped;
+        }
+
+        // Follow the wait-for chain, back to this unit is a cycle
+        waiting_for_[id] = blocker;
+        cycle_.clear();
+        cycle_.push_back(id);
+        auto in_cycle = false;
+        for (auto current = blocker; current != no_unit && cycle_.size() <= resolution_.max_cycle_length; current = waiting_for_[current]) {
+            if (current == id) {
+                in_cycle = true;
+                break;
+            }
+            cycle_.push_back(current);
+        }
+
+        if (in_cycle) {
+
+            // Every member steps into the cell of the member it waits for: rotate them all at once
+            const auto members = cycle_.size();
+            auto rotates = true;
+            for (size_t i = 0; i < members && rotates; ++i) {
+                const auto member = cycle_[i];
+                rotates = path_indices_[member] < path_lengths_[member] && backoff_ticks_[member] == 0 && swapped_[member] == 0
+                    && get_next_position(member) == positions_[cycle_[(i + 1) % members]];
+            }
+            if (rotates) {
+                metrics_.cycles++;
+                metrics_.swaps++;
+                const auto first_position = positions_[id];
+                for (size_t i = 0; i < members; ++i) {
+                    const auto member = cycle_[i];
+                    previous_positions_[member] = positions_[member];
+                    positions_[member] = i + 1 < members ? positions_[cycle_[i + 1]] : first_position;
+                    occupant(positions_[member]) = member;
+                    advance(member);
+                    waiting_for_[member] = no_unit;
+                    waited_ticks_[member] = 0;
+                    reversals_[member] = 0;
+                    if (member != id) {
+                        swapped_[member] = 1;
+                        statuses_[member] = move_status::swapped;
+                    }
+                }
+                return move_status::swapped;
+            }
+
+            // Otherwise the lowest priority member gives way
+            if (*std::max_element(cycle_.begin(), cycle_.end()) == id) {
+                metrics_.cycles++;
+                return detour(id);
+            }
+        }
+
+        // A blocker without a path that does not back off plans on its next move, it is not parked
+        const auto blocker_parked = statuses_[blocker] == move_status::at_target || backoff_ticks_[blocker] > 0
+            || (path_lengths_[blocker] > 0 && path_indices_[blocker] >= path_lengths_[blocker]);
+        if (blocker_parked || waited_ticks_[id] >= resolution_.max_yield_ticks)
+            return detour(id);
+
+        waited_ticks_[id]++;
+        metrics_.yields++;
+        return move_status::yielding;
+    }
+
+    /// <summary>
+    /// Wait 1, 2, 4, ... ticks up to the cap
+    /// </summary>
+    /// <param name="id"></param>
+    void unit_store::back_off(const unit_id id)
+    {
+        const auto ticks = std::min<unsigned>(1U << std::min<unsigned>(failures_[id], 15), resolution_.max_backoff_ticks);
+        backoff_ticks_[id] = resolution_.enabled ? static_cast<std::uint16_t>(ticks) : 0;
+        failures_[id] = static_cast<std::uint8_t>(std::min<unsigned>(failures_[id] + 1U, 15));
+    }
+
+    /// <summary>
+    /// Drop the path, the blocker is in the occupied positions of the next search.
+    /// Detours back off as well, so a unit that keeps running into the same blocker searches less and less often
+    /// </summary>
+    /// <param name="id"></param>
+    /// <returns></returns>
+    move_status unit_store::detour(const unit_id id)
+    {
+        path_lengths_[id] = 0;
+        path_indices_[id] = 0;
+        waiting_for_[id] = no_unit;
+        waited_ticks_[id] = 0;
+        back_off(id);
+        metrics_.detours++;
+        return move_status::detoured;
+    }
+
+    /// <summary>
+    /// Decode the step at the path index
+    /// </summary>
+    /// <param name="id"></param>
+    /// <returns></returns>
+    point_2d unit_store::get_next_position(const unit_id id) const
+    {
+        const auto index = path_indices_[id];
+        if (index >= path_lengths_[id])
+            return positions_[id];
+        return positions_[id] + compact_path::directions[get_step(id, index)];
+    }
+
+    /// <summary>
+    /// Decode the path from the start cell, found by walking back the steps already taken (code ^ 1 is the opposite direction)
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="resource"></param>
+    /// <returns></returns>
+    compact_path unit_store::get_path(const unit_id id, std::pmr::memory_resource* resource) const
+    {
+        compact_path path(resource);
+        if (path_nodes_[id] != path_tree::no_node && path_lengths_[id] > 0) {
+            const auto& tree = trees_[path_trees_[id]];
+            auto current = tree.get(path_nodes_[id]);
+            path.reset(current.position, path_lengths_[id]);
+            for (size_t index = 0; index < path_lengths_[id]; ++index) {
+                const auto& next = tree.get(current.parent);
+                path.set_step(index, compact_path::direction_of(current.position, next.position));
+                current = next;
+            }
+            return path;
+        }
+
+        auto start = positions_[id];
+        for (auto index = path_indices_[id]; index > 0; --index)
+            start = start + compact_path::directions[get_step(id, index - 1) ^ 1];
+
+        if (path_lengths_[id] > 0)
+            path.assign(start, path_codes_.data() + path_offsets_[id], path_lengths_[id]);
+        else
+            path.reset(start, 0);
+        return path;
+    }
+
+    /// <summary>
+    /// Tree of the target, created on the first search towards it
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="target"></param>
+    /// <param name="occupied_positions"></param>
+    /// <param name="scratch_resource"></param>
+    /// <returns></returns>
+    bool unit_store::search_tree_path(const unit_id id, const point_2d target, const std::unordered_set<point_2d>& occupied_positions,
+        std::pmr::memory_resource* scratch_resource)
+    {
+        auto found = tree_ids_.find(target);
+        if (found == tree_ids_.end()) {
+            found = tree_ids_.emplace(target, static_cast<std::uint32_t>(trees_.size())).first;
+            trees_.emplace_back(path_finder_->get_battle_field(), target, trees_.get_allocator().resource());
+        }
+
+        const auto tree_id = found->second;
+        const auto start = path_finder_->find_path_in_tree(positions_[id], occupied_positions, trees_[tree_id], scratch_resource);
+        if (start == path_tree::no_node)
+            return false;
+
+        // Acquire before releasing, the old path may share the new one's nodes
+        const auto previous_tree = path_trees_[id];
+        const auto previous_start = path_nodes_[id];
+        path_trees_[id] = tree_id;
+        path_nodes_[id] = start;
+        path_cursors_[id] = start;
+        path_lengths_[id] = trees_[tree_id].get(start).distance;
+        path_indices_[id] = 0;
+        if (previous_start != path_tree::no_node)
+            trees_[previous_tree].release(previous_start);
+        return true;
+    }
+
+    /// <summary>
+    /// Release the start node, which holds the whole path
+    /// </summary>
+    /// <param name="id"></param>
+    void unit_store::release_tree_path(const unit_id id)
+    {
+        if (path_nodes_[id] == path_tree::no_node)
+            return;
+        trees_[path_trees_[id]].release(path_nodes_[id]);
+        path_trees_[id] = no_tree;
+        path_nodes_[id] = path_tree::no_node;
+        path_cursors_[id] = path_tree::no_node;
+    }
+
+    /// <summary>
+    /// The step at the cursor is read from the cursor's node, any other one by walking from the start
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="index"></param>
+    /// <returns></returns>
+    int unit_store::get_tree_step(const unit_id id, const size_t index) const
+    {
+        const auto& tree = trees_[path_trees_[id]];
+        auto current = path_cursors_[id];
+        if (index != path_indices_[id]) {
+            current = path_nodes_[id];
+            for (size_t i = 0; i < index; ++i)
+                current = tree.get(current).parent;
+        }
+        const auto& from = tree.get(current);
+        return compact_path::direction_of(from.position, tree.get(from.parent).position);
+    }
+
+    /// <summary>
+    /// Next step, and the next node for a shared path
+    /// </summary>
+    /// <param name="id"></param>
+    void unit_store::advance(const unit_id id)
+    {
+        path_indices_[id]++;
+        if (path_cursors_[id] != path_tree::no_node)
+            path_cursors_[id] = trees_[path_trees_[id]].get(path_cursors_[id]).parent;
+    }
+
+    /// <summary>
+    /// Sum over the trees
+    /// </summary>
+    /// <returns></returns>
+    size_t unit_store::get_path_tree_node_count() const
+    {
+        size_t count = 0;
+        for (const auto& tree : trees_)
+            count += tree.get_node_count();
+        return count;
+    }
+
+    /// <summary>
+    /// Sum over the trees
+    /// </summary>
+    /// <returns></returns>
+    size_t unit_store::get_path_tree_memory_size() const
+    {
+        size_t size = 0;
+        for (const auto& tree : trees_)
+            size += tree.get_memory_size();
+        return size;
+    }
+}
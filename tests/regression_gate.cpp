@@ -0,0 +1,379 @@
+#include "../benchmarks/benchmarkMaps.hpp"
+#include "../headers/pathFinder.hpp"
+#include "../headers/landmarkHeuristic.hpp"
+#include "../headers/compressedPathDatabase.hpp"
+#include "../headers/goalBounds.hpp"
+#include "../headers/incrementalSearch.hpp"
+#include "../headers/rectangleDecomposition.hpp"
+#include "../headers/memoryResources.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <nlohmann/json.hpp>
+
+using namespace path_finding;
+using namespace path_finding_benchmarks;
+
+namespace path_finding_regression
+{
+	/// <summary>
+	/// Engine under test: answers one query
+	/// </summary>
+	using query = std::function<std::vector<point_2d>(point_2d start, point_2d goal)>;
+
+	/// <summary>
+	/// Named engine, the first one of the list is the reference
+	/// </summary>
+	struct engine {
+		std::string name;
+		query run;
+	};
+
+	/// <summary>
+	/// Everything the engines of one map need: occupied positions, pathfinders and precomputed data
+	/// </summary>
+	struct map_fixture {
+		explicit map_fixture(const benchmark_map& map) :
+			map(map), plain(map.field), alt(map.field), database(map.field), bounded(map.field), reduced(map.field),
+			landmarks(map.field, 8), path_database(compressed_path_database::build(map.field)), bounds(goal_bounds::build(map.field)),
+			rectangles(rectangle_decomposition::build(map.field))
+		{
+			alt.set_landmarks(&landmarks);
+			database.set_path_database(&path_database);
+			bounded.set_goal_bounds(&bounds);
+			reduced.set_symmetry_reduction(&rectangles);
+		}
+
+		const benchmark_map& map;
+		std::unordered_set<point_2d> occupied;
+		pathfinder plain, alt, database, bounded, reduced;
+		landmark_heuristic landmarks;
+		compressed_path_database path_database;
+		goal_bounds bounds;
+		rectangle_decomposition rectangles;
+		tick_arena arena;
+	};
+
+	/// <summary>
+	/// Every engine of the library on the fixture, new engines are added here
+	/// </summary>
+	/// <param name="fixture"></param>
+	/// <returns></returns>
+	std::vector<engine> create_engines(map_fixture& fixture)
+	{
+		auto& f = fixture;
+		return {
+			{ "a_star", [&f](const point_2d start, const point_2d goal) {
+				return f.plain.find_path(start, goal, f.occupied);
+			} },
+			{ "a_star_arena", [&f](const point_2d start, const point_2d goal) {
+				const auto path = f.plain.find_path(start, goal, f.occupied, f.arena.resource());
+				std::vector<point_2d> result(path.begin(), path.end());
+				f.arena.reset();
+				return result;
+			} },
+			{ "bidirectional", [&f](const point_2d start, const point_2d goal) {
+				return f.plain.find_path_bidirectional(start, goal, f.occupied);
+			} },
+			{ "alt", [&f](const point_2d start, const point_2d goal) {
+				return f.alt.find_path(start, goal, f.occupied);
+			} },
+			{ "alt_bidirectional", [&f](const point_2d start, const point_2d goal) {
+				return f.alt.find_path_bidirectional(start, goal, f.occupied);
+			} },
+			{ "nearest", [&f](const point_2d start, const point_2d goal) {
+				size_t reached_target = 0;
+				return f.plain.find_path_to_nearest(start, std::vector<point_2d>{ goal }, f.occupied, reached_target);
+			} },
+			{ "database", [&f](const point_2d start, const point_2d goal) {
+				return f.database.find_path_from_database(start, goal, f.occupied);
+			} },
+			{ "goal_bounds", [&f](const point_2d start, const point_2d goal) {
+				return f.bounded.find_path(start, goal, f.occupied);
+			} },
+			{ "symmetry_reduction", [&f](const point_2d start, const point_2d goal) {
+				return f.reduced.find_path_reduced(start, goal, f.occupied);
+			} },
+			{ "incremental", [&f](const point_2d start, const point_2d goal) {
+				incremental_search search(f.plain, start, goal);
+				search.advance(std::numeric_limits<size_t>::max(), f.occupied);
+				compact_path path;
+				search.get_path(start, path);
+				return std::vector<point_2d>(path.begin(), path.end());
+			} }
+		};
+	}
+
+	/// <summary>
+	/// Check a path: adjacent steps from the start, walkable, free unless it is the goal, ends at the goal
+	/// </summary>
+	/// <param name="fixture"></param>
+	/// <param name="start"></param>
+	/// <param name="goal"></param>
+	/// <param name="path"></param>
+	/// <returns>Empty when valid, the reason otherwise</returns>
+	std::string validate(const map_fixture& fixture, const point_2d start, const point_2d goal, const std::vector<point_2d>& path)
+	{
+		auto previous = start;
+		for (const auto& p : path) {
+			if (previous.manhattan_distance(p) != 1)
+				return "step is not to a neighbour";
+			if (!fixture.map.field.is_walkable(p))
+				return "step onto an obstacle";
+			if (p != goal && fixture.occupied.count(p) != 0)
+				return "step onto an occupied position";
+			previous = p;
+		}
+		if (!path.empty() && path.back() != goal)
+			return "path does not end at the goal";
+		return {};
+	}
+
+	/// <summary>
+	/// Fixed maps (woodland, dead end comb) and maps randomized by the seed (open fields, maze)
+	/// </summary>
+	/// <param name="seed"></param>
+	/// <returns></returns>
+	std::vector<benchmark_map> create_gate_suite(const std::uint64_t seed)
+	{
+		std::vector<benchmark_map> suite;
+		suite.push_back(create_open_field(64, 64, 0.1, 40, seed));
+		suite.push_back(create_open_field(64, 64, 0.3, 40, seed + 1));
+		suite.push_back(create_dead_end_comb(65, 32));
+		suite.push_back(create_maze(49, 49, 40, seed + 2));
+		for (auto& map : load_resource_maps())
+			suite.push_back(std::move(map));
+		return suite;
+	}
+
+	/// <summary>
+	/// Occupy about one free cell in 50, never a query start or goal
+	/// </summary>
+	/// <param name="fixture"></param>
+	/// <param name="seed"></param>
+	void occupy(map_fixture& fixture, const std::uint64_t seed)
+	{
+		std::unordered_set<point_2d> endpoints;
+		for (const auto& [start, goal] : fixture.map.queries) {
+			endpoints.insert(start);
+			endpoints.insert(goal);
+		}
+
+		const auto& field = fixture.map.field;
+		std::mt19937_64 gen(seed);
+		std::uniform_int_distribution<int> x(0, field.get_width() - 1), y(0, field.get_height() - 1);
+		const auto count = static_cast<size_t>(field.get_width()) * field.get_height() / 50;
+		for (size_t attempt = 0; attempt < count * 4 && fixture.occupied.size() < count; ++attempt) {
+			const point_2d p(x(gen), y(gen));
+			if (field.is_walkable(p) && endpoints.count(p) == 0)
+				fixture.occupied.insert(p);
+		}
+	}
+
+	/// <summary>
+	/// Options of the gate
+	/// </summary>
+	struct gate_options {
+		std::string baseline_filename;
+		std::string config = PATH_FINDING_BUILD_CONFIG;
+		std::uint64_t seed = 1;
+		int repetitions = 3;
+		double threshold = -1;
+		bool update = false;
+		bool absolute = false;
+	};
+
+	/// <summary>
+	/// Time of an engine over the suite (the fastest repetition per map), and its speedup over the reference
+	/// as the geometric mean of the per map speedups, so the small maps weigh as much as the big ones
+	/// </summary>
+	struct engine_timing {
+		double microseconds = 0, log_speedup = 0;
+		size_t queries = 0, maps = 0, mismatches = 0;
+	};
+
+	/// <summary>
+	/// Print the usage
+	/// </summary>
+	/// <returns></returns>
+	int usage()
+	{
+		std::cerr << "Usage: regression_gate --baseline <file.json> [--update] [--seed n] [--repetitions n] [--threshold t] [--absolute]" << '\n'
+			<< "  --update       write this build configuration's timings into the baseline instead of checking them" << '\n'
+			<< "  --threshold    allowed loss of speedup over the reference, overrides the baseline's threshold" << '\n'
+			<< "  --absolute     also check the reference's own time, only meaningful on the machine the baseline was recorded on" << '\n';
+		return 2;
+	}
+
+	/// <summary>
+	/// Run the suite through every engine, compare the paths against the reference and the timings against the baseline
+	/// </summary>
+	/// <param name="options"></param>
+	/// <returns>0 when correct and not slower than allowed</returns>
+	int run_gate(const gate_options& options)
+	{
+		std::vector<std::string> names;
+		std::map<std::string, engine_timing> timings;
+		size_t failures = 0;
+
+		for (const auto& map : create_gate_suite(options.seed)) {
+			if (map.queries.empty())
+				continue;
+			map_fixture fixture(map);
+			occupy(fixture, options.seed);
+			const auto engines = create_engines(fixture);
+			if (names.empty())
+				for (const auto& e : engines)
+					names.push_back(e.name);
+
+			// Correctness: same length as the reference and a valid path
+			std::vector<size_t> expected;
+			for (const auto& [start, goal] : map.queries)
+				expected.push_back(engines.front().run(start, goal).size());
+			for (const auto& e : engines) {
+				auto& timing = timings[e.name];
+				for (size_t i = 0; i < map.queries.size(); ++i) {
+					const auto [start, goal] = map.queries[i];
+					const auto path = e.run(start, goal);
+					auto error = validate(fixture, start, goal, path);
+					if (error.empty() && path.size() != expected[i])
+						error = "length " + std::to_string(path.size()) + " instead of " + std::to_string(expected[i]);
+					if (!error.empty()) {
+						if (timing.mismatches++ < 3)
+							std::cerr << "FAIL " << e.name << " on " << map.name << " from (" << start.get_x() << ", " << start.get_y()
+								<< ") to (" << goal.get_x() << ", " << goal.get_y() << "): " << error << '\n';
+						failures++;
+					}
+				}
+			}
+
+			// Timing: the fastest of the repetitions, the engines take turns so a load change hits them alike.
+			// A repetition runs the queries at least 2 ms so maps with few short queries are not timer noise
+			std::vector<double> best(engines.size(), std::numeric_limits<double>::max());
+			for (int repetition = 0; repetition < options.repetitions; ++repetition)
+				for (size_t i = 0; i < engines.size(); ++i) {
+					const auto begin = std::chrono::steady_clock::now();
+					double elapsed = 0;
+					int passes = 0;
+					for (; passes == 0 || elapsed < 2000; ++passes) {
+						for (const auto& [start, goal] : map.queries)
+							engines[i].run(start, goal);
+						elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+					}
+					best[i] = std::min(best[i], elapsed / passes);
+				}
+			for (size_t i = 0; i < engines.size(); ++i) {
+				auto& timing = timings[engines[i].name];
+				timing.microseconds += best[i];
+				timing.queries += map.queries.size();
+				timing.log_speedup += std::log(std::max(best.front(), 1e-3) / std::max(best[i], 1e-3));
+				timing.maps++;
+			}
+		}
+
+		// Speedups over the reference are compared, they hold across machines where absolute times do not
+		nlohmann::json baseline = nlohmann::json::object();
+		if (std::ifstream file(options.baseline_filename); file.is_open())
+			file >> baseline;
+		const auto threshold = options.threshold >= 0 ? options.threshold : baseline.value("threshold", 0.25);
+		// Speedups on randomized maps only compare on the maps the baseline was recorded on
+		auto recorded = baseline.contains("configs") && baseline["configs"].contains(options.config)
+			? baseline["configs"][options.config] : nlohmann::json::object();
+		if (!recorded.empty() && recorded.value("seed", std::uint64_t(1)) != options.seed)
+			recorded = nlohmann::json::object();
+
+		std::cout << "config " << options.config << ", seed " << options.seed << ", threshold " << threshold << '\n'
+			<< std::left << std::setw(20) << "engine" << std::right << std::setw(12) << "us/query" << std::setw(10) << "speedup"
+			<< std::setw(10) << "baseline" << std::setw(12) << "mismatches" << "  status" << '\n';
+
+		nlohmann::json current = { { "reference", names.front() }, { "seed", options.seed }, { "engines", nlohmann::json::object() } };
+		for (const auto& name : names) {
+			const auto& timing = timings[name];
+			const auto per_query = timing.microseconds / static_cast<double>(std::max<size_t>(timing.queries, 1));
+			const auto speedup = std::exp(timing.log_speedup / static_cast<double>(std::max<size_t>(timing.maps, 1)));
+			current["engines"][name] = { { "us_per_query", per_query }, { "speedup", speedup } };
+
+			std::string status = timing.mismatches > 0 ? "WRONG" : "ok";
+			double expected_speedup = 0;
+			if (recorded.contains("engines") && recorded["engines"].contains(name)) {
+				const auto& entry = recorded["engines"][name];
+				expected_speedup = entry.value("speedup", 0.0);
+				const auto slower = name == names.front()
+					? options.absolute && per_query > entry.value("us_per_query", 0.0) * (1 + threshold)
+					: speedup < expected_speedup * (1 - threshold);
+				if (slower && !options.update) {
+					status = "SLOWER";
+					failures++;
+				}
+			}
+			else if (status == "ok")
+				status = "new";
+
+			std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(12) << per_query << std::setw(10) << speedup << std::setw(10) << expected_speedup
+				<< std::setw(12) << timing.mismatches << "  " << status << '\n';
+		}
+
+		if (options.update) {
+			baseline["threshold"] = threshold;
+			baseline["configs"][options.config] = current;
+			std::ofstream file(options.baseline_filename);
+			file << baseline.dump(2) << '\n';
+			std::cout << "baseline written to " << options.baseline_filename << '\n';
+		}
+		else if (recorded.empty())
+			std::cout << "no baseline for config " << options.config << " and seed " << options.seed << ", timings not checked" << '\n';
+
+		return failures > 0 ? 1 : 0;
+	}
+}
+
+/// <summary>
+/// Differential correctness and performance regression gate, registered with ctest
+/// </summary>
+int main(const int argc, char** argv)
+{
+	using namespace path_finding_regression;
+	gate_options options;
+	if (options.config.empty())
+		options.config = "Debug";
+
+	try {
+		for (int i = 1; i < argc; ++i) {
+			const std::string argument = argv[i];
+			const auto has_value = i + 1 < argc;
+			if (argument == "--baseline" && has_value)
+				options.baseline_filename = argv[++i];
+			else if (argument == "--seed" && has_value)
+				options.seed = std::stoull(argv[++i]);
+			else if (argument == "--repetitions" && has_value)
+				options.repetitions = std::max(1, std::stoi(argv[++i]));
+			else if (argument == "--threshold" && has_value)
+				options.threshold = std::stod(argv[++i]);
+			else if (argument == "--update")
+				options.update = true;
+			else if (argument == "--absolute")
+				options.absolute = true;
+			else
+				return usage();
+		}
+		if (options.baseline_filename.empty())
+			return usage();
+		return run_gate(options);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "An error occurred: " << e.what() << '\n';
+		return 1;
+	}
+}
@@ -2,6 +2,36 @@
 #include "../headers/pathFinder.hpp"
 #include "../headers/battleField.hpp"
 #include "../headers/point2d.hpp"
+#include "../headers/unit.hpp"
+#include "../headers/memoryResources.hpp"
+#include "../headers/landmarkHeuristic.hpp"
+#include "../headers/compressedPathDatabase.hpp"
+#include "../headers/simulationSnapshot.hpp"
+#include "../headers/eventLog.hpp"
+#include "../headers/incrementalSearch.hpp"
+#include "../headers/replanScheduler.hpp"
+#include "../headers/pathService.hpp"
+#include "../headers/unitStore.hpp"
+#include "../headers/scenarioRunner.hpp"
+#include "../headers/goalBounds.hpp"
+#include "../headers/precomputeCache.hpp"
+#include "../headers/pathExecutor.hpp"
+#include "../headers/battleFieldViewport.hpp"
+#include "../headers/mapWatcher.hpp"
+#include "../headers/pathTree.hpp"
+#include "../headers/rectangleDecomposition.hpp"
+#include "../headers/gridLayout.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <limits>
+#include <random>
+#include <sstream>
+#include <thread>
 
 using namespace path_finding;
 
@@ -172,6 +202,1734 @@ namespace path_finding_unit_tests
 		EXPECT_TRUE(path.empty());
 	}
 
+	/// <summary>
+	/// Starts and goals outside the grid give no path from every search
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, out_of_grid_endpoints_test) {
+		const battle_field bf = create_simple_battlefield(8, 8);
+		pathfinder pf(bf);
+		const auto rectangles = rectangle_decomposition::build(bf);
+		pf.set_symmetry_reduction(&rectangles);
+		const std::unordered_set<point_2d> occupied;
+
+		const point_2d inside(3, 3);
+		for (const auto outside : { point_2d(-2000000, -2000000), point_2d(8, 3), point_2d(3, -1) }) {
+			EXPECT_TRUE(pf.find_path(outside, inside, occupied).empty());
+			EXPECT_TRUE(pf.find_path(inside, outside, occupied).empty());
+			EXPECT_EQ(pf.find_compact_path(outside, inside, occupied).size(), 0u);
+			EXPECT_TRUE(pf.find_path_bidirectional(outside, inside, occupied).empty());
+			EXPECT_TRUE(pf.find_path_bidirectional(inside, outside, occupied).empty());
+			EXPECT_TRUE(pf.find_path_reduced(outside, inside, occupied).empty());
+			EXPECT_TRUE(pf.find_path_reduced(inside, outside, occupied).empty());
+
+			size_t reached_target = 0;
+			EXPECT_TRUE(pf.find_path_to_nearest(outside, { inside, outside }, occupied, reached_target).empty());
+			EXPECT_EQ(reached_target, 2u);
+
+			path_tree tree(bf, inside);
+			EXPECT_EQ(pf.find_path_in_tree(outside, occupied, tree), path_tree::no_node);
+		}
+
+		// The searches still answer queries inside the grid afterwards
+		EXPECT_EQ(pf.find_path(point_2d(0, 0), inside, occupied).size(), 6u);
+	}
+
+	/// <summary>
+	/// Path is allocated from the given resource and the search only touches its scratch resource
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, search_uses_given_resources_test) {
+		const battle_field bf = create_simple_battlefield(64, 64);
+		const pathfinder pf(bf);
+		const std::unordered_set<point_2d> occupied;
+
+		counting_resource path_counter;
+		counting_resource scratch_counter;
+		const auto path = pf.find_path(point_2d(0, 0), point_2d(63, 63), occupied, &path_counter, &scratch_counter);
+
+		ASSERT_EQ(path.size(), 126u);
+		EXPECT_EQ(path.get_allocator().resource(), &path_counter);
+		EXPECT_GT(path_counter.get_allocation_count(), 0u);
+		EXPECT_GT(scratch_counter.get_allocation_count(), 0u);
+
+		// The search arena is released in one shot when the search returns
+		EXPECT_EQ(scratch_counter.get_bytes_in_use(), 0u);
+		EXPECT_EQ(pf.get_search_counter().get_allocation_count(), 0u);
+	}
+
+	/// <summary>
+	/// Small searches fit into the stack buffer of the search arena
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, small_search_does_not_allocate_test) {
+		const battle_field bf = create_simple_battlefield(5, 5);
+		const pathfinder pf(bf);
+		const std::unordered_set<point_2d> occupied;
+
+		counting_resource scratch_counter;
+		const auto path = pf.find_path(point_2d(0, 0), point_2d(4, 4), occupied, std::pmr::get_default_resource(), &scratch_counter);
+
+		EXPECT_EQ(path.size(), 8u);
+		EXPECT_EQ(scratch_counter.get_allocation_count(), 0u);
+	}
+
+	/// <summary>
+	/// Unit paths come from the pool and searches from the tick arena
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, unit_uses_pool_and_tick_arena_test) {
+		const battle_field bf = create_simple_battlefield(64, 64);
+		const pathfinder pf(bf);
+		path_pool pool;
+		tick_arena arena;
+
+		unit u(point_2d(0, 0), pf, pool.resource());
+		std::unordered_set<point_2d> occupied{ point_2d(0, 0) };
+		EXPECT_EQ(u.move(point_2d(63, 63), occupied, arena.resource()), move_status::moved);
+		arena.reset();
+
+		EXPECT_GT(pool.get_counter().get_allocation_count(), 0u);
+		EXPECT_GT(arena.get_counter().get_allocation_count(), 0u);
+		EXPECT_EQ(pf.get_search_counter().get_allocation_count(), 0u);
+		EXPECT_EQ(u.get_position().manhattan_distance(point_2d(0, 0)), 1);
+	}
+
+	/// <summary>
+	/// Bidirectional search returns paths as short as find_path, including around occupied tiles and through walls
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, bidirectional_matches_find_path_test) {
+		battle_field bf;
+		bf.generate_random_field(30, 30, 0, 250, 27);
+		const pathfinder pf(bf);
+
+		std::unordered_set<point_2d> occupied;
+		occupied.insert(point_2d(5, 5));
+		occupied.insert(point_2d(6, 5));
+		occupied.insert(point_2d(7, 5));
+
+		// Fixed endpoints spread over the grid, so every run checks the same queries
+		int found = 0;
+		for (int i = 0; i < 50; ++i) {
+			const point_2d start((i * 7) % 30, (i * 11) % 30);
+			const point_2d goal((i * 13 + 17) % 30, (i * 19 + 3) % 30);
+			const auto expected = pf.find_path(start, goal, occupied);
+			const auto path = pf.find_path_bidirectional(start, goal, occupied);
+
+			ASSERT_EQ(path.size(), expected.size());
+			if (!path.empty()) {
+				EXPECT_EQ(path.back(), goal);
+				++found;
+			}
+			auto previous = start;
+			for (const auto& p : path) {
+				EXPECT_EQ(previous.manhattan_distance(p), 1);
+				EXPECT_TRUE(bf.is_walkable(p));
+				EXPECT_TRUE(occupied.count(p) == 0 || p == goal);
+				previous = p;
+			}
+		}
+		EXPECT_GT(found, 0);
+	}
+
+	/// <summary>
+	/// Bidirectional search: no path and occupied target cases
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, bidirectional_edge_cases_test) {
+		const battle_field bf = create_simple_battlefield(5, 5);
+		const pathfinder pf(bf);
+
+		std::unordered_set<point_2d> occupied;
+		EXPECT_TRUE(pf.find_path_bidirectional(point_2d(2, 2), point_2d(2, 2), occupied).empty());
+
+		occupied.insert(point_2d(3, 4));
+		occupied.insert(point_2d(4, 3));
+		EXPECT_TRUE(pf.find_path_bidirectional(point_2d(0, 0), point_2d(4, 4), occupied).empty());
+
+		occupied.insert(point_2d(4, 4));
+		EXPECT_TRUE(pf.find_path_bidirectional(point_2d(0, 0), point_2d(3, 3), occupied).size() == 6);
+		const auto path = pf.find_path_bidirectional(point_2d(0, 0), point_2d(4, 3), occupied);
+		ASSERT_EQ(path.size(), 7u);
+		EXPECT_EQ(path.back(), point_2d(4, 3));
+	}
+
+	/// <summary>
+	/// Nearest target search picks the closest reachable target and matches the best single target search
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, nearest_target_test) {
+		battle_field bf;
+		bf.generate_random_field(30, 30, 0, 200);
+		const pathfinder pf(bf);
+		const std::unordered_set<point_2d> occupied;
+
+		for (int i = 0; i < 30; ++i) {
+			const auto start = battle_field::generate_random_point(point_2d(0, 0), point_2d(29, 29));
+			std::vector<point_2d> targets;
+			for (int t = 0; t < 5; ++t)
+				targets.push_back(battle_field::generate_random_point(point_2d(0, 0), point_2d(29, 29)));
+
+			// Best of one search per target
+			auto best_length = std::numeric_limits<size_t>::max();
+			for (const auto& target : targets) {
+				const auto path = pf.find_path(start, target, occupied);
+				if (target == start)
+					best_length = 0;
+				else if (!path.empty())
+					best_length = std::min(best_length, path.size());
+			}
+
+			size_t reached = 0;
+			const auto path = pf.find_path_to_nearest(start, targets, occupied, reached);
+			if (best_length == std::numeric_limits<size_t>::max()) {
+				EXPECT_EQ(reached, targets.size());
+				EXPECT_TRUE(path.empty());
+				continue;
+			}
+			ASSERT_LT(reached, targets.size());
+			EXPECT_EQ(path.size(), best_length);
+			if (!path.empty()) {
+				EXPECT_EQ(path.back(), targets[reached]);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Unit walks to the nearest of two targets, also when it is occupied
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, unit_moves_to_nearest_target_test) {
+		const battle_field bf = create_simple_battlefield(10, 1);
+		const pathfinder pf(bf);
+		const std::vector targets{ point_2d(0, 0), point_2d(6, 0) };
+
+		unit u(point_2d(4, 0), pf);
+		std::unordered_set<point_2d> occupied{ point_2d(4, 0), point_2d(6, 0) };
+		EXPECT_EQ(u.move_to_nearest(targets, occupied), move_status::moved);
+		EXPECT_EQ(u.get_position(), point_2d(5, 0));
+		EXPECT_EQ(u.move_to_nearest(targets, occupied), move_status::blocked);
+
+		occupied.erase(point_2d(6, 0));
+		EXPECT_EQ(u.move_to_nearest(targets, occupied), move_status::moved);
+		EXPECT_EQ(u.move_to_nearest(targets, occupied), move_status::at_target);
+		EXPECT_EQ(u.get_position(), point_2d(6, 0));
+	}
+
+	/// <summary>
+	/// Count the tiles of the given type
+	/// </summary>
+	/// <param name="bf"></param>
+	/// <param name="type"></param>
+	/// <returns></returns>
+	size_t count_tiles(const battle_field& bf, const tile_type type) {
+		size_t count = 0;
+		for (int y = 0; y < bf.get_height(); ++y)
+			for (int x = 0; x < bf.get_width(); ++x)
+				if (bf.get_tile(point_2d(x, y)) == type)
+					count++;
+		return count;
+	}
+
+	/// <summary>
+	/// Seeded generator gives the same field for the same seed with exact counts, even when nearly full
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, seeded_random_field_test) {
+		battle_field first;
+		battle_field second;
+		first.generate_random_field(100, 100, 999, 9000, 42);
+		second.generate_random_field(100, 100, 999, 9000, 42);
+
+		EXPECT_EQ(first.get_battlefield_grid(), second.get_battlefield_grid());
+		EXPECT_EQ(first.get_start_positions(), second.get_start_positions());
+		EXPECT_EQ(count_tiles(first, tile_type::elevated), 9000u);
+		EXPECT_EQ(count_tiles(first, tile_type::start), 999u);
+		EXPECT_EQ(count_tiles(first, tile_type::target), 1u);
+		EXPECT_EQ(first.get_start_positions().size(), 999u);
+
+		// Units never stand on terrain
+		for (const auto& position : first.get_start_positions())
+			EXPECT_EQ(first.get_tile(position), tile_type::start);
+
+		battle_field other;
+		other.generate_random_field(100, 100, 999, 9000, 43);
+		EXPECT_NE(first.get_battlefield_grid(), other.get_battlefield_grid());
+	}
+
+	/// <summary>
+	/// Generator spreads the picks over several chunks and rejects fields that cannot fit
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, large_random_field_test) {
+		battle_field bf;
+		bf.generate_random_field(2000, 1500, 5000, 1000000, 7);
+		EXPECT_EQ(count_tiles(bf, tile_type::elevated), 1000000u);
+		EXPECT_EQ(count_tiles(bf, tile_type::start), 5000u);
+
+		EXPECT_THROW(bf.generate_random_field(10, 10, 50, 50, 1), std::runtime_error);
+		EXPECT_THROW(bf.generate_random_field(10, 10, -1, 0, 1), std::runtime_error);
+	}
+
+	/// <summary>
+	/// Edits bump the version and are published once per cell to the subscribers
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, map_edits_are_published_test) {
+		battle_field bf = create_simple_battlefield(10, 10);
+		std::vector<map_changes> received;
+		const auto id = bf.subscribe([&](const map_changes& changes) { received.push_back(changes); });
+
+		const auto version = bf.get_version();
+		bf.set_tile(point_2d(1, 1), tile_type::elevated);
+		bf.set_tile(point_2d(1, 1), tile_type::elevated);
+		EXPECT_EQ(bf.get_version(), version + 1);
+		bf.set_tiles(point_2d(0, 0), point_2d(2, 1), tile_type::elevated);
+		EXPECT_EQ(bf.get_version(), version + 2);
+		EXPECT_FALSE(bf.is_walkable(point_2d(2, 0)));
+
+		const auto& changes = bf.publish_changes();
+		EXPECT_EQ(changes.previous_version, version);
+		EXPECT_EQ(changes.version, version + 2);
+		EXPECT_EQ(changes.cells.size(), 6u);
+		ASSERT_EQ(received.size(), 1u);
+
+		// Nothing new, nobody is notified
+		EXPECT_TRUE(bf.publish_changes().empty());
+		EXPECT_EQ(received.size(), 1u);
+
+		bf.unsubscribe(id);
+		bf.set_tile(point_2d(1, 1), tile_type::walkable);
+		EXPECT_EQ(bf.publish_changes().cells.size(), 1u);
+		EXPECT_EQ(received.size(), 1u);
+		EXPECT_THROW(bf.set_tile(point_2d(10, 0), tile_type::walkable), std::runtime_error);
+	}
+
+	/// <summary>
+	/// Snapshots only change when edits are published and keep the target positions in line
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, map_snapshot_test) {
+		std::vector<tile_type> tiles(25, tile_type::walkable);
+		tiles[4] = tile_type::target;
+		battle_field bf;
+		bf.load_from_tiles(5, 5, tiles);
+		bf.enable_snapshots();
+		const auto before = bf.get_snapshot();
+		ASSERT_NE(before, nullptr);
+
+		bf.set_tiles(point_2d(0, 2), point_2d(4, 2), tile_type::elevated);
+		EXPECT_EQ(bf.get_snapshot(), before);
+		bf.publish_changes();
+
+		const auto after = bf.get_snapshot();
+		EXPECT_NE(after, before);
+		EXPECT_TRUE(before->is_walkable(point_2d(0, 2)));
+		EXPECT_FALSE(after->is_walkable(point_2d(0, 2)));
+		EXPECT_EQ(after->get_version(), bf.get_version());
+
+		// Wall across the field splits it
+		const pathfinder pf(*after);
+		EXPECT_TRUE(pf.find_path(point_2d(0, 0), point_2d(0, 4), {}).empty());
+
+		bf.set_tile(point_2d(3, 3), tile_type::target);
+		EXPECT_EQ(bf.get_target_positions(), std::vector<point_2d>({ point_2d(4, 0), point_2d(3, 3) }));
+		bf.set_tile(point_2d(3, 3), tile_type::walkable);
+		EXPECT_EQ(bf.get_target_positions(), std::vector<point_2d>({ point_2d(4, 0) }));
+	}
+
+	/// <summary>
+	/// A unit replans when a wall appears on its path
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, unit_replans_around_new_wall_test) {
+		battle_field bf = create_simple_battlefield(5, 3);
+		const pathfinder pf(bf);
+		unit u(point_2d(0, 1), pf);
+		std::unordered_set<point_2d> occupied{ point_2d(0, 1) };
+
+		EXPECT_EQ(u.move(point_2d(4, 1), occupied), move_status::moved);
+		bf.set_tile(point_2d(2, 1), tile_type::elevated);
+		bf.set_tile(u.get_position() + point_2d(1, 0), tile_type::elevated);
+		EXPECT_EQ(u.move(point_2d(4, 1), occupied), move_status::blocked);
+
+		for (int i = 0; i < 10 && u.get_position() != point_2d(4, 1); ++i)
+			u.move(point_2d(4, 1), occupied);
+		EXPECT_EQ(u.get_position(), point_2d(4, 1));
+	}
+
+	/// <summary>
+	/// Landmark bound never overestimates and A* with landmarks still finds shortest paths
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, landmark_heuristic_test) {
+		battle_field bf;
+		bf.generate_random_field(40, 40, 0, 500, 11);
+		const landmark_heuristic landmarks(bf, 6);
+		EXPECT_EQ(landmarks.get_landmarks().size(), 6u);
+
+		pathfinder pf(bf);
+		pathfinder alt_pf(bf);
+		alt_pf.set_landmarks(&landmarks);
+		std::unordered_set<point_2d> occupied{ point_2d(20, 20), point_2d(21, 20) };
+
+		for (int i = 0; i < 40; ++i) {
+			const auto start = battle_field::generate_random_point(point_2d(0, 0), point_2d(39, 39));
+			const auto goal = battle_field::generate_random_point(point_2d(0, 0), point_2d(39, 39));
+			const auto expected = pf.find_path(start, goal, occupied);
+			EXPECT_EQ(alt_pf.find_path(start, goal, occupied).size(), expected.size());
+			EXPECT_EQ(alt_pf.find_path_bidirectional(start, goal, occupied).size(), expected.size());
+			if (!expected.empty()) {
+				EXPECT_LE(landmarks.estimate(start, goal), static_cast<float>(expected.size()));
+			}
+		}
+
+		// Given landmarks build the same tables in parallel
+		const landmark_heuristic rebuilt(bf, landmarks.get_landmarks());
+		EXPECT_EQ(rebuilt.estimate(point_2d(0, 0), point_2d(39, 39)), landmarks.estimate(point_2d(0, 0), point_2d(39, 39)));
+	}
+
+	/// <summary>
+	/// Landmarks are exact along a corridor, so A* expands only the path
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, landmark_heuristic_corridor_test) {
+		// Serpentine corridor: walls on every odd row with a gap at alternating ends
+		const int width = 9;
+		const int height = 9;
+		std::vector<tile_type> tiles(width * height, tile_type::walkable);
+		for (int y = 1; y < height; y += 2)
+			for (int x = 0; x < width; ++x)
+				if (x != ((y / 2) % 2 == 0 ? width - 1 : 0))
+					tiles[y * width + x] = tile_type::elevated;
+		battle_field bf;
+		bf.load_from_tiles(width, height, tiles);
+
+		const landmark_heuristic landmarks(bf, 2);
+		EXPECT_EQ(landmarks.estimate(point_2d(0, 0), point_2d(0, 8)), 40.0f);
+
+		pathfinder pf(bf);
+		pf.set_landmarks(&landmarks);
+		const auto before = pf.get_expanded_node_count();
+		EXPECT_EQ(pf.find_path(point_2d(0, 0), point_2d(0, 8), {}).size(), 40u);
+		EXPECT_EQ(pf.get_expanded_node_count() - before, 40u);
+
+		// Copies keep the landmarks and start with their own counters
+		const pathfinder copy = pf;
+		EXPECT_EQ(copy.get_landmarks(), &landmarks);
+		EXPECT_EQ(copy.get_expanded_node_count(), 0u);
+		EXPECT_EQ(copy.find_path(point_2d(0, 0), point_2d(0, 8), {}).size(), 40u);
+		EXPECT_EQ(copy.get_expanded_node_count(), 40u);
+	}
+
+	/// <summary>
+	/// Paths read from the path database are optimal and the database survives a save and memory mapped load
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, compressed_path_database_test) {
+		battle_field bf;
+		bf.generate_random_field(24, 20, 0, 150, 5);
+		const auto built = compressed_path_database::build(bf);
+		const auto filename = testing::TempDir() + "compressed_path_database_test.cpd";
+		built.save(filename);
+		const auto database = compressed_path_database::load(filename, bf);
+		EXPECT_EQ(database.get_run_count(), built.get_run_count());
+
+		pathfinder pf(bf);
+		pathfinder cpd_pf(bf);
+		cpd_pf.set_path_database(&database);
+		const std::unordered_set<point_2d> occupied;
+		for (int y = 0; y < 20; y += 3) {
+			for (int x = 0; x < 24; x += 2) {
+				const point_2d start(x, y);
+				const point_2d goal(23 - x, 19 - y / 2);
+				const auto expected = pf.find_path(start, goal, occupied);
+				const auto path = cpd_pf.find_path_from_database(start, goal, occupied);
+				ASSERT_EQ(path.size(), expected.size());
+				auto previous = start;
+				for (const auto& p : path) {
+					EXPECT_EQ(previous.manhattan_distance(p), 1);
+					EXPECT_TRUE(bf.is_walkable(p));
+					previous = p;
+				}
+			}
+		}
+
+		// Occupied cells on the stored path make it search instead
+		const std::unordered_set<point_2d> blocked{ database.extract_path(point_2d(0, 0), point_2d(23, 19)).front() };
+		const auto detour = cpd_pf.find_path_from_database(point_2d(0, 0), point_2d(23, 19), blocked);
+		EXPECT_EQ(detour, pf.find_path(point_2d(0, 0), point_2d(23, 19), blocked));
+
+		// A database does not load for another map
+		battle_field other;
+		other.generate_random_field(24, 20, 0, 150, 6);
+		EXPECT_THROW(compressed_path_database::load(filename, other), std::runtime_error);
+		std::remove(filename.c_str());
+	}
+
+	/// <summary>
+	/// A restored snapshot replays the same ticks as the captured simulation
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, simulation_snapshot_test) {
+		battle_field bf;
+		bf.generate_random_field(30, 20, 4, 60, 11);
+		pathfinder pf(bf);
+		const auto targets = bf.get_target_positions();
+		std::vector<unit> units;
+		std::unordered_set<point_2d> occupied;
+		for (const auto& start : bf.get_start_positions()) {
+			units.emplace_back(start, pf);
+			occupied.insert(start);
+		}
+		const auto run_ticks = [&](const int count) {
+			std::vector<point_2d> positions;
+			for (int tick = 0; tick < count; ++tick)
+				for (auto& u : units) {
+					u.move_to_nearest(targets, occupied);
+					positions.push_back(u.get_position());
+				}
+			return positions;
+		};
+		run_ticks(3);
+
+		simulation_snapshot snapshot;
+		snapshot.capture(3, bf, units, occupied);
+		const auto filename = testing::TempDir() + "simulation_snapshot_test.bin";
+		snapshot.save(filename);
+		const auto map_hash = bf.get_content_hash();
+		const auto positions = run_ticks(5);
+		bf.set_tiles(point_2d(0, 0), point_2d(29, 0), tile_type::elevated);
+		bf.load_from_tiles(30, 20, bf.get_row_major_tiles());
+		EXPECT_EQ(bf.get_seed(), 0u);
+
+		simulation_snapshot loaded;
+		loaded.load(filename);
+		EXPECT_EQ(loaded.get_size(), snapshot.get_size());
+		EXPECT_EQ(loaded.get_tick(), 3u);
+		EXPECT_EQ(loaded.get_unit_count(), units.size());
+		loaded.restore(bf, units, occupied);
+		EXPECT_EQ(bf.get_content_hash(), map_hash);
+		EXPECT_EQ(bf.get_seed(), 11u);
+		EXPECT_EQ(run_ticks(5), positions);
+
+		// Corrupted counts and paths of the right total size are rejected by load, before restore could read past the image
+		std::stringstream image_stream;
+		snapshot.save(image_stream);
+		const auto image = image_stream.str();
+		const auto load_patched = [&](const size_t offset, const auto value) {
+			auto bytes = image;
+			std::memcpy(bytes.data() + offset, &value, sizeof(value));
+			std::stringstream stream(bytes);
+			simulation_snapshot patched;
+			patched.load(stream, bytes.size());
+		};
+		std::uint64_t start_count = 0, target_count = 0;
+		std::memcpy(&start_count, image.data() + 48, sizeof(start_count));
+		std::memcpy(&target_count, image.data() + 56, sizeof(target_count));
+		const auto first_unit = 88 + 600 + (start_count + target_count) * sizeof(point_2d);
+		std::uint32_t path_length = 0;
+		std::memcpy(&path_length, image.data() + first_unit + 20, sizeof(path_length));
+		EXPECT_NO_THROW(load_patched(first_unit + 20, path_length));
+		EXPECT_THROW(load_patched(first_unit + 20, path_length + 400), std::runtime_error);
+		EXPECT_THROW(load_patched(first_unit + 16, path_length + 1), std::runtime_error);
+		EXPECT_THROW(load_patched(24, std::int32_t(0x7fffffff)), std::runtime_error);
+		EXPECT_THROW(load_patched(64, std::uint64_t(1) << 61), std::runtime_error);
+		EXPECT_THROW(load_patched(72, ~std::uint64_t(0)), std::runtime_error);
+
+		// The unit count has to match
+		units.pop_back();
+		EXPECT_THROW(loaded.restore(bf, units, occupied), std::runtime_error);
+		std::remove(filename.c_str());
+	}
+
+	/// <summary>
+	/// A recorded run replays with identical outcomes, and a changed outcome is reported
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, event_log_replay_test) {
+		battle_field bf;
+		bf.generate_random_field(30, 20, 5, 80, 21);
+		pathfinder pf(bf);
+		std::vector<unit> units;
+		std::unordered_set<point_2d> occupied;
+		for (const auto& start : bf.get_start_positions()) {
+			units.emplace_back(start, pf);
+			occupied.insert(start);
+		}
+
+		event_log log;
+		log.begin(bf, units, occupied);
+		for (int tick = 0; tick < 30; ++tick) {
+			if (tick == 4)
+				log.set_tiles(bf, point_2d(10, 5), point_2d(12, 14), tile_type::elevated);
+			for (size_t i = 0; i < units.size(); ++i)
+				log.move_to_nearest(units, i, bf, occupied);
+			log.end_tick(bf);
+		}
+		EXPECT_EQ(log.get_tick_count(), 30u);
+
+		const auto filename = testing::TempDir() + "event_log_test.bin";
+		log.save(filename);
+		event_log loaded;
+		loaded.load(filename);
+		EXPECT_EQ(loaded.get_events().size(), log.get_events().size());
+		EXPECT_EQ(loaded.get_events().front().type, event_type::seed);
+
+		const auto result = loaded.replay();
+		EXPECT_TRUE(result.identical());
+		EXPECT_EQ(result.ticks, 30u);
+		EXPECT_EQ(result.moves, 30u * units.size());
+		EXPECT_GE(result.replans, units.size());
+
+		// Change the logged position of the first move, which follows the seed
+		{
+			std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(-static_cast<std::streamoff>((loaded.get_events().size() - 1) * sizeof(event)) + 16, std::ios::end);
+			const std::int32_t x = -1;
+			file.write(reinterpret_cast<const char*>(&x), sizeof(x));
+		}
+		loaded.load(filename);
+		const auto tampered = loaded.replay();
+		EXPECT_FALSE(tampered.identical());
+		EXPECT_EQ(tampered.first_mismatch, 1u);
+
+		// A log of another map reports its seed
+		{
+			std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(-static_cast<std::streamoff>(loaded.get_events().size() * sizeof(event)) + 8, std::ios::end);
+			const std::uint64_t seed = 22;
+			file.write(reinterpret_cast<const char*>(&seed), sizeof(seed));
+		}
+		loaded.load(filename);
+		EXPECT_EQ(loaded.replay().first_mismatch, 0u);
+		std::remove(filename.c_str());
+	}
+
+	/// <summary>
+	/// Compact paths decode to the same steps as the vector paths at 2 bits per step
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, compact_path_test) {
+		battle_field bf;
+		bf.generate_random_field(40, 30, 0, 200, 8);
+		pathfinder pf(bf);
+		const std::unordered_set<point_2d> occupied;
+
+		const point_2d start(0, 0);
+		const point_2d goal(39, 29);
+		const auto expected = pf.find_path(start, goal, occupied);
+		ASSERT_FALSE(expected.empty());
+		const auto path = pf.find_compact_path(start, goal, occupied);
+		EXPECT_EQ(path.size(), expected.size());
+		EXPECT_EQ(path.get_start(), start);
+		EXPECT_EQ(path.to_points(), expected);
+		EXPECT_LT(path.get_memory_size() * 16, expected.size() * sizeof(point_2d));
+
+		size_t reached = 0;
+		size_t compact_reached = 0;
+		const std::vector<point_2d> targets{ point_2d(39, 0), point_2d(0, 29), point_2d(20, 15) };
+		const auto nearest = pf.find_compact_path_to_nearest(point_2d(38, 28), targets, occupied, compact_reached);
+		EXPECT_EQ(nearest.to_points(), pf.find_path_to_nearest(point_2d(38, 28), targets, occupied, reached));
+		EXPECT_EQ(compact_reached, reached);
+
+		// Encoding from points gives the same codes, points must be adjacent
+		const compact_path encoded(start, expected);
+		EXPECT_EQ(encoded.to_points(), expected);
+		EXPECT_TRUE(std::equal(encoded.get_codes(), encoded.get_codes() + (expected.size() + 3) / 4, path.get_codes()));
+		EXPECT_THROW(compact_path(start, { point_2d(2, 0) }), std::invalid_argument);
+
+		// A unit follows it step by step
+		unit u(start, pf);
+		std::unordered_set<point_2d> unit_occupied{ start };
+		for (size_t i = 0; i < expected.size(); ++i) {
+			ASSERT_EQ(u.move(goal, unit_occupied), move_status::moved);
+			EXPECT_EQ(u.get_position(), expected[i]);
+		}
+		EXPECT_EQ(u.move(goal, unit_occupied), move_status::at_target);
+	}
+
+	/// <summary>
+	/// A time sliced search finds paths as short as find_path and gives partial paths while running
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, incremental_search_test) {
+		battle_field bf;
+		bf.generate_random_field(40, 30, 0, 200, 8);
+		pathfinder pf(bf);
+		const std::unordered_set<point_2d> occupied;
+		const point_2d start(0, 0);
+		const point_2d goal(39, 29);
+		const auto expected = pf.find_path(start, goal, occupied);
+		ASSERT_FALSE(expected.empty());
+
+		incremental_search search(pf, start, goal);
+		EXPECT_EQ(search.advance(20, occupied), search_state::running);
+		compact_path partial;
+		search.get_path(start, partial);
+		ASSERT_FALSE(partial.empty());
+		EXPECT_EQ(partial.to_points().back(), search.get_best_node());
+		EXPECT_LT(search.get_best_node().manhattan_distance(goal), start.manhattan_distance(goal));
+
+		// A later partial path can be taken from any cell of an earlier one
+		const auto cell = partial.to_points().front();
+		while (search.advance(20, occupied) == search_state::running) {}
+		ASSERT_EQ(search.get_state(), search_state::found);
+		compact_path path;
+		search.get_path(start, path);
+		EXPECT_EQ(path.size(), expected.size());
+		search.get_path(cell, path);
+		EXPECT_EQ(path.to_points().back(), goal);
+
+		// Corridor: the only way is occupied when the search reaches it and freed on a later tick
+		battle_field corridor;
+		std::vector<tile_type> tiles(10 * 3, tile_type::elevated);
+		for (int x = 0; x < 10; ++x)
+			tiles[10 + x] = tile_type::walkable;
+		corridor.load_from_tiles(10, 3, tiles);
+		pathfinder corridor_pf(corridor);
+		incremental_search blocked_search(corridor_pf, point_2d(0, 1), point_2d(9, 1));
+		std::unordered_set<point_2d> unit_in_the_way{ point_2d(3, 1) };
+		EXPECT_EQ(blocked_search.advance(2, unit_in_the_way), search_state::running);
+		EXPECT_EQ(blocked_search.advance(1, unit_in_the_way), search_state::running);
+		unit_in_the_way.clear();
+		EXPECT_EQ(blocked_search.advance(100, unit_in_the_way), search_state::found);
+		blocked_search.get_path(point_2d(0, 1), path);
+		EXPECT_EQ(path.size(), 9u);
+
+		// Still occupied: no path
+		incremental_search no_path_search(corridor_pf, point_2d(0, 1), point_2d(9, 1));
+		EXPECT_EQ(no_path_search.advance(100, { point_2d(3, 1) }), search_state::no_path);
+
+		// A unit starts moving before its search is done and gets there
+		unit u(start, pf);
+		std::unordered_set<point_2d> unit_occupied{ start };
+		EXPECT_EQ(u.move_incremental(goal, unit_occupied, 10), move_status::moved);
+		int calls = 1;
+		while (u.move_incremental(goal, unit_occupied, 10) != move_status::at_target && calls < 1000)
+			calls++;
+		EXPECT_EQ(u.get_position(), goal);
+	}
+
+	/// <summary>
+	/// The scheduler serves close requests first, ages waiting ones and hands results back on later ticks
+	/// </summary>
+	/// <param name=""></param>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, replan_scheduler_test) {
+		battle_field bf;
+		bf.load_from_tiles(40, 40, std::vector<tile_type>(40 * 40, tile_type::walkable));
+		pathfinder pf(bf);
+		const std::unordered_set<point_2d> occupied;
+
+		// No budget: one request per tick
+		replan_scheduler scheduler(pf, std::chrono::microseconds(0), 4);
+		const auto far = scheduler.submit(point_2d(0, 0), point_2d(39, 39));
+		const auto near = scheduler.submit(point_2d(0, 0), point_2d(3, 0));
+		EXPECT_EQ(scheduler.get_metrics().queue_depth, 2u);
+
+		compact_path path;
+		EXPECT_FALSE(scheduler.take_result(near, path));
+		scheduler.service(occupied);
+		EXPECT_EQ(scheduler.get_metrics().served_last_tick, 1u);
+		EXPECT_TRUE(scheduler.take_result(near, path));
+		EXPECT_EQ(path.size(), 3u);
+		EXPECT_FALSE(scheduler.take_result(near, path));
+		EXPECT_TRUE(scheduler.is_pending(far));
+
+		// A close request every tick, the far one ages past them after (78 - 3) / 4 ticks
+		std::uint64_t newer = 0;
+		for (int tick = 1; tick < 19; ++tick) {
+			newer = scheduler.submit(point_2d(0, 0), point_2d(3, 0));
+			scheduler.service(occupied);
+			EXPECT_TRUE(scheduler.take_result(newer, path));
+		}
+		EXPECT_TRUE(scheduler.is_pending(far));
+		newer = scheduler.submit(point_2d(0, 0), point_2d(3, 0));
+		scheduler.service(occupied);
+		EXPECT_TRUE(scheduler.take_result(far, path));
+		EXPECT_EQ(path.size(), 78u);
+		EXPECT_TRUE(scheduler.is_pending(newer));
+		EXPECT_EQ(scheduler.get_metrics().max_wait_ticks, 19u);
+		EXPECT_EQ(scheduler.get_metrics().queue_depth, 1u);
+
+		// Cancelled requests are skipped
+		scheduler.cancel(newer);
+		scheduler.service(occupied);
+		EXPECT_EQ(scheduler.get_metrics().served_last_tick, 0u);
+		EXPECT_EQ(scheduler.get_metrics().served_total, 20u);
+
+		// A large budget serves everything at once, units wait for their paths
+		scheduler.set_budget(std::chrono::seconds(1));
+		std::vector<unit> units;
+		std::unordered_set<point_2d> unit_occupied;
+		for (int i = 0; i < 5; ++i) {
+			units.emplace_back(point_2d(0, i * 2), pf);
+			unit_occupied.insert(point_2d(0, i * 2));
+		}
+		for (auto& u : units)
+			EXPECT_EQ(u.move_scheduled(point_2d(39, 20), unit_occupied, scheduler), move_status::searching);
+		EXPECT_EQ(scheduler.get_metrics().queue_depth, 5u);
+		scheduler.service(unit_occupied);
+		EXPECT_EQ(scheduler.get_metrics().served_last_tick, 5u);
+		EXPECT_EQ(units[0].move_scheduled(point_2d(39, 20), unit_occupied, scheduler), move_status::moved);
+	}
+
+	/// <summary>
+	/// Test the path service answers a pipelined batch in order, with an error line for a bad query
+	/// and for points outside the grid, the queries after them are still answered
+	/// </summary>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, path_service_test) {
+		battle_field bf;
+		bf.load_from_tiles(20, 20, std::vector<tile_type>(20 * 20, tile_type::walkable));
+		pathfinder pf(bf);
+
+		std::stringstream queries;
+		for (int i = 0; i < 40; ++i)
+			queries << "{\"id\": " << i << ", \"start\": [0, 0], \"goal\": [" << i % 20 << ", " << i / 2 << "]"
+				<< (i % 3 == 0 ? ", \"engine\": \"bidirectional\"" : "") << "}\n";
+		queries << "{\"id\": \"bad\", \"start\": [0, 0]}\n";
+		queries << "{\"id\": \"far\", \"start\": [-2000000, -2000000], \"goal\": [3, 3]}\n";
+		queries << "{\"id\": \"off\", \"start\": [0, 0], \"goal\": [20, 5], \"engine\": \"bidirectional\"}\n";
+		queries << "\n{\"start\": [0, 0], \"goal\": [1, 0], \"occupied\": [[1, 0]]}\n";
+
+		// Four workers and a small window, so the reader has to wait and responses complete out of order
+		const path_service service(pf, 4, 3);
+		std::stringstream responses;
+		const auto stats = service.run(queries, responses);
+		EXPECT_EQ(stats.requests, 44u);
+		EXPECT_EQ(stats.errors, 3u);
+		EXPECT_GE(stats.max_latency, stats.total_latency / 44);
+
+		std::string line;
+		for (int i = 0; i < 40; ++i) {
+			ASSERT_TRUE(std::getline(responses, line));
+			EXPECT_EQ(line.find("{\"id\":" + std::to_string(i) + ","), 0u) << line;
+			const auto length = i % 20 + i / 2;
+			EXPECT_NE(line.find("\"length\":" + std::to_string(length) + ","), std::string::npos) << line;
+			EXPECT_NE(line.find("\"latency_us\":"), std::string::npos) << line;
+		}
+		ASSERT_TRUE(std::getline(responses, line));
+		EXPECT_EQ(line.find("{\"error\":"), 0u) << line;
+		EXPECT_NE(line.find("\"id\":\"bad\""), std::string::npos) << line;
+		for (const auto* id : { "far", "off" }) {
+			ASSERT_TRUE(std::getline(responses, line));
+			EXPECT_NE(line.find("inside the 20x20 grid"), std::string::npos) << line;
+			EXPECT_NE(line.find(std::string("\"id\":\"") + id + "\""), std::string::npos) << line;
+		}
+		ASSERT_TRUE(std::getline(responses, line));
+		EXPECT_NE(line.find("\"length\":1,"), std::string::npos) << line;
+		EXPECT_FALSE(std::getline(responses, line));
+	}
+
+	/// <summary>
+	/// Test the unit store moves its units exactly like unit objects, and reuses the slots of its path buffer
+	/// </summary>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, unit_store_test) {
+		battle_field bf;
+		bf.generate_random_field(32, 32, 16, 150, 5);
+		pathfinder pf(bf);
+		const auto& targets = bf.get_target_positions();
+
+		// Without conflict resolution the store follows the rules of unit objects
+		std::vector<unit> units;
+		unit_store store(pf);
+		conflict_resolution unit_rules;
+		unit_rules.enabled = false;
+		store.set_conflict_resolution(unit_rules);
+		std::unordered_set<point_2d> occupied, store_occupied;
+		for (const auto& start : bf.get_start_positions()) {
+			units.emplace_back(start, pf);
+			EXPECT_EQ(store.add(start), units.size() - 1);
+			occupied.insert(start);
+		}
+		store_occupied = occupied;
+		ASSERT_EQ(store.size(), units.size());
+
+		// Units print their replans
+		std::stringstream sink;
+		auto* const console = std::cout.rdbuf(sink.rdbuf());
+		size_t path_memory = 0;
+		for (int tick = 0; tick < 25; ++tick) {
+			size_t moved = 0;
+			for (size_t i = 0; i < units.size(); ++i) {
+				const auto status = units[i].move_to_nearest(targets, occupied);
+				moved += status == move_status::moved ? 1 : 0;
+				if (tick == 0) {
+					EXPECT_EQ(store[static_cast<unit_store::unit_id>(i)].move_to_nearest(targets, store_occupied), status);
+				}
+			}
+			if (tick > 0) {
+				EXPECT_EQ(store.tick_to_nearest(targets, store_occupied), moved);
+			}
+			if (tick == 10)
+				path_memory = store.get_path_memory_size();
+
+			for (unit_store::unit_id id = 0; id < store.size(); ++id) {
+				ASSERT_EQ(store.get_position(id), units[id].get_position()) << "unit " << id << " tick " << tick;
+				if (store.get_path_length(id) > 0) {
+					EXPECT_EQ(store.get_path_index(id), units[id].get_path_index());
+					EXPECT_EQ(store[id].get_path().to_points(), units[id].get_path().to_points());
+				}
+			}
+		}
+		std::cout.rdbuf(console);
+		EXPECT_EQ(store_occupied, occupied);
+		EXPECT_LE(store.get_path_memory_size(), path_memory * 2);
+
+		// Own targets, a new target drops the path
+		unit_store own(pf);
+		std::unordered_set<point_2d> own_occupied;
+		const auto id = own.add(point_2d(0, 0));
+		own_occupied.insert(point_2d(0, 0));
+		const auto target = pf.find_path(point_2d(0, 0), targets[0], own_occupied).empty() ? point_2d(0, 0) : targets[0];
+		own.set_target(id, target);
+		while (own.tick(own_occupied) > 0) {}
+		EXPECT_EQ(own.get_position(id), target);
+		EXPECT_EQ(own.get_status(id), move_status::at_target);
+		own.set_target(id, point_2d(0, 0));
+		EXPECT_EQ(own.get_path_length(id), 0u);
+	}
+
+	/// <summary>
+	/// Test the unit store follows a battlefield reloaded with another size: units replan on the larger grid, a unit left
+	/// outside a smaller grid finds no path, and a unit standing on a new wall walks off it
+	/// </summary>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, unit_store_resized_map_test) {
+		battle_field bf;
+		bf.load_from_tiles(8, 8, std::vector<tile_type>(8 * 8, tile_type::walkable));
+		const pathfinder pf(bf);
+		unit_store store(pf);
+		std::unordered_set<point_2d> occupied;
+		for (const auto& start : { point_2d(0, 0), point_2d(7, 7) }) {
+			store.add(start);
+			occupied.insert(start);
+		}
+		store.set_target(0, point_2d(7, 0));
+		store.set_target(1, point_2d(0, 7));
+		store.tick(occupied);
+		store.tick(occupied);
+
+		// Larger grid, both targets lie beyond the old one
+		bf.load_from_tiles(32, 16, std::vector<tile_type>(32 * 16, tile_type::walkable));
+		store.set_target(0, point_2d(31, 15));
+		store.set_target(1, point_2d(5, 5));
+		for (int tick = 0; tick < 200; ++tick)
+			store.tick(occupied);
+		EXPECT_EQ(store.get_position(0), point_2d(31, 15));
+		EXPECT_EQ(store.get_position(1), point_2d(5, 5));
+		EXPECT_EQ(store.get_status(0), move_status::at_target);
+
+		// Smaller grid with a wall under the second unit
+		std::vector<tile_type> tiles(10 * 10, tile_type::walkable);
+		tiles[5 * 10 + 5] = tile_type::elevated;
+		bf.load_from_tiles(10, 10, tiles);
+		store.set_target(0, point_2d(1, 1));
+		store.set_target(1, point_2d(2, 2));
+		for (int tick = 0; tick < 50; ++tick)
+			store.tick(occupied);
+		EXPECT_EQ(store.get_position(0), point_2d(31, 15));
+		EXPECT_NE(store.get_status(0), move_status::moved);
+		EXPECT_EQ(store.get_position(1), point_2d(2, 2));
+		EXPECT_EQ(store.get_status(1), move_status::at_target);
+	}
+
+	/// <summary>
+	/// Test head on units swap, a wait-for cycle rotates and a unit behind a parked one backs off instead of searching every tick
+	/// </summary>
+	/// <param name=""></param>
+	TEST(path_finding_unit_tests, conflict_resolution_test) {
+
+		// Corridor one tile wide on the middle row, entered from the columns at both ends, and a pocket above it
+		std::vector<tile_type> tiles(12 * 5, tile_type::elevated);
+		for (int x = 0; x < 12; ++x)
+			tiles[2 * 12 + x] = tile_type::walkable;
+		for (int y = 0; y < 5; ++y)
+			tiles[y * 12] = tiles[y * 12 + 11] = tile_type::walkable;
+		tiles[1 * 12 + 5] = tile_type::walkable;
+		battle_field corridor;
+		corridor.load_from_tiles(12, 5, tiles);
+		pathfinder pf(corridor);
+
+		// Both plan through the empty corridor and meet head on
+		const auto head_on = [&](unit_store& store, std::unordered_set<point_2d>& occupied, const int ticks) {
+			occupied = { point_2d(0, 0), point_2d(11, 4) };
+			store.set_target(store.add(point_2d(0, 0)), point_2d(11, 0));
+			store.set_target(store.add(point_2d(11, 4)), point_2d(0, 4));
+			for (int tick = 0; tick < ticks; ++tick)
+				store.tick(occupied);
+		};
+		unit_store store(pf);
+		std::unordered_set<point_2d> occupied;
+		head_on(store, occupied, 20);
+		EXPECT_EQ(store.get_position(0), point_2d(11, 0));
+		EXPECT_EQ(store.get_position(1), point_2d(0, 4));
+		EXPECT_EQ(store.get_status(0), move_status::at_target);
+		EXPECT_EQ(store.get_conflict_metrics().swaps, 1u);
+		EXPECT_EQ(store.get_conflict_metrics().searches, 2u);
+		EXPECT_EQ(occupied, (std::unordered_set<point_2d>{ point_2d(11, 0), point_2d(0, 4) }));
 
+		// Without resolution both search again on every tick and never get past each other
+		unit_store storm(pf);
+		conflict_resolution unit_rules;
+		unit_rules.enabled = false;
+		storm.set_conflict_resolution(unit_rules);
+		head_on(storm, occupied, 100);
+		EXPECT_NE(storm.get_position(0), point_2d(11, 0));
+		EXPECT_GT(storm.get_conflict_metrics().searches, 50u);
 
+		// A unit parks in the corridor after the other one planned: detour, no path, back off 1, 2, 4, ... ticks
+		unit_store parked(pf);
+		occupied = { point_2d(0, 0), point_2d(5, 1) };
+		parked.set_target(parked.add(point_2d(0, 0)), point_2d(11, 0));
+		parked.set_target(parked.add(point_2d(5, 1)), point_2d(5, 2));
+		std::vector<move_status> statuses;
+		for (int tick = 0; tick < 200; ++tick) {
+			parked.tick(occupied);
+			statuses.push_back(parked.get_status(0));
+		}
+		EXPECT_EQ(parked.get_position(0), point_2d(4, 2));
+		EXPECT_EQ(parked.get_status(1), move_status::at_target);
+		EXPECT_NE(std::find(statuses.begin(), statuses.end(), move_status::detoured), statuses.end());
+		EXPECT_NE(std::find(statuses.begin(), statuses.end(), move_status::no_path), statuses.end());
+		EXPECT_EQ(statuses.back(), move_status::yielding);
+		EXPECT_LT(parked.get_conflict_metrics().searches, 15u);
+
+		// Four units in a square, each heading for the next one's cell
+		battle_field open;
+		open.load_from_tiles(4, 4, std::vector<tile_type>(16, tile_type::walkable));
+		pathfinder open_pf(open);
+		unit_store ring(open_pf);
+		const point_2d square[] = { point_2d(1, 1), point_2d(2, 1), point_2d(2, 2), point_2d(1, 2) };
+		occupied.clear();
+		for (int i = 0; i < 4; ++i) {
+			ring.set_target(ring.add(square[i]), square[(i + 1) % 4]);
+			occupied.insert(square[i]);
+		}
+		for (int tick = 0; tick < 4; ++tick)
+			ring.tick(occupied);
+		for (unit_store::unit_id id = 0; id < 4; ++id)
+			EXPECT_EQ(ring.get_position(id), square[(id + 1) % 4]);
+		EXPECT_EQ(ring.get_conflict_metrics().cycles, 1u);
+		EXPECT_EQ(ring.get_conflict_metrics().detours, 0u);
+
+		// Back and forth between two cells
+		unit_store pendulum(open_pf);
+		occupied = { point_2d(1, 0) };
+		const auto id = pendulum.add(point_2d(1, 0));
+		move_status status = move_status::moved;
+		for (int tick = 0; tick < 4 && status == move_status::moved; ++tick) {
+			pendulum.set_target(id, tick % 2 == 0 ? point_2d(3, 0) : point_2d(0, 0));
+			status = pendulum.tick(occupied) > 0 ? pendulum.get_status(id) : move_status::blocked;
+		}
+		EXPECT_EQ(status, move_status::oscillating);
+		EXPECT_EQ(pendulum.get_conflict_metrics().oscillations, 1u);
+	}
+
+	/// <summary>
+	/// Seeded simulations give the same report on any number of threads, manifests load maps relative to themselves
+	/// </summary>
+	TEST(path_finding_unit_tests, scenario_runner_test) {
+		scenario_runner runner;
+		battle_field small;
+		small.generate_random_field(24, 24, 0, 60, 3);
+		runner.add_map("small", small);
+		runner.add_scenario({ "crowd", "small", 12, 1, 6, 200, scenario_goal::nearest });
+		runner.add_scenario({ "assigned", "small", 8, 50, 4, 200, scenario_goal::assigned });
+		EXPECT_THROW(runner.add_scenario({ "lost", "missing" }), std::invalid_argument);
+
+		const auto single = runner.run(1);
+		const auto parallel = runner.run(4);
+		EXPECT_EQ(single.simulations, 10u);
+		EXPECT_EQ(parallel.threads, 4u);
+		ASSERT_EQ(single.scenarios.size(), 2u);
+		ASSERT_EQ(parallel.scenarios.size(), 2u);
+		for (size_t i = 0; i < 2; ++i) {
+			EXPECT_EQ(single.scenarios[i].runs, parallel.scenarios[i].runs);
+			EXPECT_EQ(single.scenarios[i].arrived, parallel.scenarios[i].arrived);
+			EXPECT_EQ(single.scenarios[i].ticks, parallel.scenarios[i].ticks);
+			EXPECT_EQ(single.scenarios[i].conflicts.searches, parallel.scenarios[i].conflicts.searches);
+		}
+		EXPECT_EQ(single.scenarios[0].units, 6u * 12u);
+		EXPECT_EQ(single.scenarios[1].units, 4u * 8u);
+		EXPECT_GT(single.scenarios[0].arrived, 0u);
+		EXPECT_EQ(single.unit_ticks, parallel.unit_ticks);
+
+		// Same seed, same simulation
+		const auto first = scenario_runner::simulate(small, runner.get_scenarios()[0], 1);
+		const auto again = scenario_runner::simulate(small, runner.get_scenarios()[0], 1);
+		EXPECT_EQ(first.ticks, again.ticks);
+		EXPECT_EQ(first.arrived, again.arrived);
+
+		const auto json = parallel.to_json();
+		EXPECT_NE(json.find("\"simulations_per_second\""), std::string::npos);
+		EXPECT_NE(json.find("\"assigned\""), std::string::npos);
+
+		// Manifest with a generated map
+		const auto filename = testing::TempDir() + "scenario_runner_test.json";
+		{
+			std::ofstream file(filename);
+			file << R"({"maps": {"open": {"width": 16, "height": 16, "terrains": 20, "seed": 9}},
+				"scenarios": [{"name": "open", "map": "open", "units": 4, "runs": 3, "goal": "assigned"}]})";
+		}
+		const auto loaded = scenario_runner::load(filename);
+		ASSERT_EQ(loaded.get_scenarios().size(), 1u);
+		EXPECT_EQ(loaded.get_scenarios()[0].goal, scenario_goal::assigned);
+		EXPECT_EQ(loaded.run(2).scenarios[0].units, 12u);
+		std::remove(filename.c_str());
+	}
+
+	/// <summary>
+	/// Goal bounded searches find paths as short as plain A* with fewer expansions, with and without occupancy
+	/// </summary>
+	TEST(path_finding_unit_tests, goal_bounds_test) {
+		battle_field bf;
+		bf.generate_random_field(24, 20, 0, 150, 5);
+		const auto built = goal_bounds::build(bf);
+		const auto filename = testing::TempDir() + "goal_bounds_test.gb";
+		built.save(filename);
+		const auto bounds = goal_bounds::load(filename, bf);
+		EXPECT_EQ(bounds.get_memory_size(), 24u * 20u * 4u * sizeof(goal_bounds::bounding_box));
+
+		pathfinder pf(bf);
+		pathfinder bounded_pf(bf);
+		bounded_pf.set_goal_bounds(&bounds);
+		std::unordered_set<point_2d> occupied;
+		for (int y = 0; y < 20; y += 3) {
+			for (int x = 0; x < 24; x += 2) {
+				const point_2d start(x, y);
+				const point_2d goal(23 - x, 19 - y / 2);
+				const auto expected = pf.find_path(start, goal, occupied);
+				const auto path = bounded_pf.find_path(start, goal, occupied);
+				ASSERT_EQ(path.size(), expected.size());
+				if (!path.empty() && bf.is_walkable(start)) {
+					// The first move's box holds the goal
+					size_t move = 0;
+					while (start + goal_bounds::moves[move] != path.front())
+						move++;
+					EXPECT_TRUE(bounds.may_lead_to(start, move, goal));
+				}
+			}
+		}
+		EXPECT_LT(bounded_pf.get_expanded_node_count(), pf.get_expanded_node_count());
+
+		// Units in the way make it search again without pruning
+		for (int i = 0; i < 40; ++i) {
+			const auto p = battle_field::generate_random_point(point_2d(0, 0), point_2d(23, 19));
+			if (bf.is_walkable(p))
+				occupied.insert(p);
+		}
+		for (int i = 0; i < 60; ++i) {
+			const auto start = battle_field::generate_random_point(point_2d(0, 0), point_2d(23, 19));
+			const auto goal = battle_field::generate_random_point(point_2d(0, 0), point_2d(23, 19));
+			EXPECT_EQ(bounded_pf.find_path(start, goal, occupied).size(), pf.find_path(start, goal, occupied).size());
+		}
+
+		// Stale bounds are ignored once a tile changed
+		battle_field changed = bf;
+		pathfinder changed_pf(changed);
+		changed_pf.set_goal_bounds(&bounds);
+		const auto before = pf.find_path(point_2d(0, 0), point_2d(23, 19), {});
+		if (before.size() > 2) {
+			changed.set_tile(before[before.size() / 2], tile_type::elevated);
+			EXPECT_EQ(changed_pf.find_path(point_2d(0, 0), point_2d(23, 19), {}).size(),
+				pathfinder(changed).find_path(point_2d(0, 0), point_2d(23, 19), {}).size());
+
+			// Bounds built before the edit are not taken afterwards
+			pathfinder late_pf(changed);
+			late_pf.set_goal_bounds(&bounds);
+			EXPECT_EQ(late_pf.get_goal_bounds(), nullptr);
+		}
+		EXPECT_EQ(changed_pf.get_goal_bounds(), &bounds);
+
+		// Bounds do not load for another map
+		battle_field other;
+		other.generate_random_field(24, 20, 0, 150, 6);
+		EXPECT_THROW(goal_bounds::load(filename, other), std::runtime_error);
+		std::remove(filename.c_str());
+	}
+
+	/// <summary>
+	/// Cached artifacts are built once per map content, reloaded while they verify and rebuilt when corrupted
+	/// </summary>
+	TEST(path_finding_unit_tests, precompute_cache_test) {
+		const auto directory = testing::TempDir() + "precompute_cache_test";
+		std::filesystem::remove_all(directory);
+		const precompute_cache cache(directory);
+
+		battle_field bf;
+		bf.generate_random_field(20, 16, 0, 80, 11);
+		cache_lookup lookup = cache_lookup::hit;
+		const auto built = cache.load_or_build<goal_bounds>(bf, &lookup);
+		EXPECT_EQ(lookup, cache_lookup::miss);
+		const auto loaded = cache.load_or_build<goal_bounds>(bf, &lookup);
+		EXPECT_EQ(lookup, cache_lookup::hit);
+		EXPECT_EQ(loaded.get_memory_size(), built.get_memory_size());
+		EXPECT_GT(cache.load_or_build<compressed_path_database>(bf, &lookup).get_run_count(), 0u);
+		EXPECT_EQ(lookup, cache_lookup::miss);
+
+		// Same content from another object hits, other content gets another entry
+		battle_field copy = bf;
+		EXPECT_EQ(cache.get_filename(copy, goal_bounds::file_extension), cache.get_filename(bf, goal_bounds::file_extension));
+		battle_field other;
+		other.generate_random_field(20, 16, 0, 80, 12);
+		EXPECT_NE(cache.get_filename(other, goal_bounds::file_extension), cache.get_filename(bf, goal_bounds::file_extension));
+
+		// A flipped byte fails the checksum and the entry is rebuilt
+		const auto filename = cache.get_filename(bf, goal_bounds::file_extension);
+		{
+			std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekg(40);
+			const auto byte = static_cast<char>(file.get());
+			file.seekp(40);
+			file.put(static_cast<char>(~byte));
+		}
+		cache.load_or_build<goal_bounds>(bf, &lookup);
+		EXPECT_EQ(lookup, cache_lookup::corrupt);
+		cache.load_or_build<goal_bounds>(bf, &lookup);
+		EXPECT_EQ(lookup, cache_lookup::hit);
+
+		// Background build for a new map, a ready future for a known one
+		auto pending = cache.load_or_build_async<goal_bounds>(other, &lookup);
+		EXPECT_EQ(lookup, cache_lookup::miss);
+		const auto background = pending.get();
+		EXPECT_EQ(background.get_memory_size(), 20u * 16u * 4u * sizeof(goal_bounds::bounding_box));
+		auto ready = cache.load_or_build_async<goal_bounds>(other, &lookup);
+		EXPECT_EQ(lookup, cache_lookup::hit);
+		EXPECT_EQ(ready.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+
+		// The build works on a copy, the battlefield may go away before it finishes
+		std::future<goal_bounds> orphan;
+		{
+			battle_field gone = other;
+			gone.set_tile(point_2d(1, 1), gone.is_walkable(point_2d(1, 1)) ? tile_type::elevated : tile_type::walkable);
+			orphan = cache.load_or_build_async<goal_bounds>(gone, &lookup);
+		}
+		EXPECT_EQ(lookup, cache_lookup::miss);
+		EXPECT_EQ(orphan.get().get_memory_size(), background.get_memory_size());
+
+		// Without a directory every lookup builds and nothing is stored
+		const precompute_cache memory_cache("");
+		EXPECT_EQ(memory_cache.load_or_build<goal_bounds>(bf, &lookup).get_memory_size(), built.get_memory_size());
+		EXPECT_EQ(lookup, cache_lookup::miss);
+		EXPECT_EQ(memory_cache.load_or_build_async<goal_bounds>(bf, &lookup).get().get_memory_size(), built.get_memory_size());
+		EXPECT_EQ(lookup, cache_lookup::miss);
+		EXPECT_FALSE(std::filesystem::exists(memory_cache.get_filename(bf, goal_bounds::file_extension)));
+
+		// Nearest target searches prune with the cached bounds and stay optimal, also around units
+		pathfinder pf(other);
+		pathfinder bounded_pf(other);
+		const auto bounds = ready.get();
+		bounded_pf.set_goal_bounds(&bounds);
+		const std::vector<point_2d> targets = { point_2d(19, 15), point_2d(0, 15), point_2d(10, 0) };
+		std::unordered_set<point_2d> occupied;
+		for (int round = 0; round < 2; ++round) {
+			for (int y = 0; y < 16; y += 3) {
+				for (int x = 0; x < 20; x += 3) {
+					size_t expected_target = 0, reached_target = 0;
+					const auto expected = pf.find_path_to_nearest(point_2d(x, y), targets, occupied, expected_target);
+					const auto path = bounded_pf.find_path_to_nearest(point_2d(x, y), targets, occupied, reached_target);
+					EXPECT_EQ(path.size(), expected.size());
+				}
+			}
+			for (int i = 0; i < 30; ++i)
+				occupied.insert(battle_field::generate_random_point(point_2d(0, 0), point_2d(19, 15)));
+		}
+		EXPECT_LT(bounded_pf.get_expanded_node_count(), pf.get_expanded_node_count());
+		std::filesystem::remove_all(directory);
+	}
+
+	/// <summary>
+	/// Unit logic which requests a path, gives up the tick, then awaits the path
+	/// </summary>
+	/// <param name="executor"></param>
+	/// <param name="start"></param>
+	/// <param name="goal"></param>
+	/// <param name="result"></param>
+	/// <returns></returns>
+	unit_task request_then_await(path_executor& executor, const point_2d start, const point_2d goal,
+		std::optional<std::vector<point_2d>>& result) {
+		auto request = executor.request_path(start, goal);
+		co_await executor.next_tick();
+		result = co_await request;
+	}
+
+	/// <summary>
+	/// Awaited paths come from the workers, results searched before a published map edit are stale, units follow their paths to the targets
+	/// </summary>
+	TEST(path_finding_unit_tests, path_executor_test) {
+		battle_field bf = create_simple_battlefield(16, 8);
+		std::unordered_set<point_2d> occupied;
+		EXPECT_THROW(path_executor(bf, occupied, 1), std::runtime_error);
+		bf.enable_snapshots();
+		path_executor executor(bf, occupied, 2);
+
+		std::optional<std::vector<point_2d>> result;
+		executor.spawn(request_then_await(executor, point_2d(0, 0), point_2d(15, 7), result));
+		for (int i = 0; i < 5000 && executor.get_running_count() > 0; ++i) {
+			executor.tick();
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		ASSERT_TRUE(result.has_value());
+		EXPECT_EQ(result->size(), 22u);
+		EXPECT_EQ(result->back(), point_2d(15, 7));
+
+		// The map changes between the request and the await
+		result.reset();
+		executor.spawn(request_then_await(executor, point_2d(0, 0), point_2d(15, 7), result));
+		executor.tick();
+		bf.set_tile(point_2d(5, 5), tile_type::elevated);
+		bf.publish_changes();
+		for (int i = 0; i < 5000 && executor.get_running_count() > 0; ++i) {
+			executor.tick();
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		EXPECT_FALSE(result.has_value());
+		EXPECT_EQ(executor.get_metrics().stale, 1u);
+
+		// Units in lanes, one lane is walled off half way while the units are under way
+		std::vector<async_unit> units(4);
+		for (int y = 0; y < 4; ++y) {
+			units[y].position = point_2d(0, y);
+			occupied.insert(units[y].position);
+		}
+		for (int y = 0; y < 4; ++y)
+			executor.spawn(follow_path(executor, units[y], point_2d(15, y)));
+		for (int tick = 0; tick < 5000 && executor.get_running_count() > 0; ++tick) {
+			executor.tick();
+			if (tick == 3) {
+				bf.set_tile(point_2d(10, 1), tile_type::elevated);
+				bf.publish_changes();
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		EXPECT_EQ(executor.get_running_count(), 0u);
+		for (int y = 0; y < 4; ++y) {
+			EXPECT_EQ(units[y].status, move_status::at_target);
+			EXPECT_EQ(units[y].position, point_2d(15, y));
+			EXPECT_TRUE(occupied.count(point_2d(15, y)));
+		}
+		EXPECT_GE(executor.get_metrics().requests, 6u);
+		EXPECT_EQ(executor.get_pending_count(), 0u);
+	}
+
+	/// <summary>
+	/// The viewport clamps to the grid, follows positions, and aggregates blocks of tiles at zoomed out levels
+	/// </summary>
+	TEST(path_finding_unit_tests, battle_field_viewport_test) {
+		battle_field bf = create_simple_battlefield(40, 20);
+		bf.set_tile(bf.get_target_positions().front(), tile_type::walkable);
+		bf.set_tile(point_2d(20, 0), tile_type::target);
+		bf.set_tile(point_2d(31, 10), tile_type::elevated);
+		for (int y = 4; y < 8; ++y)
+			for (int x = 8; x < 12; ++x)
+				bf.set_tile(point_2d(x, y), tile_type::elevated);
+		bf.set_tile(point_2d(13, 5), tile_type::elevated);
+
+		battle_field_viewport viewport(bf, 22, 12);
+		EXPECT_EQ(viewport.get_columns(), 10);
+		EXPECT_EQ(viewport.get_rows(), 10);
+		const auto at = [&](const std::vector<battle_field_viewport::cell>& frame, const int x, const int y) {
+			return frame[static_cast<size_t>(y) * viewport.get_frame_width() + x].ch;
+		};
+
+		// Detail level, the window stops at the grid border
+		viewport.center_on(point_2d(39, 19));
+		EXPECT_EQ(viewport.get_origin(), point_2d(30, 10));
+		auto frame = viewport.compose({ point_2d(35, 15), point_2d(2, 2) });
+		ASSERT_EQ(frame.size(), 22u * 12u);
+		EXPECT_EQ(at(frame, 0, 0), '+');
+		EXPECT_EQ(at(frame, 11, 6), 'U');
+		EXPECT_EQ(at(frame, 3, 1), '*');
+		viewport.pan(-100, 0);
+		EXPECT_EQ(viewport.get_origin(), point_2d(0, 10));
+
+		// Blocks of 4x4 show the whole grid, centered vertically
+		EXPECT_EQ(viewport.get_fitting_level(), 2);
+		viewport.set_level(viewport.get_fitting_level());
+		EXPECT_EQ(viewport.get_origin(), point_2d(0, -12));
+		frame = viewport.compose({ point_2d(0, 0), point_2d(1, 2), point_2d(3, 3) });
+		EXPECT_EQ(at(frame, 1, 4), '3');
+		EXPECT_EQ(at(frame, 5, 5), '#');
+		EXPECT_EQ(at(frame, 6, 5), '#');
+		EXPECT_EQ(at(frame, 7, 5), '.');
+		EXPECT_EQ(at(frame, 1, 1), ' ');
+
+		// Edits reach the aggregated levels
+		bf.set_tile(point_2d(13, 5), tile_type::walkable);
+		frame = viewport.compose({});
+		EXPECT_EQ(at(frame, 7, 5), ' ');
+		EXPECT_EQ(at(frame, 1, 4), ' ');
+
+		// The frame of a huge battlefield is as large as the window
+		battle_field huge = create_simple_battlefield(3000, 2000);
+		int width = 0, height = 0;
+		battle_field_viewport::fit_frame(huge, 121, 40, width, height);
+		EXPECT_EQ(width, 120);
+		EXPECT_EQ(height, 40);
+		battle_field_viewport huge_viewport(huge, width, height);
+		huge_viewport.set_level(huge_viewport.get_fitting_level());
+		EXPECT_EQ(huge_viewport.compose({ point_2d(2999, 1999) }).size(), 120u * 40u);
+	}
+
+	TEST(path_finding_unit_tests, map_watcher_test) {
+		const auto filename = testing::TempDir() + "map_watcher_test.json";
+		const auto write_map = [&](const int width, const int height, const std::vector<point_2d>& elevated) {
+			std::ofstream file(filename, std::ios::trunc);
+			file << "{\"canvas\": {\"width\": " << width << ", \"height\": " << height << "}, "
+				<< "\"tilesets\": [{\"tilewidth\": 1, \"tileheight\": 1}], \"layers\": [{\"data\": [";
+			for (int i = 0; i < width * height; ++i) {
+				const point_2d position(i % width, i / width);
+				const auto type = i == 0 ? 0 : i == width * height - 1 ? 8
+					: std::find(elevated.begin(), elevated.end(), position) != elevated.end() ? 3 : 1;
+				file << (i > 0 ? ", " : "") << type;
+			}
+			file << "]}]}";
+		};
+		const auto wait_for = [](const std::function<bool()>& condition) {
+			for (int i = 0; i < 500; ++i) {
+				if (condition())
+					return true;
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			return false;
+		};
+
+		write_map(16, 8, { point_2d(4, 4) });
+		battle_field bf;
+		bf.load_from_json(filename);
+		battle_field_viewport viewport(bf, 18, 10);
+		viewport.set_level(1);
+		viewport.compose({});
+		bf.subscribe([&viewport](const map_changes& changes) { viewport.apply_changes(changes); });
+
+		map_watcher watcher(bf, filename, std::chrono::milliseconds(10));
+		EXPECT_FALSE(watcher.poll());
+
+		// One tile moved: two changed cells, applied and published at the tick boundary
+		write_map(16, 8, { point_2d(9, 3) });
+		ASSERT_TRUE(wait_for([&] { return watcher.poll(); }));
+		EXPECT_EQ(bf.get_tile(point_2d(4, 4)), tile_type::walkable);
+		EXPECT_EQ(bf.get_tile(point_2d(9, 3)), tile_type::elevated);
+		const auto changes = bf.publish_changes();
+		EXPECT_EQ(changes.cells.size(), 2u);
+		EXPECT_EQ(watcher.get_metrics().applied_tiles, 2u);
+
+		// The viewport counts were updated along the changed cells, as a rebuild would have counted them
+		const auto frame = viewport.compose({});
+		battle_field_viewport rebuilt(bf, 18, 10);
+		rebuilt.set_level(1);
+		const auto& expected = rebuilt.compose({});
+		ASSERT_EQ(frame.size(), expected.size());
+		for (size_t i = 0; i < frame.size(); ++i)
+			EXPECT_EQ(frame[i].ch, expected[i].ch);
+
+		// A file which does not parse keeps the last good map
+		const auto reloads = watcher.get_metrics().reloads;
+		std::ofstream(filename, std::ios::trunc) << "{\"canvas\": {\"width\": 16, ";
+		ASSERT_TRUE(wait_for([&] { return watcher.get_metrics().errors > 0; }));
+		EXPECT_FALSE(watcher.poll());
+		EXPECT_FALSE(watcher.get_last_error().empty());
+		EXPECT_EQ(watcher.get_metrics().reloads, reloads);
+		EXPECT_EQ(bf.get_tile(point_2d(1, 1)), tile_type::walkable);
+
+		// Another size replaces the grid
+		write_map(10, 10, {});
+		ASSERT_TRUE(wait_for([&] { return watcher.poll(); }));
+		EXPECT_EQ(bf.get_width(), 10);
+		EXPECT_EQ(bf.get_height(), 10);
+		EXPECT_EQ(bf.get_target_positions().size(), 1u);
+		EXPECT_TRUE(watcher.get_last_error().empty());
+		EXPECT_EQ(watcher.get_metrics().resizes, 1u);
+
+		std::remove(filename.c_str());
+	}
+
+	TEST(path_finding_unit_tests, path_tree_test) {
+		battle_field bf;
+		bf.generate_random_field(40, 40, 0, 300, 17);
+		const pathfinder pf(bf);
+		std::vector<point_2d> walkable;
+		for (int y = 0; y < 40; ++y)
+			for (int x = 0; x < 40; ++x)
+				if (bf.is_walkable(point_2d(x, y)))
+					walkable.emplace_back(x, y);
+		const auto goal = walkable[walkable.size() / 2];
+		path_tree tree(bf, goal);
+
+		// Later searches splice onto earlier paths: as short as find_path's without units, with units at most as long
+		// (units further than the lookahead after the splice are not avoided) and never shorter than without them
+		std::mt19937 gen(3);
+		std::uniform_int_distribution<size_t> pick(0, walkable.size() - 1);
+		std::vector<path_tree::node_id> held;
+		size_t total_length = 0;
+		for (int i = 0; i < 200; ++i) {
+			std::unordered_set<point_2d> occupied;
+			if (i % 4 == 3)
+				for (int j = 0; j < 20; ++j)
+					occupied.insert(walkable[pick(gen)]);
+			const auto start = walkable[pick(gen)];
+			occupied.erase(start);
+			const auto optimum = pf.find_path(start, goal, {});
+			const auto expected = pf.find_path(start, goal, occupied);
+			const auto id = pf.find_path_in_tree(start, occupied, tree);
+			if (optimum.empty() && start != goal) {
+				EXPECT_EQ(id, path_tree::no_node);
+				continue;
+			}
+			ASSERT_NE(id, path_tree::no_node);
+			if (occupied.empty()) {
+				ASSERT_EQ(tree.get(id).distance, optimum.size()) << "start " << start.get_x() << ", " << start.get_y();
+			}
+			else {
+				EXPECT_GE(tree.get(id).distance, optimum.size());
+				if (!expected.empty()) {
+					EXPECT_LE(tree.get(id).distance, expected.size());
+				}
+			}
+
+			// A walkable chain of neighbours ending at the goal
+			auto current = tree.get(id);
+			while (current.parent != path_tree::no_node) {
+				const auto& next = tree.get(current.parent);
+				EXPECT_GE(compact_path::direction_of(current.position, next.position), 0);
+				EXPECT_TRUE(bf.is_walkable(next.position));
+				current = next;
+			}
+			EXPECT_EQ(current.position, goal);
+			held.push_back(id);
+			total_length += tree.get(id).distance;
+		}
+		EXPECT_LT(tree.get_node_count(), total_length / 2);
+		EXPECT_GT(tree.get_shared_node_count(), 1u);
+
+		// A later search on the same paths expands fewer nodes than a full search
+		const auto start = walkable.front();
+		const std::unordered_set<point_2d> none;
+		const auto before = pf.get_expanded_node_count();
+		pf.find_path(start, goal, none);
+		const auto full = pf.get_expanded_node_count() - before;
+		held.push_back(pf.find_path_in_tree(start, none, tree));
+		const auto after = pf.get_expanded_node_count();
+		held.push_back(pf.find_path_in_tree(start, none, tree));
+		EXPECT_LT(pf.get_expanded_node_count() - after, full);
+
+		// An edit unshares the nodes, the held paths stay readable until released
+		const auto nodes = tree.get_node_count();
+		bf.set_tile(walkable.back() == goal ? walkable.front() : walkable.back(), tile_type::elevated);
+		tree.synchronize();
+		EXPECT_EQ(tree.get_shared_node_count(), 1u);
+		EXPECT_EQ(tree.get_node_count(), nodes);
+		for (const auto id : held)
+			tree.release(id);
+		EXPECT_EQ(tree.get_node_count(), 1u);
+
+		// Units heading for one target share the suffixes of their paths and all arrive
+		unit_store store(pf);
+		store.set_path_sharing(true);
+		std::unordered_set<point_2d> occupied;
+		for (int y = 0; y < 40 && store.size() < 30; y += 3) {
+			if (bf.is_walkable(point_2d(0, y)) && !pf.find_path(point_2d(0, y), goal, none).empty()) {
+				store.set_target(store.add(point_2d(0, y)), goal);
+				occupied.insert(point_2d(0, y));
+			}
+		}
+		ASSERT_GT(store.size(), 5u);
+		store.tick(occupied);
+		size_t lengths = 0;
+		for (unit_store::unit_id id = 0; id < store.size(); ++id) {
+			lengths += store.get_path_length(id);
+			const auto path = store.get_path(id).to_points();
+			if (!path.empty()) {
+				EXPECT_EQ(path.back(), goal);
+			}
+		}
+		EXPECT_LT(store.get_path_tree_node_count(), lengths);
+		for (int tick = 0; tick < 400 && store.tick(occupied) > 0; ++tick) {}
+		size_t arrived = 0;
+		for (unit_store::unit_id id = 0; id < store.size(); ++id)
+			arrived += store.get_position(id) == goal ? 1 : 0;
+		EXPECT_EQ(arrived, 1u);
+	}
+
+	TEST(path_finding_unit_tests, rectangle_decomposition_test) {
+		// An empty field is one rectangle, only its sides are left
+		battle_field empty;
+		empty.generate_random_field(10, 8, 0, 0, 1);
+		const auto single = rectangle_decomposition::build(empty);
+		EXPECT_EQ(single.get_rectangle_count(), 1u);
+		EXPECT_EQ(single.get_perimeter_cell_count(), 32u);
+
+		battle_field bf;
+		bf.generate_random_field(40, 30, 0, 120, 9);
+		const auto rectangles = rectangle_decomposition::build(bf);
+		for (int y = 0; y < 30; ++y) {
+			for (int x = 0; x < 40; ++x) {
+				const point_2d p(x, y);
+				const auto index = rectangles.get_rectangle_index(p);
+				ASSERT_EQ(index != rectangle_decomposition::no_rectangle, bf.is_walkable(p));
+				if (index == rectangle_decomposition::no_rectangle)
+					continue;
+				const auto& r = rectangles.get_rectangle(index);
+				EXPECT_TRUE(x >= r.min_x && x <= r.max_x && y >= r.min_y && y <= r.max_y);
+			}
+		}
+		EXPECT_EQ(rectangles.get_rectangle_index(point_2d(-1, 0)), rectangle_decomposition::no_rectangle);
+
+		// Same lengths as A*, valid steps, fewer expansions
+		pathfinder pf(bf);
+		pathfinder reduced_pf(bf);
+		reduced_pf.set_symmetry_reduction(&rectangles);
+		std::unordered_set<point_2d> occupied;
+		for (int y = 0; y < 30; y += 3) {
+			for (int x = 0; x < 40; x += 3) {
+				const point_2d start(x, y);
+				const point_2d goal(39 - x / 2, 29 - y);
+				const auto expected = pf.find_path(start, goal, occupied);
+				const auto path = reduced_pf.find_path_reduced(start, goal, occupied);
+				ASSERT_EQ(path.size(), expected.size());
+				auto previous = start;
+				for (const auto& p : path) {
+					ASSERT_EQ(previous.manhattan_distance(p), 1);
+					ASSERT_TRUE(bf.is_walkable(p));
+					previous = p;
+				}
+				if (!path.empty()) {
+					EXPECT_EQ(path.back(), goal);
+				}
+			}
+		}
+		EXPECT_LT(reduced_pf.get_expanded_node_count(), pf.get_expanded_node_count());
+
+		// Rectangles with units inside are searched cell by cell, paths stay optimal
+		for (int i = 0; i < 60; ++i) {
+			const auto p = battle_field::generate_random_point(point_2d(0, 0), point_2d(39, 29));
+			if (bf.is_walkable(p))
+				occupied.insert(p);
+		}
+		for (int i = 0; i < 60; ++i) {
+			const auto start = battle_field::generate_random_point(point_2d(0, 0), point_2d(39, 29));
+			const auto goal = battle_field::generate_random_point(point_2d(0, 0), point_2d(39, 29));
+			const auto path = reduced_pf.find_path_reduced(start, goal, occupied);
+			EXPECT_EQ(path.size(), pf.find_path(start, goal, occupied).size());
+			for (const auto& p : path)
+				EXPECT_TRUE(p == goal || occupied.count(p) == 0);
+		}
+
+		// A stale decomposition is ignored once a tile changed
+		battle_field changed = bf;
+		pathfinder changed_pf(changed);
+		changed_pf.set_symmetry_reduction(&rectangles);
+		changed.set_tiles(point_2d(0, 14), point_2d(38, 14), tile_type::elevated);
+		occupied.clear();
+		const auto path = changed_pf.find_path_reduced(point_2d(0, 0), point_2d(0, 29), occupied);
+		EXPECT_EQ(path.size(), changed_pf.find_path(point_2d(0, 0), point_2d(0, 29), occupied).size());
+		for (const auto& p : path)
+			EXPECT_TRUE(changed.is_walkable(p));
+	}
+
+	TEST(path_finding_unit_tests, grid_layout_test) {
+		// x in the even bits: x = 011, y = 101 interleave to 100111
+		EXPECT_EQ(grid_layout::morton_encode(3, 5), 39u);
+		for (std::uint32_t x : { 0u, 1u, 63u, 1000u, 65535u }) {
+			for (std::uint32_t y : { 0u, 2u, 64u, 777u, 65535u }) {
+				std::uint32_t decoded_x, decoded_y;
+				grid_layout::morton_decode(grid_layout::morton_encode(x, y), decoded_x, decoded_y);
+				EXPECT_EQ(decoded_x, x);
+				EXPECT_EQ(decoded_y, y);
+			}
+		}
+
+		// Every cell gets its own index inside the padded blocks
+		const grid_layout layout(grid_layout_type::morton, 100, 70);
+		EXPECT_EQ(layout.get_cell_count(), static_cast<size_t>(4 * 64 * 64));
+		std::vector<bool> used(layout.get_cell_count());
+		for (int y = 0; y < 70; ++y) {
+			for (int x = 0; x < 100; ++x) {
+				const auto index = layout.index_of(point_2d(x, y));
+				ASSERT_LT(index, layout.get_cell_count());
+				EXPECT_FALSE(used[index]);
+				used[index] = true;
+				EXPECT_EQ(layout.position_of(index), point_2d(x, y));
+			}
+		}
+		// Neighbours inside a block are close in memory
+		EXPECT_EQ(layout.index_of(point_2d(1, 0)) - layout.index_of(point_2d(0, 0)), 1u);
+		EXPECT_EQ(layout.index_of(point_2d(0, 1)) - layout.index_of(point_2d(0, 0)), 2u);
+
+		// The same battlefield in either layout
+		battle_field row_major;
+		row_major.generate_random_field(90, 70, 0, 3, 9);
+		battle_field morton = row_major;
+		morton.set_layout(grid_layout_type::morton);
+		EXPECT_EQ(morton.get_layout().get_type(), grid_layout_type::morton);
+		EXPECT_EQ(morton.get_cell_count(), static_cast<size_t>(2 * 2 * 64 * 64));
+		EXPECT_EQ(morton.get_row_major_tiles(), row_major.get_row_major_tiles());
+		EXPECT_EQ(morton.get_content_hash(), row_major.get_content_hash());
+		for (int y = -1; y <= 70; ++y) {
+			for (int x = -1; x <= 90; ++x) {
+				EXPECT_EQ(morton.is_walkable(point_2d(x, y)), row_major.is_walkable(point_2d(x, y)));
+			}
+		}
+
+		// Searches and the per cell tables give the same paths
+		pathfinder row_major_pf(row_major);
+		pathfinder morton_pf(morton);
+		const landmark_heuristic row_major_landmarks(row_major, 4);
+		const landmark_heuristic morton_landmarks(morton, 4);
+		const auto row_major_rectangles = rectangle_decomposition::build(row_major);
+		const auto morton_rectangles = rectangle_decomposition::build(morton);
+		EXPECT_EQ(morton_rectangles.get_rectangle_count(), row_major_rectangles.get_rectangle_count());
+		morton_pf.set_symmetry_reduction(&morton_rectangles);
+		const std::unordered_set<point_2d> occupied;
+		for (int i = 0; i < 40; ++i) {
+			const auto start = battle_field::generate_random_point(point_2d(0, 0), point_2d(89, 69));
+			const auto goal = battle_field::generate_random_point(point_2d(0, 0), point_2d(89, 69));
+			const auto expected = row_major_pf.find_path(start, goal, occupied).size();
+			EXPECT_EQ(morton_pf.find_path(start, goal, occupied).size(), expected);
+			EXPECT_EQ(morton_pf.find_path_reduced(start, goal, occupied).size(), expected);
+			EXPECT_EQ(morton_landmarks.estimate(start, goal), row_major_landmarks.estimate(start, goal));
+			morton_pf.set_landmarks(&morton_landmarks);
+			EXPECT_EQ(morton_pf.find_path(start, goal, occupied).size(), expected);
+			morton_pf.set_landmarks(nullptr);
+		}
+
+		// Edits and reloads keep the layout
+		morton.publish_changes();
+		morton.set_tile(point_2d(70, 65), tile_type::elevated);
+		morton.set_tile(point_2d(70, 65), tile_type::elevated);
+		EXPECT_EQ(morton.get_tile(point_2d(70, 65)), tile_type::elevated);
+		EXPECT_EQ(morton.publish_changes().cells, std::vector<point_2d>{ point_2d(70, 65) });
+		morton.load_from_tiles(3, 2, { tile_type::elevated, tile_type::walkable, tile_type::walkable,
+			tile_type::walkable, tile_type::walkable, tile_type::elevated });
+		EXPECT_EQ(morton.get_layout().get_type(), grid_layout_type::morton);
+		EXPECT_FALSE(morton.is_walkable(point_2d(0, 0)));
+		EXPECT_TRUE(morton.is_walkable(point_2d(1, 0)));
+		EXPECT_FALSE(morton.is_walkable(point_2d(2, 1)));
+		EXPECT_FALSE(morton.is_walkable(point_2d(3, 0)));
+	}
 }
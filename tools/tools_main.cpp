@@ -0,0 +1,361 @@
+#include "../headers/battleField.hpp"
+#include "../headers/compressedPathDatabase.hpp"
+#include "../headers/goalBounds.hpp"
+#include "../headers/pathFinder.hpp"
+#include "../headers/pathService.hpp"
+#include "../headers/scenarioRunner.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace path_finding;
+
+namespace path_finding_tools
+{
+	/// <summary>
+	/// Build the compressed path database of a map and save it alongside the map
+	/// </summary>
+	/// <param name="map_filename"></param>
+	/// <returns></returns>
+	int build_path_database(const std::string& map_filename)
+	{
+		battle_field field;
+		field.load_from_json(map_filename);
+
+		const auto begin = std::chrono::steady_clock::now();
+		const auto database = compressed_path_database::build(field);
+		const auto end = std::chrono::steady_clock::now();
+
+		const auto output = compressed_path_database::default_filename(map_filename);
+		database.save(output);
+		std::cout << output << ": " << database.get_run_count() << " runs, " << database.get_memory_size() / 1024
+			<< " KiB, built in " << std::chrono::duration<double, std::milli>(end - begin).count() << " ms" << '\n';
+		return 0;
+	}
+
+	/// <summary>
+	/// Build the goal bounds of a map and save them alongside the map
+	/// </summary>
+	/// <param name="map_filename"></param>
+	/// <returns></returns>
+	int build_goal_bounds(const std::string& map_filename)
+	{
+		battle_field field;
+		field.load_from_json(map_filename);
+
+		const auto begin = std::chrono::steady_clock::now();
+		const auto bounds = goal_bounds::build(field);
+		const auto end = std::chrono::steady_clock::now();
+
+		const auto output = goal_bounds::default_filename(map_filename);
+		bounds.save(output);
+		std::cout << output << ": " << bounds.get_memory_size() / 1024
+			<< " KiB, built in " << std::chrono::duration<double, std::milli>(end - begin).count() << " ms" << '\n';
+		return 0;
+	}
+
+	/// <summary>
+	/// Print the totals of a path service session
+	/// </summary>
+	/// <param name="stats"></param>
+	void print_service_stats(const path_service_stats& stats)
+	{
+		const auto average = stats.requests > 0 ? stats.total_latency.count() / static_cast<double>(stats.requests) : 0.0;
+		std::cerr << stats.requests << " queries, " << stats.errors << " errors, latency " << average << " us average, "
+			<< stats.max_latency.count() << " us max, " << stats.elapsed.count() / 1000.0 << " ms" << '\n';
+	}
+
+#ifndef _WIN32
+	/// <summary>
+	/// Stream buffer over a connected socket, so a connection can be served like stdin and stdout.
+	/// The socket is closed by its owner, after the thread using the buffer was joined
+	/// </summary>
+	class socket_buffer : public std::streambuf {
+	public:
+
+		explicit socket_buffer(const int socket) : socket_(socket)
+		{
+			setg(input_, input_, input_);
+			setp(output_, output_ + sizeof(output_));
+		}
+
+		~socket_buffer() override
+		{
+			sync();
+		}
+
+	protected:
+
+		int_type underflow() override
+		{
+			const auto received = ::recv(socket_, input_, sizeof(input_), 0);
+			if (received <= 0)
+				return traits_type::eof();
+			setg(input_, input_, input_ + received);
+			return traits_type::to_int_type(*gptr());
+		}
+
+		int_type overflow(const int_type c) override
+		{
+			if (sync() != 0)
+				return traits_type::eof();
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+				sputc(traits_type::to_char_type(c));
+			return traits_type::not_eof(c);
+		}
+
+		int sync() override
+		{
+			for (auto begin = pbase(); begin < pptr();) {
+				const auto sent = ::send(socket_, begin, static_cast<size_t>(pptr() - begin), MSG_NOSIGNAL);
+				if (sent <= 0)
+					return -1;
+				begin += sent;
+			}
+			setp(output_, output_ + sizeof(output_));
+			return 0;
+		}
+
+	private:
+
+		int socket_;
+		char input_[4096];
+		char output_[4096];
+	};
+
+	/// <summary>
+	/// Set by SIGINT and SIGTERM, the accept loop polls it
+	/// </summary>
+	volatile std::sig_atomic_t stop_serving = 0;
+
+	/// <summary>
+	/// Most connections served at once, more wait in the listen backlog
+	/// </summary>
+	constexpr size_t max_connections = 16;
+
+	/// <summary>
+	/// Served connection, its thread is joined before the socket is closed
+	/// </summary>
+	struct connection {
+		int socket;
+		std::thread thread;
+		std::shared_ptr<std::atomic<bool>> done;
+	};
+
+	/// <summary>
+	/// Join the connections whose session ended, or all of them after shutting their sockets down
+	/// </summary>
+	/// <param name="connections"></param>
+	/// <param name="all"></param>
+	void join_connections(std::list<connection>& connections, const bool all)
+	{
+		for (auto it = connections.begin(); it != connections.end();) {
+			if (!all && !it->done->load()) {
+				++it;
+				continue;
+			}
+			if (all)
+				::shutdown(it->socket, SHUT_RDWR);
+			it->thread.join();
+			::close(it->socket);
+			it = connections.erase(it);
+		}
+	}
+
+	/// <summary>
+	/// Accept connections on a Unix domain socket, every connection is a session of its own on the shared workers.
+	/// Runs until SIGINT or SIGTERM, then shuts the open connections down and joins them
+	/// </summary>
+	/// <param name="service"></param>
+	/// <param name="socket_path"></param>
+	/// <returns></returns>
+	int serve_socket(const path_service& service, const std::string& socket_path)
+	{
+		sockaddr_un address{};
+		if (socket_path.size() >= sizeof(address.sun_path))
+			throw std::runtime_error("Socket path too long: " + socket_path);
+		address.sun_family = AF_UNIX;
+		socket_path.copy(address.sun_path, socket_path.size());
+
+		const auto listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		::unlink(socket_path.c_str());
+		if (listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 16) != 0)
+			throw std::runtime_error("Failed to listen on " + socket_path);
+		std::signal(SIGINT, [](int) { stop_serving = 1; });
+		std::signal(SIGTERM, [](int) { stop_serving = 1; });
+		std::cerr << "listening on " << socket_path << '\n';
+
+		std::list<connection> connections;
+		auto result = 0;
+		while (stop_serving == 0) {
+			join_connections(connections, false);
+			if (connections.size() >= max_connections) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				continue;
+			}
+
+			// Wait with a timeout, so a signal handled by another thread still ends the loop
+			pollfd waiting{ listener, POLLIN, 0 };
+			const auto polled = ::poll(&waiting, 1, 250);
+			if (polled <= 0) {
+				if (polled < 0 && errno != EINTR) {
+					std::cerr << "poll failed: " << std::strerror(errno) << '\n';
+					result = 1;
+					break;
+				}
+				continue;
+			}
+
+			const auto socket = ::accept(listener, nullptr, nullptr);
+			if (socket < 0) {
+				// Transient: an aborted connection or out of descriptors or memory, back off and retry
+				if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO)
+					continue;
+				if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+					continue;
+				}
+				std::cerr << "accept failed: " << std::strerror(errno) << '\n';
+				result = 1;
+				break;
+			}
+
+			auto done = std::make_shared<std::atomic<bool>>(false);
+			connections.push_back({ socket, std::thread([&service, socket, done] {
+				{
+					socket_buffer buffer(socket);
+					std::istream input(&buffer);
+					std::ostream output(&buffer);
+					print_service_stats(service.run(input, output));
+				}
+				done->store(true);
+			}), done });
+		}
+
+		join_connections(connections, true);
+		::close(listener);
+		::unlink(socket_path.c_str());
+		return result;
+	}
+#endif
+
+	/// <summary>
+	/// Load the map once, with its path database and goal bounds when they were built, and answer path queries
+	/// from stdin to stdout, or from the connections to a Unix domain socket
+	/// </summary>
+	/// <param name="map_filename"></param>
+	/// <param name="socket_path">Empty for stdin</param>
+	/// <returns></returns>
+	int serve(const std::string& map_filename, const std::string& socket_path)
+	{
+		battle_field field;
+		field.load_from_json(map_filename);
+		pathfinder path_finder(field);
+
+		std::optional<compressed_path_database> database;
+		const auto database_filename = compressed_path_database::default_filename(map_filename);
+		if (std::filesystem::exists(database_filename)) {
+			database.emplace(compressed_path_database::load(database_filename, field));
+			path_finder.set_path_database(&*database);
+		}
+		std::optional<goal_bounds> bounds;
+		const auto bounds_filename = goal_bounds::default_filename(map_filename);
+		if (std::filesystem::exists(bounds_filename)) {
+			bounds.emplace(goal_bounds::load(bounds_filename, field));
+			path_finder.set_goal_bounds(&*bounds);
+		}
+
+		const path_service service(path_finder);
+		if (socket_path.empty()) {
+			std::ios::sync_with_stdio(false);
+			print_service_stats(service.run(std::cin, std::cout));
+			return 0;
+		}
+#ifndef _WIN32
+		return serve_socket(service, socket_path);
+#else
+		std::cerr << "Sockets are not supported on this platform, serve from stdin" << '\n';
+		return 1;
+#endif
+	}
+
+	/// <summary>
+	/// Run every scenario of a manifest sharded over the cores, print the report and the throughput
+	/// </summary>
+	/// <param name="manifest_filename"></param>
+	/// <param name="number_of_threads">0 for one thread per core</param>
+	/// <returns></returns>
+	int run_scenarios(const std::string& manifest_filename, const unsigned number_of_threads)
+	{
+		const auto runner = scenario_runner::load(manifest_filename);
+		const auto report = runner.run(number_of_threads);
+		std::cout << report.to_json() << '\n';
+		std::cerr << report.simulations << " simulations on " << report.threads << " threads in "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(report.wall_time).count() << " ms, "
+			<< report.get_throughput() << " simulations/s" << '\n';
+		return 0;
+	}
+
+	/// <summary>
+	/// Print the usage
+	/// </summary>
+	/// <returns></returns>
+	int usage()
+	{
+		std::cerr << "Usage: path_finding_tools <command> <file> [option]" << '\n'
+			<< "  build-cpd    build the compressed path database next to the map" << '\n'
+			<< "               path_finding_tools build-cpd <map.json>" << '\n'
+			<< "  build-bounds build the goal bounds next to the map" << '\n'
+			<< "               path_finding_tools build-bounds <map.json>" << '\n'
+			<< "  serve        answer JSON path queries line by line from stdin, or from a Unix domain socket" << '\n'
+			<< "               path_finding_tools serve <map.json> [socket]" << '\n'
+			<< "  scenarios    run the simulations of a scenario manifest on all cores and print the JSON report" << '\n'
+			<< "               path_finding_tools scenarios <manifest.json> [threads]" << '\n';
+		return 1;
+	}
+}
+
+/// <summary>
+/// Offline tools entry point
+/// </summary>
+int main(const int argc, char** argv)
+{
+	using namespace path_finding_tools;
+	try {
+		if (argc < 3)
+			return usage();
+
+		const std::string command = argv[1];
+		if (command == "build-cpd")
+			return build_path_database(argv[2]);
+		if (command == "build-bounds")
+			return build_goal_bounds(argv[2]);
+		if (command == "serve")
+			return serve(argv[2], argc > 3 ? argv[3] : "");
+		if (command == "scenarios")
+			return run_scenarios(argv[2], argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 0);
+		return usage();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "An error occurred: " << e.what() << '\n';
+		return 1;
+	}
+}